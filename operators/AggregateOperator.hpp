@@ -0,0 +1,276 @@
+//
+//  AggregateOperator.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_OPERATORS_AGGREGATE_OPERATOR_HPP_
+#define GIFTED_OPERATORS_AGGREGATE_OPERATOR_HPP_
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "operators/Operator.hpp"
+#include "storage/ColumnVector.hpp"
+#include "storage/HyperLogLog.hpp"
+#include "storage/QuantileSketch.hpp"
+#include "storage/VectorBatch.hpp"
+#include "types/BaseType.hpp"
+#include "types/TypeRegistry.hpp"
+
+/**
+ * @brief Computes aggregates over all of its input (no grouping) and
+ *        produces a single row with one column per aggregate.
+ *
+ *        COUNT works on any column and counts its non null values. SUM, MIN
+ *        and MAX work on int64, int32 and decimal columns; SUM of int32 is an
+ *        int64, everything else keeps the column's type. SUM, MIN and MAX of
+ *        no values are null.
+ *
+ *        Two aggregates are approximate, from sketches, for inputs too big
+ *        to hash or sort exactly: APPROX_COUNT_DISTINCT (any column; an
+ *        int64, from a GiftedHyperLogLog fed by the type's batch hash, so it
+ *        needs the registry) and APPROX_QUANTILE (numeric columns; the
+ *        column's type, null if no values, from a GiftedQuantileSketch).
+ **/
+class GiftedAggregateOperator : public GiftedOperator {
+public:
+  enum AggregateId {
+    kCount,
+    kSum,
+    kMin,
+    kMax,
+    kApproxCountDistinct,
+    kApproxQuantile
+  };
+
+  struct Aggregate {
+    /**
+     * @param fractionIn For kApproxQuantile, the quantile (0.5: the median).
+     **/
+    Aggregate(const AggregateId aggregateIn, const std::size_t columnIn, const double fractionIn = 0.5)
+        : aggregate(aggregateIn), column(columnIn), fraction(fractionIn) {}
+
+    AggregateId aggregate;
+    std::size_t column;
+    double fraction;
+  };
+
+  GiftedAggregateOperator(std::unique_ptr<GiftedOperator> child,
+                          const std::vector<Aggregate> &aggregates)
+      : _registry(nullptr),
+        _child(std::move(child)),
+        _aggregates(aggregates),
+        _states(aggregates.size()),
+        _done(false) {}
+
+  GiftedAggregateOperator(const GiftedTypeRegistry &registry,
+                          std::unique_ptr<GiftedOperator> child,
+                          const std::vector<Aggregate> &aggregates)
+      : _registry(&registry),
+        _child(std::move(child)),
+        _aggregates(aggregates),
+        _states(aggregates.size()),
+        _done(false) {}
+
+  bool Next(GiftedVectorBatch *batch) override {
+    if (_done) return false;
+    _done = true;
+
+    while (_child->Next(batch)) {
+      for (std::size_t a = 0; a < _aggregates.size(); a++) {
+        if (_aggregates[a].aggregate == kApproxCountDistinct) {
+          AccumulateDistinct(_aggregates[a], *batch, &_states[a]);
+        } else {
+          Accumulate(_aggregates[a], *batch, &_states[a]);
+        }
+      }
+    }
+
+    batch->Reset();
+    for (std::size_t a = 0; a < _aggregates.size(); a++) {
+      batch->AddColumn(Result(_aggregates[a], _states[a]));
+    }
+    return true;
+  }
+
+private:
+  struct State {
+    State()
+        : typeId(GiftedBaseType::_GiftedUnknownTypeId),
+          count(0),
+          sum(0),
+          min(std::numeric_limits<std::int64_t>::max()),
+          max(std::numeric_limits<std::int64_t>::min()) {}
+
+    GiftedBaseType::GiftedTypeId typeId;
+    std::int64_t count;
+    std::int64_t sum;
+    std::int64_t min;
+    std::int64_t max;
+    std::unique_ptr<GiftedHyperLogLog> distinct;
+    std::unique_ptr<GiftedQuantileSketch> quantiles;
+  };
+
+  void AccumulateDistinct(const Aggregate &aggregate, const GiftedVectorBatch &batch, State *state) {
+    if (_registry == nullptr) {
+      throw std::invalid_argument("GiftedAggregateOperator: APPROX_COUNT_DISTINCT needs the type registry");
+    }
+    const GiftedColumnVector &column = batch.getColumn(aggregate.column);
+    state->typeId = column.getTypeId();
+    if (!state->distinct) state->distinct.reset(new GiftedHyperLogLog());
+    if (_hashes.size() < column.size()) _hashes.resize(column.size());
+    column.Hash(_registry->getEntry(column.getTypeId())->prototype.get(), _hashes.data());
+    if (column.getValidityBitmap() == nullptr) {
+      state->distinct->AddBatch(_hashes.data(), batch.hasSelection() ? batch.getSelection() : nullptr,
+                                batch.getNumSelected());
+      return;
+    }
+    _rows.clear();
+    ForEachRow(batch, column, CollectRow(&_rows));
+    state->distinct->AddBatch(_hashes.data(), _rows.data(), _rows.size());
+  }
+
+  static void Accumulate(const Aggregate &aggregate, const GiftedVectorBatch &batch, State *state) {
+    const GiftedColumnVector &column = batch.getColumn(aggregate.column);
+    state->typeId = column.getTypeId();
+    if (aggregate.aggregate == kCount) {
+      if (column.getValidityBitmap() == nullptr) {
+        state->count += batch.getNumSelected();
+      } else {
+        ForEachRow(batch, column, CountRow(state));
+      }
+      return;
+    }
+
+    switch (column.getTypeId()) {
+      case GiftedBaseType::_GiftedIntTypeId:
+      case GiftedBaseType::_GiftedDecimalTypeId:
+        ForEachRow(batch, column, AccumulateRow<std::int64_t>(aggregate.aggregate, column, state));
+        break;
+      case GiftedBaseType::_GiftedInt32TypeId:
+        ForEachRow(batch, column, AccumulateRow<std::int32_t>(aggregate.aggregate, column, state));
+        break;
+      default:
+        throw std::invalid_argument("GiftedAggregateOperator: column type is not numeric");
+    }
+  }
+
+  // Call "function" with each live, non null row of the batch.
+  template <typename Function>
+  static void ForEachRow(const GiftedVectorBatch &batch, const GiftedColumnVector &column, Function function) {
+    const bool hasNulls = column.getValidityBitmap() != nullptr;
+    if (batch.hasSelection()) {
+      const std::uint32_t *selection = batch.getSelection();
+      for (std::size_t i = 0; i < batch.getNumSelected(); i++) {
+        if (!hasNulls || !column.isNull(selection[i])) function(selection[i]);
+      }
+    } else {
+      for (std::size_t i = 0; i < batch.getNumRows(); i++) {
+        if (!hasNulls || !column.isNull(i)) function(i);
+      }
+    }
+  }
+
+  struct CollectRow {
+    explicit CollectRow(std::vector<std::uint32_t> *rowsIn) : rows(rowsIn) {}
+    void operator()(const std::size_t row) const {rows->push_back(static_cast<std::uint32_t>(row));}
+    std::vector<std::uint32_t> *rows;
+  };
+
+  struct CountRow {
+    explicit CountRow(State *stateIn) : state(stateIn) {}
+    void operator()(const std::size_t) const {state->count++;}
+    State *state;
+  };
+
+  template <typename T>
+  struct AccumulateRow {
+    AccumulateRow(const AggregateId aggregateIn, const GiftedColumnVector &column, State *stateIn)
+        : aggregate(aggregateIn),
+          values(reinterpret_cast<const T*>(column.getValues())),
+          state(stateIn) {}
+
+    void operator()(const std::size_t row) const {
+      const std::int64_t value = values[row];
+      state->count++;
+      switch (aggregate) {
+        case kSum:
+          if (__builtin_add_overflow(state->sum, value, &state->sum)) {
+            throw std::overflow_error("GiftedAggregateOperator: SUM overflows");
+          }
+          break;
+        case kMin:
+          if (value < state->min) state->min = value;
+          break;
+        case kMax:
+          if (value > state->max) state->max = value;
+          break;
+        case kApproxQuantile:
+          if (!state->quantiles) state->quantiles.reset(new GiftedQuantileSketch());
+          state->quantiles->Add(value);
+          break;
+        default:
+          break;
+      }
+    }
+
+    const AggregateId aggregate;
+    const T *values;
+    State *state;
+  };
+
+  static GiftedColumnVector Result(const Aggregate &aggregate, const State &state) {
+    if (aggregate.aggregate == kCount) {
+      GiftedColumnVector result(GiftedBaseType::_GiftedIntTypeId, sizeof(std::int64_t), 1);
+      result.AppendFixed(reinterpret_cast<const char*>(&state.count));
+      return result;
+    }
+    if (aggregate.aggregate == kApproxCountDistinct) {
+      const std::int64_t estimate = state.distinct ? std::llround(state.distinct->Estimate()) : 0;
+      GiftedColumnVector result(GiftedBaseType::_GiftedIntTypeId, sizeof(std::int64_t), 1);
+      result.AppendFixed(reinterpret_cast<const char*>(&estimate));
+      return result;
+    }
+
+    const bool isInt32 = state.typeId == GiftedBaseType::_GiftedInt32TypeId;
+    const bool isSum = aggregate.aggregate == kSum;
+    std::int64_t value = isSum ? state.sum : aggregate.aggregate == kMin ? state.min : state.max;
+    if (aggregate.aggregate == kApproxQuantile && state.count > 0) {
+      value = state.quantiles->Quantile(aggregate.fraction);
+    }
+    if (isInt32 && !isSum) {
+      GiftedColumnVector result(GiftedBaseType::_GiftedInt32TypeId, sizeof(std::int32_t), 1);
+      const std::int32_t narrow = static_cast<std::int32_t>(value);
+      if (state.count == 0) {
+        result.AppendNull();
+      } else {
+        result.AppendFixed(reinterpret_cast<const char*>(&narrow));
+      }
+      return result;
+    }
+    GiftedColumnVector result(isInt32 ? GiftedBaseType::_GiftedIntTypeId : state.typeId,
+                              sizeof(std::int64_t), 1);
+    if (state.count == 0) {
+      result.AppendNull();
+    } else {
+      result.AppendFixed(reinterpret_cast<const char*>(&value));
+    }
+    return result;
+  }
+
+  const GiftedTypeRegistry *_registry;
+  std::unique_ptr<GiftedOperator> _child;
+  const std::vector<Aggregate> _aggregates;
+  std::vector<State> _states;
+  bool _done;
+  std::vector<std::uint64_t> _hashes;
+  std::vector<std::uint32_t> _rows;
+};
+
+#endif  // GIFTED_OPERATORS_AGGREGATE_OPERATOR_HPP_
@@ -0,0 +1,42 @@
+//
+//  BitmapIndexPredicate.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_OPERATORS_BITMAP_INDEX_PREDICATE_HPP_
+#define GIFTED_OPERATORS_BITMAP_INDEX_PREDICATE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "storage/VectorBatch.hpp"
+#include "types/BatchPredicate.hpp"
+#include "utility/RoaringBitmap.hpp"
+
+/**
+ * @brief Passes the rows in a set answered by bitmap indexes, e.g.
+ *        GiftedBitmapIndex::Equal() or In(), or several of them combined.
+ *        Put in a GiftedFilterOperator on a scan of the indexed rows, it
+ *        replaces the comparison kernels with a lookup of each batch's rows
+ *        (by getFirstRow()) in the bitmap; the batch's columns are not read.
+ *
+ *        Only for filters whose input batches are the indexed rows as
+ *        scanned, numbered from 0 (other filters below may narrow the
+ *        selection).
+ **/
+class GiftedBitmapIndexPredicate : public GiftedBatchPredicate {
+public:
+  explicit GiftedBitmapIndexPredicate(GiftedRoaringBitmap rows)
+      : _rows(std::move(rows)) {}
+
+  void Evaluate(const GiftedVectorBatch &batch, bool *result) override {
+    _rows.FillBools(static_cast<std::uint32_t>(batch.getFirstRow()), batch.getNumRows(), result);
+  }
+
+private:
+  const GiftedRoaringBitmap _rows;
+};
+
+#endif  // GIFTED_OPERATORS_BITMAP_INDEX_PREDICATE_HPP_
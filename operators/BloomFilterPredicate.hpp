@@ -0,0 +1,51 @@
+//
+//  BloomFilterPredicate.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_OPERATORS_BLOOM_FILTER_PREDICATE_HPP_
+#define GIFTED_OPERATORS_BLOOM_FILTER_PREDICATE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "storage/BloomFilter.hpp"
+#include "storage/ColumnVector.hpp"
+#include "types/ColumnPredicate.hpp"
+#include "types/TypeRegistry.hpp"
+
+/**
+ * @brief Passes the values that may be in a Bloom filter, typically the one
+ *        a hash join fills from its build side. Put in a GiftedFilterOperator
+ *        on the probe side's scan, it drops most rows without a join partner
+ *        before they reach the join.
+ *
+ *        The filter is shared with the join and only filled once the join
+ *        has read its build side; until then everything passes.
+ **/
+class GiftedBloomFilterPredicate : public GiftedColumnPredicate {
+public:
+  GiftedBloomFilterPredicate(const GiftedTypeRegistry &registry,
+                             const std::shared_ptr<const GiftedBlockedBloomFilter> &filter)
+      : _registry(registry), _filter(filter) {}
+
+  void Evaluate(const GiftedColumnVector &batch, bool *result) override {
+    if (_filter->empty()) {
+      for (std::size_t i = 0; i < batch.size(); i++) result[i] = true;
+      return;
+    }
+    if (_hashes.size() < batch.size()) _hashes.resize(batch.size());
+    batch.Hash(_registry.getEntry(batch.getTypeId())->prototype.get(), _hashes.data());
+    _filter->ProbeBatch(_hashes.data(), batch.size(), result);
+  }
+
+private:
+  const GiftedTypeRegistry &_registry;
+  std::shared_ptr<const GiftedBlockedBloomFilter> _filter;
+  std::vector<std::uint64_t> _hashes;
+};
+
+#endif  // GIFTED_OPERATORS_BLOOM_FILTER_PREDICATE_HPP_
@@ -0,0 +1,86 @@
+//
+//  BufferPoolScanOperator.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_OPERATORS_BUFFER_POOL_SCAN_OPERATOR_HPP_
+#define GIFTED_OPERATORS_BUFFER_POOL_SCAN_OPERATOR_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "operators/Operator.hpp"
+#include "storage/BufferPool.hpp"
+#include "storage/VectorBatch.hpp"
+
+/**
+ * @brief Scans equally long GiftedPooledColumns through a GiftedBufferPool.
+ *        A batch's columns are views of pinned blocks (with the kScan hint,
+ *        so the scan does not push other blocks out of the pool), and no
+ *        batch spans two blocks of a column. Whenever a column moves on to
+ *        a new block, the next "prefetchBlocks" of it are prefetched.
+ *
+ *        A batch's blocks stay pinned until its columns are dropped, i.e.
+ *        the next Next(); the pool needs two frames per scanned column.
+ **/
+class GiftedBufferPoolScanOperator : public GiftedOperator {
+public:
+  GiftedBufferPoolScanOperator(GiftedBufferPool *pool,
+                               const std::vector<GiftedPooledColumn> &columns,
+                               const std::size_t batchRows = kGiftedDefaultBatchRows,
+                               const std::size_t prefetchBlocks = 4)
+      : _pool(pool),
+        _columns(columns),
+        _batchRows(batchRows > 0 ? batchRows : 1),
+        _prefetchBlocks(prefetchBlocks),
+        _position(0) {
+    for (std::size_t i = 1; i < _columns.size(); i++) {
+      if (_columns[i].numRows != _columns[0].numRows) {
+        throw std::invalid_argument("GiftedBufferPoolScanOperator: columns differ in length");
+      }
+    }
+  }
+
+  bool Next(GiftedVectorBatch *batch) override {
+    batch->Reset();
+    if (_columns.empty() || _position >= _columns[0].numRows) return false;
+    if (batch->getCapacity() < _batchRows) {
+      throw std::invalid_argument("GiftedBufferPoolScanOperator: batch is smaller than the scan's batches");
+    }
+
+    // Up to the end of the first block that ends.
+    std::size_t rows = _columns[0].numRows - _position;
+    if (rows > _batchRows) rows = _batchRows;
+    for (std::size_t i = 0; i < _columns.size(); i++) {
+      const std::size_t left = _columns[i].rowsPerBlock - _position % _columns[i].rowsPerBlock;
+      if (rows > left) rows = left;
+    }
+    for (std::size_t i = 0; i < _columns.size(); i++) {
+      const GiftedPooledColumn &column = _columns[i];
+      const std::uint64_t block = column.firstBlock + _position / column.rowsPerBlock;
+      const std::size_t row = _position % column.rowsPerBlock;
+      if (row == 0 && _prefetchBlocks > 0) {
+        const std::uint64_t lastBlock = column.firstBlock + (column.numRows - 1) / column.rowsPerBlock;
+        const std::uint64_t ahead = lastBlock - block < _prefetchBlocks ? lastBlock - block : _prefetchBlocks;
+        _pool->Prefetch(block + 1, static_cast<std::size_t>(ahead));
+      }
+      batch->AddColumn(_pool->PinColumn(block, row * column.elementLength, column.typeId, column.elementLength,
+                                        rows, GiftedBufferPool::kScan));
+    }
+    batch->SetFirstRow(_position);
+    _position += rows;
+    return true;
+  }
+
+private:
+  GiftedBufferPool *_pool;
+  const std::vector<GiftedPooledColumn> _columns;
+  const std::size_t _batchRows;
+  const std::size_t _prefetchBlocks;
+  std::size_t _position;
+};
+
+#endif  // GIFTED_OPERATORS_BUFFER_POOL_SCAN_OPERATOR_HPP_
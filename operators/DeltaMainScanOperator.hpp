@@ -0,0 +1,127 @@
+//
+//  DeltaMainScanOperator.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_OPERATORS_DELTA_MAIN_SCAN_OPERATOR_HPP_
+#define GIFTED_OPERATORS_DELTA_MAIN_SCAN_OPERATOR_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "operators/Operator.hpp"
+#include "storage/ColumnVector.hpp"
+#include "storage/DeltaMainTable.hpp"
+#include "storage/VectorBatch.hpp"
+
+/**
+ * @brief Scans some columns of a GiftedDeltaMainTable snapshot: the union of
+ *        its main blocks, decoded one block per batch, and its delta chunks,
+ *        passed on as views. Batch row numbers run on across both.
+ *
+ *        With SetRangeFilter(), main blocks whose zone maps rule out every
+ *        value of a column in [low, high] are skipped without being
+ *        decoded. This only prunes: a filter on the same range must still
+ *        follow the scan.
+ **/
+class GiftedDeltaMainScanOperator : public GiftedOperator {
+public:
+  GiftedDeltaMainScanOperator(const GiftedDeltaMainTable &table,
+                              const GiftedDeltaMainTable::Snapshot &snapshot,
+                              const std::vector<std::size_t> &columns)
+      : _snapshot(snapshot),
+        _columns(columns),
+        _numTableColumns(table.getNumColumns()),
+        _blockRows(table.getBlockRows()),
+        _next(0),
+        _firstRow(0),
+        _skippedBlocks(0),
+        _hasRange(false),
+        _rangeColumn(0),
+        _low(0),
+        _high(0) {
+    for (std::size_t i = 0; i < columns.size(); i++) {
+      if (columns[i] >= table.getNumColumns()) {
+        throw std::invalid_argument("GiftedDeltaMainScanOperator: no such column");
+      }
+      _types.push_back(table.getTypeId(columns[i]));
+    }
+  }
+
+  /**
+   * @brief Skip main blocks without a value of table column "column" in
+   *        [low, high].
+   *
+   * @exception std::out_of_range if the table has no such column.
+   **/
+  void SetRangeFilter(const std::size_t column, const std::int64_t low, const std::int64_t high) {
+    if (column >= _numTableColumns) {
+      throw std::out_of_range("GiftedDeltaMainScanOperator: no such range filter column");
+    }
+    _hasRange = true;
+    _rangeColumn = column;
+    _low = low;
+    _high = high;
+  }
+
+  /**
+   * @brief Main blocks skipped by the zone maps so far.
+   **/
+  std::size_t getSkippedBlocks() const {return _skippedBlocks;}
+
+  bool Next(GiftedVectorBatch *batch) override {
+    batch->Reset();
+    if (batch->getCapacity() < _blockRows) {
+      throw std::invalid_argument("GiftedDeltaMainScanOperator: batch is smaller than the table's blocks");
+    }
+    while (_next < _snapshot.main.size()) {
+      const GiftedDeltaMainTable::MainBlock &block = *_snapshot.main[_next++];
+      const std::size_t first = _firstRow;
+      _firstRow += block.numRows;
+      if (_hasRange && !block.columns[_rangeColumn].getZoneMap().MayContain(_low, _high)) {
+        _skippedBlocks++;
+        continue;
+      }
+      for (std::size_t i = 0; i < _columns.size(); i++) {
+        const GiftedCompressedColumn &compressed = block.columns[_columns[i]];
+        GiftedColumnVector column(_types[i], compressed.getElementLength(), block.numRows);
+        compressed.Decode(&column);
+        batch->AddColumn(std::move(column));
+      }
+      batch->SetFirstRow(first);
+      return true;
+    }
+    while (_next - _snapshot.main.size() < _snapshot.delta.size()) {
+      const GiftedDeltaMainTable::DeltaChunk &chunk = *_snapshot.delta[_next++ - _snapshot.main.size()];
+      const std::size_t rows = chunk.columns[0].size();
+      if (rows == 0) continue;
+      for (std::size_t i = 0; i < _columns.size(); i++) {
+        batch->AddColumn(chunk.columns[_columns[i]].Slice(0, rows));
+      }
+      batch->SetFirstRow(_firstRow);
+      _firstRow += rows;
+      return true;
+    }
+    return false;
+  }
+
+private:
+  const GiftedDeltaMainTable::Snapshot _snapshot;  // Keeps the blocks alive.
+  const std::vector<std::size_t> _columns;
+  std::vector<GiftedBaseType::GiftedTypeId> _types;
+  const std::size_t _numTableColumns;
+  const std::size_t _blockRows;
+  std::size_t _next;  // Main blocks first, then delta chunks.
+  std::size_t _firstRow;
+  std::size_t _skippedBlocks;
+  bool _hasRange;
+  std::size_t _rangeColumn;
+  std::int64_t _low;
+  std::int64_t _high;
+};
+
+#endif  // GIFTED_OPERATORS_DELTA_MAIN_SCAN_OPERATOR_HPP_
@@ -0,0 +1,138 @@
+//
+//  FilterOperator.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_OPERATORS_FILTER_OPERATOR_HPP_
+#define GIFTED_OPERATORS_FILTER_OPERATOR_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "operators/Operator.hpp"
+#include "storage/ColumnVector.hpp"
+#include "storage/PredicateResultCache.hpp"
+#include "storage/VectorBatch.hpp"
+#include "types/BatchPredicate.hpp"
+#include "types/ColumnPredicate.hpp"
+
+/**
+ * @brief Keeps the rows whose value in one column passes a predicate (e.g. a
+ *        GiftedVectorizedComparison). The predicate runs over the whole batch
+ *        column at once, and the outcome narrows the batch's selection
+ *        vector; values are never moved. Nulls never pass. Batches with no
+ *        rows left are skipped.
+ *
+ *        A filter can test several columns at once instead, with a batch
+ *        predicate (e.g. a GiftedFusedPredicate), in one pass over the
+ *        batch.
+ *
+ *        Over a scan of a sealed block, the predicate's outcomes can be kept
+ *        in a GiftedPredicateResultCache, so running the same filter on the
+ *        block again only copies them back.
+ **/
+class GiftedFilterOperator : public GiftedOperator {
+public:
+  GiftedFilterOperator(std::unique_ptr<GiftedOperator> child,
+                       const std::size_t column,
+                       std::unique_ptr<GiftedColumnPredicate> predicate)
+      : _child(std::move(child)),
+        _column(column),
+        _predicate(std::move(predicate)),
+        _resultCapacity(0),
+        _blockId(0) {}
+
+  GiftedFilterOperator(std::unique_ptr<GiftedOperator> child,
+                       std::unique_ptr<GiftedBatchPredicate> predicate)
+      : _child(std::move(child)),
+        _column(0),
+        _batchPredicate(std::move(predicate)),
+        _resultCapacity(0),
+        _blockId(0) {}
+
+  /**
+   * @brief Cache the predicate's outcomes, keyed by "blockId" and the
+   *        batches' first rows. Only for a filter whose input batches are
+   *        the rows of block "blockId" as scanned (other filters below may
+   *        narrow the selection). Predicates without a cache key are not
+   *        cached.
+   **/
+  void SetResultCache(const std::shared_ptr<GiftedPredicateResultCache> &cache, const std::uint64_t blockId) {
+    _cache = cache;
+    _blockId = blockId;
+    _cacheKey = _batchPredicate ? _batchPredicate->getCacheKey() : _predicate->getCacheKey();
+    if (_cacheKey.empty()) {
+      _cache.reset();
+    } else if (!_batchPredicate) {
+      _cacheKey = std::to_string(_column) + ":" + _cacheKey;
+    }
+  }
+
+  bool Next(GiftedVectorBatch *batch) override {
+    while (_child->Next(batch)) {
+      const std::size_t numRows = batch->getNumRows();
+      if (numRows > _resultCapacity) {
+        _result.reset(new bool[numRows]);
+        _resultCapacity = numRows;
+      }
+      const bool cached = _cache && _cache->Lookup(_blockId, batch->getFirstRow(), _cacheKey, numRows,
+                                                   _result.get());
+      if (_batchPredicate) {
+        if (!cached) {
+          _batchPredicate->Evaluate(*batch, _result.get());
+          if (_cache) _cache->Insert(_blockId, batch->getFirstRow(), _cacheKey, numRows, _result.get());
+        }
+        if (Select(nullptr, batch) > 0) return true;
+        continue;
+      }
+      const GiftedColumnVector &values = batch->getColumn(_column);
+      if (!cached) {
+        _predicate->Evaluate(values, _result.get());
+        if (_cache) _cache->Insert(_blockId, batch->getFirstRow(), _cacheKey, numRows, _result.get());
+      }
+      if (Select(&values, batch) > 0) return true;
+    }
+    return false;
+  }
+
+private:
+  // Narrow the selection to the rows that passed, and are not null in
+  // "values" if given; returns how many did.
+  std::size_t Select(const GiftedColumnVector *values, GiftedVectorBatch *batch) {
+    const bool *result = _result.get();
+    std::uint32_t *selection = batch->getSelectionMutable();
+    std::size_t selected = 0;
+    const bool hasNulls = values != nullptr && values->getValidityBitmap() != nullptr;
+    if (!batch->hasSelection()) {
+      for (std::size_t i = 0; i < batch->getNumRows(); i++) {
+        selection[selected] = static_cast<std::uint32_t>(i);
+        selected += result[i] && !(hasNulls && values->isNull(i));
+      }
+    } else {
+      const std::size_t numSelected = batch->getNumSelected();
+      for (std::size_t i = 0; i < numSelected; i++) {
+        const std::uint32_t row = selection[i];
+        selection[selected] = row;
+        selected += result[row] && !(hasNulls && values->isNull(row));
+      }
+    }
+    batch->SetNumSelected(selected);
+    return selected;
+  }
+
+  std::unique_ptr<GiftedOperator> _child;
+  const std::size_t _column;
+  std::unique_ptr<GiftedColumnPredicate> _predicate;
+  std::unique_ptr<GiftedBatchPredicate> _batchPredicate;
+  std::unique_ptr<bool[]> _result;
+  std::size_t _resultCapacity;
+
+  std::shared_ptr<GiftedPredicateResultCache> _cache;
+  std::uint64_t _blockId;
+  std::string _cacheKey;
+};
+
+#endif  // GIFTED_OPERATORS_FILTER_OPERATOR_HPP_
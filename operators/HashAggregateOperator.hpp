@@ -0,0 +1,558 @@
+//
+//  HashAggregateOperator.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_OPERATORS_HASH_AGGREGATE_OPERATOR_HPP_
+#define GIFTED_OPERATORS_HASH_AGGREGATE_OPERATOR_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "operators/AggregateOperator.hpp"
+#include "operators/Operator.hpp"
+#include "operators/SpillScanOperator.hpp"
+#include "storage/ColumnVector.hpp"
+#include "storage/SpillFile.hpp"
+#include "storage/VectorBatch.hpp"
+#include "types/BaseType.hpp"
+#include "types/TypeRegistry.hpp"
+
+/**
+ * @brief GROUP BY: computes COUNT, SUM, MIN and MAX (typed as in
+ *        GiftedAggregateOperator) per distinct combination of the group
+ *        columns, and produces one row per group: the group columns followed
+ *        by one column per aggregate. Nulls form a group of their own.
+ *        Groups come in no particular order.
+ *
+ *        The groups live in kGiftedSpillFanout hash tables, partitioned on
+ *        the top bits of the group hash. Whenever the tables take more than
+ *        "memoryBytes", the largest is written to a GiftedSpillFile as
+ *        partial results (the group columns, then a count and an int64
+ *        accumulator per aggregate), and so are the later rows of its
+ *        groups. Once the input is read, the groups in memory are produced,
+ *        then each spilled partition is merged by a
+ *        GiftedHashAggregateOperator on the next hash bits, which spills
+ *        again if it has to.
+ **/
+class GiftedHashAggregateOperator : public GiftedOperator {
+public:
+  typedef GiftedAggregateOperator::Aggregate Aggregate;
+
+  GiftedHashAggregateOperator(const GiftedTypeRegistry &registry,
+                              std::unique_ptr<GiftedOperator> child,
+                              const std::vector<std::size_t> &groupColumns,
+                              const std::vector<Aggregate> &aggregates,
+                              const std::size_t memoryBytes = std::numeric_limits<std::size_t>::max(),
+                              const std::string &spillDirectory = GiftedSpillDirectory())
+      : GiftedHashAggregateOperator(registry, std::move(child), groupColumns, aggregates, memoryBytes, spillDirectory,
+                                    0, std::vector<GiftedBaseType::GiftedTypeId>()) {}
+
+  bool Next(GiftedVectorBatch *batch) override {
+    if (!_consumed) Consume(batch);
+    if (NextResident(batch)) return true;
+    if (!_current) NextSpilledPartition();
+    while (_current) {
+      if (_current->Next(batch)) return true;
+      _current.reset();
+      NextSpilledPartition();
+    }
+    batch->Reset();
+    return false;
+  }
+
+  /**
+   * @brief Partitions spilled at this level (once the input is read).
+   **/
+  std::size_t getSpilledPartitions() const {return _numSpilled;}
+
+private:
+  /**
+   * @param valueTypes With partial input, the types of the aggregated
+   *        columns of the original input.
+   **/
+  GiftedHashAggregateOperator(const GiftedTypeRegistry &registry,
+                              std::unique_ptr<GiftedOperator> child,
+                              const std::vector<std::size_t> &groupColumns,
+                              const std::vector<Aggregate> &aggregates,
+                              const std::size_t memoryBytes,
+                              const std::string &spillDirectory,
+                              const unsigned level,
+                              const std::vector<GiftedBaseType::GiftedTypeId> &valueTypes)
+      : _registry(registry),
+        _child(std::move(child)),
+        _groupColumns(groupColumns),
+        _aggregates(aggregates),
+        _memoryBytes(memoryBytes),
+        _spillDirectory(spillDirectory),
+        _level(level),
+        _partial(level > 0),
+        _valueTypes(valueTypes),
+        _consumed(false),
+        _partitions(kGiftedSpillFanout),
+        _numSpilled(0),
+        _partition(0),
+        _position(0),
+        _nextSpilled(0) {
+    if (_groupColumns.empty()) {
+      throw std::invalid_argument("GiftedHashAggregateOperator: no group columns, use a GiftedAggregateOperator");
+    }
+    for (std::size_t a = 0; a < _aggregates.size(); a++) {
+      const GiftedAggregateOperator::AggregateId id = _aggregates[a].aggregate;
+      if (id != GiftedAggregateOperator::kCount && id != GiftedAggregateOperator::kSum &&
+          id != GiftedAggregateOperator::kMin && id != GiftedAggregateOperator::kMax) {
+        throw std::invalid_argument("GiftedHashAggregateOperator: only COUNT, SUM, MIN and MAX are supported");
+      }
+    }
+  }
+
+  // The groups of a partition: their group columns and hashes, a count and
+  // an accumulator per group and aggregate (group-major), and a chained
+  // hash table as in GiftedHashJoinOperator.
+  struct Partition {
+    Partition() : bucketMask(0), bytes(0), spilled(false) {}
+
+    std::size_t getNumGroups() const {return hashes.size();}
+
+    std::vector<GiftedColumnVector> keys;
+    std::vector<std::uint64_t> hashes;
+    std::vector<std::int64_t> counts;
+    std::vector<std::int64_t> values;
+    std::vector<std::uint32_t> buckets;
+    std::vector<std::uint32_t> next;
+    std::size_t bucketMask;
+    std::size_t bytes;
+    bool spilled;
+  };
+
+  /**
+   * @brief Read all the input into the tables and the spill files.
+   **/
+  void Consume(GiftedVectorBatch *batch) {
+    _consumed = true;
+    GiftedSpillPartitions spill(kGiftedSpillFanout, GiftedSpillBatchRows(batch->getCapacity()), _spillDirectory);
+    std::vector<std::vector<std::uint32_t> > positions(kGiftedSpillFanout);
+    while (_child->Next(batch)) {
+      if (_valueTypes.empty()) CheckTypes(*batch);
+      HashGroups(*batch);
+      for (std::size_t p = 0; p < positions.size(); p++) positions[p].clear();
+      for (std::size_t i = 0; i < batch->getNumSelected(); i++) {
+        const std::uint32_t row = batch->hasSelection() ? batch->getSelection()[i] : static_cast<std::uint32_t>(i);
+        const std::size_t p = GiftedSpillPartition(_hashes[row], _level);
+        Partition &partition = _partitions[p];
+        if (partition.spilled) {
+          positions[p].push_back(row);
+          continue;
+        }
+        const std::size_t group = FindOrInsertGroup(&partition, *batch, row);
+        std::int64_t *counts = partition.counts.data() + group * _aggregates.size();
+        std::int64_t *values = partition.values.data() + group * _aggregates.size();
+        for (std::size_t a = 0; a < _aggregates.size(); a++) {
+          if (_partial) {
+            Merge(a, *batch, row, counts + a, values + a);
+          } else {
+            Accumulate(a, *batch, row, counts + a, values + a);
+          }
+        }
+      }
+      for (std::size_t p = 0; p < positions.size(); p++) {
+        if (!positions[p].empty()) SpillRows(&spill, p, *batch, positions[p]);
+      }
+
+      std::size_t bytes = 0;
+      for (std::size_t p = 0; p < _partitions.size(); p++) {
+        if (!_partitions[p].spilled) bytes += UpdateBytes(&_partitions[p]);
+      }
+      while (bytes > _memoryBytes) {
+        const std::size_t spilled = SpillLargestPartition(&spill);
+        if (spilled == 0) break;
+        bytes -= spilled;
+      }
+    }
+    _spillFiles = spill.Finish();
+  }
+
+  /**
+   * @brief Take the types of the aggregated columns from the first batch.
+   **/
+  void CheckTypes(const GiftedVectorBatch &batch) {
+    for (std::size_t a = 0; a < _aggregates.size(); a++) {
+      const GiftedBaseType::GiftedTypeId typeId = batch.getColumn(_aggregates[a].column).getTypeId();
+      if (_aggregates[a].aggregate != GiftedAggregateOperator::kCount &&
+          typeId != GiftedBaseType::_GiftedIntTypeId && typeId != GiftedBaseType::_GiftedInt32TypeId &&
+          typeId != GiftedBaseType::_GiftedDecimalTypeId) {
+        throw std::invalid_argument("GiftedHashAggregateOperator: column type is not numeric");
+      }
+      _valueTypes.push_back(typeId);
+    }
+  }
+
+  /**
+   * @brief Hash the group columns of every row of the batch into _hashes.
+   **/
+  void HashGroups(const GiftedVectorBatch &batch) {
+    const std::size_t numRows = batch.getNumRows();
+    if (_hashes.size() < numRows) {
+      _hashes.resize(numRows);
+      _columnHashes.resize(numRows);
+    }
+    for (std::size_t g = 0; g < _groupColumns.size(); g++) {
+      const GiftedColumnVector &column = batch.getColumn(_groupColumns[g]);
+      std::uint64_t *hashes = g == 0 ? _hashes.data() : _columnHashes.data();
+      column.Hash(Kernels(column), hashes);
+      if (column.getValidityBitmap() != nullptr) {
+        for (std::size_t i = 0; i < numRows; i++) {
+          if (column.isNull(i)) hashes[i] = kNullHash;
+        }
+      }
+      if (g == 0) continue;
+      for (std::size_t i = 0; i < numRows; i++) {
+        _hashes[i] = (_hashes[i] * 0x9e3779b97f4a7c15ULL) ^ _columnHashes[i];
+      }
+    }
+  }
+
+  std::size_t FindOrInsertGroup(Partition *partition, const GiftedVectorBatch &batch, const std::uint32_t row) {
+    const std::uint64_t hash = _hashes[row];
+    if (!partition->buckets.empty()) {
+      for (std::uint32_t chain = partition->buckets[hash & partition->bucketMask]; chain != 0;
+           chain = partition->next[chain - 1]) {
+        if (partition->hashes[chain - 1] == hash && GroupEqual(*partition, chain - 1, batch, row)) return chain - 1;
+      }
+    }
+
+    const std::size_t group = partition->getNumGroups();
+    if (group + 1 >= std::numeric_limits<std::uint32_t>::max()) {
+      throw std::overflow_error("GiftedHashAggregateOperator: too many groups");
+    }
+    if (partition->keys.empty()) {
+      for (std::size_t g = 0; g < _groupColumns.size(); g++) {
+        const GiftedColumnVector &column = batch.getColumn(_groupColumns[g]);
+        partition->keys.push_back(GiftedColumnVector(column.getTypeId(), column.getElementLength(), 64));
+      }
+    }
+    for (std::size_t g = 0; g < _groupColumns.size(); g++) {
+      const GiftedColumnVector &column = batch.getColumn(_groupColumns[g]);
+      partition->keys[g].AppendGathered(column, &row, 1, Kernels(column));
+    }
+    partition->hashes.push_back(hash);
+    for (std::size_t a = 0; a < _aggregates.size(); a++) {
+      partition->counts.push_back(0);
+      partition->values.push_back(InitialValue(_aggregates[a].aggregate));
+    }
+    partition->next.push_back(0);
+    if (2 * partition->getNumGroups() > partition->buckets.size()) {
+      Rehash(partition);
+    } else {
+      std::uint32_t &bucket = partition->buckets[hash & partition->bucketMask];
+      partition->next[group] = bucket;
+      bucket = static_cast<std::uint32_t>(group + 1);
+    }
+    return group;
+  }
+
+  static void Rehash(Partition *partition) {
+    std::size_t numBuckets = 16;
+    while (numBuckets < 4 * partition->getNumGroups()) numBuckets *= 2;
+    partition->bucketMask = numBuckets - 1;
+    partition->buckets.assign(numBuckets, 0);
+    for (std::size_t i = 0; i < partition->getNumGroups(); i++) {
+      std::uint32_t &bucket = partition->buckets[partition->hashes[i] & partition->bucketMask];
+      partition->next[i] = bucket;
+      bucket = static_cast<std::uint32_t>(i + 1);
+    }
+  }
+
+  bool GroupEqual(const Partition &partition,
+                  const std::size_t group,
+                  const GiftedVectorBatch &batch,
+                  const std::uint32_t row) const {
+    for (std::size_t g = 0; g < _groupColumns.size(); g++) {
+      const GiftedColumnVector &key = partition.keys[g];
+      const GiftedColumnVector &column = batch.getColumn(_groupColumns[g]);
+      const bool isNull = column.isNull(row);
+      if (key.isNull(group) != isNull) return false;
+      if (isNull) continue;
+      std::size_t keyLength, length;
+      const char *keyValue = key.getElement(group, &keyLength);
+      const char *value = column.getElement(row, &length);
+      if (keyLength != length || std::memcmp(keyValue, value, length) != 0) return false;
+    }
+    return true;
+  }
+
+  static std::int64_t InitialValue(const GiftedAggregateOperator::AggregateId aggregate) {
+    if (aggregate == GiftedAggregateOperator::kMin) return std::numeric_limits<std::int64_t>::max();
+    if (aggregate == GiftedAggregateOperator::kMax) return std::numeric_limits<std::int64_t>::min();
+    return 0;
+  }
+
+  /**
+   * @brief Value of aggregate "a" in input row "row" as an int64.
+   **/
+  std::int64_t InputValue(const std::size_t a, const GiftedVectorBatch &batch, const std::uint32_t row) const {
+    const GiftedColumnVector &column = batch.getColumn(_aggregates[a].column);
+    if (_valueTypes[a] == GiftedBaseType::_GiftedInt32TypeId) {
+      return reinterpret_cast<const std::int32_t*>(column.getValues())[row];
+    }
+    return reinterpret_cast<const std::int64_t*>(column.getValues())[row];
+  }
+
+  /**
+   * @brief Fold a (count, accumulator) pair into a group's.
+   **/
+  void Fold(const std::size_t a, const std::int64_t count, const std::int64_t value,
+            std::int64_t *groupCount, std::int64_t *groupValue) const {
+    if (count == 0) return;
+    *groupCount += count;
+    switch (_aggregates[a].aggregate) {
+      case GiftedAggregateOperator::kSum:
+        if (__builtin_add_overflow(*groupValue, value, groupValue)) {
+          throw std::overflow_error("GiftedHashAggregateOperator: SUM overflows");
+        }
+        break;
+      case GiftedAggregateOperator::kMin:
+        if (value < *groupValue) *groupValue = value;
+        break;
+      case GiftedAggregateOperator::kMax:
+        if (value > *groupValue) *groupValue = value;
+        break;
+      default:
+        break;
+    }
+  }
+
+  void Accumulate(const std::size_t a, const GiftedVectorBatch &batch, const std::uint32_t row,
+                  std::int64_t *groupCount, std::int64_t *groupValue) const {
+    if (batch.getColumn(_aggregates[a].column).isNull(row)) return;
+    const bool isCount = _aggregates[a].aggregate == GiftedAggregateOperator::kCount;
+    Fold(a, 1, isCount ? 0 : InputValue(a, batch, row), groupCount, groupValue);
+  }
+
+  // Partial input: the group columns, then a count and an accumulator per
+  // aggregate.
+  void Merge(const std::size_t a, const GiftedVectorBatch &batch, const std::uint32_t row,
+             std::int64_t *groupCount, std::int64_t *groupValue) const {
+    const std::size_t column = _groupColumns.size() + 2 * a;
+    Fold(a, reinterpret_cast<const std::int64_t*>(batch.getColumn(column).getValues())[row],
+         reinterpret_cast<const std::int64_t*>(batch.getColumn(column + 1).getValues())[row],
+         groupCount, groupValue);
+  }
+
+  /**
+   * @brief Write the rows at "rows" of the batch to partition p's file, as
+   *        partial results.
+   **/
+  void SpillRows(GiftedSpillPartitions *spill,
+                 const std::size_t p,
+                 const GiftedVectorBatch &batch,
+                 const std::vector<std::uint32_t> &rows) {
+    std::vector<const GiftedColumnVector*> columns;
+    if (_partial) {
+      for (std::size_t c = 0; c < batch.getNumColumns(); c++) columns.push_back(&batch.getColumn(c));
+      spill->AppendGathered(p, columns, rows.data(), rows.size(), _registry);
+      return;
+    }
+
+    std::vector<GiftedColumnVector> partials;
+    for (std::size_t a = 0; a < _aggregates.size(); a++) {
+      GiftedColumnVector counts(GiftedBaseType::_GiftedIntTypeId, sizeof(std::int64_t), rows.size());
+      GiftedColumnVector values(GiftedBaseType::_GiftedIntTypeId, sizeof(std::int64_t), rows.size());
+      std::int64_t *count = reinterpret_cast<std::int64_t*>(counts.AppendFixedSlots(rows.size()));
+      std::int64_t *value = reinterpret_cast<std::int64_t*>(values.AppendFixedSlots(rows.size()));
+      for (std::size_t i = 0; i < rows.size(); i++) {
+        count[i] = 0;
+        value[i] = InitialValue(_aggregates[a].aggregate);
+        Accumulate(a, batch, rows[i], count + i, value + i);
+      }
+      partials.push_back(std::move(counts));
+      partials.push_back(std::move(values));
+    }
+
+    std::vector<GiftedColumnVector> keys;
+    for (std::size_t g = 0; g < _groupColumns.size(); g++) {
+      const GiftedColumnVector &column = batch.getColumn(_groupColumns[g]);
+      keys.push_back(GiftedColumnVector(column.getTypeId(), column.getElementLength(), rows.size()));
+      keys.back().AppendGathered(column, rows.data(), rows.size(), Kernels(column));
+    }
+    for (std::size_t g = 0; g < keys.size(); g++) columns.push_back(&keys[g]);
+    for (std::size_t c = 0; c < partials.size(); c++) columns.push_back(&partials[c]);
+    spill->Append(p, columns);
+  }
+
+  /**
+   * @brief Bytes of the partition's groups and table, now.
+   **/
+  std::size_t UpdateBytes(Partition *partition) const {
+    const std::size_t bytesPerGroup = sizeof(std::uint64_t) + sizeof(std::uint32_t) +
+                                      2 * sizeof(std::int64_t) * _aggregates.size();
+    std::size_t bytes = partition->getNumGroups() * bytesPerGroup + partition->buckets.size() * sizeof(std::uint32_t);
+    for (std::size_t g = 0; g < partition->keys.size(); g++) bytes += GiftedColumnBytes(partition->keys[g]);
+    partition->bytes = bytes;
+    return bytes;
+  }
+
+  /**
+   * @brief Write the partition with the most bytes in memory to its file, as
+   *        partial results, and free it.
+   *
+   * @return The bytes freed; 0 if spilling would not help (no partition
+   *         with more than one group, or no hash bits left).
+   **/
+  std::size_t SpillLargestPartition(GiftedSpillPartitions *spill) {
+    if (_level >= kGiftedMaxSpillLevel) return 0;
+    std::size_t largest = _partitions.size();
+    for (std::size_t p = 0; p < _partitions.size(); p++) {
+      if (_partitions[p].spilled || _partitions[p].getNumGroups() < 2) continue;
+      if (largest == _partitions.size() || _partitions[p].bytes > _partitions[largest].bytes) largest = p;
+    }
+    if (largest == _partitions.size()) return 0;
+
+    Partition &partition = _partitions[largest];
+    const std::size_t numGroups = partition.getNumGroups();
+    std::vector<GiftedColumnVector> partials;
+    for (std::size_t a = 0; a < _aggregates.size(); a++) {
+      GiftedColumnVector counts(GiftedBaseType::_GiftedIntTypeId, sizeof(std::int64_t), numGroups);
+      GiftedColumnVector values(GiftedBaseType::_GiftedIntTypeId, sizeof(std::int64_t), numGroups);
+      std::int64_t *count = reinterpret_cast<std::int64_t*>(counts.AppendFixedSlots(numGroups));
+      std::int64_t *value = reinterpret_cast<std::int64_t*>(values.AppendFixedSlots(numGroups));
+      for (std::size_t i = 0; i < numGroups; i++) {
+        count[i] = partition.counts[i * _aggregates.size() + a];
+        value[i] = partition.values[i * _aggregates.size() + a];
+      }
+      partials.push_back(std::move(counts));
+      partials.push_back(std::move(values));
+    }
+    std::vector<const GiftedColumnVector*> columns;
+    for (std::size_t g = 0; g < partition.keys.size(); g++) columns.push_back(&partition.keys[g]);
+    for (std::size_t c = 0; c < partials.size(); c++) columns.push_back(&partials[c]);
+    spill->Append(largest, columns);
+
+    const std::size_t bytes = partition.bytes;
+    partition = Partition();
+    partition.spilled = true;
+    _numSpilled++;
+    return bytes;
+  }
+
+  /**
+   * @brief The next batch of groups held in memory, a partition at a time;
+   *        a partition is freed once the batch after its last is asked for.
+   **/
+  bool NextResident(GiftedVectorBatch *batch) {
+    batch->Reset();
+    const std::size_t batchRows = GiftedSpillBatchRows(batch->getCapacity());
+    for (; _partition < _partitions.size(); _partition++, _position = 0) {
+      Partition &partition = _partitions[_partition];
+      if (_position >= partition.getNumGroups()) {
+        if (!partition.spilled) partition = Partition();
+        continue;
+      }
+      std::size_t rows = partition.getNumGroups() - _position;
+      if (rows > batchRows) rows = batchRows;
+      for (std::size_t g = 0; g < partition.keys.size(); g++) {
+        batch->AddColumn(partition.keys[g].Slice(_position, rows));
+      }
+      for (std::size_t a = 0; a < _aggregates.size(); a++) {
+        batch->AddColumn(Result(a, partition, _position, rows));
+      }
+      _position += rows;
+      return true;
+    }
+    return false;
+  }
+
+  /**
+   * @brief Aggregate "a" of groups [begin, begin+count) of a partition.
+   **/
+  GiftedColumnVector Result(const std::size_t a,
+                            const Partition &partition,
+                            const std::size_t begin,
+                            const std::size_t count) const {
+    const std::size_t numAggregates = _aggregates.size();
+    if (_aggregates[a].aggregate == GiftedAggregateOperator::kCount) {
+      GiftedColumnVector result(GiftedBaseType::_GiftedIntTypeId, sizeof(std::int64_t), count);
+      std::int64_t *values = reinterpret_cast<std::int64_t*>(result.AppendFixedSlots(count));
+      for (std::size_t i = 0; i < count; i++) values[i] = partition.counts[(begin + i) * numAggregates + a];
+      return result;
+    }
+
+    const bool isInt32 = _valueTypes[a] == GiftedBaseType::_GiftedInt32TypeId;
+    if (isInt32 && _aggregates[a].aggregate != GiftedAggregateOperator::kSum) {
+      GiftedColumnVector result(GiftedBaseType::_GiftedInt32TypeId, sizeof(std::int32_t), count);
+      std::int32_t *values = reinterpret_cast<std::int32_t*>(result.AppendFixedSlots(count));
+      for (std::size_t i = 0; i < count; i++) {
+        values[i] = static_cast<std::int32_t>(partition.values[(begin + i) * numAggregates + a]);
+        if (partition.counts[(begin + i) * numAggregates + a] == 0) result.MarkNull(i);
+      }
+      return result;
+    }
+    GiftedColumnVector result(isInt32 ? GiftedBaseType::_GiftedIntTypeId : _valueTypes[a], sizeof(std::int64_t),
+                              count);
+    std::int64_t *values = reinterpret_cast<std::int64_t*>(result.AppendFixedSlots(count));
+    for (std::size_t i = 0; i < count; i++) {
+      values[i] = partition.values[(begin + i) * numAggregates + a];
+      if (partition.counts[(begin + i) * numAggregates + a] == 0) result.MarkNull(i);
+    }
+    return result;
+  }
+
+  /**
+   * @brief Move _current on to the merge of the next spilled partition.
+   **/
+  void NextSpilledPartition() {
+    for (; _nextSpilled < _spillFiles.size(); _nextSpilled++) {
+      std::shared_ptr<GiftedSpillFile> file;
+      file.swap(_spillFiles[_nextSpilled]);
+      if (!file) continue;
+      std::vector<std::size_t> groupColumns;
+      for (std::size_t g = 0; g < _groupColumns.size(); g++) groupColumns.push_back(g);
+      _current.reset(new GiftedHashAggregateOperator(
+          _registry, std::unique_ptr<GiftedOperator>(new GiftedSpillScanOperator(file)), groupColumns, _aggregates,
+          _memoryBytes, _spillDirectory, _level + 1, _valueTypes));
+      _nextSpilled++;
+      return;
+    }
+  }
+
+  GiftedBaseType* Kernels(const GiftedColumnVector &column) const {
+    return _registry.getEntry(column.getTypeId())->prototype.get();
+  }
+
+  // Hash of a null group value.
+  static const std::uint64_t kNullHash = 0x5bd1e9955bd1e995ULL;
+
+  const GiftedTypeRegistry &_registry;
+  std::unique_ptr<GiftedOperator> _child;
+  const std::vector<std::size_t> _groupColumns;
+  const std::vector<Aggregate> _aggregates;
+  const std::size_t _memoryBytes;
+  const std::string _spillDirectory;
+  const unsigned _level;  // Of recursion: which hash bits partition.
+  const bool _partial;    // The input is spilled partial results.
+  std::vector<GiftedBaseType::GiftedTypeId> _valueTypes;
+
+  bool _consumed;
+  std::vector<Partition> _partitions;
+  std::size_t _numSpilled;
+  std::vector<std::uint64_t> _hashes;
+  std::vector<std::uint64_t> _columnHashes;
+
+  // What is produced next: group _position of partition _partition, then
+  // the merge of each spilled partition from _nextSpilled on.
+  std::size_t _partition;
+  std::size_t _position;
+  std::unique_ptr<GiftedOperator> _current;
+  std::vector<std::shared_ptr<GiftedSpillFile> > _spillFiles;
+  std::size_t _nextSpilled;
+};
+
+#endif  // GIFTED_OPERATORS_HASH_AGGREGATE_OPERATOR_HPP_
@@ -0,0 +1,431 @@
+//
+//  HashJoinOperator.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_OPERATORS_HASH_JOIN_OPERATOR_HPP_
+#define GIFTED_OPERATORS_HASH_JOIN_OPERATOR_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "operators/Operator.hpp"
+#include "operators/RadixPartition.hpp"
+#include "storage/BloomFilter.hpp"
+#include "storage/ColumnVector.hpp"
+#include "storage/VectorBatch.hpp"
+#include "types/BaseType.hpp"
+#include "types/TypeRegistry.hpp"
+#include "utility/CacheInfo.hpp"
+
+/**
+ * @brief Inner equi-join on one key column.
+ *
+ *        On the first call to Next() the build side is read in full, its
+ *        live rows are copied into owned columns, and a chained hash table
+ *        is built over the key hashes (computed a batch at a time with the
+ *        key type's VectorizedHash). If a Bloom filter was given, it is
+ *        filled with the same hashes, for a GiftedBloomFilterPredicate on
+ *        the probe side. The probe side is then streamed: each output row
+ *        is the probe batch's columns followed by the build side's columns.
+ *        Null keys never match. Both keys must have the same type.
+ *
+ *        When the hash table would not fit in the L2 cache, every probe
+ *        would miss it, so the join radix partitions instead: the probe
+ *        side is read in full as well, both sides' (hash, row) pairs are
+ *        partitioned on the low hash bits until each build partition's
+ *        table fits in about half the cache, and the partitions are joined
+ *        pair by pair. Output rows then come in partition order.
+ **/
+class GiftedHashJoinOperator : public GiftedOperator {
+public:
+  enum Partitioning {
+    kAutomatic = 0,  // Partition if the table is larger than the L2 cache.
+    kNoPartitioning,
+    kRadixPartitioning
+  };
+
+  GiftedHashJoinOperator(const GiftedTypeRegistry &registry,
+                         std::unique_ptr<GiftedOperator> build,
+                         const std::size_t buildKey,
+                         std::unique_ptr<GiftedOperator> probe,
+                         const std::size_t probeKey,
+                         const std::shared_ptr<GiftedBlockedBloomFilter> &bloomFilter =
+                             std::shared_ptr<GiftedBlockedBloomFilter>(),
+                         const Partitioning partitioning = kAutomatic)
+      : _registry(registry),
+        _buildChild(std::move(build)),
+        _buildKey(buildKey),
+        _probeChild(std::move(probe)),
+        _probeKey(probeKey),
+        _bloomFilter(bloomFilter),
+        _partitioning(partitioning),
+        _built(false),
+        _bucketMask(0),
+        _probeBatch(kGiftedDefaultBatchRows),
+        _probeRow(0),
+        _chain(0),
+        _inChain(false),
+        _radixBits(0),
+        _partition(0),
+        _partitionBuilt(false),
+        _probePosition(0) {}
+
+  bool Next(GiftedVectorBatch *batch) override {
+    if (!_built) Build(batch->getCapacity());
+    if (_radixBits > 0) return NextPartitioned(batch);
+
+    const std::size_t capacity = batch->getCapacity();
+    _matchProbe.resize(capacity);
+    _matchBuild.resize(capacity);
+    std::size_t matches = 0;
+    while (matches < capacity) {
+      if (_probeRow == _probeBatch.getNumSelected()) {
+        // Output refers to the current probe batch; hand it out first.
+        if (matches > 0) break;
+        if (!_probeChild->Next(&_probeBatch)) return false;
+        HashProbeBatch();
+        _probeRow = 0;
+        _inChain = false;
+        continue;
+      }
+
+      const std::uint32_t row = _probeBatch.hasSelection() ? _probeBatch.getSelection()[_probeRow]
+                                                           : static_cast<std::uint32_t>(_probeRow);
+      const GiftedColumnVector &key = _probeBatch.getColumn(_probeKey);
+      if (!_inChain) {
+        _chain = key.isNull(row) ? 0 : _buckets[_probeHashes[row] & _bucketMask];
+        _inChain = true;
+      }
+      while (_chain != 0 && matches < capacity) {
+        const std::uint32_t buildRow = _chain - 1;
+        if (_buildHashes[buildRow] == _probeHashes[row] && KeysEqual(buildRow, key, row)) {
+          _matchProbe[matches] = row;
+          _matchBuild[matches] = buildRow;
+          matches++;
+        }
+        _chain = _next[buildRow];
+      }
+      if (_chain == 0) {
+        _probeRow++;
+        _inChain = false;
+      }
+    }
+
+    std::vector<const GiftedColumnVector*> probeColumns;
+    for (std::size_t c = 0; c < _probeBatch.getNumColumns(); c++) {
+      probeColumns.push_back(&_probeBatch.getColumn(c));
+    }
+    Emit(probeColumns, matches, batch);
+    return true;
+  }
+
+  /**
+   * @brief Rows on the build side (once built).
+   **/
+  std::size_t getBuildRows() const {return _buildColumns.empty() ? 0 : _buildColumns[0].size();}
+
+  /**
+   * @brief Radix bits the join partitions on (once built), 0 if it does not.
+   **/
+  unsigned getRadixBits() const {return _radixBits;}
+
+private:
+  void Build(const std::size_t batchRows) {
+    _built = true;
+    _probeBatch = GiftedVectorBatch(batchRows);
+    GiftedVectorBatch input(batchRows);
+    while (_buildChild->Next(&input)) {
+      if (_buildColumns.empty()) {
+        for (std::size_t c = 0; c < input.getNumColumns(); c++) {
+          _buildColumns.push_back(GiftedColumnVector(input.getColumn(c).getTypeId(),
+                                                     input.getColumn(c).getElementLength()));
+        }
+      }
+      for (std::size_t c = 0; c < input.getNumColumns(); c++) {
+        if (input.hasSelection()) {
+          _buildColumns[c].AppendGathered(input.getColumn(c), input.getSelection(), input.getNumSelected(),
+                                          Kernels(input.getColumn(c)));
+        } else {
+          _buildColumns[c].AppendColumn(input.getColumn(c));
+        }
+      }
+    }
+
+    const std::size_t numRows = getBuildRows();
+    if (numRows >= std::numeric_limits<std::uint32_t>::max()) {
+      throw std::overflow_error("GiftedHashJoinOperator: build side is too large");
+    }
+    const std::size_t cacheBytes = GiftedL2CacheBytes();
+    const std::size_t tableBytes = numRows == 0 ? 0 : numRows * BytesPerBuildRow();
+    if (_partitioning == kRadixPartitioning ||
+        (_partitioning == kAutomatic && tableBytes > cacheBytes)) {
+      unsigned bits = 1;
+      while (bits < kMaxRadixBits && (tableBytes >> bits) > cacheBytes / 2) bits++;
+      BuildPartitioned(bits, batchRows);
+      return;
+    }
+
+    std::size_t numBuckets = 16;
+    while (numBuckets < 2 * numRows) numBuckets *= 2;
+    _bucketMask = numBuckets - 1;
+    _buckets.assign(numBuckets, 0);
+    _next.resize(numRows);
+    _buildHashes.resize(numRows);
+    if (_bloomFilter) _bloomFilter->Reset(numRows);
+    if (numRows == 0) return;
+
+    const GiftedColumnVector &key = _buildColumns[_buildKey];
+    key.Hash(Kernels(key), _buildHashes.data());
+    for (std::size_t i = 0; i < numRows; i++) {
+      if (key.isNull(i)) continue;
+      std::uint32_t &bucket = _buckets[_buildHashes[i] & _bucketMask];
+      _next[i] = bucket;
+      bucket = static_cast<std::uint32_t>(i + 1);
+      if (_bloomFilter) _bloomFilter->Insert(_buildHashes[i]);
+    }
+  }
+
+  /**
+   * @brief Hash table bytes per build row: the key, its hash, a chain link
+   *        and two bucket slots.
+   **/
+  std::size_t BytesPerBuildRow() const {
+    const std::size_t keyLength = _buildColumns[_buildKey].getElementLength();
+    return (keyLength > 0 ? keyLength : 16) + sizeof(std::uint64_t) + 3 * sizeof(std::uint32_t);
+  }
+
+  /**
+   * @brief The partitioned build: hash the build side (filling the Bloom
+   *        filter), then read and hash the probe side in full, and partition
+   *        the (hash, row) pairs of both on the low "bits" hash bits.
+   **/
+  void BuildPartitioned(const unsigned bits, const std::size_t batchRows) {
+    _radixBits = bits;
+    const std::size_t numRows = getBuildRows();
+    if (_bloomFilter) _bloomFilter->Reset(numRows);
+    if (numRows > 0) {
+      const GiftedColumnVector &key = _buildColumns[_buildKey];
+      _buildHashes.resize(numRows);
+      key.Hash(Kernels(key), _buildHashes.data());
+      for (std::size_t i = 0; i < numRows; i++) {
+        if (key.isNull(i)) continue;
+        const GiftedHashedRow entry = {_buildHashes[i], static_cast<std::uint32_t>(i), 0};
+        _buildRows.push_back(entry);
+        if (_bloomFilter) _bloomFilter->Insert(_buildHashes[i]);
+      }
+    }
+    // The hashes live in _buildRows now.
+    std::vector<std::uint64_t>().swap(_buildHashes);
+
+    GiftedVectorBatch input(batchRows);
+    while (_probeChild->Next(&input)) {
+      if (_probeColumns.empty()) {
+        for (std::size_t c = 0; c < input.getNumColumns(); c++) {
+          _probeColumns.push_back(GiftedColumnVector(input.getColumn(c).getTypeId(),
+                                                     input.getColumn(c).getElementLength()));
+        }
+      }
+      for (std::size_t c = 0; c < input.getNumColumns(); c++) {
+        if (input.hasSelection()) {
+          _probeColumns[c].AppendGathered(input.getColumn(c), input.getSelection(), input.getNumSelected(),
+                                          Kernels(input.getColumn(c)));
+        } else {
+          _probeColumns[c].AppendColumn(input.getColumn(c));
+        }
+      }
+    }
+    if (!_probeColumns.empty()) {
+      const GiftedColumnVector &key = _probeColumns[_probeKey];
+      if (!_buildColumns.empty() && key.getTypeId() != _buildColumns[_buildKey].getTypeId()) {
+        throw std::invalid_argument("GiftedHashJoinOperator: join keys differ in type, cast first");
+      }
+      if (key.size() >= std::numeric_limits<std::uint32_t>::max()) {
+        throw std::overflow_error("GiftedHashJoinOperator: probe side is too large");
+      }
+      _probeHashes.resize(key.size());
+      key.Hash(Kernels(key), _probeHashes.data());
+      for (std::size_t i = 0; i < key.size(); i++) {
+        if (key.isNull(i)) continue;
+        const GiftedHashedRow entry = {_probeHashes[i], static_cast<std::uint32_t>(i), 0};
+        _probeRows.push_back(entry);
+      }
+      std::vector<std::uint64_t>().swap(_probeHashes);
+    }
+
+    std::vector<GiftedHashedRow> scratch;
+    GiftedRadixPartition(&_buildRows, &scratch, bits, &_buildStarts);
+    GiftedRadixPartition(&_probeRows, &scratch, bits, &_probeStarts);
+  }
+
+  /**
+   * @brief Chained table over build partition "partition", on the hash bits
+   *        above the partition bits; entries are 1 + the position in the
+   *        partition, as in the unpartitioned table.
+   **/
+  void BuildPartition(const std::size_t partition) {
+    const std::size_t begin = _buildStarts[partition];
+    const std::size_t numRows = _buildStarts[partition + 1] - begin;
+    std::size_t numBuckets = 16;
+    while (numBuckets < 2 * numRows) numBuckets *= 2;
+    _bucketMask = numBuckets - 1;
+    _buckets.assign(numBuckets, 0);
+    _next.resize(numRows);
+    for (std::size_t i = 0; i < numRows; i++) {
+      std::uint32_t &bucket = _buckets[(_buildRows[begin + i].hash >> _radixBits) & _bucketMask];
+      _next[i] = bucket;
+      bucket = static_cast<std::uint32_t>(i + 1);
+    }
+  }
+
+  bool NextPartitioned(GiftedVectorBatch *batch) {
+    const std::size_t capacity = batch->getCapacity();
+    _matchProbe.resize(capacity);
+    _matchBuild.resize(capacity);
+    std::size_t matches = 0;
+    const std::size_t numPartitions = _buildStarts.size() - 1;
+    while (matches < capacity && _partition < numPartitions) {
+      const std::size_t buildBegin = _buildStarts[_partition];
+      if (!_partitionBuilt) {
+        // Nothing can match in a partition without build rows.
+        if (_buildStarts[_partition + 1] == buildBegin) {
+          _partition++;
+          continue;
+        }
+        BuildPartition(_partition);
+        _probePosition = _probeStarts[_partition];
+        _inChain = false;
+        _partitionBuilt = true;
+      }
+      if (_probePosition == _probeStarts[_partition + 1]) {
+        _partition++;
+        _partitionBuilt = false;
+        continue;
+      }
+
+      const GiftedHashedRow &probe = _probeRows[_probePosition];
+      if (!_inChain) {
+        _chain = _buckets[(probe.hash >> _radixBits) & _bucketMask];
+        _inChain = true;
+      }
+      while (_chain != 0 && matches < capacity) {
+        const GiftedHashedRow &build = _buildRows[buildBegin + _chain - 1];
+        if (build.hash == probe.hash && KeysEqual(build.row, _probeColumns[_probeKey], probe.row)) {
+          _matchProbe[matches] = probe.row;
+          _matchBuild[matches] = build.row;
+          matches++;
+        }
+        _chain = _next[_chain - 1];
+      }
+      if (_chain == 0) {
+        _probePosition++;
+        _inChain = false;
+      }
+    }
+    if (matches == 0) return false;
+
+    std::vector<const GiftedColumnVector*> probeColumns;
+    for (std::size_t c = 0; c < _probeColumns.size(); c++) {
+      probeColumns.push_back(&_probeColumns[c]);
+    }
+    Emit(probeColumns, matches, batch);
+    return true;
+  }
+
+  void HashProbeBatch() {
+    const GiftedColumnVector &key = _probeBatch.getColumn(_probeKey);
+    if (!_buildColumns.empty() && key.getTypeId() != _buildColumns[_buildKey].getTypeId()) {
+      throw std::invalid_argument("GiftedHashJoinOperator: join keys differ in type, cast first");
+    }
+    if (_probeHashes.size() < key.size()) _probeHashes.resize(key.size());
+    key.Hash(Kernels(key), _probeHashes.data());
+  }
+
+  bool KeysEqual(const std::uint32_t buildRow, const GiftedColumnVector &probeKey, const std::uint32_t probeRow) const {
+    std::size_t buildLength, probeLength;
+    const char *buildValue = _buildColumns[_buildKey].getElement(buildRow, &buildLength);
+    const char *probeValue = probeKey.getElement(probeRow, &probeLength);
+    return buildLength == probeLength && std::memcmp(buildValue, probeValue, buildLength) == 0;
+  }
+
+  void Emit(const std::vector<const GiftedColumnVector*> &probeColumns,
+            const std::size_t matches,
+            GiftedVectorBatch *batch) {
+    const std::size_t numProbe = probeColumns.size();
+    const std::size_t numOutput = numProbe + _buildColumns.size();
+    while (_output.size() < numOutput) {
+      const GiftedColumnVector &like = _output.size() < numProbe ? *probeColumns[_output.size()]
+                                                                 : _buildColumns[_output.size() - numProbe];
+      _output.push_back(GiftedColumnVector(like.getTypeId(), like.getElementLength()));
+    }
+
+    batch->Reset();
+    for (std::size_t c = 0; c < numOutput; c++) {
+      const bool fromProbe = c < numProbe;
+      const GiftedColumnVector &input = fromProbe ? *probeColumns[c] : _buildColumns[c - numProbe];
+      _output[c].Clear();
+      _output[c].AppendGathered(input, fromProbe ? _matchProbe.data() : _matchBuild.data(), matches,
+                                Kernels(input));
+      batch->AddColumn(_output[c].Slice(0, matches));
+    }
+  }
+
+  GiftedBaseType* Kernels(const GiftedColumnVector &column) const {
+    return _registry.getEntry(column.getTypeId())->prototype.get();
+  }
+
+  const GiftedTypeRegistry &_registry;
+  std::unique_ptr<GiftedOperator> _buildChild;
+  const std::size_t _buildKey;
+  std::unique_ptr<GiftedOperator> _probeChild;
+  const std::size_t _probeKey;
+  std::shared_ptr<GiftedBlockedBloomFilter> _bloomFilter;
+  const Partitioning _partitioning;
+
+  // 2^16 partitions is two passes, and plenty for any build side that fits
+  // in memory.
+  static const unsigned kMaxRadixBits = 16;
+
+  // The build side and its hash table: _buckets holds 1 + the first row of
+  // each chain, _next[row] 1 + the next row (0 ends a chain).
+  bool _built;
+  std::vector<GiftedColumnVector> _buildColumns;
+  std::vector<std::uint64_t> _buildHashes;
+  std::vector<std::uint32_t> _buckets;
+  std::vector<std::uint32_t> _next;
+  std::size_t _bucketMask;
+
+  // Where the probe stopped: row _probeRow (of the selection) of
+  // _probeBatch, at chain entry _chain.
+  GiftedVectorBatch _probeBatch;
+  std::vector<std::uint64_t> _probeHashes;
+  std::size_t _probeRow;
+  std::uint32_t _chain;
+  bool _inChain;
+
+  // The partitioned join (_radixBits > 0): both sides' (hash, row) pairs in
+  // partition order, with the partition boundaries, the materialized probe
+  // side, and where the probe stopped: _probePosition in partition
+  // _partition, at chain entry _chain.
+  unsigned _radixBits;
+  std::vector<GiftedHashedRow> _buildRows;
+  std::vector<std::size_t> _buildStarts;
+  std::vector<GiftedHashedRow> _probeRows;
+  std::vector<std::size_t> _probeStarts;
+  std::vector<GiftedColumnVector> _probeColumns;
+  std::size_t _partition;
+  bool _partitionBuilt;
+  std::size_t _probePosition;
+
+  std::vector<std::uint32_t> _matchProbe;
+  std::vector<std::uint32_t> _matchBuild;
+  std::vector<GiftedColumnVector> _output;
+};
+
+#endif  // GIFTED_OPERATORS_HASH_JOIN_OPERATOR_HPP_
@@ -0,0 +1,286 @@
+//
+//  MergeJoinOperator.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_OPERATORS_MERGE_JOIN_OPERATOR_HPP_
+#define GIFTED_OPERATORS_MERGE_JOIN_OPERATOR_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "operators/Operator.hpp"
+#include "storage/ColumnVector.hpp"
+#include "storage/NormalizedKeys.hpp"
+#include "storage/VectorBatch.hpp"
+#include "types/BaseType.hpp"
+#include "types/TypeRegistry.hpp"
+
+/**
+ * @brief Inner equi-join of two inputs that are both sorted on their join
+ *        keys, ascending, in the order LessThan gives (nulls anywhere).
+ *
+ *        Nothing is hashed and neither side is read in full: each batch's
+ *        keys are turned into normalized keys (see GiftedNormalizeKeys), so
+ *        a multi-column key compares with one memcmp, and two cursors
+ *        advance through them. A cursor that is behind gallops: it tries
+ *        1, 2, 4, ... keys ahead and then binary searches, so it skips a
+ *        long run of unmatched keys in a logarithmic number of comparisons,
+ *        and still steps one key at a time when both sides are dense.
+ *
+ *        For each key that matches, the right side's rows with that key
+ *        (the group) are copied out, even if they span batches, and every
+ *        left row with the key is paired with all of them. Each output row
+ *        is the left batch's columns followed by the right side's columns.
+ *        Only the group is held in memory, not a whole side.
+ **/
+class GiftedMergeJoinOperator : public GiftedOperator {
+public:
+  GiftedMergeJoinOperator(const GiftedTypeRegistry &registry,
+                          std::unique_ptr<GiftedOperator> left,
+                          const std::vector<std::size_t> &leftKeys,
+                          std::unique_ptr<GiftedOperator> right,
+                          const std::vector<std::size_t> &rightKeys)
+      : _registry(registry),
+        _left(std::move(left), leftKeys),
+        _right(std::move(right), rightKeys),
+        _started(false),
+        _done(false),
+        _groupActive(false),
+        _groupSize(0),
+        _groupPosition(0) {
+    if (leftKeys.empty() || leftKeys.size() != rightKeys.size()) {
+      throw std::invalid_argument("GiftedMergeJoinOperator: need as many left keys as right keys");
+    }
+  }
+
+  bool Next(GiftedVectorBatch *batch) override {
+    if (!_started) {
+      _started = true;
+      _left.batch = GiftedVectorBatch(batch->getCapacity());
+      _right.batch = GiftedVectorBatch(batch->getCapacity());
+    }
+
+    const std::size_t capacity = batch->getCapacity();
+    _matchLeft.resize(capacity);
+    _matchGroup.resize(capacity);
+    std::size_t matches = 0;
+    while (matches < capacity && !_done) {
+      if (_left.position == _left.rows.size()) {
+        // Output refers to the current left batch; hand it out first.
+        if (matches > 0) break;
+        if (!Refill(&_left)) {
+          _done = true;
+          break;
+        }
+      }
+      std::size_t leftLength;
+      const char *leftKey = _left.keys.getElement(_left.position, &leftLength);
+
+      if (_groupActive) {
+        if (GiftedCompareNormalizedKeys(leftKey, leftLength, _groupKey.data(), _groupKey.size()) == 0) {
+          const std::uint32_t leftRow = _left.rows[_left.position];
+          while (_groupPosition < _groupSize && matches < capacity) {
+            _matchLeft[matches] = leftRow;
+            _matchGroup[matches] = static_cast<std::uint32_t>(_groupPosition++);
+            matches++;
+          }
+          if (_groupPosition == _groupSize) {
+            _left.position++;
+            _groupPosition = 0;
+          }
+          continue;
+        }
+        _groupActive = false;
+      }
+
+      if (_right.position == _right.rows.size() && !Refill(&_right)) {
+        _done = true;
+        break;
+      }
+      CheckKeyTypes();
+      std::size_t rightLength;
+      const char *rightKey = _right.keys.getElement(_right.position, &rightLength);
+      const int order = GiftedCompareNormalizedKeys(leftKey, leftLength, rightKey, rightLength);
+      if (order < 0) {
+        _left.position = Gallop(_left, rightKey, rightLength, false);
+      } else if (order > 0) {
+        _right.position = Gallop(_right, leftKey, leftLength, false);
+      } else {
+        // Output refers to the current group; hand it out first.
+        if (matches > 0) break;
+        _groupKey.assign(leftKey, leftLength);
+        CollectGroup();
+      }
+    }
+    if (matches == 0) return false;
+
+    Emit(matches, batch);
+    return true;
+  }
+
+private:
+  // One input, with the normalized keys of its current batch.
+  struct Cursor {
+    Cursor(std::unique_ptr<GiftedOperator> child, const std::vector<std::size_t> &keyColumns)
+        : child(std::move(child)),
+          keyColumns(keyColumns),
+          batch(kGiftedDefaultBatchRows),
+          keys(GiftedBaseType::_GiftedVarCharTypeId, 0),
+          position(0),
+          exhausted(false) {}
+
+    std::unique_ptr<GiftedOperator> child;
+    const std::vector<std::size_t> keyColumns;
+    GiftedVectorBatch batch;
+    std::vector<std::uint32_t> rows;  // Batch rows with non-null keys.
+    GiftedColumnVector keys;          // Their normalized keys.
+    std::size_t position;             // Into rows and keys.
+    bool exhausted;
+  };
+
+  /**
+   * @brief Move "cursor" to the next batch with a row to join.
+   *
+   * @return false at the end of the input.
+   **/
+  bool Refill(Cursor *cursor) {
+    cursor->position = 0;
+    cursor->rows.clear();
+    while (!cursor->exhausted && cursor->rows.empty()) {
+      if (!cursor->child->Next(&cursor->batch)) {
+        cursor->exhausted = true;
+        break;
+      }
+      GiftedNormalizeKeys(_registry, cursor->batch, cursor->keyColumns, &cursor->rows, &cursor->keys);
+    }
+    return !cursor->rows.empty();
+  }
+
+  /**
+   * @brief First position from the cursor's on whose key is not less than
+   *        "key" (or, if "past", not less or equal), or the end of the
+   *        batch's keys. Galloping, then a binary search.
+   **/
+  static std::size_t Gallop(const Cursor &cursor, const char *key, const std::size_t keyLength, const bool past) {
+    const std::size_t end = cursor.rows.size();
+    std::size_t low = cursor.position;
+    if (low == end || !Before(cursor, low, key, keyLength, past)) return low;
+    // Keys at "low" are before "key"; the answer is in (low, high].
+    std::size_t step = 1;
+    std::size_t high = low + step;
+    while (high < end && Before(cursor, high, key, keyLength, past)) {
+      low = high;
+      step *= 2;
+      high = low + step;
+    }
+    if (high > end) high = end;
+    while (low + 1 < high) {
+      const std::size_t middle = low + (high - low) / 2;
+      if (Before(cursor, middle, key, keyLength, past)) {
+        low = middle;
+      } else {
+        high = middle;
+      }
+    }
+    return high;
+  }
+
+  static bool Before(const Cursor &cursor, const std::size_t position,
+                     const char *key, const std::size_t keyLength, const bool orEqual) {
+    std::size_t length;
+    const char *value = cursor.keys.getElement(position, &length);
+    const int order = GiftedCompareNormalizedKeys(value, length, key, keyLength);
+    return orEqual ? order <= 0 : order < 0;
+  }
+
+  /**
+   * @brief Copy the right side's rows with key _groupKey, from the right
+   *        cursor on, into the group, leaving the cursor just past them.
+   **/
+  void CollectGroup() {
+    const GiftedVectorBatch &batch = _right.batch;
+    if (_group.empty()) {
+      for (std::size_t c = 0; c < batch.getNumColumns(); c++) {
+        _group.push_back(GiftedColumnVector(batch.getColumn(c).getTypeId(),
+                                            batch.getColumn(c).getElementLength()));
+      }
+    }
+    for (std::size_t c = 0; c < _group.size(); c++) _group[c].Clear();
+    _groupSize = 0;
+    while (true) {
+      const std::size_t end = Gallop(_right, _groupKey.data(), _groupKey.size(), true);
+      for (std::size_t c = 0; c < _group.size(); c++) {
+        _group[c].AppendGathered(batch.getColumn(c), _right.rows.data() + _right.position,
+                                 end - _right.position, Kernels(batch.getColumn(c)));
+      }
+      _groupSize += end - _right.position;
+      _right.position = end;
+      // The group may go on in the next batch.
+      if (end < _right.rows.size() || !Refill(&_right)) break;
+    }
+    _groupActive = true;
+    _groupPosition = 0;
+  }
+
+  void CheckKeyTypes() {
+    if (!_keyTypes.empty()) return;
+    for (std::size_t k = 0; k < _left.keyColumns.size(); k++) {
+      const GiftedBaseType::GiftedTypeId type = _left.batch.getColumn(_left.keyColumns[k]).getTypeId();
+      if (type != _right.batch.getColumn(_right.keyColumns[k]).getTypeId()) {
+        throw std::invalid_argument("GiftedMergeJoinOperator: join keys differ in type, cast first");
+      }
+      _keyTypes.push_back(type);
+    }
+  }
+
+  void Emit(const std::size_t matches, GiftedVectorBatch *batch) {
+    const std::size_t numLeft = _left.batch.getNumColumns();
+    const std::size_t numOutput = numLeft + _group.size();
+    while (_output.size() < numOutput) {
+      const GiftedColumnVector &like = _output.size() < numLeft ? _left.batch.getColumn(_output.size())
+                                                                : _group[_output.size() - numLeft];
+      _output.push_back(GiftedColumnVector(like.getTypeId(), like.getElementLength()));
+    }
+
+    batch->Reset();
+    for (std::size_t c = 0; c < numOutput; c++) {
+      const bool fromLeft = c < numLeft;
+      const GiftedColumnVector &input = fromLeft ? _left.batch.getColumn(c) : _group[c - numLeft];
+      _output[c].Clear();
+      _output[c].AppendGathered(input, fromLeft ? _matchLeft.data() : _matchGroup.data(), matches,
+                                Kernels(input));
+      batch->AddColumn(_output[c].Slice(0, matches));
+    }
+  }
+
+  GiftedBaseType* Kernels(const GiftedColumnVector &column) const {
+    return _registry.getEntry(column.getTypeId())->prototype.get();
+  }
+
+  const GiftedTypeRegistry &_registry;
+  Cursor _left;
+  Cursor _right;
+  bool _started;
+  bool _done;
+  std::vector<GiftedBaseType::GiftedTypeId> _keyTypes;
+
+  // The right side's rows with key _groupKey, and where the current left
+  // row's pairing with them stopped.
+  bool _groupActive;
+  std::string _groupKey;
+  std::vector<GiftedColumnVector> _group;
+  std::size_t _groupSize;
+  std::size_t _groupPosition;
+
+  std::vector<std::uint32_t> _matchLeft;
+  std::vector<std::uint32_t> _matchGroup;
+  std::vector<GiftedColumnVector> _output;
+};
+
+#endif  // GIFTED_OPERATORS_MERGE_JOIN_OPERATOR_HPP_
@@ -0,0 +1,31 @@
+//
+//  Operator.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_OPERATORS_OPERATOR_HPP_
+#define GIFTED_OPERATORS_OPERATOR_HPP_
+
+#include "storage/VectorBatch.hpp"
+
+/**
+ * @brief A pull based operator. Each call to Next() produces the next batch
+ *        of the operator's output, so a pipeline of operators (scan, filter,
+ *        project, aggregate, ...) works on one cache resident batch at a
+ *        time and never materializes a whole intermediate column.
+ **/
+class GiftedOperator {
+public:
+  virtual ~GiftedOperator() {}
+
+  /**
+   * @brief Fill "batch" with the next output. The batch stays valid until
+   *        the next call.
+   *
+   * @return false when there is no more output.
+   **/
+  virtual bool Next(GiftedVectorBatch *batch) = 0;
+};
+
+#endif  // GIFTED_OPERATORS_OPERATOR_HPP_
@@ -0,0 +1,65 @@
+//
+//  PaxScanOperator.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_OPERATORS_PAX_SCAN_OPERATOR_HPP_
+#define GIFTED_OPERATORS_PAX_SCAN_OPERATOR_HPP_
+
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include "operators/Operator.hpp"
+#include "storage/PaxBlock.hpp"
+#include "storage/VectorBatch.hpp"
+
+/**
+ * @brief Scans some columns of a sequence of GiftedPaxBlocks, one batch per
+ *        block. The batch's columns are views over the blocks' minipages,
+ *        so nothing is copied and the other columns' minipages are never
+ *        read; the blocks must outlive the pipeline. Batch row numbers run
+ *        on across the blocks.
+ **/
+class GiftedPaxScanOperator : public GiftedOperator {
+public:
+  GiftedPaxScanOperator(const std::vector<const GiftedPaxBlock*> &blocks, const std::vector<std::size_t> &columns)
+      : _blocks(blocks),
+        _columns(columns),
+        _block(0),
+        _firstRow(0) {
+    for (std::size_t b = 0; b < _blocks.size(); b++) {
+      for (std::size_t i = 0; i < _columns.size(); i++) {
+        if (_columns[i] >= _blocks[b]->getNumColumns() ||
+            _blocks[b]->getTypeId(_columns[i]) != _blocks[0]->getTypeId(_columns[i])) {
+          throw std::invalid_argument("GiftedPaxScanOperator: blocks differ in their columns");
+        }
+      }
+    }
+  }
+
+  bool Next(GiftedVectorBatch *batch) override {
+    batch->Reset();
+    while (_block < _blocks.size() && _blocks[_block]->size() == 0) _block++;
+    if (_block >= _blocks.size()) return false;
+    const GiftedPaxBlock *block = _blocks[_block++];
+    if (batch->getCapacity() < block->size()) {
+      throw std::invalid_argument("GiftedPaxScanOperator: batch is smaller than a block");
+    }
+    for (std::size_t i = 0; i < _columns.size(); i++) {
+      batch->AddColumn(block->getColumn(_columns[i]));
+    }
+    batch->SetFirstRow(_firstRow);
+    _firstRow += block->size();
+    return true;
+  }
+
+private:
+  const std::vector<const GiftedPaxBlock*> _blocks;
+  const std::vector<std::size_t> _columns;
+  std::size_t _block;
+  std::size_t _firstRow;
+};
+
+#endif  // GIFTED_OPERATORS_PAX_SCAN_OPERATOR_HPP_
@@ -0,0 +1,111 @@
+//
+//  ProjectOperator.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_OPERATORS_PROJECT_OPERATOR_HPP_
+#define GIFTED_OPERATORS_PROJECT_OPERATOR_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "operators/Operator.hpp"
+#include "storage/ColumnVector.hpp"
+#include "storage/VectorBatch.hpp"
+#include "types/BaseType.hpp"
+#include "types/TypeRegistry.hpp"
+
+/**
+ * @brief Keeps some of the columns of each batch, in a given order.
+ *
+ *        By default the columns are handed on as they are, with the
+ *        selection untouched. In late materialization mode the output is
+ *        compacted instead: the kept batch columns are gathered down to the
+ *        selected rows, and further columns of the scanned table, which the
+ *        scan did not produce, are fetched for the selected rows only. A
+ *        selective filter then only pays for the rows it lets through.
+ **/
+class GiftedProjectOperator : public GiftedOperator {
+public:
+  GiftedProjectOperator(std::unique_ptr<GiftedOperator> child,
+                        const std::vector<std::size_t> &columns)
+      : _child(std::move(child)), _columns(columns), _registry(nullptr) {}
+
+  /**
+   * @brief Late materialization mode.
+   *
+   * @param columns Batch columns to keep; they come first in the output.
+   * @param tableColumns Columns of the table the scan below reads (by the
+   *        batches' first row), appended after "columns". Must outlive the
+   *        pipeline.
+   **/
+  GiftedProjectOperator(std::unique_ptr<GiftedOperator> child,
+                        const GiftedTypeRegistry &registry,
+                        const std::vector<std::size_t> &columns,
+                        const std::vector<const GiftedColumnVector*> &tableColumns)
+      : _child(std::move(child)),
+        _columns(columns),
+        _tableColumns(tableColumns),
+        _registry(&registry) {}
+
+  bool Next(GiftedVectorBatch *batch) override {
+    if (!_child->Next(batch)) return false;
+    if (_registry == nullptr) {
+      batch->ProjectColumns(_columns);
+      return true;
+    }
+
+    std::vector<GiftedColumnVector> output;
+    output.reserve(_columns.size() + _tableColumns.size());
+    for (std::size_t i = 0; i < _columns.size(); i++) {
+      GiftedColumnVector &column = batch->getColumnMutable(_columns[i]);
+      if (batch->hasSelection() || column.isView()) {
+        output.push_back(Materialize(*batch, column, i));
+        continue;
+      }
+      // A column the batch owns moves to the output, as SetColumns frees the
+      // input columns; a column kept twice is a view of its first copy.
+      const std::size_t first = std::find(_columns.begin(), _columns.begin() + i, _columns[i]) - _columns.begin();
+      output.push_back(first < i ? output[first].Slice(0, output[first].size()) : std::move(column));
+    }
+    for (std::size_t i = 0; i < _tableColumns.size(); i++) {
+      const GiftedColumnVector rows = _tableColumns[i]->Slice(batch->getFirstRow(), batch->getNumRows());
+      output.push_back(Materialize(*batch, rows, _columns.size() + i));
+    }
+    batch->SetColumns(&output);
+    batch->ClearSelection();
+    return true;
+  }
+
+private:
+  // The selected rows of "column", as a view valid until the next batch.
+  // Without a selection "column" must itself be a view.
+  GiftedColumnVector Materialize(const GiftedVectorBatch &batch,
+                                 const GiftedColumnVector &column,
+                                 const std::size_t outputColumn) {
+    if (!batch.hasSelection()) return column.Slice(0, column.size());
+
+    while (_gathered.size() <= outputColumn) {
+      _gathered.push_back(GiftedColumnVector(column.getTypeId(), column.getElementLength()));
+    }
+    GiftedColumnVector &gathered = _gathered[outputColumn];
+    if (gathered.getTypeId() != column.getTypeId()) {
+      gathered = GiftedColumnVector(column.getTypeId(), column.getElementLength());
+    }
+    gathered.Clear();
+    gathered.AppendGathered(column, batch.getSelection(), batch.getNumSelected(),
+                            _registry->getEntry(column.getTypeId())->prototype.get());
+    return gathered.Slice(0, gathered.size());
+  }
+
+  std::unique_ptr<GiftedOperator> _child;
+  const std::vector<std::size_t> _columns;
+  const std::vector<const GiftedColumnVector*> _tableColumns;
+  const GiftedTypeRegistry *_registry; // Set in late materialization mode.
+  std::vector<GiftedColumnVector> _gathered; // Compacted output columns.
+};
+
+#endif  // GIFTED_OPERATORS_PROJECT_OPERATOR_HPP_
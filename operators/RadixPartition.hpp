@@ -0,0 +1,137 @@
+//
+//  RadixPartition.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_OPERATORS_RADIX_PARTITION_HPP_
+#define GIFTED_OPERATORS_RADIX_PARTITION_HPP_
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "utility/AlignedBuffer.hpp"
+
+/**
+ * @brief What the radix partitioner moves around: a row's key hash and its
+ *        position in the (materialized) input. Four fit in a cache line.
+ **/
+struct alignas(16) GiftedHashedRow {
+  std::uint64_t hash;
+  std::uint32_t row;
+  std::uint32_t padding;
+};
+
+// Partition bits taken per pass: 2^8 output streams keep the write
+// combining buffers in L1 and the destinations within reach of the TLB.
+static const unsigned kGiftedRadixBitsPerPass = 8;
+
+/**
+ * @brief One radix pass: scatter "input" into 2^bits partitions by hash bits
+ *        [shift, shift+bits), in a histogram then scatter pass. Each
+ *        partition gets a cache line sized write combining buffer, so
+ *        "output" is written a whole line at a time, with non temporal
+ *        stores that do not pull the destination into the cache.
+ *
+ * @param starts Receives 2^bits+1 partition boundaries in "output".
+ **/
+inline void GiftedRadixPass(const GiftedHashedRow *input,
+                            const std::size_t count,
+                            const unsigned shift,
+                            const unsigned bits,
+                            GiftedHashedRow *output,
+                            std::size_t *starts) {
+  static const std::size_t kRowsPerLine = 64 / sizeof(GiftedHashedRow);
+  const std::size_t fanout = static_cast<std::size_t>(1) << bits;
+  const std::uint64_t mask = fanout - 1;
+
+  std::vector<std::size_t> next(fanout, 0);
+  for (std::size_t i = 0; i < count; i++) {
+    next[(input[i].hash >> shift) & mask]++;
+  }
+  std::size_t total = 0;
+  for (std::size_t p = 0; p < fanout; p++) {
+    starts[p] = total;
+    total += next[p];
+    next[p] = starts[p];
+  }
+  starts[fanout] = total;
+
+  GiftedAlignedBuffer lines(fanout * 64);
+  GiftedHashedRow *buffers = reinterpret_cast<GiftedHashedRow*>(lines.data());
+  for (std::size_t i = 0; i < count; i++) {
+    const std::size_t p = (input[i].hash >> shift) & mask;
+    const std::size_t slot = (next[p] - starts[p]) % kRowsPerLine;
+    GiftedHashedRow *line = buffers + p * kRowsPerLine;
+    line[slot] = input[i];
+    next[p]++;
+    if (slot == kRowsPerLine - 1) {
+      GiftedHashedRow *destination = output + next[p] - kRowsPerLine;
+#if defined(__SSE2__)
+      for (std::size_t r = 0; r < kRowsPerLine; r++) {
+        _mm_stream_si128(reinterpret_cast<__m128i*>(destination + r),
+                         _mm_load_si128(reinterpret_cast<const __m128i*>(line + r)));
+      }
+#else
+      std::memcpy(destination, line, 64);
+#endif
+    }
+  }
+  // Whatever is left in the buffers.
+  for (std::size_t p = 0; p < fanout; p++) {
+    const std::size_t pending = (next[p] - starts[p]) % kRowsPerLine;
+    std::memcpy(output + next[p] - pending, buffers + p * kRowsPerLine, pending * sizeof(GiftedHashedRow));
+  }
+#if defined(__SSE2__)
+  _mm_sfence();
+#endif
+}
+
+/**
+ * @brief Partition "rows" by the low "bits" bits of the hash, in as many
+ *        passes of at most kGiftedRadixBitsPerPass bits as it takes. The
+ *        result ends up back in "rows" ("scratch" must be as large), and
+ *        starts[p] .. starts[p+1] are the rows of partition p.
+ *
+ *        Partition p holds the rows whose low hash bits are p, so two inputs
+ *        partitioned with the same "bits" line up partition by partition.
+ **/
+inline void GiftedRadixPartition(std::vector<GiftedHashedRow> *rows,
+                                 std::vector<GiftedHashedRow> *scratch,
+                                 const unsigned bits,
+                                 std::vector<std::size_t> *starts) {
+  scratch->resize(rows->size());
+  starts->assign(2, 0);
+  (*starts)[1] = rows->size();
+  // Most significant digit first, so each pass refines the partitions of
+  // the one before.
+  unsigned shift = bits;
+  bool inScratch = false;
+  while (shift > 0) {
+    const unsigned passBits = shift < kGiftedRadixBitsPerPass ? shift : kGiftedRadixBitsPerPass;
+    shift -= passBits;
+    const std::size_t fanout = static_cast<std::size_t>(1) << passBits;
+    const GiftedHashedRow *input = inScratch ? scratch->data() : rows->data();
+    GiftedHashedRow *output = inScratch ? rows->data() : scratch->data();
+
+    // Split every partition so far into "fanout" smaller ones.
+    std::vector<std::size_t> refined(1, 0);
+    std::vector<std::size_t> local(fanout + 1);
+    for (std::size_t p = 0; p + 1 < starts->size(); p++) {
+      const std::size_t begin = (*starts)[p];
+      GiftedRadixPass(input + begin, (*starts)[p + 1] - begin, shift, passBits, output + begin, local.data());
+      for (std::size_t q = 1; q <= fanout; q++) refined.push_back(begin + local[q]);
+    }
+    starts->swap(refined);
+    inScratch = !inScratch;
+  }
+  if (inScratch) rows->swap(*scratch);
+}
+
+#endif  // GIFTED_OPERATORS_RADIX_PARTITION_HPP_
@@ -0,0 +1,144 @@
+//
+//  SamplingScanOperator.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_OPERATORS_SAMPLING_SCAN_OPERATOR_HPP_
+#define GIFTED_OPERATORS_SAMPLING_SCAN_OPERATOR_HPP_
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "operators/Operator.hpp"
+#include "storage/ColumnVector.hpp"
+#include "storage/VectorBatch.hpp"
+
+/**
+ * @brief A scan that produces a random sample of its columns' rows, for
+ *        approximate answers at a fraction of a full scan's cost.
+ *
+ *        The columns are cut into blocks of "batchRows" rows, as by a
+ *        GiftedScanOperator, and sampled twice:
+ *        - Blocks: each is kept with probability "blockRate" (Bernoulli), or
+ *          with "exactBlockCount" exactly round(blockRate * blocks) of them
+ *          are kept, every such set equally likely (selection sampling, a
+ *          reservoir over blocks whose number is known). A block that is
+ *          not kept is never sliced or read.
+ *        - Rows: in a kept block, each row is kept with probability
+ *          "rowRate". The sampled rows are the batch's selection; the gaps
+ *          between them are drawn from a geometric distribution, so the
+ *          cost is per sampled row, not per row.
+ *
+ *        Sums and counts over the sample estimate the whole input's when
+ *        multiplied by getScaleFactor(). Row sampling gives better
+ *        estimates, block sampling reads less; clustered columns favour
+ *        the first. Batches with no sampled rows are skipped.
+ **/
+class GiftedSamplingScanOperator : public GiftedOperator {
+public:
+  GiftedSamplingScanOperator(const std::vector<const GiftedColumnVector*> &columns,
+                             const double blockRate,
+                             const double rowRate,
+                             const bool exactBlockCount = false,
+                             const std::uint64_t seed = 0x5eed,
+                             const std::size_t batchRows = kGiftedDefaultBatchRows)
+      : _columns(columns),
+        _batchRows(batchRows < 8 ? 8 : batchRows & ~static_cast<std::size_t>(7)),
+        _blockRate(blockRate),
+        _rowRate(rowRate),
+        _exactBlockCount(exactBlockCount),
+        _random(seed),
+        _position(0),
+        _blocksLeft(0),
+        _blocksToKeep(0) {
+    if (!(blockRate > 0 && blockRate <= 1) || !(rowRate > 0 && rowRate <= 1)) {
+      throw std::invalid_argument("GiftedSamplingScanOperator: sampling rates must be in (0, 1]");
+    }
+    for (std::size_t i = 1; i < _columns.size(); i++) {
+      if (_columns[i]->size() != _columns[0]->size()) {
+        throw std::invalid_argument("GiftedSamplingScanOperator: columns differ in length");
+      }
+    }
+    const std::size_t numRows = _columns.empty() ? 0 : _columns[0]->size();
+    _blocksLeft = (numRows + _batchRows - 1) / _batchRows;
+    _blocksToKeep = static_cast<std::size_t>(std::llround(blockRate * static_cast<double>(_blocksLeft)));
+    if (_blocksToKeep == 0 && _blocksLeft > 0) _blocksToKeep = 1;
+    _scaleFactor = 1.0 / rowRate;
+    if (exactBlockCount) {
+      _scaleFactor *= _blocksToKeep == 0 ? 1.0 : static_cast<double>(_blocksLeft) / static_cast<double>(_blocksToKeep);
+    } else {
+      _scaleFactor /= blockRate;
+    }
+  }
+
+  /**
+   * @brief The number of input rows each sampled row stands for.
+   **/
+  double getScaleFactor() const {return _scaleFactor;}
+
+  bool Next(GiftedVectorBatch *batch) override {
+    batch->Reset();
+    if (batch->getCapacity() < _batchRows) {
+      throw std::invalid_argument("GiftedSamplingScanOperator: batch is smaller than the scan's batches");
+    }
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    while (!_columns.empty() && _position < _columns[0]->size()) {
+      const std::size_t first = _position;
+      const std::size_t remaining = _columns[0]->size() - _position;
+      const std::size_t rows = remaining < _batchRows ? remaining : _batchRows;
+      _position += rows;
+
+      bool keep;
+      if (_exactBlockCount) {
+        // Keep this block with probability (blocks to keep) / (blocks left).
+        keep = uniform(_random) * static_cast<double>(_blocksLeft) < static_cast<double>(_blocksToKeep);
+        _blocksToKeep -= keep;
+        _blocksLeft--;
+      } else {
+        keep = _blockRate >= 1 || uniform(_random) < _blockRate;
+      }
+      if (!keep) continue;
+
+      batch->Reset();
+      for (std::size_t i = 0; i < _columns.size(); i++) {
+        batch->AddColumn(_columns[i]->Slice(first, rows));
+      }
+      batch->SetFirstRow(first);
+      if (_rowRate >= 1) return true;
+      if (SampleRows(batch) > 0) return true;
+    }
+    batch->Reset();
+    return false;
+  }
+
+private:
+  // Select each row of the batch with probability _rowRate.
+  std::size_t SampleRows(GiftedVectorBatch *batch) {
+    std::geometric_distribution<std::size_t> gap(_rowRate);
+    std::uint32_t *selection = batch->getSelectionMutable();
+    std::size_t selected = 0;
+    for (std::size_t row = gap(_random); row < batch->getNumRows(); row += 1 + gap(_random)) {
+      selection[selected++] = static_cast<std::uint32_t>(row);
+    }
+    batch->SetNumSelected(selected);
+    return selected;
+  }
+
+  const std::vector<const GiftedColumnVector*> _columns;
+  const std::size_t _batchRows;
+  const double _blockRate;
+  const double _rowRate;
+  const bool _exactBlockCount;
+  std::mt19937_64 _random;
+  std::size_t _position;
+  std::size_t _blocksLeft;
+  std::size_t _blocksToKeep;
+  double _scaleFactor;
+};
+
+#endif  // GIFTED_OPERATORS_SAMPLING_SCAN_OPERATOR_HPP_
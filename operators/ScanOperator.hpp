@@ -0,0 +1,64 @@
+//
+//  ScanOperator.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_OPERATORS_SCAN_OPERATOR_HPP_
+#define GIFTED_OPERATORS_SCAN_OPERATOR_HPP_
+
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include "operators/Operator.hpp"
+#include "storage/ColumnVector.hpp"
+#include "storage/VectorBatch.hpp"
+
+/**
+ * @brief Cuts a set of equally long columns into batches. The batches are
+ *        views over the columns, so nothing is copied; the columns must
+ *        outlive the pipeline.
+ **/
+class GiftedScanOperator : public GiftedOperator {
+public:
+  /**
+   * @param batchRows Rows per batch; rounded down to a multiple of 8 so that
+   *        every batch starts on a byte of the validity bitmaps.
+   **/
+  GiftedScanOperator(const std::vector<const GiftedColumnVector*> &columns,
+                     const std::size_t batchRows = kGiftedDefaultBatchRows)
+      : _columns(columns),
+        _batchRows(batchRows < 8 ? 8 : batchRows & ~static_cast<std::size_t>(7)),
+        _position(0) {
+    for (std::size_t i = 1; i < _columns.size(); i++) {
+      if (_columns[i]->size() != _columns[0]->size()) {
+        throw std::invalid_argument("GiftedScanOperator: columns differ in length");
+      }
+    }
+  }
+
+  bool Next(GiftedVectorBatch *batch) override {
+    batch->Reset();
+    if (_columns.empty() || _position >= _columns[0]->size()) return false;
+    if (batch->getCapacity() < _batchRows) {
+      throw std::invalid_argument("GiftedScanOperator: batch is smaller than the scan's batches");
+    }
+
+    const std::size_t remaining = _columns[0]->size() - _position;
+    const std::size_t rows = remaining < _batchRows ? remaining : _batchRows;
+    for (std::size_t i = 0; i < _columns.size(); i++) {
+      batch->AddColumn(_columns[i]->Slice(_position, rows));
+    }
+    batch->SetFirstRow(_position);
+    _position += rows;
+    return true;
+  }
+
+private:
+  const std::vector<const GiftedColumnVector*> _columns;
+  const std::size_t _batchRows;
+  std::size_t _position;
+};
+
+#endif  // GIFTED_OPERATORS_SCAN_OPERATOR_HPP_
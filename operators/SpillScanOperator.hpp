@@ -0,0 +1,54 @@
+//
+//  SpillScanOperator.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_OPERATORS_SPILL_SCAN_OPERATOR_HPP_
+#define GIFTED_OPERATORS_SPILL_SCAN_OPERATOR_HPP_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "operators/Operator.hpp"
+#include "storage/ColumnVector.hpp"
+#include "storage/SpillFile.hpp"
+#include "storage/VectorBatch.hpp"
+
+/**
+ * @brief Reads a GiftedSpillFile (rewound) back, a chunk at a time. The
+ *        batches are views over the chunk, cut to the batch capacity
+ *        (rounded down to a multiple of 8 rows) where a chunk is larger.
+ **/
+class GiftedSpillScanOperator : public GiftedOperator {
+public:
+  explicit GiftedSpillScanOperator(const std::shared_ptr<GiftedSpillFile> &file)
+      : _file(file), _position(0), _firstRow(0) {}
+
+  bool Next(GiftedVectorBatch *batch) override {
+    batch->Reset();
+    while (_chunk.empty() || _position >= _chunk[0].size()) {
+      _position = 0;
+      if (!_file->Read(&_chunk)) return false;
+    }
+    std::size_t rows = _chunk[0].size() - _position;
+    const std::size_t batchRows = GiftedSpillBatchRows(batch->getCapacity());
+    if (rows > batchRows) rows = batchRows;
+    for (std::size_t c = 0; c < _chunk.size(); c++) {
+      batch->AddColumn(_chunk[c].Slice(_position, rows));
+    }
+    batch->SetFirstRow(_firstRow);
+    _position += rows;
+    _firstRow += rows;
+    return true;
+  }
+
+private:
+  std::shared_ptr<GiftedSpillFile> _file;
+  std::vector<GiftedColumnVector> _chunk;
+  std::size_t _position;  // In _chunk.
+  std::size_t _firstRow;
+};
+
+#endif  // GIFTED_OPERATORS_SPILL_SCAN_OPERATOR_HPP_
@@ -0,0 +1,330 @@
+//
+//  SpillingHashJoinOperator.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_OPERATORS_SPILLING_HASH_JOIN_OPERATOR_HPP_
+#define GIFTED_OPERATORS_SPILLING_HASH_JOIN_OPERATOR_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "operators/HashJoinOperator.hpp"
+#include "operators/Operator.hpp"
+#include "operators/SpillScanOperator.hpp"
+#include "storage/ColumnVector.hpp"
+#include "storage/SpillFile.hpp"
+#include "storage/VectorBatch.hpp"
+#include "types/TypeRegistry.hpp"
+
+/**
+ * @brief A GiftedHashJoinOperator (same inputs, same output) whose build
+ *        side need not fit in memory.
+ *
+ *        The build rows are kept in kGiftedSpillFanout partitions on the top
+ *        hash bits of their key. Whenever they take more than "memoryBytes",
+ *        the largest partition is written to a GiftedSpillFile, as are its
+ *        later rows. The partitions left in memory are joined by a
+ *        GiftedHashJoinOperator while the probe side streams through; probe
+ *        rows of spilled partitions go to files of their own. Each spilled
+ *        pair of files is then joined by a GiftedSpillingHashJoinOperator on
+ *        the next hash bits, which spills again if it has to.
+ *
+ *        A partition is only spilled if the build side spreads over more
+ *        than one, since spilling cannot split a single (skewed) key; such a
+ *        build side stays in memory. The probe side is never materialized,
+ *        so the in-memory join does not radix partition.
+ **/
+class GiftedSpillingHashJoinOperator : public GiftedOperator {
+public:
+  GiftedSpillingHashJoinOperator(const GiftedTypeRegistry &registry,
+                                 std::unique_ptr<GiftedOperator> build,
+                                 const std::size_t buildKey,
+                                 std::unique_ptr<GiftedOperator> probe,
+                                 const std::size_t probeKey,
+                                 const std::size_t memoryBytes,
+                                 const std::string &spillDirectory = GiftedSpillDirectory())
+      : GiftedSpillingHashJoinOperator(registry, std::move(build), buildKey, std::move(probe), probeKey,
+                                       memoryBytes, spillDirectory, 0) {}
+
+  bool Next(GiftedVectorBatch *batch) override {
+    if (!_started) Start(GiftedSpillBatchRows(batch->getCapacity()));
+    while (_current) {
+      if (_current->Next(batch)) return true;
+      _current.reset();
+      NextSpilledPair();
+    }
+    batch->Reset();
+    return false;
+  }
+
+  /**
+   * @brief Partitions spilled at this level (once the build side is read).
+   **/
+  std::size_t getSpilledPartitions() const {return _numSpilled;}
+
+  /**
+   * @brief Build rows spilled at this level (once the build side is read).
+   **/
+  std::size_t getSpilledBuildRows() const {return _spilledBuildRows;}
+
+private:
+  GiftedSpillingHashJoinOperator(const GiftedTypeRegistry &registry,
+                                 std::unique_ptr<GiftedOperator> build,
+                                 const std::size_t buildKey,
+                                 std::unique_ptr<GiftedOperator> probe,
+                                 const std::size_t probeKey,
+                                 const std::size_t memoryBytes,
+                                 const std::string &spillDirectory,
+                                 const unsigned level)
+      : _registry(registry),
+        _buildChild(std::move(build)),
+        _buildKey(buildKey),
+        _probeChild(std::move(probe)),
+        _probeKey(probeKey),
+        _memoryBytes(memoryBytes),
+        _spillDirectory(spillDirectory),
+        _level(level),
+        _started(false),
+        _partitions(kGiftedSpillFanout),
+        _residentBytes(0),
+        _numSpilled(0),
+        _spilledBuildRows(0),
+        _nextPartition(0) {}
+
+  struct Partition {
+    Partition() : bytes(0), spilled(false), hadRows(false) {}
+
+    std::vector<GiftedColumnVector> columns;  // Build rows, while in memory.
+    std::size_t bytes;
+    bool spilled;
+    bool hadRows;
+  };
+
+  /**
+   * @brief The build rows in memory, a partition at a time; a partition is
+   *        freed once the join has copied it (the batch after its last).
+   **/
+  class ResidentScan : public GiftedOperator {
+  public:
+    explicit ResidentScan(std::vector<Partition> *partitions)
+        : _partitions(partitions), _partition(0), _position(0) {}
+
+    bool Next(GiftedVectorBatch *batch) override {
+      batch->Reset();
+      const std::size_t batchRows = GiftedSpillBatchRows(batch->getCapacity());
+      for (; _partition < _partitions->size(); _partition++, _position = 0) {
+        std::vector<GiftedColumnVector> &columns = (*_partitions)[_partition].columns;
+        if (columns.empty() || _position >= columns[0].size()) {
+          std::vector<GiftedColumnVector>().swap(columns);
+          continue;
+        }
+        std::size_t rows = columns[0].size() - _position;
+        if (rows > batchRows) rows = batchRows;
+        for (std::size_t c = 0; c < columns.size(); c++) {
+          batch->AddColumn(columns[c].Slice(_position, rows));
+        }
+        _position += rows;
+        return true;
+      }
+      return false;
+    }
+
+  private:
+    std::vector<Partition> *_partitions;
+    std::size_t _partition;
+    std::size_t _position;
+  };
+
+  /**
+   * @brief The probe side, less the rows of spilled partitions (which go to
+   *        their files) and rows with a null key.
+   **/
+  class ProbeRouter : public GiftedOperator {
+  public:
+    ProbeRouter(GiftedSpillingHashJoinOperator *join, const std::size_t batchRows)
+        : _join(join), _spill(kGiftedSpillFanout, batchRows, join->_spillDirectory), _positions(kGiftedSpillFanout) {}
+
+    bool Next(GiftedVectorBatch *batch) override {
+      while (_join->_probeChild->Next(batch)) {
+        const GiftedColumnVector &key = batch->getColumn(_join->_probeKey);
+        if (_hashes.size() < key.size()) _hashes.resize(key.size());
+        key.Hash(_join->Kernels(key), _hashes.data());
+        for (std::size_t p = 0; p < _positions.size(); p++) _positions[p].clear();
+
+        const std::uint32_t *selection = batch->hasSelection() ? batch->getSelection() : nullptr;
+        std::uint32_t *kept = batch->getSelectionMutable();
+        std::size_t numKept = 0;
+        for (std::size_t i = 0; i < batch->getNumSelected(); i++) {
+          const std::uint32_t row = selection != nullptr ? selection[i] : static_cast<std::uint32_t>(i);
+          if (key.isNull(row)) continue;
+          const std::size_t p = GiftedSpillPartition(_hashes[row], _join->_level);
+          if (_join->_partitions[p].spilled) {
+            _positions[p].push_back(row);
+          } else {
+            kept[numKept++] = row;
+          }
+        }
+        batch->SetNumSelected(numKept);
+
+        std::vector<const GiftedColumnVector*> columns;
+        for (std::size_t c = 0; c < batch->getNumColumns(); c++) columns.push_back(&batch->getColumn(c));
+        for (std::size_t p = 0; p < _positions.size(); p++) {
+          _spill.AppendGathered(p, columns, _positions[p].data(), _positions[p].size(), _join->_registry);
+        }
+        if (numKept > 0) return true;
+      }
+      _join->_probeFiles = _spill.Finish();
+      return false;
+    }
+
+  private:
+    GiftedSpillingHashJoinOperator *_join;
+    GiftedSpillPartitions _spill;
+    std::vector<std::vector<std::uint32_t> > _positions;
+    std::vector<std::uint64_t> _hashes;
+  };
+
+  /**
+   * @brief Read the build side, spilling partitions as it outgrows the
+   *        memory budget, and start the join of the partitions left.
+   **/
+  void Start(const std::size_t batchRows) {
+    _started = true;
+    GiftedSpillPartitions spill(kGiftedSpillFanout, batchRows, _spillDirectory);
+    std::vector<std::vector<std::uint32_t> > positions(kGiftedSpillFanout);
+    std::vector<std::uint64_t> hashes;
+    GiftedVectorBatch input(batchRows);
+    while (_buildChild->Next(&input)) {
+      const GiftedColumnVector &key = input.getColumn(_buildKey);
+      if (hashes.size() < key.size()) hashes.resize(key.size());
+      key.Hash(Kernels(key), hashes.data());
+      for (std::size_t p = 0; p < positions.size(); p++) positions[p].clear();
+      for (std::size_t i = 0; i < input.getNumSelected(); i++) {
+        const std::uint32_t row = input.hasSelection() ? input.getSelection()[i] : static_cast<std::uint32_t>(i);
+        if (!key.isNull(row)) positions[GiftedSpillPartition(hashes[row], _level)].push_back(row);
+      }
+
+      std::vector<const GiftedColumnVector*> columns;
+      for (std::size_t c = 0; c < input.getNumColumns(); c++) columns.push_back(&input.getColumn(c));
+      for (std::size_t p = 0; p < positions.size(); p++) {
+        if (positions[p].empty()) continue;
+        Partition &partition = _partitions[p];
+        partition.hadRows = true;
+        if (partition.spilled) {
+          spill.AppendGathered(p, columns, positions[p].data(), positions[p].size(), _registry);
+          _spilledBuildRows += positions[p].size();
+          continue;
+        }
+        if (partition.columns.empty()) {
+          for (std::size_t c = 0; c < columns.size(); c++) {
+            partition.columns.push_back(GiftedColumnVector(columns[c]->getTypeId(), columns[c]->getElementLength()));
+          }
+        }
+        _residentBytes -= partition.bytes;
+        partition.bytes = 0;
+        for (std::size_t c = 0; c < columns.size(); c++) {
+          partition.columns[c].AppendGathered(*columns[c], positions[p].data(), positions[p].size(),
+                                              Kernels(*columns[c]));
+          partition.bytes += GiftedColumnBytes(partition.columns[c]);
+        }
+        _residentBytes += partition.bytes;
+      }
+      while (_residentBytes > _memoryBytes && SpillLargestPartition(&spill)) {}
+    }
+    _buildFiles = spill.Finish();
+    _probeFiles.assign(kGiftedSpillFanout, std::shared_ptr<GiftedSpillFile>());
+
+    std::unique_ptr<GiftedOperator> probe;
+    if (_numSpilled > 0) {
+      probe.reset(new ProbeRouter(this, batchRows));
+    } else {
+      probe = std::move(_probeChild);
+    }
+    std::unique_ptr<GiftedOperator> resident(new ResidentScan(&_partitions));
+    _current.reset(new GiftedHashJoinOperator(_registry, std::move(resident), _buildKey, std::move(probe), _probeKey,
+                                              std::shared_ptr<GiftedBlockedBloomFilter>(),
+                                              GiftedHashJoinOperator::kNoPartitioning));
+  }
+
+  /**
+   * @brief Write the largest partition in memory to its file.
+   *
+   * @return false if spilling would not help.
+   **/
+  bool SpillLargestPartition(GiftedSpillPartitions *spill) {
+    if (_level >= kGiftedMaxSpillLevel) return false;
+    std::size_t largest = _partitions.size();
+    std::size_t withRows = 0;
+    for (std::size_t p = 0; p < _partitions.size(); p++) {
+      if (_partitions[p].hadRows) withRows++;
+      if (_partitions[p].spilled || _partitions[p].bytes == 0) continue;
+      if (largest == _partitions.size() || _partitions[p].bytes > _partitions[largest].bytes) largest = p;
+    }
+    if (largest == _partitions.size() || withRows < 2) return false;
+
+    Partition &partition = _partitions[largest];
+    std::vector<const GiftedColumnVector*> columns;
+    for (std::size_t c = 0; c < partition.columns.size(); c++) columns.push_back(&partition.columns[c]);
+    spill->Append(largest, columns);
+    _spilledBuildRows += partition.columns[0].size();
+    std::vector<GiftedColumnVector>().swap(partition.columns);
+    _residentBytes -= partition.bytes;
+    partition.bytes = 0;
+    partition.spilled = true;
+    _numSpilled++;
+    return true;
+  }
+
+  /**
+   * @brief Move _current on to the join of the next spilled pair of files
+   *        with rows on both sides, if any.
+   **/
+  void NextSpilledPair() {
+    for (; _nextPartition < _buildFiles.size(); _nextPartition++) {
+      std::shared_ptr<GiftedSpillFile> build, probe;
+      build.swap(_buildFiles[_nextPartition]);
+      probe.swap(_probeFiles[_nextPartition]);
+      if (!build || !probe) continue;
+      _current.reset(new GiftedSpillingHashJoinOperator(
+          _registry, std::unique_ptr<GiftedOperator>(new GiftedSpillScanOperator(build)), _buildKey,
+          std::unique_ptr<GiftedOperator>(new GiftedSpillScanOperator(probe)), _probeKey, _memoryBytes,
+          _spillDirectory, _level + 1));
+      _nextPartition++;
+      return;
+    }
+  }
+
+  GiftedBaseType* Kernels(const GiftedColumnVector &column) const {
+    return _registry.getEntry(column.getTypeId())->prototype.get();
+  }
+
+  const GiftedTypeRegistry &_registry;
+  std::unique_ptr<GiftedOperator> _buildChild;
+  const std::size_t _buildKey;
+  std::unique_ptr<GiftedOperator> _probeChild;
+  const std::size_t _probeKey;
+  const std::size_t _memoryBytes;
+  const std::string _spillDirectory;
+  const unsigned _level;  // Of recursion: which hash bits partition.
+
+  bool _started;
+  std::vector<Partition> _partitions;
+  std::size_t _residentBytes;
+  std::size_t _numSpilled;
+  std::size_t _spilledBuildRows;
+
+  // The join under way: of the partitions in memory, then of each spilled
+  // pair of files from _nextPartition on.
+  std::unique_ptr<GiftedOperator> _current;
+  std::vector<std::shared_ptr<GiftedSpillFile> > _buildFiles;
+  std::vector<std::shared_ptr<GiftedSpillFile> > _probeFiles;
+  std::size_t _nextPartition;
+};
+
+#endif  // GIFTED_OPERATORS_SPILLING_HASH_JOIN_OPERATOR_HPP_
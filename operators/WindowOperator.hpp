@@ -0,0 +1,432 @@
+//
+//  WindowOperator.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_OPERATORS_WINDOW_OPERATOR_HPP_
+#define GIFTED_OPERATORS_WINDOW_OPERATOR_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "operators/Operator.hpp"
+#include "storage/ColumnVector.hpp"
+#include "storage/VectorBatch.hpp"
+#include "types/BaseType.hpp"
+#include "types/DecimalType.hpp"
+#include "types/TypeRegistry.hpp"
+
+/**
+ * @brief Window functions over an input that is sorted by its partition
+ *        columns (and within a partition by the order the windows mean).
+ *        Each output row is an input row followed by one column per window.
+ *
+ *        ROW_NUMBER, RANK and DENSE_RANK number the rows of a partition;
+ *        ranks treat rows with equal values in the window's column as
+ *        peers. COUNT, SUM, MIN, MAX and AVG aggregate the window's column
+ *        (int64, int32 or decimal; COUNT any type) over a ROWS frame of
+ *        "preceding" rows before and "following" rows after each row, either
+ *        of which may be kUnbounded. Nulls are skipped; an aggregate of no
+ *        values is null (COUNT: 0). Results are int64, except that SUM of
+ *        decimal is decimal, MIN and MAX keep the column's type and AVG is a
+ *        decimal (truncated).
+ *
+ *        Frames are not recomputed row by row: COUNT, SUM and AVG read
+ *        prefix sums of the partition's values (one typed pass, then two
+ *        lookups a row), and MIN and MAX a running extreme for frames that
+ *        start at the partition, or else a segment tree over the partition
+ *        (log of the frame size a row). A partition is buffered until the
+ *        next one starts, so only one partition (plus a batch) is in memory.
+ **/
+class GiftedWindowOperator : public GiftedOperator {
+public:
+  enum FunctionId {
+    kRowNumber,
+    kRank,
+    kDenseRank,
+    kCount,
+    kSum,
+    kMin,
+    kMax,
+    kAverage
+  };
+
+  static const std::size_t kUnbounded = std::numeric_limits<std::size_t>::max();
+
+  struct Window {
+    /**
+     * @param columnIn The column aggregated, or for ranks the order column.
+     *        Unused by ROW_NUMBER.
+     * The default frame is from the partition's start to the current row,
+     * i.e. running aggregates.
+     **/
+    Window(const FunctionId functionIn,
+           const std::size_t columnIn,
+           const std::size_t precedingIn = kUnbounded,
+           const std::size_t followingIn = 0)
+        : function(functionIn), column(columnIn), preceding(precedingIn), following(followingIn) {}
+
+    FunctionId function;
+    std::size_t column;
+    std::size_t preceding;
+    std::size_t following;
+  };
+
+  GiftedWindowOperator(const GiftedTypeRegistry &registry,
+                       std::unique_ptr<GiftedOperator> child,
+                       const std::vector<std::size_t> &partitionColumns,
+                       const std::vector<Window> &windows)
+      : _registry(registry),
+        _child(std::move(child)),
+        _partitionColumns(partitionColumns),
+        _windows(windows),
+        _results(windows.size()),
+        _resultNulls(windows.size()),
+        _inputDone(false),
+        _partitionStart(0),
+        _checked(0),
+        _computed(0),
+        _emitted(0) {}
+
+  bool Next(GiftedVectorBatch *batch) override {
+    while (_emitted == _computed) {
+      if (_inputDone) {
+        batch->Reset();
+        return false;
+      }
+      Compact();
+      if (_child->Next(batch)) {
+        Append(*batch);
+        FindPartitions();
+      } else {
+        _inputDone = true;
+        if (!_buffer.empty() && _buffer[0].size() > _partitionStart) {
+          ComputePartition(_partitionStart, _buffer[0].size());
+        }
+      }
+    }
+    Emit(batch);
+    return true;
+  }
+
+private:
+  void Append(const GiftedVectorBatch &batch) {
+    if (_buffer.empty()) Prepare(batch);
+    _positions.clear();
+    if (batch.hasSelection()) {
+      _positions.assign(batch.getSelection(), batch.getSelection() + batch.getNumSelected());
+    } else {
+      for (std::size_t i = 0; i < batch.getNumRows(); i++) _positions.push_back(static_cast<std::uint32_t>(i));
+    }
+    for (std::size_t c = 0; c < _buffer.size(); c++) {
+      const GiftedColumnVector &column = batch.getColumn(c);
+      _buffer[c].AppendGathered(column, _positions.data(), _positions.size(),
+                                _registry.getEntry(column.getTypeId())->prototype.get());
+    }
+  }
+
+  // Make the buffer and the result columns for the input's columns.
+  void Prepare(const GiftedVectorBatch &batch) {
+    for (std::size_t c = 0; c < batch.getNumColumns(); c++) {
+      const GiftedColumnVector &column = batch.getColumn(c);
+      _buffer.push_back(GiftedColumnVector(column.getTypeId(), column.getElementLength()));
+      _output.push_back(GiftedColumnVector(column.getTypeId(), column.getElementLength()));
+    }
+    for (std::size_t w = 0; w < _windows.size(); w++) {
+      const Window &window = _windows[w];
+      const GiftedBaseType::GiftedTypeId typeId =
+          window.function == kRowNumber ? GiftedBaseType::_GiftedIntTypeId : batch.getColumn(window.column).getTypeId();
+      const bool numeric = typeId == GiftedBaseType::_GiftedIntTypeId ||
+                           typeId == GiftedBaseType::_GiftedInt32TypeId ||
+                           typeId == GiftedBaseType::_GiftedDecimalTypeId;
+      if (window.function >= kSum && !numeric) {
+        throw std::invalid_argument("GiftedWindowOperator: column type is not numeric");
+      }
+      GiftedBaseType::GiftedTypeId resultType = GiftedBaseType::_GiftedIntTypeId;
+      if (window.function == kMin || window.function == kMax) resultType = typeId;
+      if (window.function == kAverage ||
+          (window.function == kSum && typeId == GiftedBaseType::_GiftedDecimalTypeId)) {
+        resultType = GiftedBaseType::_GiftedDecimalTypeId;
+      }
+      const std::size_t length =
+          resultType == GiftedBaseType::_GiftedInt32TypeId ? sizeof(std::int32_t) : sizeof(std::int64_t);
+      _resultColumns.push_back(GiftedColumnVector(resultType, length));
+    }
+    for (std::size_t p = 0; p < _partitionColumns.size(); p++) {
+      if (_partitionColumns[p] >= _buffer.size()) {
+        throw std::out_of_range("GiftedWindowOperator: no such partition column");
+      }
+    }
+  }
+
+  // Close every partition that the rows appended since the last call end.
+  void FindPartitions() {
+    const std::size_t numRows = _buffer[0].size();
+    for (std::size_t row = _checked > 0 ? _checked : 1; row < numRows; row++) {
+      if (!RowsEqual(_partitionColumns, row - 1, row)) {
+        ComputePartition(_partitionStart, row);
+        _partitionStart = row;
+      }
+    }
+    _checked = numRows;
+  }
+
+  bool RowsEqual(const std::vector<std::size_t> &columns, const std::size_t left, const std::size_t right) const {
+    for (std::size_t i = 0; i < columns.size(); i++) {
+      if (!ValuesEqual(_buffer[columns[i]], left, right)) return false;
+    }
+    return true;
+  }
+
+  static bool ValuesEqual(const GiftedColumnVector &column, const std::size_t left, const std::size_t right) {
+    const bool leftNull = column.isNull(left);
+    if (leftNull || column.isNull(right)) return leftNull && column.isNull(right);
+    std::size_t leftLength, rightLength;
+    const char *leftValue = column.getElement(left, &leftLength);
+    const char *rightValue = column.getElement(right, &rightLength);
+    return leftLength == rightLength && std::memcmp(leftValue, rightValue, leftLength) == 0;
+  }
+
+  void ComputePartition(const std::size_t begin, const std::size_t end) {
+    for (std::size_t w = 0; w < _windows.size(); w++) {
+      _results[w].resize(end);
+      _resultNulls[w].resize(end);
+      std::fill(_resultNulls[w].begin() + begin, _resultNulls[w].end(), 0);
+      const Window &window = _windows[w];
+      switch (window.function) {
+        case kRowNumber:
+        case kRank:
+        case kDenseRank:
+          Rank(window, begin, end, _results[w].data());
+          break;
+        default:
+          Aggregate(window, begin, end, _results[w].data(), _resultNulls[w].data());
+          break;
+      }
+    }
+    _computed = end;
+  }
+
+  void Rank(const Window &window, const std::size_t begin, const std::size_t end, std::int64_t *out) const {
+    std::int64_t rank = 0;
+    for (std::size_t row = begin; row < end; row++) {
+      const bool peer = row > begin && window.function != kRowNumber &&
+                        ValuesEqual(_buffer[window.column], row - 1, row);
+      if (!peer) rank = window.function == kDenseRank ? rank + 1 : static_cast<std::int64_t>(row - begin + 1);
+      out[row] = rank;
+    }
+  }
+
+  void Aggregate(const Window &window, const std::size_t begin, const std::size_t end,
+                 std::int64_t *out, std::uint8_t *nulls) {
+    const GiftedColumnVector &column = _buffer[window.column];
+    const std::size_t n = end - begin;
+
+    // The partition's values as int64, nulls as 0, with their prefix counts.
+    _values.resize(n);
+    _counts.resize(n + 1);
+    _counts[0] = 0;
+    if (window.function != kCount) {
+      if (column.getTypeId() == GiftedBaseType::_GiftedInt32TypeId) {
+        const std::int32_t *values = reinterpret_cast<const std::int32_t*>(column.getValues()) + begin;
+        for (std::size_t i = 0; i < n; i++) _values[i] = values[i];
+      } else {
+        std::memcpy(_values.data(), column.getValues() + begin * sizeof(std::int64_t), n * sizeof(std::int64_t));
+      }
+    }
+    const bool hasNulls = column.getValidityBitmap() != nullptr;
+    for (std::size_t i = 0; i < n; i++) {
+      const bool isNull = hasNulls && column.isNull(begin + i);
+      if (isNull && window.function != kCount) _values[i] = 0;
+      _counts[i + 1] = _counts[i] + !isNull;
+    }
+
+    if (window.function == kMin || window.function == kMax) {
+      Extreme(window, n, out + begin, nulls + begin);
+      return;
+    }
+
+    if (window.function != kCount) {
+      // 128-bit prefix sums, as a wrapping low word and a high word, so that
+      // only a frame whose own sum is out of range overflows.
+      _sums.resize(n + 1);
+      _sumHighs.resize(n + 1);
+      _sums[0] = 0;
+      _sumHighs[0] = 0;
+      for (std::size_t i = 0; i < n; i++) {
+        _sums[i + 1] = _sums[i] + static_cast<std::uint64_t>(_values[i]);
+        _sumHighs[i + 1] = _sumHighs[i] - (_values[i] < 0) + (_sums[i + 1] < _sums[i]);
+      }
+    }
+    const bool integral = column.getTypeId() != GiftedBaseType::_GiftedDecimalTypeId;
+    for (std::size_t i = 0; i < n; i++) {
+      std::size_t low, high;
+      Frame(window, i, n, &low, &high);
+      const std::int64_t count = static_cast<std::int64_t>(_counts[high] - _counts[low]);
+      if (window.function == kCount) {
+        out[begin + i] = count;
+        continue;
+      }
+      if (count == 0) {
+        nulls[begin + i] = 1;
+        continue;
+      }
+      const std::uint64_t sumLow = _sums[high] - _sums[low];
+      const std::int64_t sumHigh = _sumHighs[high] - _sumHighs[low] - (_sums[high] < _sums[low]);
+      // In range iff the high word is the low word's sign extension.
+      if (sumHigh != (sumLow >> 63 ? -1 : 0)) {
+        throw std::overflow_error("GiftedWindowOperator: SUM overflows");
+      }
+      std::int64_t sum = static_cast<std::int64_t>(sumLow);
+      if (window.function == kAverage) {
+        if (integral && __builtin_mul_overflow(sum, GiftedDecimalType::kScale, &sum)) {
+          throw std::overflow_error("GiftedWindowOperator: AVG overflows");
+        }
+        sum /= count;
+      }
+      out[begin + i] = sum;
+    }
+  }
+
+  // MIN or MAX of each row's frame in _values (n values).
+  void Extreme(const Window &window, const std::size_t n, std::int64_t *out, std::uint8_t *nulls) {
+    const bool isMin = window.function == kMin;
+    const std::int64_t identity = isMin ? std::numeric_limits<std::int64_t>::max()
+                                        : std::numeric_limits<std::int64_t>::min();
+    for (std::size_t i = 0; i < n; i++) {
+      if (_counts[i + 1] == _counts[i]) _values[i] = identity;
+    }
+
+    if (window.preceding == kUnbounded && window.following == 0) {
+      // Running: the frame only ever grows by one row.
+      std::int64_t extreme = identity;
+      for (std::size_t i = 0; i < n; i++) {
+        extreme = isMin ? (_values[i] < extreme ? _values[i] : extreme) : (_values[i] > extreme ? _values[i] : extreme);
+        out[i] = extreme;
+        nulls[i] = _counts[i + 1] == 0;
+      }
+      return;
+    }
+
+    // A bottom up segment tree: leaves at [n, 2n), node k covers 2k, 2k+1.
+    _tree.resize(2 * n);
+    std::memcpy(_tree.data() + n, _values.data(), n * sizeof(std::int64_t));
+    for (std::size_t k = n; k-- > 1;) {
+      _tree[k] = isMin ? std::min(_tree[2 * k], _tree[2 * k + 1]) : std::max(_tree[2 * k], _tree[2 * k + 1]);
+    }
+    for (std::size_t i = 0; i < n; i++) {
+      std::size_t low, high;
+      Frame(window, i, n, &low, &high);
+      if (_counts[high] == _counts[low]) {
+        nulls[i] = 1;
+        continue;
+      }
+      std::int64_t extreme = identity;
+      for (std::size_t l = low + n, h = high + n; l < h; l /= 2, h /= 2) {
+        if (l & 1) {
+          extreme = isMin ? std::min(extreme, _tree[l]) : std::max(extreme, _tree[l]);
+          l++;
+        }
+        if (h & 1) {
+          h--;
+          extreme = isMin ? std::min(extreme, _tree[h]) : std::max(extreme, _tree[h]);
+        }
+      }
+      out[i] = extreme;
+    }
+  }
+
+  // Row i's frame [low, high) within a partition of n rows.
+  static void Frame(const Window &window, const std::size_t i, const std::size_t n,
+                    std::size_t *low, std::size_t *high) {
+    *low = window.preceding == kUnbounded || window.preceding > i ? 0 : i - window.preceding;
+    *high = window.following == kUnbounded || window.following >= n - i ? n : i + window.following + 1;
+  }
+
+  void Emit(GiftedVectorBatch *batch) {
+    batch->Reset();
+    const std::size_t remaining = _computed - _emitted;
+    const std::size_t count = remaining < batch->getCapacity() ? remaining : batch->getCapacity();
+    _positions.clear();
+    for (std::size_t i = 0; i < count; i++) _positions.push_back(static_cast<std::uint32_t>(_emitted + i));
+    for (std::size_t c = 0; c < _buffer.size(); c++) {
+      _output[c].Clear();
+      _output[c].AppendGathered(_buffer[c], _positions.data(), count,
+                                _registry.getEntry(_buffer[c].getTypeId())->prototype.get());
+      batch->AddColumn(_output[c].Slice(0, count));
+    }
+    for (std::size_t w = 0; w < _windows.size(); w++) {
+      GiftedColumnVector &result = _resultColumns[w];
+      result.Clear();
+      const bool isInt32 = result.getTypeId() == GiftedBaseType::_GiftedInt32TypeId;
+      for (std::size_t i = _emitted; i < _emitted + count; i++) {
+        if (_resultNulls[w][i]) {
+          result.AppendNull();
+        } else if (isInt32) {
+          const std::int32_t narrow = static_cast<std::int32_t>(_results[w][i]);
+          result.AppendFixed(reinterpret_cast<const char*>(&narrow));
+        } else {
+          result.AppendFixed(reinterpret_cast<const char*>(&_results[w][i]));
+        }
+      }
+      batch->AddColumn(result.Slice(0, count));
+    }
+    _emitted += count;
+  }
+
+  // Drop the emitted rows once they are at least half of the buffer, so
+  // a long partition is not copied again for every batch.
+  void Compact() {
+    if (_buffer.empty() || _emitted == 0 || 2 * _emitted < _buffer[0].size()) return;
+    _positions.clear();
+    for (std::size_t i = _emitted; i < _buffer[0].size(); i++) _positions.push_back(static_cast<std::uint32_t>(i));
+    for (std::size_t c = 0; c < _buffer.size(); c++) {
+      GiftedColumnVector kept(_buffer[c].getTypeId(), _buffer[c].getElementLength(), _positions.size());
+      kept.AppendGathered(_buffer[c], _positions.data(), _positions.size(),
+                          _registry.getEntry(_buffer[c].getTypeId())->prototype.get());
+      _buffer[c] = std::move(kept);
+    }
+    for (std::size_t w = 0; w < _windows.size(); w++) {
+      _results[w].clear();
+      _resultNulls[w].clear();
+    }
+    _partitionStart -= _emitted;
+    _checked -= _emitted;
+    _computed -= _emitted;
+    _emitted = 0;
+  }
+
+  const GiftedTypeRegistry &_registry;
+  std::unique_ptr<GiftedOperator> _child;
+  const std::vector<std::size_t> _partitionColumns;
+  const std::vector<Window> _windows;
+
+  // Input rows not yet emitted; [_partitionStart, size) is the open
+  // partition, [_emitted, _computed) are ready to emit.
+  std::vector<GiftedColumnVector> _buffer;
+  std::vector<std::vector<std::int64_t> > _results;  // By window, by buffer row.
+  std::vector<std::vector<std::uint8_t> > _resultNulls;
+  bool _inputDone;
+  std::size_t _partitionStart;
+  std::size_t _checked;
+  std::size_t _computed;
+  std::size_t _emitted;
+
+  std::vector<GiftedColumnVector> _output;
+  std::vector<GiftedColumnVector> _resultColumns;
+  std::vector<std::uint32_t> _positions;
+  std::vector<std::int64_t> _values;
+  std::vector<std::size_t> _counts;
+  std::vector<std::uint64_t> _sums;
+  std::vector<std::int64_t> _sumHighs;
+  std::vector<std::int64_t> _tree;
+};
+
+#endif  // GIFTED_OPERATORS_WINDOW_OPERATOR_HPP_
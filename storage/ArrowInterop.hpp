@@ -0,0 +1,624 @@
+//
+//  ArrowInterop.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_STORAGE_ARROW_INTEROP_HPP_
+#define GIFTED_STORAGE_ARROW_INTEROP_HPP_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "storage/ColumnVector.hpp"
+#include "types/BaseType.hpp"
+#include "types/TypeRegistry.hpp"
+#include "utility/Bitmap.hpp"
+
+// The Arrow C data interface, exactly as given by the Arrow specification.
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+  const char* format;
+  const char* name;
+  const char* metadata;
+  int64_t flags;
+  int64_t n_children;
+  struct ArrowSchema** children;
+  struct ArrowSchema* dictionary;
+  void (*release)(struct ArrowSchema*);
+  void* private_data;
+};
+
+struct ArrowArray {
+  int64_t length;
+  int64_t null_count;
+  int64_t offset;
+  int64_t n_buffers;
+  int64_t n_children;
+  const void** buffers;
+  struct ArrowArray** children;
+  struct ArrowArray* dictionary;
+  void (*release)(struct ArrowArray*);
+  void* private_data;
+};
+
+#endif  // ARROW_C_DATA_INTERFACE
+
+/**
+ * @brief Map an Arrow C data interface format string to a Gifted type.
+ *        Only the types whose layout is the same on both sides are mapped,
+ *        so that columns can be shared without conversion.
+ **/
+inline GiftedBaseType::GiftedTypeId GiftedArrowFormatToTypeId(const char *format) {
+  if (std::strcmp(format, "l") == 0) return GiftedBaseType::_GiftedIntTypeId;
+  if (std::strcmp(format, "i") == 0) return GiftedBaseType::_GiftedInt32TypeId;
+  if (std::strcmp(format, "u") == 0) return GiftedBaseType::_GiftedVarCharTypeId;
+  return GiftedBaseType::_GiftedUnknownTypeId;
+}
+
+inline const char* GiftedTypeIdToArrowFormat(const GiftedBaseType::GiftedTypeId typeId) {
+  switch (typeId) {
+    case GiftedBaseType::_GiftedIntTypeId: return "l";
+    case GiftedBaseType::_GiftedInt32TypeId: return "i";
+    case GiftedBaseType::_GiftedVarCharTypeId: return "u";
+    default: return nullptr;
+  }
+}
+
+namespace gifted_arrow_internal {
+
+// What an exported array keeps alive until the consumer releases it.
+struct ExportedArray {
+  explicit ExportedArray(GiftedColumnVector &&exported)
+      : column(std::move(exported)) {}
+
+  GiftedColumnVector column;
+  GiftedAlignedBuffer bitmap; // For exported booleans.
+  const void *buffers[3];
+};
+
+inline void ReleaseSchema(ArrowSchema *schema) {
+  schema->release = nullptr;
+}
+
+inline void ReleaseArray(ArrowArray *array) {
+  delete static_cast<ExportedArray*>(array->private_data);
+  array->release = nullptr;
+}
+
+// Holds an imported ArrowArray and releases it with the last column view.
+struct ImportedArray {
+  ArrowArray array;
+  GiftedAlignedBuffer validity; // Re-aligned bitmap when offset % 8 != 0.
+
+  ~ImportedArray() {
+    if (array.release != nullptr) array.release(&array);
+  }
+};
+
+inline void FillSchema(const char *format, ArrowSchema *schema) {
+  schema->format = format;
+  schema->name = "";
+  schema->metadata = nullptr;
+  schema->flags = ARROW_FLAG_NULLABLE;
+  schema->n_children = 0;
+  schema->children = nullptr;
+  schema->dictionary = nullptr;
+  schema->release = &ReleaseSchema;
+  schema->private_data = nullptr;
+}
+
+}  // namespace gifted_arrow_internal
+
+/**
+ * @brief Hand a column to an Arrow consumer without copying: the column is
+ *        moved into the exported array, and freed when the consumer calls
+ *        the array's release callback.
+ **/
+inline void GiftedExportArrowArray(GiftedColumnVector &&column,
+                                   ArrowSchema *schema,
+                                   ArrowArray *array) {
+  using namespace gifted_arrow_internal;
+  const char *format = GiftedTypeIdToArrowFormat(column.getTypeId());
+  if (format == nullptr) {
+    throw std::invalid_argument("GiftedExportArrowArray: type has no Arrow equivalent");
+  }
+
+  ExportedArray *exported = new ExportedArray(std::move(column));
+  const GiftedColumnVector &owned = exported->column;
+  exported->buffers[0] = owned.getValidityBitmap();
+  if (owned.isVariableLength()) {
+    exported->buffers[1] = owned.getOffsets();
+    exported->buffers[2] = owned.getValues();
+  } else {
+    exported->buffers[1] = owned.getValues();
+  }
+
+  std::int64_t nullCount = 0;
+  if (owned.getValidityBitmap() != nullptr) {
+    for (std::size_t i = 0; i < owned.size(); i++) nullCount += owned.isNull(i);
+  }
+
+  FillSchema(format, schema);
+  array->length = static_cast<std::int64_t>(owned.size());
+  array->null_count = nullCount;
+  array->offset = 0;
+  array->n_buffers = owned.isVariableLength() ? 3 : 2;
+  array->n_children = 0;
+  array->buffers = exported->buffers;
+  array->children = nullptr;
+  array->dictionary = nullptr;
+  array->release = &ReleaseArray;
+  array->private_data = exported;
+}
+
+/**
+ * @brief Export the result of a vectorized kernel (one bool per row) as an
+ *        Arrow boolean array, with the validity of the input column.
+ **/
+inline void GiftedExportArrowBooleans(const bool *result,
+                                      const GiftedColumnVector &input,
+                                      ArrowSchema *schema,
+                                      ArrowArray *array) {
+  using namespace gifted_arrow_internal;
+  // The exported column only carries the validity bitmap.
+  GiftedColumnVector validity(GiftedBaseType::_GiftedUnknownTypeId, 1, 0);
+  for (std::size_t i = 0; i < input.size(); i++) {
+    if (input.isNull(i)) {
+      validity.AppendNull();
+    } else {
+      validity.AppendFixedSlots(1)[0] = 0;
+    }
+  }
+  ExportedArray *exported = new ExportedArray(std::move(validity));
+  exported->bitmap.Grow((input.size() + 7) / 8 + 16, 0);
+  GiftedPackBools(result, input.size(), reinterpret_cast<std::uint8_t*>(exported->bitmap.data()));
+  exported->buffers[0] = exported->column.getValidityBitmap();
+  exported->buffers[1] = exported->bitmap.data();
+
+  std::int64_t nullCount = 0;
+  for (std::size_t i = 0; i < input.size(); i++) nullCount += input.isNull(i);
+
+  FillSchema("b", schema);
+  array->length = static_cast<std::int64_t>(input.size());
+  array->null_count = nullCount;
+  array->offset = 0;
+  array->n_buffers = 2;
+  array->n_children = 0;
+  array->buffers = exported->buffers;
+  array->children = nullptr;
+  array->dictionary = nullptr;
+  array->release = &ReleaseArray;
+  array->private_data = exported;
+}
+
+/**
+ * @brief Wrap an Arrow array as a (read-only) column without copying the
+ *        values. Ownership of the array moves to the column: "array" is
+ *        marked released, and the producer's release callback runs once the
+ *        column (and any column moved from it) is gone.
+ **/
+inline GiftedColumnVector GiftedImportArrowArray(const GiftedTypeRegistry &registry,
+                                                 const ArrowSchema &schema,
+                                                 ArrowArray *array) {
+  using namespace gifted_arrow_internal;
+  const GiftedBaseType::GiftedTypeId typeId = GiftedArrowFormatToTypeId(schema.format);
+  const GiftedTypeRegistry::Entry *entry = registry.getEntry(typeId);
+  if (entry == nullptr) {
+    throw std::invalid_argument(std::string("GiftedImportArrowArray: unsupported format ") + schema.format);
+  }
+
+  std::shared_ptr<ImportedArray> imported(new ImportedArray);
+  imported->array = *array;
+  array->release = nullptr; // Moved.
+
+  const ArrowArray &moved = imported->array;
+  const std::size_t offset = static_cast<std::size_t>(moved.offset);
+  const std::size_t length = static_cast<std::size_t>(moved.length);
+  const std::uint8_t *validity = static_cast<const std::uint8_t*>(moved.buffers[0]);
+  if (moved.null_count == 0) {
+    validity = nullptr;
+  } else if (validity != nullptr && offset % 8 != 0) {
+    // A bitmap that does not start on a byte boundary has to be shifted.
+    imported->validity.Grow((length + 7) / 8, 0);
+    std::uint8_t *shifted = reinterpret_cast<std::uint8_t*>(imported->validity.data());
+    std::memset(shifted, 0, (length + 7) / 8);
+    for (std::size_t i = 0; i < length; i++) {
+      if (validity[(offset + i) >> 3] & (1u << ((offset + i) & 7))) {
+        shifted[i >> 3] |= static_cast<std::uint8_t>(1u << (i & 7));
+      }
+    }
+    validity = shifted;
+  } else if (validity != nullptr) {
+    validity += offset / 8;
+  }
+
+  if (entry->length == 0) {
+    return GiftedColumnVector::Wrap(
+        typeId, 0, length,
+        static_cast<const char*>(moved.buffers[2]),
+        static_cast<const GiftedColumnVector::OffsetType*>(moved.buffers[1]) + offset,
+        validity, imported);
+  }
+  return GiftedColumnVector::Wrap(
+      typeId, entry->length, length,
+      static_cast<const char*>(moved.buffers[1]) + offset * entry->length,
+      nullptr, validity, imported);
+}
+
+namespace gifted_arrow_internal {
+
+// A file mapped read-only into memory, unmapped with the last reference.
+struct MappedFile {
+  MappedFile() : data(nullptr), size(0) {}
+  ~MappedFile() {
+    if (data != nullptr) munmap(const_cast<std::uint8_t*>(data), size);
+  }
+
+  const std::uint8_t *data;
+  std::size_t size;
+};
+
+/**
+ * @brief Just enough of a FlatBuffers reader to walk the Arrow IPC metadata.
+ *        Every access is bounds checked against the buffer.
+ **/
+class FlatTable {
+public:
+  FlatTable(const std::uint8_t *base, const std::size_t size, const std::size_t position)
+      : _base(base), _size(size), _position(position) {
+    _vtable = _position - Read<std::int32_t>(_position);
+    _vtableSize = Read<std::uint16_t>(_vtable);
+  }
+
+  static FlatTable Root(const std::uint8_t *base, const std::size_t size) {
+    FlatTable bootstrap(base, size);
+    return FlatTable(base, size, bootstrap.Read<std::uint32_t>(0));
+  }
+
+  bool has(const int field) const {return FieldPosition(field) != 0;}
+
+  template <typename T>
+  T getScalar(const int field, const T defaultValue) const {
+    const std::size_t position = FieldPosition(field);
+    return position == 0 ? defaultValue : Read<T>(position);
+  }
+
+  FlatTable getTable(const int field) const {
+    return FlatTable(_base, _size, Target(field));
+  }
+
+  std::size_t getVectorLength(const int field) const {
+    return has(field) ? Read<std::uint32_t>(Target(field)) : 0;
+  }
+
+  // Vector of tables.
+  FlatTable getTableAt(const int field, const std::size_t i) const {
+    const std::size_t element = Target(field) + 4 + 4 * i;
+    return FlatTable(_base, _size, element + Read<std::uint32_t>(element));
+  }
+
+  // Vector of structs of "structSize" bytes: position of element i.
+  std::size_t getStructAt(const int field, const std::size_t i, const std::size_t structSize) const {
+    return Target(field) + 4 + structSize * i;
+  }
+
+  std::string getString(const int field) const {
+    if (!has(field)) return std::string();
+    const std::size_t position = Target(field);
+    const std::uint32_t length = Read<std::uint32_t>(position);
+    Check(position + 4 + length);
+    return std::string(reinterpret_cast<const char*>(_base + position + 4), length);
+  }
+
+  template <typename T>
+  T Read(const std::size_t position) const {
+    Check(position + sizeof(T));
+    T value;
+    std::memcpy(&value, _base + position, sizeof(T));
+    return value;
+  }
+
+private:
+  FlatTable(const std::uint8_t *base, const std::size_t size)
+      : _base(base), _size(size), _position(0), _vtable(0), _vtableSize(0) {}
+
+  void Check(const std::size_t end) const {
+    if (end > _size) {
+      throw std::runtime_error("GiftedArrowFileReader: corrupt metadata");
+    }
+  }
+
+  std::size_t FieldPosition(const int field) const {
+    const std::size_t entry = 4 + 2 * field;
+    if (entry + 2 > _vtableSize) return 0;
+    const std::uint16_t offset = Read<std::uint16_t>(_vtable + entry);
+    return offset == 0 ? 0 : _position + offset;
+  }
+
+  std::size_t Target(const int field) const {
+    const std::size_t position = FieldPosition(field);
+    if (position == 0) {
+      throw std::runtime_error("GiftedArrowFileReader: missing metadata field");
+    }
+    return position + Read<std::uint32_t>(position);
+  }
+
+  const std::uint8_t *_base;
+  std::size_t _size;
+  std::size_t _position;
+  std::size_t _vtable;
+  std::size_t _vtableSize;
+};
+
+}  // namespace gifted_arrow_internal
+
+/**
+ * @brief Reads columns straight out of an Arrow IPC file (the "Feather v2"
+ *        random access format). The file is mapped and each column of each
+ *        record batch comes back as a GiftedColumnVector view over the
+ *        mapping, so VectorizedEqual and friends run on the file's pages
+ *        with no copy or decode step.
+ *
+ *        Columns of types without a Gifted equivalent are listed with an
+ *        unknown type id and cannot be read. Compressed bodies, dictionary
+ *        encoded, nested, run-end encoded and view columns are not supported.
+ **/
+class GiftedArrowFileReader {
+public:
+  GiftedArrowFileReader(const GiftedTypeRegistry &registry, const std::string &path)
+      : _registry(registry), _file(new gifted_arrow_internal::MappedFile) {
+    using gifted_arrow_internal::FlatTable;
+    MapFile(path);
+
+    static const char kMagic[] = "ARROW1";
+    const std::uint8_t *data = _file->data;
+    const std::size_t size = _file->size;
+    if (size < 22 || std::memcmp(data, kMagic, 6) != 0 || std::memcmp(data + size - 6, kMagic, 6) != 0) {
+      throw std::runtime_error("GiftedArrowFileReader: " + path + " is not an Arrow IPC file");
+    }
+
+    // File layout: magic, messages, footer, footer length, magic.
+    std::int32_t footerLength;
+    std::memcpy(&footerLength, data + size - 10, sizeof(footerLength));
+    if (footerLength <= 0 || static_cast<std::size_t>(footerLength) > size - 18) {
+      throw std::runtime_error("GiftedArrowFileReader: corrupt footer");
+    }
+    const FlatTable footer = FlatTable::Root(data + size - 10 - footerLength, footerLength);
+
+    // Footer.schema.fields
+    const FlatTable schema = footer.getTable(1);
+    if (schema.getScalar<std::int16_t>(0, 0) != 0) {
+      throw std::runtime_error("GiftedArrowFileReader: big endian files are not supported");
+    }
+    for (std::size_t i = 0; i < schema.getVectorLength(1); i++) {
+      const FlatTable field = schema.getTableAt(1, i);
+      Column column;
+      column.name = field.getString(0);
+      column.typeId = GiftedBaseType::_GiftedUnknownTypeId;
+      const std::uint8_t typeType = field.getScalar<std::uint8_t>(2, 0);
+      column.numBuffers = BuffersForType(typeType);
+      if (field.has(4)) {
+        column.numBuffers = 2; // Dictionary indices; not mapped.
+      } else if (typeType == kArrowInt) {
+        const FlatTable type = field.getTable(3);
+        const std::int32_t bitWidth = type.getScalar<std::int32_t>(0, 0);
+        const bool isSigned = type.getScalar<std::uint8_t>(1, 0) != 0;
+        if (isSigned && bitWidth == 64) column.typeId = GiftedBaseType::_GiftedIntTypeId;
+        if (isSigned && bitWidth == 32) column.typeId = GiftedBaseType::_GiftedInt32TypeId;
+      } else if (typeType == kArrowUtf8) {
+        column.typeId = GiftedBaseType::_GiftedVarCharTypeId;
+      }
+      _columns.push_back(column);
+    }
+
+    // Footer.recordBatches, a vector of Block structs.
+    for (std::size_t i = 0; i < footer.getVectorLength(3); i++) {
+      const std::size_t block = footer.getStructAt(3, i, 24);
+      Block entry;
+      entry.offset = footer.Read<std::int64_t>(block);
+      entry.metaDataLength = footer.Read<std::int32_t>(block + 8);
+      entry.bodyLength = footer.Read<std::int64_t>(block + 16);
+      _batches.push_back(entry);
+    }
+  }
+
+  std::size_t getNumColumns() const {return _columns.size();}
+  std::size_t getNumRecordBatches() const {return _batches.size();}
+  const std::string& getColumnName(const std::size_t column) const {return _columns[column].name;}
+  GiftedBaseType::GiftedTypeId getColumnType(const std::size_t column) const {
+    return _columns[column].typeId;
+  }
+
+  /**
+   * @brief A view over one column of one record batch. The view keeps the
+   *        file mapped for as long as it lives.
+   **/
+  GiftedColumnVector ReadColumn(const std::size_t batch, const std::size_t column) const {
+    using gifted_arrow_internal::FlatTable;
+    if (batch >= _batches.size() || column >= _columns.size()) {
+      throw std::out_of_range("GiftedArrowFileReader: no such record batch or column");
+    }
+    const GiftedTypeRegistry::Entry *entry = _registry.getEntry(_columns[column].typeId);
+    if (entry == nullptr) {
+      throw std::invalid_argument("GiftedArrowFileReader: column " + _columns[column].name +
+                                  " has no Gifted type");
+    }
+
+    const Block &block = _batches[batch];
+    const std::uint8_t *data = _file->data;
+    const std::size_t size = _file->size;
+    // The body follows the metadata and must lie within the file.
+    if (block.offset < 0 || block.metaDataLength < 8 || block.bodyLength < 0 ||
+        static_cast<std::uint64_t>(block.offset) > size ||
+        static_cast<std::uint64_t>(block.metaDataLength) > size - block.offset ||
+        static_cast<std::uint64_t>(block.bodyLength) > size - block.offset - block.metaDataLength) {
+      throw std::runtime_error("GiftedArrowFileReader: corrupt block");
+    }
+
+    // Encapsulated message: [0xFFFFFFFF] length, then the Message flatbuffer.
+    std::size_t messageStart = static_cast<std::size_t>(block.offset);
+    std::int32_t prefix;
+    std::memcpy(&prefix, data + messageStart, sizeof(prefix));
+    messageStart += (prefix == -1) ? 8 : 4;
+    const FlatTable message = FlatTable::Root(data + messageStart,
+                                              block.offset + block.metaDataLength - messageStart);
+    if (message.getScalar<std::uint8_t>(1, 0) != kArrowRecordBatch) {
+      throw std::runtime_error("GiftedArrowFileReader: block is not a record batch");
+    }
+    const FlatTable recordBatch = message.getTable(2);
+    if (recordBatch.has(3)) {
+      throw std::runtime_error("GiftedArrowFileReader: compressed record batches are not supported");
+    }
+
+    std::size_t firstBuffer = 0;
+    for (std::size_t c = 0; c < column; c++) {
+      if (_columns[c].numBuffers < 0) {
+        throw std::runtime_error("GiftedArrowFileReader: nested and view columns are not supported");
+      }
+      firstBuffer += _columns[c].numBuffers;
+    }
+
+    // FieldNode {length, null_count}, Buffer {offset, length}.
+    const int numBuffers = _columns[column].numBuffers;
+    if (column >= recordBatch.getVectorLength(1) ||
+        firstBuffer + numBuffers > recordBatch.getVectorLength(2)) {
+      throw std::runtime_error("GiftedArrowFileReader: record batch has too few nodes or buffers");
+    }
+    const std::size_t node = recordBatch.getStructAt(1, column, 16);
+    const std::int64_t length = recordBatch.Read<std::int64_t>(node);
+    const std::int64_t nullCount = recordBatch.Read<std::int64_t>(node + 8);
+    if (length < 0 || nullCount < 0 || nullCount > length) {
+      throw std::runtime_error("GiftedArrowFileReader: corrupt field node");
+    }
+    const std::uint8_t *body = data + block.offset + block.metaDataLength;
+    const std::uint64_t bodySize = static_cast<std::uint64_t>(block.bodyLength);
+    const void *buffers[3] = {nullptr, nullptr, nullptr};
+    std::uint64_t bufferLengths[3] = {0, 0, 0};
+    for (int b = 0; b < numBuffers; b++) {
+      const std::size_t buffer = recordBatch.getStructAt(2, firstBuffer + b, 16);
+      const std::int64_t offset = recordBatch.Read<std::int64_t>(buffer);
+      const std::int64_t bufferLength = recordBatch.Read<std::int64_t>(buffer + 8);
+      if (offset < 0 || bufferLength < 0 || static_cast<std::uint64_t>(offset) > bodySize ||
+          static_cast<std::uint64_t>(bufferLength) > bodySize - offset) {
+        throw std::runtime_error("GiftedArrowFileReader: corrupt buffer");
+      }
+      buffers[b] = bufferLength == 0 ? nullptr : body + offset;
+      bufferLengths[b] = static_cast<std::uint64_t>(bufferLength);
+    }
+
+    // The buffers must hold "length" values; the offsets must stay within the data.
+    const std::uint64_t count = static_cast<std::uint64_t>(length);
+    if (nullCount != 0 && bufferLengths[0] < (count + 7) / 8) {
+      throw std::runtime_error("GiftedArrowFileReader: validity buffer too short");
+    }
+    if (entry->length == 0) {
+      typedef GiftedColumnVector::OffsetType OffsetType;
+      if (count != 0 && bufferLengths[1] / sizeof(OffsetType) < count + 1) {
+        throw std::runtime_error("GiftedArrowFileReader: offsets buffer too short");
+      }
+      const std::uint8_t *offsets = static_cast<const std::uint8_t*>(buffers[1]);
+      OffsetType previous = 0;
+      for (std::uint64_t i = 0; count != 0 && i <= count; i++) {
+        OffsetType current;
+        std::memcpy(&current, offsets + i * sizeof(OffsetType), sizeof(OffsetType));
+        if (current < previous || static_cast<std::uint64_t>(current) > bufferLengths[2]) {
+          throw std::runtime_error("GiftedArrowFileReader: corrupt offsets");
+        }
+        previous = current;
+      }
+    } else if (bufferLengths[1] / entry->length < count) {
+      throw std::runtime_error("GiftedArrowFileReader: values buffer too short");
+    }
+
+    const std::uint8_t *validity = nullCount == 0 ? nullptr : static_cast<const std::uint8_t*>(buffers[0]);
+    if (entry->length == 0) {
+      return GiftedColumnVector::Wrap(entry->id, 0, length,
+                                      static_cast<const char*>(buffers[2]),
+                                      static_cast<const GiftedColumnVector::OffsetType*>(buffers[1]),
+                                      validity, _file);
+    }
+    return GiftedColumnVector::Wrap(entry->id, entry->length, length,
+                                    static_cast<const char*>(buffers[1]),
+                                    nullptr, validity, _file);
+  }
+
+private:
+  // Arrow "Type" union tags and "MessageHeader" union tags.
+  static const std::uint8_t kArrowInt = 2;
+  static const std::uint8_t kArrowUtf8 = 5;
+  static const std::uint8_t kArrowRecordBatch = 3;
+
+  struct Column {
+    std::string name;
+    GiftedBaseType::GiftedTypeId typeId;
+    int numBuffers; // In the record batch body; -1 for nested and view types.
+  };
+
+  struct Block {
+    std::int64_t offset;
+    std::int32_t metaDataLength;
+    std::int64_t bodyLength;
+  };
+
+  static int BuffersForType(const std::uint8_t typeType) {
+    switch (typeType) {
+      case 1:            // Null
+        return 0;
+      case 4: case 5:    // Binary, Utf8
+      case 19: case 20:  // LargeBinary, LargeUtf8
+        return 3;
+      case 12: case 13: case 14: case 16: case 17: case 21:  // Nested.
+      case 22:                                                // RunEndEncoded
+        return -1;
+      default:
+        // Fixed width: validity and values. The view types (23 on) carry a
+        // variable number of buffers, so neither they nor any later type can
+        // be located.
+        return typeType < 22 ? 2 : -1;
+    }
+  }
+
+  void MapFile(const std::string &path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error("GiftedArrowFileReader: cannot open " + path);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+      close(fd);
+      throw std::runtime_error("GiftedArrowFileReader: cannot stat " + path);
+    }
+    void *mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+      throw std::runtime_error("GiftedArrowFileReader: cannot map " + path);
+    }
+    _file->data = static_cast<const std::uint8_t*>(mapped);
+    _file->size = static_cast<std::size_t>(info.st_size);
+  }
+
+  const GiftedTypeRegistry &_registry;
+  std::shared_ptr<gifted_arrow_internal::MappedFile> _file;
+  std::vector<Column> _columns;
+  std::vector<Block> _batches;
+};
+
+#endif  // GIFTED_STORAGE_ARROW_INTEROP_HPP_
@@ -0,0 +1,109 @@
+//
+//  BitmapIndex.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_STORAGE_BITMAP_INDEX_HPP_
+#define GIFTED_STORAGE_BITMAP_INDEX_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "storage/ColumnVector.hpp"
+#include "utility/RoaringBitmap.hpp"
+
+/**
+ * @brief A bitmap index over one low cardinality column (a status, a
+ *        category): the column is dictionary encoded, and each dictionary
+ *        code has a compressed bitmap of the rows holding its value.
+ *
+ *        Equal and IN are answered by taking one bitmap or Or-ing a few,
+ *        without reading the column, and predicates on several indexed
+ *        columns combine with GiftedRoaringBitmap::And / Or / AndNot.
+ *        Columns with more than "maxDistinct" values are rejected; their
+ *        bitmaps would not pay for themselves. Nulls are in no bitmap. The
+ *        index copies what it needs from the column.
+ **/
+class GiftedBitmapIndex {
+public:
+  explicit GiftedBitmapIndex(const GiftedColumnVector &column, const std::size_t maxDistinct = 4096) {
+    if (column.size() > std::numeric_limits<std::uint32_t>::max()) {
+      throw std::overflow_error("GiftedBitmapIndex: column is too large");
+    }
+    _codes.reserve(column.size());
+    for (std::size_t i = 0; i < column.size(); i++) {
+      if (column.isNull(i)) {
+        _codes.push_back(static_cast<std::uint32_t>(kNullCode));
+        continue;
+      }
+      std::size_t length;
+      const char *value = column.getElement(i, &length);
+      std::pair<Dictionary::iterator, bool> entry =
+          _dictionary.insert(std::make_pair(std::string(value, length), static_cast<std::uint32_t>(_values.size())));
+      if (entry.second) {
+        if (_values.size() == maxDistinct) {
+          throw std::length_error("GiftedBitmapIndex: column has more than " + std::to_string(maxDistinct) +
+                                  " distinct values");
+        }
+        _values.push_back(entry.first->first);
+        _bitmaps.push_back(GiftedRoaringBitmap());
+      }
+      _codes.push_back(entry.first->second);
+      _bitmaps[entry.first->second].Add(static_cast<std::uint32_t>(i));
+    }
+  }
+
+  std::size_t getNumRows() const {return _codes.size();}
+  std::size_t getDictionarySize() const {return _values.size();}
+
+  /**
+   * @brief The dictionary code of each row (kNullCode for nulls), and the
+   *        value of each code (raw form).
+   **/
+  const std::vector<std::uint32_t>& getCodes() const {return _codes;}
+  const std::string& getValue(const std::uint32_t code) const {return _values.at(code);}
+
+  /**
+   * @brief The rows whose value is "value" (raw form, "length" bytes).
+   **/
+  GiftedRoaringBitmap Equal(const char *value, const std::size_t length) const {
+    Dictionary::const_iterator entry = _dictionary.find(std::string(value, length));
+    return entry == _dictionary.end() ? GiftedRoaringBitmap() : _bitmaps[entry->second];
+  }
+
+  /**
+   * @brief The rows whose value is any of "values" (raw forms).
+   **/
+  GiftedRoaringBitmap In(const std::vector<std::string> &values) const {
+    GiftedRoaringBitmap rows;
+    for (std::size_t v = 0; v < values.size(); v++) {
+      Dictionary::const_iterator entry = _dictionary.find(values[v]);
+      if (entry != _dictionary.end()) rows = GiftedRoaringBitmap::Or(rows, _bitmaps[entry->second]);
+    }
+    return rows;
+  }
+
+  std::size_t getBytes() const {
+    std::size_t bytes = _codes.size() * sizeof(std::uint32_t);
+    for (std::size_t c = 0; c < _bitmaps.size(); c++) bytes += _bitmaps[c].getBytes() + _values[c].size();
+    return bytes;
+  }
+
+  static const std::uint32_t kNullCode = std::numeric_limits<std::uint32_t>::max();
+
+private:
+  typedef std::unordered_map<std::string, std::uint32_t> Dictionary;
+
+  Dictionary _dictionary;
+  std::vector<std::string> _values;  // By code.
+  std::vector<GiftedRoaringBitmap> _bitmaps;  // By code.
+  std::vector<std::uint32_t> _codes;  // By row.
+};
+
+#endif  // GIFTED_STORAGE_BITMAP_INDEX_HPP_
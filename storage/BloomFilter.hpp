@@ -0,0 +1,127 @@
+//
+//  BloomFilter.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_STORAGE_BLOOM_FILTER_HPP_
+#define GIFTED_STORAGE_BLOOM_FILTER_HPP_
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "utility/AlignedBuffer.hpp"
+
+/**
+ * @brief A blocked ("split block") Bloom filter over 64 bit hashes.
+ *
+ *        The filter is an array of 32 byte blocks, cache line aligned, so a
+ *        key touches one cache line only. The high half of a key's hash
+ *        picks its block; the low half, multiplied by eight odd constants,
+ *        picks one bit in each of the block's eight 32 bit words. Setting or
+ *        testing those bits is one 256 bit operation with AVX2, and an eight
+ *        step loop without it.
+ *
+ *        At 16 bits per key the false positive rate is about 0.1%.
+ **/
+class GiftedBlockedBloomFilter {
+public:
+  GiftedBlockedBloomFilter() : _numBlocks(0) {}
+
+  /**
+   * @brief Size the (empty) filter for "numKeys" keys.
+   **/
+  void Reset(const std::size_t numKeys, const std::size_t bitsPerKey = 16) {
+    _numBlocks = (numKeys * bitsPerKey + kBlockBits - 1) / kBlockBits;
+    if (_numBlocks == 0) _numBlocks = 1;
+    _blocks = GiftedAlignedBuffer(_numBlocks * kBlockBytes);
+    std::memset(_blocks.data(), 0, _numBlocks * kBlockBytes);
+  }
+
+  /**
+   * @brief True until the filter has been sized with Reset().
+   **/
+  bool empty() const {return _numBlocks == 0;}
+
+  std::size_t getBytes() const {return _numBlocks * kBlockBytes;}
+
+  void Insert(const std::uint64_t hash) {
+    std::uint32_t *block = Block(hash);
+#if defined(__AVX2__)
+    __m256i *words = reinterpret_cast<__m256i*>(block);
+    _mm256_store_si256(words, _mm256_or_si256(_mm256_load_si256(words), Mask(hash)));
+#else
+    std::uint32_t mask[8];
+    Mask(hash, mask);
+    for (int i = 0; i < 8; i++) block[i] |= mask[i];
+#endif
+  }
+
+  void InsertBatch(const std::uint64_t *hashes, const std::size_t count) {
+    for (std::size_t i = 0; i < count; i++) Insert(hashes[i]);
+  }
+
+  bool MayContain(const std::uint64_t hash) const {
+    const std::uint32_t *block = Block(hash);
+#if defined(__AVX2__)
+    // All the mask's bits must be set in the block.
+    return _mm256_testc_si256(_mm256_load_si256(reinterpret_cast<const __m256i*>(block)), Mask(hash)) != 0;
+#else
+    std::uint32_t mask[8];
+    Mask(hash, mask);
+    std::uint32_t missing = 0;
+    for (int i = 0; i < 8; i++) missing |= mask[i] & ~block[i];
+    return missing == 0;
+#endif
+  }
+
+  /**
+   * @brief result[i] = MayContain(hashes[i]). The block addresses of the
+   *        whole batch are touched first, so the cache misses overlap.
+   **/
+  void ProbeBatch(const std::uint64_t *hashes, const std::size_t count, bool *result) const {
+    static const std::size_t kPrefetchDistance = 16;
+    for (std::size_t i = 0; i < count; i++) {
+      if (i + kPrefetchDistance < count) {
+        __builtin_prefetch(Block(hashes[i + kPrefetchDistance]));
+      }
+      result[i] = MayContain(hashes[i]);
+    }
+  }
+
+private:
+  static const std::size_t kBlockBytes = 32;
+  static const std::size_t kBlockBits = kBlockBytes * 8;
+
+  std::uint32_t* Block(const std::uint64_t hash) const {
+    const std::uint64_t block = ((hash >> 32) * _numBlocks) >> 32;
+    return reinterpret_cast<std::uint32_t*>(const_cast<char*>(_blocks.data()) + block * kBlockBytes);
+  }
+
+#if defined(__AVX2__)
+  static __m256i Mask(const std::uint64_t hash) {
+    const __m256i salts = _mm256_setr_epi32(0x47b6137b, 0x44974d91, 0x8824ad5b, 0xa2b7289d,
+                                            0x705495c7, 0x2df1424b, 0x9efc4947, 0x5c6bfb31);
+    const __m256i key = _mm256_set1_epi32(static_cast<std::int32_t>(hash));
+    const __m256i bits = _mm256_srli_epi32(_mm256_mullo_epi32(key, salts), 27);
+    return _mm256_sllv_epi32(_mm256_set1_epi32(1), bits);
+  }
+#else
+  static void Mask(const std::uint64_t hash, std::uint32_t *mask) {
+    static const std::uint32_t kSalts[8] = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+                                            0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+    const std::uint32_t key = static_cast<std::uint32_t>(hash);
+    for (int i = 0; i < 8; i++) mask[i] = 1u << ((key * kSalts[i]) >> 27);
+  }
+#endif
+
+  std::size_t _numBlocks;
+  GiftedAlignedBuffer _blocks;
+};
+
+#endif  // GIFTED_STORAGE_BLOOM_FILTER_HPP_
@@ -0,0 +1,507 @@
+//
+//  BufferPool.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_STORAGE_BUFFER_POOL_HPP_
+#define GIFTED_STORAGE_BUFFER_POOL_HPP_
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "storage/ColumnVector.hpp"
+#include "types/BaseType.hpp"
+#include "utility/AlignedBuffer.hpp"
+#include "utility/IoUring.hpp"
+
+struct GiftedBufferPoolOptions {
+  GiftedBufferPoolOptions()
+      : frameBytes(64 * 1024), numFrames(256), k(2), directIO(false), queueDepth(16) {}
+
+  std::size_t frameBytes;  // Bytes per block and frame; whole pages.
+  std::size_t numFrames;   // Blocks held in memory at most.
+  std::size_t k;           // References LRU-K eviction looks back on.
+  bool directIO;           // Bypass the page cache (O_DIRECT) where possible.
+  std::size_t queueDepth;  // Prefetch reads in flight at most.
+};
+
+/**
+ * @brief A buffer pool over a file of fixed size blocks: at most numFrames
+ *        blocks are in memory, in frames of one page aligned allocation, so
+ *        kernels can work on tables larger than memory.
+ *
+ *        A block is used between Pin() and Unpin() (or for the life of a
+ *        PinColumn() view); pinned frames are never evicted. A miss evicts
+ *        by LRU-K: the unpinned frame whose k-th most recent reference is
+ *        oldest goes first, and frames referenced fewer than k times go
+ *        before all others, oldest last reference first. Blocks pinned with
+ *        the kScan hint do not count as referenced and go first of all, so
+ *        a large scan passes through the pool without pushing out the
+ *        blocks that lookups keep coming back to. Dirty blocks are written
+ *        back when evicted or flushed.
+ *
+ *        Prefetch() starts reading blocks into free or evictable frames
+ *        ahead of their Pin() (through io_uring where available, as a read
+ *        ahead hint to the kernel otherwise). Thread safe; a miss reads
+ *        under the pool's lock.
+ **/
+class GiftedBufferPool {
+public:
+  enum AccessHint {
+    kNormal,
+    kScan     // Read once, e.g. by a sequential scan.
+  };
+
+  struct Stats {
+    Stats() : hits(0), misses(0), evictions(0), writes(0), prefetches(0) {}
+
+    std::size_t hits;
+    std::size_t misses;
+    std::size_t evictions;
+    std::size_t writes;
+    std::size_t prefetches;  // Reads started by Prefetch().
+  };
+
+  /**
+   * @param path The block file; created if it does not exist.
+   **/
+  explicit GiftedBufferPool(const std::string &path,
+                            const GiftedBufferPoolOptions &options = GiftedBufferPoolOptions())
+      : _frameBytes(options.frameBytes),
+        _k(options.k > 0 ? options.k : 1),
+        _fd(-1),
+        _numBlocks(0),
+        _clock(0),
+        _inFlight(0),
+        _useRing(false) {
+    if (options.frameBytes == 0 || options.frameBytes % kPageBytes != 0 || options.numFrames == 0) {
+      throw std::invalid_argument("GiftedBufferPool: frames must be whole pages, and there must be some");
+    }
+    // The destructor does not run if this throws.
+    try {
+      Open(path, options.directIO);
+      _memory = GiftedAlignedBuffer(options.numFrames * _frameBytes, kPageBytes);
+      _frames.resize(options.numFrames);
+      for (std::size_t f = 0; f < _frames.size(); f++) _frames[f].history.assign(_k, 0);
+#if defined(GIFTED_HAVE_IO_URING)
+      _useRing = _ring.Setup(static_cast<unsigned>(options.queueDepth > 0 ? options.queueDepth : 1));
+#endif
+    } catch (...) {
+      if (_fd >= 0) close(_fd);
+      throw;
+    }
+  }
+
+  ~GiftedBufferPool() {
+    try {
+      std::lock_guard<std::mutex> lock(_mutex);
+      // The kernel may still be writing into the frames.
+      while (_inFlight > 0) WaitForCompletion();
+      for (std::size_t f = 0; f < _frames.size(); f++) WriteBack(f);
+    } catch (...) {
+    }
+    if (_fd >= 0) close(_fd);
+  }
+
+  std::size_t getFrameBytes() const {return _frameBytes;}
+  std::size_t getNumFrames() const {return _frames.size();}
+
+  std::uint64_t getNumBlocks() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _numBlocks;
+  }
+
+  Stats getStats() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _stats;
+  }
+
+  /**
+   * @brief Pin block "block" in a frame, reading it if need be, and return
+   *        its getFrameBytes() bytes.
+   *
+   * @exception std::runtime_error if every frame is pinned, or I/O fails.
+   **/
+  char* Pin(const std::uint64_t block, const AccessHint hint = kNormal) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (block >= _numBlocks) throw std::out_of_range("GiftedBufferPool: no such block");
+    std::unordered_map<std::uint64_t, std::size_t>::const_iterator found = _blockFrames.find(block);
+    std::size_t f = 0;
+    if (found != _blockFrames.end()) {
+      f = found->second;
+      while (_frames[f].loading) WaitForCompletion();
+      // A failed prefetch left the frame.
+      if (_frames[f].valid && _frames[f].block == block) {
+        _stats.hits++;
+        Reference(f, hint);
+        return FrameData(f);
+      }
+    }
+    _stats.misses++;
+    f = TakeFrame(block);
+    ReadFrame(f, 0);
+    if (hint == kScan) {
+      _frames[f].scanOnly = true;
+      _frames[f].history[0] = ++_clock;
+    }
+    Reference(f, hint);
+    return FrameData(f);
+  }
+
+  /**
+   * @brief Release a Pin(); "dirty" if the block was changed.
+   **/
+  void Unpin(const std::uint64_t block, const bool dirty) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::unordered_map<std::uint64_t, std::size_t>::const_iterator found = _blockFrames.find(block);
+    if (found == _blockFrames.end() || _frames[found->second].pinCount == 0) {
+      throw std::logic_error("GiftedBufferPool: block is not pinned");
+    }
+    Frame &frame = _frames[found->second];
+    frame.pinCount--;
+    frame.dirty = frame.dirty || dirty;
+  }
+
+  /**
+   * @brief Add a zeroed block at the end of the file, pinned (and dirty).
+   *
+   * @return The new block's number.
+   **/
+  std::uint64_t NewBlock(char **data) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const std::uint64_t block = _numBlocks;
+    const std::size_t f = TakeFrame(block);
+    _numBlocks++;
+    std::memset(FrameData(f), 0, _frameBytes);
+    _frames[f].dirty = true;
+    Reference(f, kNormal);
+    *data = FrameData(f);
+    return block;
+  }
+
+  /**
+   * @brief Start reading blocks [first, first + count) that are not in
+   *        the pool, into free frames or frames that were only scanned, as
+   *        far as there are such frames and queue slots. Prefetched blocks
+   *        count as scanned until pinned without kScan.
+   **/
+  void Prefetch(const std::uint64_t first, const std::size_t count) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (std::uint64_t block = first; block < first + count && block < _numBlocks; block++) {
+      if (_blockFrames.count(block) > 0) continue;
+      if (!_useRing) {
+#if defined(POSIX_FADV_WILLNEED)
+        posix_fadvise(_fd, static_cast<off_t>(block * _frameBytes), static_cast<off_t>(_frameBytes),
+                      POSIX_FADV_WILLNEED);
+#endif
+        continue;
+      }
+      // Never at the expense of blocks that are in use.
+      std::size_t f = 0;
+      if (!FindVictim(true, &f)) return;
+      Frame &frame = _frames[f];
+      Evict(f);
+      frame.iov.iov_base = FrameData(f);
+      frame.iov.iov_len = _frameBytes;
+#if defined(GIFTED_HAVE_IO_URING)
+      if (!_ring.PrepareRead(_fd, &frame.iov, block * _frameBytes, f)) break;
+#endif
+      Assign(f, block);
+      frame.loading = true;
+      frame.scanOnly = true;
+      frame.history[0] = ++_clock;
+      _inFlight++;
+      _stats.prefetches++;
+    }
+#if defined(GIFTED_HAVE_IO_URING)
+    if (_useRing) _ring.Submit(0);
+#endif
+  }
+
+  /**
+   * @brief Write every dirty block back to the file.
+   **/
+  void FlushAll() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (std::size_t f = 0; f < _frames.size(); f++) WriteBack(f);
+  }
+
+  /**
+   * @brief Pin a block and view "count" fixed length values at "byteOffset"
+   *        in it as a read-only column, which unpins the block when it (and
+   *        any column moved or sliced from it) is gone. The column must not
+   *        outlive the pool.
+   **/
+  GiftedColumnVector PinColumn(const std::uint64_t block,
+                               const std::size_t byteOffset,
+                               const GiftedBaseType::GiftedTypeId typeId,
+                               const std::size_t elementLength,
+                               const std::size_t count,
+                               const AccessHint hint = kNormal) {
+    if (elementLength == 0 || byteOffset + count * elementLength > _frameBytes) {
+      throw std::invalid_argument("GiftedBufferPool: values are not within a block");
+    }
+    const char *data = Pin(block, hint);
+    const std::shared_ptr<const void> pin(static_cast<const void*>(data), Unpinner(this, block));
+    return GiftedColumnVector::Wrap(typeId, elementLength, count, data + byteOffset, nullptr, nullptr, pin);
+  }
+
+private:
+  static const std::size_t kPageBytes = 4096;
+  static const std::uint64_t kNoBlock = ~static_cast<std::uint64_t>(0);
+
+  struct Frame {
+    Frame()
+        : block(kNoBlock), pinCount(0), valid(false), dirty(false), loading(false), scanOnly(false), references(0),
+          iov() {}
+
+    std::uint64_t block;
+    std::size_t pinCount;
+    bool valid;
+    bool dirty;
+    bool loading;   // A prefetch read is in flight.
+    bool scanOnly;  // Only scanned or prefetched since it was read.
+    std::size_t references;
+    std::vector<std::uint64_t> history;  // Reference times, most recent first.
+    iovec iov;
+  };
+
+  struct Unpinner {
+    Unpinner(GiftedBufferPool *pool, const std::uint64_t block) : pool(pool), block(block) {}
+
+    void operator()(const void*) const {pool->Unpin(block, false);}
+
+    GiftedBufferPool *pool;
+    std::uint64_t block;
+  };
+
+  void Open(const std::string &path, const bool directIO) {
+    int flags = O_RDWR | O_CREAT;
+#if defined(O_DIRECT)
+    if (directIO) flags |= O_DIRECT;
+#endif
+    _fd = open(path.c_str(), flags, 0644);
+#if defined(O_DIRECT)
+    if (_fd < 0 && errno == EINVAL && directIO) {
+      _fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);  // The file system has no direct I/O.
+    }
+#endif
+    if (_fd < 0) {
+      throw std::runtime_error("GiftedBufferPool: cannot open " + path);
+    }
+#if defined(F_NOCACHE)
+    if (directIO) fcntl(_fd, F_NOCACHE, 1);
+#endif
+    struct stat info;
+    if (fstat(_fd, &info) != 0) {
+      throw std::runtime_error("GiftedBufferPool: cannot stat " + path);
+    }
+    _numBlocks = (static_cast<std::uint64_t>(info.st_size) + _frameBytes - 1) / _frameBytes;
+  }
+
+  char* FrameData(const std::size_t f) {return _memory.data() + f * _frameBytes;}
+
+  void Reference(const std::size_t f, const AccessHint hint) {
+    Frame &frame = _frames[f];
+    frame.pinCount++;
+    if (hint == kScan) return;
+    frame.scanOnly = false;
+    for (std::size_t i = _k - 1; i > 0; i--) frame.history[i] = frame.history[i - 1];
+    frame.history[0] = ++_clock;
+    frame.references++;
+  }
+
+  // The unpinned frame to evict first, a free one if there is one. With
+  // "scannedOnly" only free or scanned frames qualify.
+  bool FindVictim(const bool scannedOnly, std::size_t *victim) const {
+    bool found = false;
+    int bestClass = 0;
+    std::uint64_t bestTime = 0;
+    for (std::size_t f = 0; f < _frames.size(); f++) {
+      const Frame &frame = _frames[f];
+      if (frame.pinCount > 0 || frame.loading || (scannedOnly && frame.valid && !frame.scanOnly)) continue;
+      if (!frame.valid) {
+        *victim = f;
+        return true;
+      }
+      // Scanned, then seen fewer than k times (by the last time), then the
+      // rest (by the k-th last time).
+      int evictionClass = 2;
+      std::uint64_t time = frame.history[_k - 1];
+      if (frame.scanOnly) {
+        evictionClass = 0;
+        time = frame.history[0];
+      } else if (frame.references < _k) {
+        evictionClass = 1;
+        time = frame.history[0];
+      }
+      if (!found || evictionClass < bestClass || (evictionClass == bestClass && time < bestTime)) {
+        found = true;
+        bestClass = evictionClass;
+        bestTime = time;
+        *victim = f;
+      }
+    }
+    return found;
+  }
+
+  // A frame for "block", evicting if need be.
+  std::size_t TakeFrame(const std::uint64_t block) {
+    std::size_t f = 0;
+    if (!FindVictim(false, &f)) throw std::runtime_error("GiftedBufferPool: all frames are pinned");
+    Evict(f);
+    Assign(f, block);
+    return f;
+  }
+
+  void Evict(const std::size_t f) {
+    Frame &frame = _frames[f];
+    if (!frame.valid) return;
+    WriteBack(f);
+    _blockFrames.erase(frame.block);
+    _stats.evictions++;
+    frame = Frame();
+    frame.history.assign(_k, 0);
+  }
+
+  void Assign(const std::size_t f, const std::uint64_t block) {
+    Frame &frame = _frames[f];
+    frame.block = block;
+    frame.valid = true;
+    _blockFrames[block] = f;
+  }
+
+  void WriteBack(const std::size_t f) {
+    Frame &frame = _frames[f];
+    if (!frame.valid || !frame.dirty) return;
+    const char *data = FrameData(f);
+    const std::uint64_t offset = frame.block * _frameBytes;
+    for (std::size_t done = 0; done < _frameBytes;) {
+      const ssize_t result = pwrite(_fd, data + done, _frameBytes - done, static_cast<off_t>(offset + done));
+      if (result < 0) {
+        if (errno == EINTR) continue;
+        throw std::runtime_error(std::string("GiftedBufferPool: write failed: ") + std::strerror(errno));
+      }
+      done += static_cast<std::size_t>(result);
+    }
+    frame.dirty = false;
+    _stats.writes++;
+  }
+
+  // Read the frame's block from byte "done" on; past the end of the file
+  // it is zeros.
+  void ReadFrame(const std::size_t f, std::size_t done) {
+    char *data = FrameData(f);
+    const std::uint64_t offset = _frames[f].block * _frameBytes;
+    while (done < _frameBytes) {
+      const ssize_t result = pread(_fd, data + done, _frameBytes - done, static_cast<off_t>(offset + done));
+      if (result < 0) {
+        if (errno == EINTR) continue;
+        _blockFrames.erase(_frames[f].block);
+        _frames[f] = Frame();
+        _frames[f].history.assign(_k, 0);
+        throw std::runtime_error(std::string("GiftedBufferPool: read failed: ") + std::strerror(errno));
+      }
+      if (result == 0) break;
+      done += static_cast<std::size_t>(result);
+    }
+    std::memset(data + done, 0, _frameBytes - done);
+  }
+
+  // Complete one prefetch read.
+  void WaitForCompletion() {
+#if defined(GIFTED_HAVE_IO_URING)
+    std::uint64_t f;
+    int result;
+    while (!_ring.PopCompletion(&f, &result)) _ring.Submit(1);
+    _inFlight--;
+    Frame &frame = _frames[f];
+    frame.loading = false;
+    if (result < 0) {
+      // Only a hint: drop the frame, a Pin() reads the block itself.
+      _blockFrames.erase(frame.block);
+      frame = Frame();
+      frame.history.assign(_k, 0);
+      return;
+    }
+    ReadFrame(f, static_cast<std::size_t>(result));
+#endif
+  }
+
+  const std::size_t _frameBytes;
+  const std::size_t _k;
+  int _fd;
+  GiftedAlignedBuffer _memory;  // All the frames, back to back.
+
+  // Guarded by _mutex.
+  mutable std::mutex _mutex;
+  std::vector<Frame> _frames;
+  std::unordered_map<std::uint64_t, std::size_t> _blockFrames;
+  std::uint64_t _numBlocks;
+  std::uint64_t _clock;
+  std::size_t _inFlight;  // Prefetch reads the kernel has not completed.
+  Stats _stats;
+  bool _useRing;
+#if defined(GIFTED_HAVE_IO_URING)
+  GiftedIoUring _ring;
+#endif
+
+  GiftedBufferPool(const GiftedBufferPool&) = delete;
+  GiftedBufferPool& operator=(const GiftedBufferPool&) = delete;
+};
+
+/**
+ * @brief A column of fixed length values stored in consecutive blocks of
+ *        a GiftedBufferPool, as many whole values per block as fit.
+ **/
+struct GiftedPooledColumn {
+  GiftedBaseType::GiftedTypeId typeId;
+  std::size_t elementLength;
+  std::uint64_t firstBlock;
+  std::size_t numRows;
+  std::size_t rowsPerBlock;
+};
+
+/**
+ * @brief Write a column (without nulls) to new blocks of "pool".
+ **/
+inline GiftedPooledColumn GiftedStorePooledColumn(GiftedBufferPool *pool, const GiftedColumnVector &column) {
+  if (column.isVariableLength() || column.getValidityBitmap() != nullptr) {
+    throw std::invalid_argument("GiftedStorePooledColumn: only fixed length columns without nulls");
+  }
+  GiftedPooledColumn pooled;
+  pooled.typeId = column.getTypeId();
+  pooled.elementLength = column.getElementLength();
+  pooled.numRows = column.size();
+  pooled.rowsPerBlock = pool->getFrameBytes() / column.getElementLength();
+  if (pooled.rowsPerBlock == 0) throw std::invalid_argument("GiftedStorePooledColumn: values exceed a block");
+  pooled.firstBlock = pool->getNumBlocks();
+  for (std::size_t row = 0; row < column.size(); row += pooled.rowsPerBlock) {
+    char *data;
+    const std::uint64_t block = pool->NewBlock(&data);
+    if (block != pooled.firstBlock + row / pooled.rowsPerBlock) {
+      pool->Unpin(block, true);
+      throw std::logic_error("GiftedStorePooledColumn: blocks were added concurrently");
+    }
+    const std::size_t rows = column.size() - row < pooled.rowsPerBlock ? column.size() - row : pooled.rowsPerBlock;
+    std::memcpy(data, column.getValues() + row * pooled.elementLength, rows * pooled.elementLength);
+    pool->Unpin(block, true);
+  }
+  return pooled;
+}
+
+#endif  // GIFTED_STORAGE_BUFFER_POOL_HPP_
@@ -0,0 +1,407 @@
+//
+//  ColumnVector.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_STORAGE_COLUMN_VECTOR_HPP_
+#define GIFTED_STORAGE_COLUMN_VECTOR_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#include "types/BaseType.hpp"
+#include "utility/AlignedBuffer.hpp"
+
+/**
+ * @brief A column of values of one Gifted type, in the raw (marshalled) form
+ *        that the vectorized kernels consume.
+ *
+ *        Fixed length values are packed back to back in the values buffer.
+ *        Variable length values are concatenated in the values buffer and
+ *        located through size()+1 offsets, i.e. value i is the bytes
+ *        [offsets[i], offsets[i+1]). Nulls are tracked in an optional
+ *        validity bitmap (bit i set means value i is present), which is only
+ *        allocated once the first null shows up. This is the Apache Arrow
+ *        layout, so a column can also be a read-only view over buffers owned
+ *        by someone else (see Wrap()).
+ **/
+class GiftedColumnVector {
+public:
+  typedef std::int32_t OffsetType;
+
+  /**
+   * @param typeId The type of the values.
+   * @param elementLength The type's getLength(), i.e. 0 for variable length.
+   * @param initialCapacity Number of values to make room for up front.
+   **/
+  GiftedColumnVector(const GiftedBaseType::GiftedTypeId typeId,
+                     const std::size_t elementLength,
+                     const std::size_t initialCapacity = 1024)
+      : _typeId(typeId),
+        _elementLength(elementLength),
+        _size(0),
+        _valuesBytes(0),
+        _hasValidity(false),
+        _isView(false),
+        _viewValues(nullptr),
+        _viewOffsets(nullptr),
+        _viewValidity(nullptr) {
+    Reserve(initialCapacity, isVariableLength() ? initialCapacity * 16 : 0);
+    if (isVariableLength()) {
+      getOffsetsMutable()[0] = 0;
+    }
+  }
+
+  GiftedColumnVector(GiftedColumnVector &&other) = default;
+  GiftedColumnVector& operator=(GiftedColumnVector &&other) = default;
+
+  /**
+   * @brief Make a read-only column over memory that is owned elsewhere,
+   *        without copying it.
+   *
+   * @param values The packed values (fixed length) or the characters
+   *        (variable length).
+   * @param offsets count+1 offsets into "values" for variable length types,
+   *        null otherwise. offsets[0] need not be 0.
+   * @param validity Validity bitmap with bit i for value i, or null if
+   *        there are no nulls.
+   * @param keepAlive Holds the owner of the memory for as long as the view
+   *        (or any column moved from it) is around. May be empty.
+   **/
+  static GiftedColumnVector Wrap(const GiftedBaseType::GiftedTypeId typeId,
+                                 const std::size_t elementLength,
+                                 const std::size_t count,
+                                 const char *values,
+                                 const OffsetType *offsets,
+                                 const std::uint8_t *validity,
+                                 const std::shared_ptr<const void> &keepAlive) {
+    GiftedColumnVector view(typeId, elementLength, 0);
+    view._isView = true;
+    view._size = count;
+    view._viewValues = values;
+    view._viewOffsets = offsets;
+    view._viewValidity = validity;
+    view._hasValidity = (validity != nullptr);
+    if (elementLength > 0) {
+      view._valuesBytes = count * elementLength;
+    } else if (count > 0) {
+      view._valuesBytes = static_cast<std::size_t>(offsets[count] - offsets[0]);
+    }
+    view._keepAlive = keepAlive;
+    return view;
+  }
+
+  /**
+   * @brief A read-only view of values [begin, begin+count), without a copy.
+   *        The view must not outlive this column (or the memory this column
+   *        is a view of). "begin" must be a multiple of 8 when the column
+   *        has a validity bitmap.
+   **/
+  GiftedColumnVector Slice(const std::size_t begin, const std::size_t count) const {
+    const std::uint8_t *validity = getValidityBitmap();
+    if (validity != nullptr && begin % 8 != 0) {
+      throw std::invalid_argument("GiftedColumnVector::Slice: must start on a byte of the validity bitmap");
+    }
+    const OffsetType *offsets = getOffsets();
+    return Wrap(_typeId, _elementLength, count,
+                getValues() + (offsets == nullptr ? begin * _elementLength : 0),
+                offsets == nullptr ? nullptr : offsets + begin,
+                validity == nullptr ? nullptr : validity + begin / 8,
+                _keepAlive);
+  }
+
+  GiftedBaseType::GiftedTypeId getTypeId() const {return _typeId;}
+  std::size_t getElementLength() const {return _elementLength;}
+  bool isVariableLength() const {return _elementLength == 0;}
+
+  /**
+   * @brief True if the column is a read-only view over someone else's memory.
+   **/
+  bool isView() const {return _isView;}
+
+  std::size_t size() const {return _size;}
+
+  const char* getValues() const {return _isView ? _viewValues : _values.data();}
+  char* getValuesMutable() {
+    checkMutable();
+    return _values.data();
+  }
+
+  /**
+   * @brief Number of bytes of value data, i.e. from the start of the first
+   *        value to the end of the last one.
+   **/
+  std::size_t getValuesBytes() const {return _valuesBytes;}
+
+  /**
+   * @brief Offsets of the variable length values (size()+1 entries). Null
+   *        for fixed length columns.
+   **/
+  const OffsetType* getOffsets() const {
+    if (!isVariableLength()) return nullptr;
+    return _isView ? _viewOffsets : reinterpret_cast<const OffsetType*>(_offsets.data());
+  }
+
+  /**
+   * @brief The validity bitmap (ceil(size()/8) bytes, least significant bit
+   *        first), or null if no value is null.
+   **/
+  const std::uint8_t* getValidityBitmap() const {
+    if (!_hasValidity) return nullptr;
+    return _isView ? _viewValidity : reinterpret_cast<const std::uint8_t*>(_validity.data());
+  }
+
+  bool isNull(const std::size_t i) const {
+    const std::uint8_t *validity = getValidityBitmap();
+    return validity != nullptr && (validity[i >> 3] & (1u << (i & 7))) == 0;
+  }
+
+  /**
+   * @brief Raw form of value i, suitable for GiftedBaseType::UnMarshall.
+   **/
+  const char* getElement(const std::size_t i, std::size_t *length) const {
+    if (!isVariableLength()) {
+      *length = _elementLength;
+      return getValues() + i * _elementLength;
+    }
+    const OffsetType *offsets = getOffsets();
+    *length = offsets[i + 1] - offsets[i];
+    return getValues() + offsets[i];
+  }
+
+  /**
+   * @brief Hash every value into "hashes" (size() entries): fixed length
+   *        values with the type's VectorizedHash, variable length values as
+   *        bytes. Nulls get an arbitrary hash.
+   **/
+  void Hash(GiftedBaseType *kernels, std::uint64_t *hashes) const {
+    if (!isVariableLength()) {
+      kernels->VectorizedHash(_elementLength, getValues(), _size, hashes);
+      return;
+    }
+    const OffsetType *offsets = getOffsets();
+    const char *values = getValues();
+    for (std::size_t i = 0; i < _size; i++) {
+      hashes[i] = GiftedHashBytes(values + offsets[i], offsets[i + 1] - offsets[i]);
+    }
+  }
+
+  /**
+   * @brief Make room for "count" values (and for variable length columns,
+   *        "valueBytes" bytes of value data) in total.
+   **/
+  void Reserve(const std::size_t count, const std::size_t valueBytes = 0) {
+    checkMutable();
+    if (isVariableLength()) {
+      _offsets.Grow((count + 1) * sizeof(OffsetType), (_size + 1) * sizeof(OffsetType));
+      _values.Grow(valueBytes, _valuesBytes);
+    } else {
+      _values.Grow(count * _elementLength, _valuesBytes);
+    }
+    if (_hasValidity) {
+      _validity.Grow((count + 7) / 8, (_size + 7) / 8);
+    }
+  }
+
+  /**
+   * @brief Append "count" uninitialized fixed length values and return where
+   *        to write them. Kernels use this to fill a column in one go.
+   **/
+  char* AppendFixedSlots(const std::size_t count) {
+    checkMutable();
+    const std::size_t needed = _valuesBytes + count * _elementLength;
+    if (needed > _values.capacity()) {
+      _values.Grow(needed < 2 * _values.capacity() ? 2 * _values.capacity() : needed, _valuesBytes);
+    }
+    char *slots = _values.data() + _valuesBytes;
+    _valuesBytes = needed;
+    MarkValid(_size, count);
+    _size += count;
+    return slots;
+  }
+
+  void AppendFixed(const char *value) {
+    std::memcpy(AppendFixedSlots(1), value, _elementLength);
+  }
+
+  void AppendVariable(const char *data, const std::size_t length) {
+    checkMutable();
+    if ((_size + 2) * sizeof(OffsetType) > _offsets.capacity()) {
+      _offsets.Grow(2 * _offsets.capacity(), (_size + 1) * sizeof(OffsetType));
+    }
+    if (_valuesBytes + length > _values.capacity()) {
+      const std::size_t doubled = 2 * _values.capacity();
+      _values.Grow(doubled > _valuesBytes + length ? doubled : _valuesBytes + length, _valuesBytes);
+    }
+    if (length > 0) {
+      std::memcpy(_values.data() + _valuesBytes, data, length);
+    }
+    _valuesBytes += length;
+    MarkValid(_size, 1);
+    getOffsetsMutable()[++_size] = static_cast<OffsetType>(_valuesBytes);
+  }
+
+  /**
+   * @brief Append a null: a zero (or empty) value with its validity bit
+   *        cleared.
+   **/
+  void AppendNull() {
+    checkMutable();
+    const std::size_t row = _size;
+    if (isVariableLength()) {
+      AppendVariable(nullptr, 0);
+    } else {
+      std::memset(AppendFixedSlots(1), 0, _elementLength);
+    }
+    SetNull(row);
+  }
+
+  /**
+   * @brief Make the existing value "row" null, e.g. after filling a column
+   *        through AppendFixedSlots().
+   **/
+  void MarkNull(const std::size_t row) {
+    checkMutable();
+    SetNull(row);
+  }
+
+  /**
+   * @brief Append all the values of another column of the same type.
+   **/
+  void AppendColumn(const GiftedColumnVector &other) {
+    checkMutable();
+    if (other.size() == 0) return;
+    const std::size_t row = _size;
+    if (!isVariableLength()) {
+      std::memcpy(AppendFixedSlots(other.size()), other.getValues(), other.getValuesBytes());
+    } else {
+      Reserve(_size + other.size(), _valuesBytes + other.getValuesBytes());
+      const OffsetType *otherOffsets = other.getOffsets();
+      std::memcpy(_values.data() + _valuesBytes, other.getValues() + otherOffsets[0],
+                  other.getValuesBytes());
+      const OffsetType base = static_cast<OffsetType>(_valuesBytes) - otherOffsets[0];
+      OffsetType *offsets = getOffsetsMutable();
+      for (std::size_t i = 1; i <= other.size(); i++) {
+        offsets[_size + i] = base + otherOffsets[i];
+      }
+      MarkValid(_size, other.size());
+      _size += other.size();
+      _valuesBytes += other.getValuesBytes();
+    }
+
+    if (other.getValidityBitmap() != nullptr) {
+      for (std::size_t i = 0; i < other.size(); i++) {
+        if (other.isNull(i)) SetNull(row + i);
+      }
+    }
+  }
+
+  /**
+   * @brief Append the values of another column of the same type at the
+   *        given positions (e.g. a selection vector). Fixed length values go
+   *        through the type's VectorizedGather; variable length values are
+   *        copied after the offsets are rebuilt.
+   **/
+  void AppendGathered(const GiftedColumnVector &other,
+                      const std::uint32_t *positions,
+                      const std::size_t count,
+                      GiftedBaseType *kernels) {
+    checkMutable();
+    const std::size_t row = _size;
+    if (!isVariableLength()) {
+      char *slots = AppendFixedSlots(count);
+      kernels->VectorizedGather(_elementLength, other.getValues(), positions, count, slots);
+    } else {
+      const OffsetType *otherOffsets = other.getOffsets();
+      std::size_t bytes = 0;
+      for (std::size_t i = 0; i < count; i++) {
+        bytes += otherOffsets[positions[i] + 1] - otherOffsets[positions[i]];
+      }
+      Reserve(_size + count, _valuesBytes + bytes);
+      OffsetType *offsets = getOffsetsMutable();
+      for (std::size_t i = 0; i < count; i++) {
+        const OffsetType begin = otherOffsets[positions[i]];
+        const OffsetType length = otherOffsets[positions[i] + 1] - begin;
+        std::memcpy(_values.data() + offsets[_size + i], other.getValues() + begin, length);
+        offsets[_size + i + 1] = offsets[_size + i] + length;
+      }
+      MarkValid(_size, count);
+      _size += count;
+      _valuesBytes += bytes;
+    }
+
+    if (other.getValidityBitmap() != nullptr) {
+      for (std::size_t i = 0; i < count; i++) {
+        if (other.isNull(positions[i])) SetNull(row + i);
+      }
+    }
+  }
+
+  /**
+   * @brief Drop all the values but keep the memory.
+   **/
+  void Clear() {
+    checkMutable();
+    _size = 0;
+    _valuesBytes = 0;
+    _hasValidity = false;
+  }
+
+private:
+  OffsetType* getOffsetsMutable() {
+    return reinterpret_cast<OffsetType*>(_offsets.data());
+  }
+
+  void checkMutable() const {
+    if (_isView) {
+      throw std::logic_error("GiftedColumnVector: cannot modify a view");
+    }
+  }
+
+  // Set the validity bits of rows [first, first+count), if there is a bitmap.
+  void MarkValid(const std::size_t first, const std::size_t count) {
+    if (!_hasValidity) return;
+    const std::size_t bytes = (first + count + 7) / 8;
+    if (bytes > _validity.capacity()) {
+      _validity.Grow(2 * bytes, (first + 7) / 8);
+    }
+    std::uint8_t *validity = reinterpret_cast<std::uint8_t*>(_validity.data());
+    for (std::size_t i = first; i < first + count; i++) {
+      validity[i >> 3] |= static_cast<std::uint8_t>(1u << (i & 7));
+    }
+  }
+
+  // Clear the validity bit of an existing row. The first null creates the
+  // bitmap, with every row so far marked valid.
+  void SetNull(const std::size_t row) {
+    if (!_hasValidity) {
+      _validity.Grow((_size + 64) / 8, 0);
+      std::memset(_validity.data(), 0xFF, (_size + 7) / 8);
+      _hasValidity = true;
+    }
+    std::uint8_t *validity = reinterpret_cast<std::uint8_t*>(_validity.data());
+    validity[row >> 3] &= static_cast<std::uint8_t>(~(1u << (row & 7)));
+  }
+
+  GiftedBaseType::GiftedTypeId _typeId;
+  std::size_t _elementLength;
+  std::size_t _size;        // Number of values.
+  std::size_t _valuesBytes; // Bytes of value data.
+  GiftedAlignedBuffer _values;
+  GiftedAlignedBuffer _offsets;  // Only used for variable length types.
+  GiftedAlignedBuffer _validity; // Only used once there is a null.
+  bool _hasValidity;
+
+  // Set when the column is a view over external memory.
+  bool _isView;
+  const char *_viewValues;
+  const OffsetType *_viewOffsets;
+  const std::uint8_t *_viewValidity;
+  std::shared_ptr<const void> _keepAlive;
+};
+
+#endif  // GIFTED_STORAGE_COLUMN_VECTOR_HPP_
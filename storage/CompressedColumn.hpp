@@ -0,0 +1,141 @@
+//
+//  CompressedColumn.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_STORAGE_COMPRESSED_COLUMN_HPP_
+#define GIFTED_STORAGE_COMPRESSED_COLUMN_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "storage/ColumnVector.hpp"
+#include "storage/ZoneMap.hpp"
+#include "types/BaseType.hpp"
+
+/**
+ * @brief A read-only, compressed block of a column, with its zone map.
+ *
+ *        int64, int32 and decimal values are stored frame of reference
+ *        encoded: minus the block's minimum, in as many bits as the largest
+ *        difference needs, packed into 64 bit words. Nulls keep a validity
+ *        bitmap and encode as the minimum. Other types are kept as they are.
+ *        Decode() appends the values to a GiftedColumnVector for the
+ *        kernels.
+ **/
+class GiftedCompressedColumn {
+public:
+  /**
+   * @brief Compress values [begin, begin + count) of "column".
+   **/
+  GiftedCompressedColumn(const GiftedColumnVector &column, const std::size_t begin, const std::size_t count)
+      : _typeId(column.getTypeId()),
+        _elementLength(column.getElementLength()),
+        _numRows(count),
+        _bitWidth(0),
+        _zoneMap(GiftedZoneMap::Build(column, begin, count)),
+        _plain(column.getTypeId(), column.getElementLength(), 0) {
+    const bool hasNulls = _zoneMap.numNulls > 0;
+    if (hasNulls) {
+      _validity.assign((count + 7) / 8, 0);
+      for (std::size_t i = 0; i < count; i++) {
+        if (!column.isNull(begin + i)) _validity[i / 8] |= static_cast<std::uint8_t>(1u << (i % 8));
+      }
+    }
+    if (!_zoneMap.hasRange) {
+      // Not integral (or all null): copied as is.
+      std::vector<std::uint32_t> positions(count);
+      for (std::size_t i = 0; i < count; i++) positions[i] = static_cast<std::uint32_t>(begin + i);
+      if (column.isVariableLength() || count == 0) {
+        _plain.AppendGathered(column, positions.data(), count, nullptr);
+      } else {
+        std::memcpy(_plain.AppendFixedSlots(count), column.getValues() + begin * _elementLength,
+                    count * _elementLength);
+      }
+      return;
+    }
+    const std::uint64_t range = static_cast<std::uint64_t>(_zoneMap.max) - static_cast<std::uint64_t>(_zoneMap.min);
+    _bitWidth = range == 0 ? 0 : 64 - __builtin_clzll(range);
+    // One spare word, so that unpacking may always read two.
+    _words.assign((count * _bitWidth + 63) / 64 + 1, 0);
+    const bool isInt32 = _typeId == GiftedBaseType::_GiftedInt32TypeId;
+    for (std::size_t i = 0; _bitWidth > 0 && i < count; i++) {
+      if (hasNulls && column.isNull(begin + i)) continue;
+      const std::int64_t value = GiftedZoneMap::IntegralValue(column, begin + i, isInt32);
+      const std::uint64_t delta = static_cast<std::uint64_t>(value) - static_cast<std::uint64_t>(_zoneMap.min);
+      const std::size_t bit = i * _bitWidth;
+      const unsigned shift = bit % 64;
+      _words[bit / 64] |= delta << shift;
+      if (shift + _bitWidth > 64) _words[bit / 64 + 1] |= delta >> (64 - shift);
+    }
+  }
+
+  GiftedBaseType::GiftedTypeId getTypeId() const {return _typeId;}
+  std::size_t getElementLength() const {return _elementLength;}
+  std::size_t size() const {return _numRows;}
+  unsigned getBitWidth() const {return _bitWidth;}
+  const GiftedZoneMap& getZoneMap() const {return _zoneMap;}
+
+  std::size_t getBytes() const {
+    return _words.size() * sizeof(std::uint64_t) + _validity.size() + _plain.getValuesBytes() +
+           (_plain.isVariableLength() ? (_plain.size() + 1) * sizeof(GiftedColumnVector::OffsetType) : 0);
+  }
+
+  /**
+   * @brief Append the block's values to "out", a column of the same type.
+   **/
+  void Decode(GiftedColumnVector *out) const {
+    const std::size_t first = out->size();
+    if (!_zoneMap.hasRange) {
+      out->AppendColumn(_plain);
+      // Fixed length values were copied without their nulls.
+      if (!_validity.empty() && _plain.getValidityBitmap() == nullptr) MarkNulls(first, out);
+      return;
+    }
+    char *slots = out->AppendFixedSlots(_numRows);
+    if (_typeId == GiftedBaseType::_GiftedInt32TypeId) {
+      Unpack(reinterpret_cast<std::int32_t*>(slots));
+    } else {
+      Unpack(reinterpret_cast<std::int64_t*>(slots));
+    }
+    if (!_validity.empty()) MarkNulls(first, out);
+  }
+
+private:
+  template <typename T>
+  void Unpack(T *values) const {
+    const std::uint64_t base = static_cast<std::uint64_t>(_zoneMap.min);
+    if (_bitWidth == 0) {
+      for (std::size_t i = 0; i < _numRows; i++) values[i] = static_cast<T>(base);
+      return;
+    }
+    const std::uint64_t mask = _bitWidth == 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << _bitWidth) - 1;
+    const std::uint64_t *words = _words.data();
+    for (std::size_t i = 0, bit = 0; i < _numRows; i++, bit += _bitWidth) {
+      const unsigned shift = bit % 64;
+      std::uint64_t delta = words[bit / 64] >> shift;
+      if (shift + _bitWidth > 64) delta |= words[bit / 64 + 1] << (64 - shift);
+      values[i] = static_cast<T>(base + (delta & mask));
+    }
+  }
+
+  void MarkNulls(const std::size_t first, GiftedColumnVector *out) const {
+    for (std::size_t i = 0; i < _numRows; i++) {
+      if (((_validity[i / 8] >> (i % 8)) & 1) == 0) out->MarkNull(first + i);
+    }
+  }
+
+  GiftedBaseType::GiftedTypeId _typeId;
+  std::size_t _elementLength;
+  std::size_t _numRows;
+  unsigned _bitWidth;
+  GiftedZoneMap _zoneMap;
+  std::vector<std::uint64_t> _words;    // Packed differences from the minimum.
+  std::vector<std::uint8_t> _validity;  // Empty if there are no nulls.
+  GiftedColumnVector _plain;            // The values of other types.
+};
+
+#endif  // GIFTED_STORAGE_COMPRESSED_COLUMN_HPP_
@@ -0,0 +1,190 @@
+//
+//  CsvExporter.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_STORAGE_CSV_EXPORTER_HPP_
+#define GIFTED_STORAGE_CSV_EXPORTER_HPP_
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "storage/ColumnVector.hpp"
+#include "types/TextConversions.hpp"
+#include "types/TypeRegistry.hpp"
+
+/**
+ * @brief Streams columns out as delimited text (CSV, or TSV with a tab
+ *        delimiter) to a file descriptor.
+ *
+ *        Rows are produced a batch at a time: each fixed length column of the
+ *        batch is turned into text with one call to its type's FormatVector,
+ *        then the fields are interleaved into a large output buffer that is
+ *        handed to write(2) when full. Nothing goes through iostreams.
+ *        Variable length values are quoted when they contain the delimiter,
+ *        a quote or a line break, or are empty. A NULL is an empty field,
+ *        as GiftedCsvLoader reads it.
+ **/
+class GiftedCsvExporter {
+public:
+  /**
+   * @param registry The (frozen) type registry.
+   * @param fd Where to write. Not closed by the exporter.
+   **/
+  GiftedCsvExporter(const GiftedTypeRegistry &registry,
+                    const int fd,
+                    const char delimiter = ',',
+                    const std::size_t bufferBytes = 1 << 20)
+      : _registry(registry),
+        _fd(fd),
+        _delimiter(delimiter),
+        _buffer(new char[bufferBytes]),
+        _bufferBytes(bufferBytes),
+        _used(0) {}
+
+  // Flushes what is left; errors at this point are dropped, call Flush()
+  // to see them.
+  ~GiftedCsvExporter() {
+    try {
+      Flush();
+    } catch (...) {
+    }
+  }
+
+  void WriteHeader(const std::vector<std::string> &names) {
+    for (std::size_t c = 0; c < names.size(); c++) {
+      if (c > 0) Append(&_delimiter, 1);
+      AppendText(names[c].data(), names[c].size());
+    }
+    Append("\n", 1);
+  }
+
+  /**
+   * @brief Write one row per position of the given columns, which must all
+   *        have the same number of values.
+   **/
+  void WriteColumns(const std::vector<const GiftedColumnVector*> &columns) {
+    if (columns.empty()) return;
+    const std::size_t numRows = columns[0]->size();
+    const std::size_t numColumns = columns.size();
+
+    // Formatted text of the fixed length columns for the current batch.
+    std::vector<std::unique_ptr<char[]> > texts(numColumns);
+    std::vector<std::unique_ptr<std::uint32_t[]> > ends(numColumns);
+    std::vector<GiftedBaseType*> kernels(numColumns, nullptr);
+    for (std::size_t c = 0; c < numColumns; c++) {
+      if (columns[c]->size() != numRows) {
+        throw std::invalid_argument("GiftedCsvExporter: columns differ in length");
+      }
+      if (!columns[c]->isVariableLength()) {
+        kernels[c] = _registry.getEntry(columns[c]->getTypeId())->prototype.get();
+        texts[c].reset(new char[kBatchRows * kGiftedMaxFormattedLength]);
+        ends[c].reset(new std::uint32_t[kBatchRows]);
+      }
+    }
+
+    for (std::size_t start = 0; start < numRows; start += kBatchRows) {
+      const std::size_t rows = numRows - start < kBatchRows ? numRows - start : kBatchRows;
+      for (std::size_t c = 0; c < numColumns; c++) {
+        if (kernels[c] == nullptr) continue;
+        const std::size_t length = columns[c]->getElementLength();
+        kernels[c]->FormatVector(length, columns[c]->getValues() + start * length, rows,
+                                 texts[c].get(), ends[c].get());
+      }
+
+      for (std::size_t r = 0; r < rows; r++) {
+        for (std::size_t c = 0; c < numColumns; c++) {
+          if (c > 0) Append(&_delimiter, 1);
+          if (columns[c]->isNull(start + r)) continue;
+          if (kernels[c] != nullptr) {
+            const std::uint32_t begin = r == 0 ? 0 : ends[c][r - 1];
+            Append(texts[c].get() + begin, ends[c][r] - begin);
+          } else {
+            std::size_t length;
+            const char *value = columns[c]->getElement(start + r, &length);
+            AppendText(value, length);
+          }
+        }
+        Append("\n", 1);
+      }
+    }
+  }
+
+  /**
+   * @brief Hand everything buffered so far to the file descriptor.
+   *
+   * @exception std::runtime_error if the write fails.
+   **/
+  void Flush() {
+    WriteFully(_buffer.get(), _used);
+    _used = 0;
+  }
+
+private:
+  static const std::size_t kBatchRows = 1024;
+
+  void Append(const char *data, const std::size_t length) {
+    if (_used + length > _bufferBytes) {
+      Flush();
+      if (length > _bufferBytes) {
+        WriteFully(data, length);
+        return;
+      }
+    }
+    std::memcpy(_buffer.get() + _used, data, length);
+    _used += length;
+  }
+
+  // Append a text value, quoting it if needed. An empty one is quoted, as
+  // an empty field is NULL.
+  void AppendText(const char *data, const std::size_t length) {
+    bool needsQuotes = length == 0;
+    for (std::size_t i = 0; i < length && !needsQuotes; i++) {
+      needsQuotes = data[i] == _delimiter || data[i] == '"' || data[i] == '\n' || data[i] == '\r';
+    }
+    if (!needsQuotes) {
+      Append(data, length);
+      return;
+    }
+    Append("\"", 1);
+    std::size_t runBegin = 0;
+    for (std::size_t i = 0; i < length; i++) {
+      if (data[i] == '"') {
+        Append(data + runBegin, i + 1 - runBegin); // Up to and including the quote ...
+        runBegin = i;                              // ... which is then written again.
+      }
+    }
+    Append(data + runBegin, length - runBegin);
+    Append("\"", 1);
+  }
+
+  void WriteFully(const char *data, std::size_t length) {
+    while (length > 0) {
+      const ssize_t written = write(_fd, data, length);
+      if (written < 0) {
+        if (errno == EINTR) continue;
+        throw std::runtime_error(std::string("GiftedCsvExporter: write failed: ") + std::strerror(errno));
+      }
+      data += written;
+      length -= static_cast<std::size_t>(written);
+    }
+  }
+
+  const GiftedTypeRegistry &_registry;
+  const int _fd;
+  const char _delimiter;
+  std::unique_ptr<char[]> _buffer;
+  const std::size_t _bufferBytes;
+  std::size_t _used;
+};
+
+#endif  // GIFTED_STORAGE_CSV_EXPORTER_HPP_
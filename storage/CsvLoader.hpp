@@ -0,0 +1,370 @@
+//
+//  CsvLoader.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_STORAGE_CSV_LOADER_HPP_
+#define GIFTED_STORAGE_CSV_LOADER_HPP_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "storage/ColumnVector.hpp"
+#include "types/BaseType.hpp"
+#include "types/TypeRegistry.hpp"
+
+/**
+ * @brief Return the first delimiter or newline in [text, end), or end. Looks
+ *        at 16 bytes per step with SSE2 when it is available.
+ **/
+inline const char* GiftedFindFieldEnd(const char *text, const char *end, const char delimiter) {
+#if defined(__SSE2__)
+  const __m128i delimiters = _mm_set1_epi8(delimiter);
+  const __m128i newlines = _mm_set1_epi8('\n');
+  while (end - text >= 16) {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text));
+    const int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block, delimiters),
+                                                    _mm_cmpeq_epi8(block, newlines)));
+    if (mask != 0) return text + __builtin_ctz(mask);
+    text += 16;
+  }
+#endif
+  while (text < end && *text != delimiter && *text != '\n') ++text;
+  return text;
+}
+
+/**
+ * @brief Options for GiftedCsvLoader.
+ **/
+struct GiftedCsvOptions {
+  GiftedCsvOptions()
+      : delimiter(','),
+        hasHeader(false),
+        numThreads(0),
+        chunkBytes(8 << 20) {}
+
+  char delimiter;
+  bool hasHeader;         // Skip the first line.
+  std::size_t numThreads; // 0 means one per hardware thread.
+  std::size_t chunkBytes; // Target size of the unit of work per thread.
+};
+
+/**
+ * @brief Bulk loader from delimited text (CSV/TSV) into column vectors.
+ *
+ *        The input is split into chunks at line boundaries, and the chunks
+ *        are parsed by a pool of threads. Each thread finds the field
+ *        boundaries of a batch of rows, then hands every fixed length column
+ *        of the batch to the type's ParseVector, which writes straight into
+ *        the column buffer. Variable length values are copied as is. The
+ *        per chunk columns are concatenated in file order at the end.
+ *
+ *        Fields may be enclosed in double quotes (to hold a delimiter, with
+ *        "" standing for a quote), but may not contain a newline, since
+ *        chunks are split at newlines. An empty field is NULL; a quoted
+ *        empty field ("") is an empty string.
+ **/
+class GiftedCsvLoader {
+public:
+  /**
+   * @param registry The (frozen) type registry.
+   * @param schema The type of each column, in file order; at least one.
+   **/
+  GiftedCsvLoader(const GiftedTypeRegistry &registry,
+                  const std::vector<GiftedBaseType::GiftedTypeId> &schema,
+                  const GiftedCsvOptions &options = GiftedCsvOptions())
+      : _options(options) {
+    if (schema.empty()) {
+      throw std::invalid_argument("GiftedCsvLoader: the schema has no columns");
+    }
+    for (std::size_t i = 0; i < schema.size(); i++) {
+      const GiftedTypeRegistry::Entry *entry = registry.getEntry(schema[i]);
+      if (entry == nullptr) {
+        throw std::invalid_argument("GiftedCsvLoader: unknown type in schema");
+      }
+      _entries.push_back(entry);
+    }
+    if (_options.numThreads == 0) {
+      _options.numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+  }
+
+  /**
+   * @brief Load a whole file, which is mapped rather than read.
+   *
+   * @exception std::runtime_error on an I/O error or malformed input.
+   **/
+  std::vector<GiftedColumnVector> LoadFile(const std::string &path) const {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error("GiftedCsvLoader: cannot open " + path);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+      close(fd);
+      throw std::runtime_error("GiftedCsvLoader: cannot stat " + path);
+    }
+    const std::size_t length = static_cast<std::size_t>(info.st_size);
+    if (length == 0) {
+      close(fd);
+      return LoadBuffer(nullptr, 0);
+    }
+    void *mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+      throw std::runtime_error("GiftedCsvLoader: cannot map " + path);
+    }
+    madvise(mapped, length, MADV_SEQUENTIAL);
+
+    std::vector<GiftedColumnVector> columns;
+    try {
+      columns = LoadBuffer(static_cast<const char*>(mapped), length);
+    } catch (...) {
+      munmap(mapped, length);
+      throw;
+    }
+    munmap(mapped, length);
+    return columns;
+  }
+
+  /**
+   * @brief Load delimited text that is already in memory.
+   *
+   * @exception std::runtime_error on malformed input.
+   **/
+  std::vector<GiftedColumnVector> LoadBuffer(const char *data, const std::size_t length) const {
+    const char *begin = data;
+    const char *end = data + length;
+    if (_options.hasHeader && begin != end) {
+      const char *newline = static_cast<const char*>(std::memchr(begin, '\n', length));
+      begin = newline == nullptr ? end : newline + 1;
+    }
+
+    // Cut the input into chunks that end on a line boundary.
+    std::vector<Chunk> chunks;
+    const std::size_t remaining = end - begin;
+    std::size_t target = std::min(_options.chunkBytes,
+                                  remaining / _options.numThreads + 1);
+    target = std::min<std::size_t>(std::max<std::size_t>(target, 1 << 16), 1 << 30);
+    while (begin < end) {
+      const char *cut = end;
+      if (static_cast<std::size_t>(end - begin) > target) {
+        const char *newline = static_cast<const char*>(
+            std::memchr(begin + target, '\n', end - begin - target));
+        cut = newline == nullptr ? end : newline + 1;
+      }
+      chunks.push_back(Chunk(begin, cut));
+      begin = cut;
+    }
+
+    // Parse the chunks in parallel.
+    std::atomic<std::size_t> nextChunk(0);
+    std::vector<std::thread> workers;
+    const std::size_t numWorkers = std::min(_options.numThreads, chunks.size());
+    for (std::size_t t = 0; t < numWorkers; t++) {
+      workers.push_back(std::thread([this, &chunks, &nextChunk]() {
+        std::size_t index;
+        while ((index = nextChunk.fetch_add(1)) < chunks.size()) {
+          try {
+            ParseChunk(&chunks[index]);
+          } catch (const std::exception &e) {
+            chunks[index].error = e.what();
+          }
+        }
+      }));
+    }
+    for (std::size_t t = 0; t < workers.size(); t++) {
+      workers[t].join();
+    }
+
+    // Stitch the chunks together in input order.
+    std::vector<GiftedColumnVector> columns;
+    for (std::size_t c = 0; c < _entries.size(); c++) {
+      std::size_t rows = 0;
+      std::size_t bytes = 0;
+      for (std::size_t k = 0; k < chunks.size(); k++) {
+        rows += chunks[k].columns[c].size();
+        bytes += chunks[k].columns[c].getValuesBytes();
+      }
+      columns.push_back(GiftedColumnVector(_entries[c]->id, _entries[c]->length, 0));
+      columns.back().Reserve(rows, bytes);
+    }
+    for (std::size_t k = 0; k < chunks.size(); k++) {
+      if (!chunks[k].error.empty()) {
+        throw std::runtime_error("GiftedCsvLoader: " + chunks[k].error + " at byte " +
+                                 std::to_string(chunks[k].begin - data + chunks[k].errorOffset));
+      }
+      for (std::size_t c = 0; c < _entries.size(); c++) {
+        columns[c].AppendColumn(chunks[k].columns[c]);
+      }
+    }
+    return columns;
+  }
+
+private:
+  static const std::size_t kBatchRows = 1024;
+
+  /**
+   * @brief A piece of the input and the columns parsed from it.
+   **/
+  struct Chunk {
+    Chunk(const char *chunkBegin, const char *chunkEnd)
+        : begin(chunkBegin), end(chunkEnd), errorOffset(0) {}
+
+    const char *begin;
+    const char *end;
+    std::vector<GiftedColumnVector> columns;
+    std::string error;       // Set if the chunk is malformed.
+    std::size_t errorOffset; // Where in the chunk the bad row starts.
+  };
+
+  /**
+   * @brief Hand the fields of the fixed length columns collected so far to
+   *        the types' ParseVector.
+   **/
+  void FlushBatch(Chunk *chunk,
+                  const std::size_t rows,
+                  const std::vector<std::uint32_t> &fieldBegins,
+                  const std::vector<std::uint32_t> &fieldLengths,
+                  const std::vector<char> &fieldNulls,
+                  const std::vector<std::uint32_t> &rowBegins,
+                  bool *failed) const {
+    for (std::size_t c = 0; c < _entries.size(); c++) {
+      if (_entries[c]->length == 0 || rows == 0) continue;
+      const std::size_t firstRow = chunk->columns[c].size();
+      char *slots = chunk->columns[c].AppendFixedSlots(rows);
+      _entries[c]->prototype->ParseVector(chunk->begin,
+                                          &fieldBegins[c * kBatchRows],
+                                          &fieldLengths[c * kBatchRows],
+                                          rows,
+                                          slots,
+                                          failed);
+      for (std::size_t r = 0; r < rows; r++) {
+        if (fieldNulls[c * kBatchRows + r]) {
+          std::memset(slots + r * _entries[c]->length, 0, _entries[c]->length);
+          chunk->columns[c].MarkNull(firstRow + r);
+        } else if (failed[r]) {
+          chunk->errorOffset = rowBegins[r];
+          throw std::runtime_error("bad " + _entries[c]->name + " value in column " +
+                                   std::to_string(c + 1));
+        }
+      }
+    }
+  }
+
+  void ParseChunk(Chunk *chunk) const {
+    const std::size_t numColumns = _entries.size();
+    for (std::size_t c = 0; c < numColumns; c++) {
+      chunk->columns.push_back(GiftedColumnVector(_entries[c]->id, _entries[c]->length));
+    }
+
+    std::vector<std::uint32_t> fieldBegins(numColumns * kBatchRows);
+    std::vector<std::uint32_t> fieldLengths(numColumns * kBatchRows);
+    std::vector<char> fieldNulls(numColumns * kBatchRows);
+    std::vector<std::uint32_t> rowBegins(kBatchRows);
+    std::unique_ptr<bool[]> failed(new bool[kBatchRows]);
+    std::string unescaped;
+
+    const char delimiter = _options.delimiter;
+    const char *p = chunk->begin;
+    const char *end = chunk->end;
+    std::size_t rows = 0;
+    while (p < end) {
+      // Skip empty lines, except where they hold a single NULL field.
+      if (numColumns > 1 && (*p == '\n' || (*p == '\r' && p + 1 < end && p[1] == '\n'))) {
+        p += (*p == '\n') ? 1 : 2;
+        continue;
+      }
+      rowBegins[rows] = static_cast<std::uint32_t>(p - chunk->begin);
+      chunk->errorOffset = rowBegins[rows];
+
+      for (std::size_t c = 0; c < numColumns; c++) {
+        const char *fieldBegin = p;
+        const char *fieldEnd;
+        bool escaped = false;
+        const bool quoted = p < end && *p == '"';
+        if (quoted) {
+          // Quoted field: runs to the quote that is not followed by another.
+          fieldBegin = ++p;
+          for (;;) {
+            const char *quote = static_cast<const char*>(std::memchr(p, '"', end - p));
+            if (quote == nullptr) throw std::runtime_error("unterminated quoted field");
+            if (quote + 1 < end && quote[1] == '"') {
+              escaped = true;
+              p = quote + 2;
+              continue;
+            }
+            fieldEnd = quote;
+            p = quote + 1;
+            break;
+          }
+        } else {
+          p = GiftedFindFieldEnd(p, end, delimiter);
+          fieldEnd = p;
+        }
+
+        // Check what follows the field.
+        const bool last = (c + 1 == numColumns);
+        if (!last) {
+          if (p >= end || *p != delimiter) throw std::runtime_error("too few fields in row");
+          ++p;
+        } else {
+          if (p < end && *p == '\r') ++p;
+          if (p < end && *p != '\n') throw std::runtime_error("too many fields in row");
+          // The \r of a \r\n line end; within quotes it is data.
+          if (!quoted && fieldEnd > fieldBegin && fieldEnd[-1] == '\r') --fieldEnd;
+          if (p < end) ++p;
+        }
+
+        const bool isNull = !quoted && fieldEnd == fieldBegin;
+        if (_entries[c]->length == 0) {
+          if (isNull) {
+            chunk->columns[c].AppendNull();
+          } else if (escaped) {
+            unescaped.clear();
+            for (const char *q = fieldBegin; q < fieldEnd; q++) {
+              unescaped.push_back(*q);
+              if (*q == '"') ++q; // Drop the second quote of a "" pair.
+            }
+            chunk->columns[c].AppendVariable(unescaped.data(), unescaped.size());
+          } else {
+            chunk->columns[c].AppendVariable(fieldBegin, fieldEnd - fieldBegin);
+          }
+        } else {
+          fieldBegins[c * kBatchRows + rows] = static_cast<std::uint32_t>(fieldBegin - chunk->begin);
+          fieldLengths[c * kBatchRows + rows] = static_cast<std::uint32_t>(fieldEnd - fieldBegin);
+          fieldNulls[c * kBatchRows + rows] = isNull;
+        }
+      }
+
+      if (++rows == kBatchRows) {
+        FlushBatch(chunk, rows, fieldBegins, fieldLengths, fieldNulls, rowBegins, failed.get());
+        rows = 0;
+      }
+    }
+    FlushBatch(chunk, rows, fieldBegins, fieldLengths, fieldNulls, rowBegins, failed.get());
+  }
+
+  std::vector<const GiftedTypeRegistry::Entry*> _entries;
+  GiftedCsvOptions _options;
+};
+
+#endif  // GIFTED_STORAGE_CSV_LOADER_HPP_
@@ -0,0 +1,366 @@
+//
+//  DeltaMainTable.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_STORAGE_DELTA_MAIN_TABLE_HPP_
+#define GIFTED_STORAGE_DELTA_MAIN_TABLE_HPP_
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "storage/ColumnVector.hpp"
+#include "storage/CompressedColumn.hpp"
+#include "storage/VectorBatch.hpp"
+#include "storage/ZoneMap.hpp"
+#include "types/BaseType.hpp"
+#include "types/TypeRegistry.hpp"
+
+/**
+ * @brief A table that takes a steady stream of inserts while its bulk stays
+ *        compressed and read optimized.
+ *
+ *        Inserts append to the delta: uncompressed, append only
+ *        GiftedColumnVectors, cut into chunks of "blockRows" rows. Merge()
+ *        re-encodes the full delta chunks into main blocks, a
+ *        GiftedCompressedColumn (with its zone map) per column, optionally
+ *        sorted on an integral column first so that the new blocks' zone
+ *        maps are tight. StartMerger() runs merges on a background thread
+ *        once "mergeRows" rows are waiting.
+ *
+ *        Readers take a Snapshot (getSnapshot()): the main blocks and delta
+ *        chunks at that moment, all immutable and shared, so neither inserts
+ *        nor merges disturb a running scan (GiftedDeltaMainScanOperator).
+ *        Compression runs outside the table's lock; a chunk being merged
+ *        stays visible in the delta until its main blocks replace it.
+ **/
+class GiftedDeltaMainTable {
+public:
+  static const std::size_t kNoSortColumn = static_cast<std::size_t>(-1);
+
+  /**
+   * @brief A compressed block of rows, one GiftedCompressedColumn per column.
+   **/
+  struct MainBlock {
+    std::vector<GiftedCompressedColumn> columns;
+    std::size_t numRows;
+  };
+
+  /**
+   * @brief A chunk of the delta, one column per table column.
+   **/
+  struct DeltaChunk {
+    std::vector<GiftedColumnVector> columns;
+  };
+
+  /**
+   * @brief The table's rows at one moment: the main blocks, then the delta.
+   **/
+  struct Snapshot {
+    std::vector<std::shared_ptr<const MainBlock> > main;
+    std::vector<std::shared_ptr<const DeltaChunk> > delta;
+  };
+
+  /**
+   * @param blockRows Rows per delta chunk and main block, rounded up to a
+   *        multiple of 8.
+   * @param mergeRows Rows of full delta chunks at which the background
+   *        merger merges.
+   * @param sortColumn An int64, int32 or decimal column to sort merged rows
+   *        on, or kNoSortColumn.
+   **/
+  GiftedDeltaMainTable(const GiftedTypeRegistry &registry,
+                       const std::vector<GiftedBaseType::GiftedTypeId> &types,
+                       const std::size_t blockRows = kGiftedDefaultBatchRows,
+                       const std::size_t mergeRows = 16 * kGiftedDefaultBatchRows,
+                       const std::size_t sortColumn = kNoSortColumn)
+      : _types(types),
+        _blockRows((blockRows + 7) & ~static_cast<std::size_t>(7)),
+        _mergeRows(mergeRows),
+        _sortColumn(sortColumn),
+        _stopMerger(false) {
+    if (types.empty() || blockRows == 0) throw std::invalid_argument("GiftedDeltaMainTable: no columns or rows");
+    for (std::size_t c = 0; c < types.size(); c++) {
+      const GiftedTypeRegistry::Entry *entry = registry.getEntry(types[c]);
+      if (entry == nullptr) throw std::invalid_argument("GiftedDeltaMainTable: unknown type");
+      _lengths.push_back(entry->length);
+      _kernels.push_back(entry->prototype.get());
+    }
+    if (sortColumn != kNoSortColumn &&
+        (sortColumn >= types.size() || (types[sortColumn] != GiftedBaseType::_GiftedIntTypeId &&
+                                        types[sortColumn] != GiftedBaseType::_GiftedInt32TypeId &&
+                                        types[sortColumn] != GiftedBaseType::_GiftedDecimalTypeId))) {
+      throw std::invalid_argument("GiftedDeltaMainTable: can only sort on an integral column");
+    }
+    _tail = NewChunk();
+  }
+
+  ~GiftedDeltaMainTable() {
+    try {
+      StopMerger();
+    } catch (...) {
+    }
+  }
+
+  std::size_t getNumColumns() const {return _types.size();}
+  GiftedBaseType::GiftedTypeId getTypeId(const std::size_t column) const {return _types[column];}
+  std::size_t getBlockRows() const {return _blockRows;}
+
+  /**
+   * @brief Append the rows of "columns", one per table column and of its
+   *        type, all equally long.
+   **/
+  void Insert(const std::vector<const GiftedColumnVector*> &columns) {
+    if (columns.size() != _types.size()) {
+      throw std::invalid_argument("GiftedDeltaMainTable: need one column per table column");
+    }
+    for (std::size_t c = 0; c < columns.size(); c++) {
+      if (columns[c]->getTypeId() != _types[c] || columns[c]->size() != columns[0]->size()) {
+        throw std::invalid_argument("GiftedDeltaMainTable: columns differ from the table's types or in length");
+      }
+    }
+    const std::size_t count = columns[0]->size();
+    std::vector<std::uint32_t> positions;
+    bool mergeDue = false;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      for (std::size_t begin = 0; begin < count;) {
+        const std::size_t room = _blockRows - _tail->columns[0].size();
+        const std::size_t rows = count - begin < room ? count - begin : room;
+        positions.resize(rows);
+        for (std::size_t i = 0; i < rows; i++) positions[i] = static_cast<std::uint32_t>(begin + i);
+        for (std::size_t c = 0; c < columns.size(); c++) {
+          _tail->columns[c].AppendGathered(*columns[c], positions.data(), rows, _kernels[c]);
+        }
+        begin += rows;
+        if (_tail->columns[0].size() == _blockRows) {
+          _sealed.push_back(std::shared_ptr<const DeltaChunk>(_tail.release()));
+          _tail = NewChunk();
+        }
+      }
+      mergeDue = _sealed.size() * _blockRows >= _mergeRows;
+    }
+    if (mergeDue) _mergerWakeup.notify_one();
+  }
+
+  Snapshot getSnapshot() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    Snapshot snapshot;
+    snapshot.main = _main;
+    snapshot.delta = _merging;
+    snapshot.delta.insert(snapshot.delta.end(), _sealed.begin(), _sealed.end());
+    // The tail still takes inserts, so it is copied (less than a chunk).
+    if (_tail->columns[0].size() > 0) {
+      std::unique_ptr<DeltaChunk> tail(NewChunk());
+      for (std::size_t c = 0; c < _types.size(); c++) tail->columns[c].AppendColumn(_tail->columns[c]);
+      snapshot.delta.push_back(std::shared_ptr<const DeltaChunk>(tail.release()));
+    }
+    return snapshot;
+  }
+
+  std::size_t getNumMainBlocks() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _main.size();
+  }
+
+  std::size_t getDeltaRows() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return (_merging.size() + _sealed.size()) * _blockRows + _tail->columns[0].size();
+  }
+
+  /**
+   * @brief Merge the whole delta, the partly filled chunk too, into main
+   *        blocks now.
+   *
+   * @return The number of rows merged.
+   **/
+  std::size_t Merge() {
+    return MergeDelta(true);
+  }
+
+  /**
+   * @brief Merge in the background, checking every "interval" and whenever
+   *        an insert fills up "mergeRows" rows.
+   **/
+  void StartMerger(const std::chrono::milliseconds interval = std::chrono::milliseconds(100)) {
+    std::lock_guard<std::mutex> lock(_mergerMutex);
+    if (_merger.joinable()) return;
+    _stopMerger = false;
+    _merger = std::thread([this, interval] {
+      for (;;) {
+        {
+          std::unique_lock<std::mutex> lock(_mergerMutex);
+          _mergerWakeup.wait_for(lock, interval, [this] {return _stopMerger || MergeDue();});
+          if (_stopMerger) return;
+        }
+        try {
+          MergeDelta(false);
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(_mergerMutex);
+          _mergerError = std::current_exception();
+          return;
+        }
+      }
+    });
+  }
+
+  /**
+   * @brief Stop the background merger, waiting for a running merge.
+   *
+   * @exception Whatever made a background merge fail.
+   **/
+  void StopMerger() {
+    {
+      std::lock_guard<std::mutex> lock(_mergerMutex);
+      _stopMerger = true;
+    }
+    _mergerWakeup.notify_one();
+    if (_merger.joinable()) _merger.join();
+    std::exception_ptr error;
+    {
+      std::lock_guard<std::mutex> lock(_mergerMutex);
+      std::swap(error, _mergerError);
+    }
+    if (error) std::rethrow_exception(error);
+  }
+
+private:
+  std::unique_ptr<DeltaChunk> NewChunk() const {
+    std::unique_ptr<DeltaChunk> chunk(new DeltaChunk);
+    for (std::size_t c = 0; c < _types.size(); c++) {
+      chunk->columns.push_back(GiftedColumnVector(_types[c], _lengths[c], _blockRows));
+    }
+    return chunk;
+  }
+
+  bool MergeDue() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _sealed.size() * _blockRows >= _mergeRows;
+  }
+
+  // Merge the full delta chunks (and with "all" the tail) into main blocks.
+  std::size_t MergeDelta(const bool all) {
+    std::lock_guard<std::mutex> merging(_mergeMutex);
+    std::vector<std::shared_ptr<const DeltaChunk> > chunks;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (all && _tail->columns[0].size() > 0) {
+        _sealed.push_back(std::shared_ptr<const DeltaChunk>(_tail.release()));
+        _tail = NewChunk();
+      }
+      _merging.swap(_sealed);
+      chunks = _merging;
+    }
+    if (chunks.empty()) return 0;
+
+    // On failure the chunks go back in front of those sealed since, in order.
+    std::size_t numRows = 0;
+    std::vector<std::shared_ptr<const MainBlock> > blocks;
+    try {
+      // Concatenate (and sort) the chunks, then compress a block at a time.
+      std::unique_ptr<DeltaChunk> rows(NewChunk());
+      if (_sortColumn == kNoSortColumn) {
+        for (std::size_t i = 0; i < chunks.size(); i++) {
+          for (std::size_t c = 0; c < _types.size(); c++) rows->columns[c].AppendColumn(chunks[i]->columns[c]);
+        }
+      } else {
+        SortedConcatenation(chunks, rows.get());
+      }
+      numRows = rows->columns[0].size();
+      for (std::size_t begin = 0; begin < numRows; begin += _blockRows) {
+        std::shared_ptr<MainBlock> block(new MainBlock);
+        block->numRows = numRows - begin < _blockRows ? numRows - begin : _blockRows;
+        for (std::size_t c = 0; c < _types.size(); c++) {
+          block->columns.push_back(GiftedCompressedColumn(rows->columns[c], begin, block->numRows));
+        }
+        blocks.push_back(block);
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _sealed.insert(_sealed.begin(), _merging.begin(), _merging.end());
+      _merging.clear();
+      throw;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _main.insert(_main.end(), blocks.begin(), blocks.end());
+    _merging.clear();
+    return numRows;
+  }
+
+  // Gather the chunks' rows into "rows" ordered by the sort column, nulls
+  // last.
+  void SortedConcatenation(const std::vector<std::shared_ptr<const DeltaChunk> > &chunks, DeltaChunk *rows) const {
+    const bool isInt32 = _types[_sortColumn] == GiftedBaseType::_GiftedInt32TypeId;
+    struct Row {
+      std::int64_t key;
+      bool null;
+      std::uint32_t chunk;
+      std::uint32_t position;
+      bool operator<(const Row &other) const {
+        return null != other.null ? other.null : key < other.key;
+      }
+    };
+    std::vector<Row> order;
+    for (std::size_t i = 0; i < chunks.size(); i++) {
+      const GiftedColumnVector &keys = chunks[i]->columns[_sortColumn];
+      const bool hasNulls = keys.getValidityBitmap() != nullptr;
+      for (std::size_t r = 0; r < keys.size(); r++) {
+        Row row;
+        row.null = hasNulls && keys.isNull(r);
+        row.key = row.null ? 0 : GiftedZoneMap::IntegralValue(keys, r, isInt32);
+        row.chunk = static_cast<std::uint32_t>(i);
+        row.position = static_cast<std::uint32_t>(r);
+        order.push_back(row);
+      }
+    }
+    std::stable_sort(order.begin(), order.end());
+    // Gather runs of rows that come from the same chunk.
+    std::vector<std::uint32_t> positions;
+    for (std::size_t begin = 0; begin < order.size();) {
+      std::size_t end = begin;
+      positions.clear();
+      while (end < order.size() && order[end].chunk == order[begin].chunk) positions.push_back(order[end++].position);
+      const DeltaChunk &chunk = *chunks[order[begin].chunk];
+      for (std::size_t c = 0; c < _types.size(); c++) {
+        rows->columns[c].AppendGathered(chunk.columns[c], positions.data(), positions.size(), _kernels[c]);
+      }
+      begin = end;
+    }
+  }
+
+  const std::vector<GiftedBaseType::GiftedTypeId> _types;
+  std::vector<std::size_t> _lengths;
+  std::vector<GiftedBaseType*> _kernels;
+  const std::size_t _blockRows;
+  const std::size_t _mergeRows;
+  const std::size_t _sortColumn;
+
+  // Guarded by _mutex.
+  mutable std::mutex _mutex;
+  std::vector<std::shared_ptr<const MainBlock> > _main;
+  std::vector<std::shared_ptr<const DeltaChunk> > _merging;  // Being merged.
+  std::vector<std::shared_ptr<const DeltaChunk> > _sealed;   // Full chunks.
+  std::unique_ptr<DeltaChunk> _tail;                         // Takes inserts.
+
+  std::mutex _mergeMutex;  // One merge at a time.
+
+  // Guarded by _mergerMutex.
+  std::mutex _mergerMutex;
+  std::condition_variable _mergerWakeup;
+  std::thread _merger;
+  bool _stopMerger;
+  std::exception_ptr _mergerError;
+};
+
+#endif  // GIFTED_STORAGE_DELTA_MAIN_TABLE_HPP_
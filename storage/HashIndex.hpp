@@ -0,0 +1,97 @@
+//
+//  HashIndex.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_STORAGE_HASH_INDEX_HPP_
+#define GIFTED_STORAGE_HASH_INDEX_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "storage/ColumnVector.hpp"
+#include "types/BaseType.hpp"
+#include "types/HashFunctions.hpp"
+#include "types/TypeRegistry.hpp"
+
+/**
+ * @brief A hash index over one column, for point lookups without a scan.
+ *
+ *        The column is hashed in one call to its type's batch hash (as for
+ *        a hash join), and the rows are chained by bucket: _buckets holds
+ *        1 + the first row of each chain, _next[row] 1 + the next row (0
+ *        ends a chain). Chains are built from the last row down, so a
+ *        lookup returns its rows in ascending order, ready to use as a
+ *        selection. Nulls are not indexed. The column must outlive the
+ *        index and not change.
+ **/
+class GiftedHashIndex {
+public:
+  GiftedHashIndex(const GiftedTypeRegistry &registry, const GiftedColumnVector &column)
+      : _column(column),
+        _kernels(registry.getEntry(column.getTypeId())->prototype.get()),
+        _bucketMask(0) {
+    const std::size_t numRows = column.size();
+    if (numRows >= std::numeric_limits<std::uint32_t>::max()) {
+      throw std::overflow_error("GiftedHashIndex: column is too large");
+    }
+    std::size_t numBuckets = 16;
+    while (numBuckets < 2 * numRows) numBuckets *= 2;
+    _bucketMask = numBuckets - 1;
+    _buckets.assign(numBuckets, 0);
+    _next.assign(numRows, 0);
+    _hashes.resize(numRows);
+    if (numRows == 0) return;
+
+    column.Hash(_kernels, _hashes.data());
+    for (std::size_t i = numRows; i-- > 0;) {
+      if (column.isNull(i)) continue;
+      std::uint32_t &bucket = _buckets[_hashes[i] & _bucketMask];
+      _next[i] = bucket;
+      bucket = static_cast<std::uint32_t>(i + 1);
+    }
+  }
+
+  /**
+   * @brief Append the rows whose value is "value" (in raw form, "length"
+   *        bytes) to "rows", in ascending order.
+   **/
+  void Lookup(const char *value, const std::size_t length, std::vector<std::uint32_t> *rows) const {
+    std::uint64_t hash;
+    if (_column.isVariableLength()) {
+      hash = GiftedHashBytes(value, length);
+    } else {
+      if (length != _column.getElementLength()) {
+        throw std::invalid_argument("GiftedHashIndex: value is not of the column's type");
+      }
+      _kernels->VectorizedHash(length, value, 1, &hash);
+    }
+    for (std::uint32_t chain = _buckets[hash & _bucketMask]; chain != 0; chain = _next[chain - 1]) {
+      const std::uint32_t row = chain - 1;
+      if (_hashes[row] != hash) continue;
+      std::size_t rowLength;
+      const char *rowValue = _column.getElement(row, &rowLength);
+      if (rowLength == length && std::memcmp(rowValue, value, length) == 0) rows->push_back(row);
+    }
+  }
+
+  std::size_t getBytes() const {
+    return _buckets.size() * sizeof(std::uint32_t) + _next.size() * sizeof(std::uint32_t) +
+           _hashes.size() * sizeof(std::uint64_t);
+  }
+
+private:
+  const GiftedColumnVector &_column;
+  GiftedBaseType *_kernels;
+  std::vector<std::uint64_t> _hashes;
+  std::vector<std::uint32_t> _buckets;
+  std::vector<std::uint32_t> _next;
+  std::size_t _bucketMask;
+};
+
+#endif  // GIFTED_STORAGE_HASH_INDEX_HPP_
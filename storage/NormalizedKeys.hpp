@@ -0,0 +1,102 @@
+//
+//  NormalizedKeys.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_STORAGE_NORMALIZED_KEYS_HPP_
+#define GIFTED_STORAGE_NORMALIZED_KEYS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "storage/ColumnVector.hpp"
+#include "storage/VectorBatch.hpp"
+#include "types/BaseType.hpp"
+#include "types/TypeRegistry.hpp"
+
+/**
+ * @brief Order two normalized keys: memcmp, then the shorter first.
+ *
+ * @return <0, 0 or >0, as memcmp.
+ **/
+inline int GiftedCompareNormalizedKeys(const char *left, const std::size_t leftLength,
+                                       const char *right, const std::size_t rightLength) {
+  const int order = std::memcmp(left, right, leftLength < rightLength ? leftLength : rightLength);
+  if (order != 0) return order;
+  return leftLength < rightLength ? -1 : (leftLength > rightLength ? 1 : 0);
+}
+
+/**
+ * @brief Build the normalized (multi-column) keys of a batch's live rows.
+ *
+ *        Each key is the concatenation of the key columns' normalized forms:
+ *        fixed length values by the type's NormalizeKeys kernel, a batch at
+ *        a time, and variable length values escaped (0x00 as 0x00 0xFF) and
+ *        ended by 0x00 0x00, so a shorter string still orders first and the
+ *        next column's bytes cannot leak into the comparison. Keys then
+ *        compare with GiftedCompareNormalizedKeys in the columns' order.
+ *
+ *        Rows with a null in any key column are left out, as they match
+ *        nothing.
+ *
+ * @param rows Receives the batch rows the keys are for, in batch order.
+ * @param keys Receives one variable length value per entry of "rows".
+ **/
+inline void GiftedNormalizeKeys(const GiftedTypeRegistry &registry,
+                                const GiftedVectorBatch &batch,
+                                const std::vector<std::size_t> &keyColumns,
+                                std::vector<std::uint32_t> *rows,
+                                GiftedColumnVector *keys) {
+  rows->clear();
+  keys->Clear();
+  const std::size_t numLive = batch.getNumSelected();
+  for (std::size_t i = 0; i < numLive; i++) {
+    const std::uint32_t row = batch.hasSelection() ? batch.getSelection()[i] : static_cast<std::uint32_t>(i);
+    bool hasNull = false;
+    for (std::size_t k = 0; k < keyColumns.size(); k++) {
+      hasNull = hasNull || batch.getColumn(keyColumns[k]).isNull(row);
+    }
+    if (!hasNull) rows->push_back(row);
+  }
+  const std::size_t numRows = rows->size();
+
+  // Fixed length key columns: gather the rows, then normalize them in one go.
+  std::vector<std::string> normalized(keyColumns.size());
+  std::string gathered;
+  for (std::size_t k = 0; k < keyColumns.size(); k++) {
+    const GiftedColumnVector &column = batch.getColumn(keyColumns[k]);
+    if (column.isVariableLength() || numRows == 0) continue;
+    GiftedBaseType *kernels = registry.getEntry(column.getTypeId())->prototype.get();
+    gathered.resize(numRows * column.getElementLength());
+    normalized[k].resize(numRows * column.getElementLength());
+    kernels->VectorizedGather(column.getElementLength(), column.getValues(), rows->data(), numRows, &gathered[0]);
+    kernels->NormalizeKeys(column.getElementLength(), gathered.data(), numRows, &normalized[k][0]);
+  }
+
+  keys->Reserve(numRows);
+  std::string key;
+  for (std::size_t i = 0; i < numRows; i++) {
+    key.clear();
+    for (std::size_t k = 0; k < keyColumns.size(); k++) {
+      const GiftedColumnVector &column = batch.getColumn(keyColumns[k]);
+      if (!column.isVariableLength()) {
+        key.append(normalized[k], i * column.getElementLength(), column.getElementLength());
+        continue;
+      }
+      std::size_t length;
+      const char *value = column.getElement((*rows)[i], &length);
+      for (std::size_t c = 0; c < length; c++) {
+        key.push_back(value[c]);
+        if (value[c] == '\0') key.push_back('\xff');
+      }
+      key.append(2, '\0');
+    }
+    keys->AppendVariable(key.data(), key.size());
+  }
+}
+
+#endif  // GIFTED_STORAGE_NORMALIZED_KEYS_HPP_
@@ -0,0 +1,228 @@
+//
+//  PaxBlock.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_STORAGE_PAX_BLOCK_HPP_
+#define GIFTED_STORAGE_PAX_BLOCK_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "storage/ColumnVector.hpp"
+#include "storage/RowBlock.hpp"
+#include "storage/VectorBatch.hpp"
+#include "types/BaseType.hpp"
+#include "types/TypeRegistry.hpp"
+
+/**
+ * @brief A block of up to getCapacity() rows of fixed length values in the
+ *        PAX layout (Partition Attributes Across): one allocation holding a
+ *        "minipage" per column, i.e. the column's values back to back
+ *        followed by its validity bitmap (bit set means present, as in a
+ *        GiftedColumnVector). Minipages start on a cache line.
+ *
+ *        Scans get a minipage as a GiftedColumnVector view (getColumn()), so
+ *        the contiguous kernels run on it as on any column, and only the
+ *        scanned columns' minipages are read. All values of a row are in the
+ *        same block, so a point lookup or update touches one line per
+ *        column of a single block, not of column-long arrays. Packed rows
+ *        (GiftedRowBlock) go in and out one field at a time through the
+ *        strided kernels, GiftedGatherField and GiftedScatterField.
+ **/
+class GiftedPaxBlock {
+public:
+  /**
+   * @param capacity Rows in the block, rounded up to a multiple of 8.
+   **/
+  GiftedPaxBlock(const GiftedTypeRegistry &registry,
+                 const std::vector<GiftedBaseType::GiftedTypeId> &types,
+                 const std::size_t capacity = kGiftedDefaultBatchRows)
+      : _types(types),
+        _capacity((capacity + 7) & ~static_cast<std::size_t>(7)),
+        _numRows(0),
+        _nullCounts(types.size(), 0) {
+    if (types.empty() || capacity == 0) throw std::invalid_argument("GiftedPaxBlock: no columns or rows");
+    std::size_t bytes = 0;
+    for (std::size_t c = 0; c < types.size(); c++) {
+      const GiftedTypeRegistry::Entry *entry = registry.getEntry(types[c]);
+      if (entry == nullptr) throw std::invalid_argument("GiftedPaxBlock: unknown type");
+      if (entry->length == 0) throw std::invalid_argument("GiftedPaxBlock: only fixed length types");
+      _lengths.push_back(entry->length);
+      _valueOffsets.push_back(bytes);
+      bytes += RoundToLine(_capacity * entry->length);
+      _validityOffsets.push_back(bytes);
+      bytes += RoundToLine(_capacity / 8);
+    }
+    _data.assign(bytes + kLineBytes, 0);
+    _skew = (kLineBytes - reinterpret_cast<std::uintptr_t>(_data.data()) % kLineBytes) % kLineBytes;
+  }
+
+  GiftedPaxBlock(GiftedPaxBlock &&other) = default;
+  GiftedPaxBlock& operator=(GiftedPaxBlock &&other) = default;
+
+  std::size_t getNumColumns() const {return _types.size();}
+  GiftedBaseType::GiftedTypeId getTypeId(const std::size_t column) const {return _types[column];}
+  std::size_t getFieldLength(const std::size_t column) const {return _lengths[column];}
+  std::size_t getCapacity() const {return _capacity;}
+  std::size_t size() const {return _numRows;}
+  bool full() const {return _numRows == _capacity;}
+  std::size_t getBytes() const {return _data.size();}
+
+  /**
+   * @brief Column "column" of the block as a read-only view of its minipage.
+   *        The view must not outlive the block or see appends to it.
+   **/
+  GiftedColumnVector getColumn(const std::size_t column) const {
+    return GiftedColumnVector::Wrap(_types[column], _lengths[column], _numRows, getValues(column), nullptr,
+                                    _nullCounts[column] > 0 ? getValidity(column) : nullptr,
+                                    std::shared_ptr<const void>());
+  }
+
+  const char* getValues(const std::size_t column) const {return base() + _valueOffsets[column];}
+
+  const char* getField(const std::size_t row, const std::size_t column) const {
+    return getValues(column) + row * _lengths[column];
+  }
+
+  bool isNull(const std::size_t row, const std::size_t column) const {
+    return ((getValidity(column)[row / 8] >> (row % 8)) & 1) == 0;
+  }
+
+  /**
+   * @brief Overwrite a value in place; the value is no longer null.
+   **/
+  void Update(const std::size_t row, const std::size_t column, const char *value) {
+    if (row >= _numRows) throw std::out_of_range("GiftedPaxBlock: row out of range");
+    std::memcpy(getValuesMutable(column) + row * _lengths[column], value, _lengths[column]);
+    if (isNull(row, column)) {
+      getValidityMutable(column)[row / 8] |= static_cast<std::uint8_t>(1u << (row % 8));
+      _nullCounts[column]--;
+    }
+  }
+
+  void SetNull(const std::size_t row, const std::size_t column) {
+    if (row >= _numRows) throw std::out_of_range("GiftedPaxBlock: row out of range");
+    if (isNull(row, column)) return;
+    std::memset(getValuesMutable(column) + row * _lengths[column], 0, _lengths[column]);
+    getValidityMutable(column)[row / 8] &= static_cast<std::uint8_t>(~(1u << (row % 8)));
+    _nullCounts[column]++;
+  }
+
+  /**
+   * @brief Append rows from "begin" on of "columns", one per block column and
+   *        of its type, until the block is full.
+   *
+   * @return The number of rows appended.
+   **/
+  std::size_t AppendColumns(const std::vector<const GiftedColumnVector*> &columns, const std::size_t begin) {
+    if (columns.size() != _types.size()) {
+      throw std::invalid_argument("GiftedPaxBlock: need one column per block column");
+    }
+    for (std::size_t c = 0; c < columns.size(); c++) {
+      if (columns[c]->getTypeId() != _types[c] || columns[c]->size() != columns[0]->size()) {
+        throw std::invalid_argument("GiftedPaxBlock: columns differ from the block's types or in length");
+      }
+    }
+    const std::size_t count = Room(columns[0]->size() > begin ? columns[0]->size() - begin : 0);
+    for (std::size_t c = 0; c < columns.size(); c++) {
+      std::memcpy(getValuesMutable(c) + _numRows * _lengths[c], columns[c]->getValues() + begin * _lengths[c],
+                  count * _lengths[c]);
+      for (std::size_t r = 0; r < count; r++) {
+        MarkAppended(_numRows + r, c, columns[c]->getValidityBitmap() != nullptr && columns[c]->isNull(begin + r));
+      }
+    }
+    _numRows += count;
+    return count;
+  }
+
+  /**
+   * @brief Append packed rows from "begin" on of "rows", whose columns are
+   *        the block's, until the block is full.
+   *
+   * @return The number of rows appended.
+   **/
+  std::size_t AppendRows(const GiftedRowBlock &rows, const std::size_t begin) {
+    CheckRowBlock(rows);
+    const std::size_t count = Room(rows.size() > begin ? rows.size() - begin : 0);
+    if (count == 0) return 0;
+    for (std::size_t c = 0; c < _types.size(); c++) {
+      GiftedGatherField(rows.getField(begin, c), rows.getRowWidth(), _lengths[c], count,
+                        getValuesMutable(c) + _numRows * _lengths[c]);
+      for (std::size_t r = 0; r < count; r++) MarkAppended(_numRows + r, c, rows.isNull(begin + r, c));
+    }
+    _numRows += count;
+    return count;
+  }
+
+  /**
+   * @brief Append rows [begin, begin + count) to "rows" as packed rows.
+   **/
+  void ToRows(const std::size_t begin, const std::size_t count, GiftedRowBlock *rows) const {
+    if (begin + count > _numRows) throw std::out_of_range("GiftedPaxBlock: rows out of range");
+    CheckRowBlock(*rows);
+    if (count == 0) return;
+    char *out = rows->AppendRows(count);
+    const std::size_t rowWidth = rows->getRowWidth();
+    for (std::size_t c = 0; c < _types.size(); c++) {
+      GiftedScatterField(getField(begin, c), _lengths[c], count, rowWidth, out + rows->getFieldOffset(c));
+      if (_nullCounts[c] == 0) continue;
+      for (std::size_t r = 0; r < count; r++) {
+        if (isNull(begin + r, c)) out[r * rowWidth + c / 8] |= static_cast<char>(1u << (c % 8));
+      }
+    }
+  }
+
+private:
+  static const std::size_t kLineBytes = 64;
+
+  static std::size_t RoundToLine(const std::size_t bytes) {
+    return (bytes + kLineBytes - 1) / kLineBytes * kLineBytes;
+  }
+
+  const char* base() const {return _data.data() + _skew;}
+  char* base() {return _data.data() + _skew;}
+  char* getValuesMutable(const std::size_t column) {return base() + _valueOffsets[column];}
+  const std::uint8_t* getValidity(const std::size_t column) const {
+    return reinterpret_cast<const std::uint8_t*>(base() + _validityOffsets[column]);
+  }
+  std::uint8_t* getValidityMutable(const std::size_t column) {
+    return reinterpret_cast<std::uint8_t*>(base() + _validityOffsets[column]);
+  }
+
+  std::size_t Room(const std::size_t wanted) const {
+    return wanted < _capacity - _numRows ? wanted : _capacity - _numRows;
+  }
+
+  // Appended slots start out null (their validity bits are clear).
+  void MarkAppended(const std::size_t row, const std::size_t column, const bool null) {
+    if (null) {
+      _nullCounts[column]++;
+    } else {
+      getValidityMutable(column)[row / 8] |= static_cast<std::uint8_t>(1u << (row % 8));
+    }
+  }
+
+  void CheckRowBlock(const GiftedRowBlock &rows) const {
+    bool same = rows.getNumColumns() == _types.size();
+    for (std::size_t c = 0; same && c < _types.size(); c++) same = rows.getTypeId(c) == _types[c];
+    if (!same) throw std::invalid_argument("GiftedPaxBlock: row block has other columns");
+  }
+
+  std::vector<GiftedBaseType::GiftedTypeId> _types;
+  std::size_t _capacity;
+  std::size_t _numRows;
+  std::vector<std::size_t> _lengths;
+  std::vector<std::size_t> _valueOffsets;     // Of each minipage's values,
+  std::vector<std::size_t> _validityOffsets;  // and validity, from base().
+  std::vector<std::size_t> _nullCounts;
+  std::vector<char> _data;
+  std::size_t _skew;  // From _data to the first cache line boundary.
+};
+
+#endif  // GIFTED_STORAGE_PAX_BLOCK_HPP_
@@ -0,0 +1,163 @@
+//
+//  PredicateResultCache.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_STORAGE_PREDICATE_RESULT_CACHE_HPP_
+#define GIFTED_STORAGE_PREDICATE_RESULT_CACHE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "utility/Bitmap.hpp"
+
+/**
+ * @brief Remembers the outcomes of predicates on sealed (immutable) blocks
+ *        of rows, so a filter that is run again on the same rows copies a
+ *        bitmap instead of evaluating the predicate.
+ *
+ *        An entry is keyed by the block's id, the first row of the batch
+ *        within the block and the predicate's cache key (see
+ *        GiftedColumnPredicate::getCacheKey()), and holds one bit per row.
+ *        Rewriting a block must be followed by InvalidateBlock(). The
+ *        entries are bounded by a byte budget and evicted least recently
+ *        used first. Safe to share between threads.
+ **/
+class GiftedPredicateResultCache {
+public:
+  struct Stats {
+    std::size_t hits;
+    std::size_t misses;
+    std::size_t insertions;
+    std::size_t evictions;
+    std::size_t invalidations;
+    std::size_t entries;
+    std::size_t bytes;
+  };
+
+  explicit GiftedPredicateResultCache(const std::size_t capacityBytes)
+      : _capacityBytes(capacityBytes), _bytes(0) {
+    _stats = Stats();
+  }
+
+  GiftedPredicateResultCache(const GiftedPredicateResultCache&) = delete;
+  GiftedPredicateResultCache& operator=(const GiftedPredicateResultCache&) = delete;
+
+  /**
+   * @brief If the outcomes for "numRows" rows from "firstRow" of the block
+   *        are cached, write them to result[0 .. numRows) and return true.
+   **/
+  bool Lookup(const std::uint64_t blockId,
+              const std::uint64_t firstRow,
+              const std::string &predicateKey,
+              const std::size_t numRows,
+              bool *result) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    Index::iterator found = _index.find(MakeKey(blockId, firstRow, predicateKey));
+    if (found == _index.end() || found->second->numRows != numRows) {
+      _stats.misses++;
+      return false;
+    }
+    // Most recently used goes to the front.
+    _entries.splice(_entries.begin(), _entries, found->second);
+    GiftedUnpackBools(found->second->bitmap.data(), numRows, result);
+    _stats.hits++;
+    return true;
+  }
+
+  /**
+   * @brief Cache the outcomes result[0 .. numRows) for the rows from
+   *        "firstRow" of the block, evicting old entries to stay in budget.
+   **/
+  void Insert(const std::uint64_t blockId,
+              const std::uint64_t firstRow,
+              const std::string &predicateKey,
+              const std::size_t numRows,
+              const bool *result) {
+    const std::string key = MakeKey(blockId, firstRow, predicateKey);
+    const std::size_t entryBytes = (numRows + 7) / 8 + key.size() + sizeof(Entry);
+    if (entryBytes > _capacityBytes) return;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    Index::iterator found = _index.find(key);
+    if (found != _index.end()) Erase(found->second);
+    while (_bytes + entryBytes > _capacityBytes && !_entries.empty()) {
+      Erase(--_entries.end());
+      _stats.evictions++;
+    }
+
+    _entries.push_front(Entry());
+    Entry &entry = _entries.front();
+    entry.key = key;
+    entry.blockId = blockId;
+    entry.numRows = numRows;
+    entry.bytes = entryBytes;
+    entry.bitmap.resize((numRows + 7) / 8);
+    GiftedPackBools(result, numRows, entry.bitmap.data());
+    _index[key] = _entries.begin();
+    _bytes += entryBytes;
+    _stats.insertions++;
+  }
+
+  /**
+   * @brief Drop every entry of a block, e.g. after it is rewritten.
+   **/
+  void InvalidateBlock(const std::uint64_t blockId) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (EntryList::iterator entry = _entries.begin(); entry != _entries.end();) {
+      EntryList::iterator next = entry;
+      ++next;
+      if (entry->blockId == blockId) {
+        Erase(entry);
+        _stats.invalidations++;
+      }
+      entry = next;
+    }
+  }
+
+  Stats getStats() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    Stats stats = _stats;
+    stats.entries = _entries.size();
+    stats.bytes = _bytes;
+    return stats;
+  }
+
+private:
+  struct Entry {
+    std::string key;
+    std::uint64_t blockId;
+    std::size_t numRows;
+    std::size_t bytes;
+    std::vector<std::uint8_t> bitmap;
+  };
+  typedef std::list<Entry> EntryList;
+  typedef std::unordered_map<std::string, EntryList::iterator> Index;
+
+  static std::string MakeKey(const std::uint64_t blockId, const std::uint64_t firstRow, const std::string &predicateKey) {
+    std::string key(reinterpret_cast<const char*>(&blockId), sizeof(blockId));
+    key.append(reinterpret_cast<const char*>(&firstRow), sizeof(firstRow));
+    return key.append(predicateKey);
+  }
+
+  void Erase(const EntryList::iterator entry) {
+    _bytes -= entry->bytes;
+    _index.erase(entry->key);
+    _entries.erase(entry);
+  }
+
+  const std::size_t _capacityBytes;
+  mutable std::mutex _mutex;
+  EntryList _entries;  // Most recently used first.
+  Index _index;
+  std::size_t _bytes;
+  Stats _stats;
+};
+
+#endif  // GIFTED_STORAGE_PREDICATE_RESULT_CACHE_HPP_
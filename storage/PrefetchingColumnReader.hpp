@@ -0,0 +1,288 @@
+//
+//  PrefetchingColumnReader.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_STORAGE_PREFETCHING_COLUMN_READER_HPP_
+#define GIFTED_STORAGE_PREFETCHING_COLUMN_READER_HPP_
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "storage/ColumnVector.hpp"
+#include "types/BaseType.hpp"
+#include "utility/AlignedBuffer.hpp"
+#include "utility/IoUring.hpp"
+
+struct GiftedPrefetchOptions {
+  GiftedPrefetchOptions()
+      : blockBytes(1 << 20), queueDepth(8), directIO(false) {}
+
+  std::size_t blockBytes; // Bytes per read; rounded to whole pages and values.
+  std::size_t queueDepth; // Reads in flight ahead of the scan.
+  bool directIO;          // Bypass the page cache (O_DIRECT) where possible.
+};
+
+/**
+ * @brief Streams a column file (fixed length values, packed back to back in
+ *        their marshalled form) through a ring of aligned buffers.
+ *
+ *        Up to queueDepth reads are kept in flight ahead of the block being
+ *        scanned, so the kernels work on one block while the next ones are
+ *        being read. On Linux the reads go through io_uring; elsewhere (or
+ *        when io_uring is unavailable) each block is read with pread after
+ *        asking the kernel to read ahead.
+ *
+ *        Unlike a mapping of the file, a scan never takes a page fault and
+ *        only queueDepth blocks of memory are used, however big the column.
+ **/
+class GiftedPrefetchingColumnReader {
+public:
+  GiftedPrefetchingColumnReader(const GiftedBaseType::GiftedTypeId typeId,
+                                const std::size_t elementLength,
+                                const std::string &path,
+                                const GiftedPrefetchOptions &options = GiftedPrefetchOptions())
+      : _typeId(typeId),
+        _elementLength(elementLength),
+        _fd(-1),
+        _fileBytes(0),
+        _numBlocks(0),
+        _nextToIssue(0),
+        _nextToConsume(0),
+        _inFlight(0),
+        _useRing(false) {
+    if (elementLength == 0) {
+      throw std::invalid_argument("GiftedPrefetchingColumnReader: only fixed length columns are supported");
+    }
+    // The destructor does not run if this throws.
+    try {
+      Open(path, options.directIO);
+
+      // Blocks hold whole pages (for direct I/O) and whole values.
+      std::size_t unit = kPageBytes;
+      while (unit % elementLength != 0) unit += kPageBytes;
+      _blockBytes = (options.blockBytes + unit - 1) / unit * unit;
+      _numBlocks = (_fileBytes + _blockBytes - 1) / _blockBytes;
+
+      const std::size_t depth = options.queueDepth > 0 ? options.queueDepth : 1;
+      for (std::size_t i = 0; i < depth; i++) {
+        _slots.push_back(std::unique_ptr<Slot>(new Slot(_blockBytes)));
+      }
+
+#if defined(GIFTED_HAVE_IO_URING)
+      _useRing = _ring.Setup(static_cast<unsigned>(depth));
+#endif
+    } catch (...) {
+      if (_fd >= 0) close(_fd);
+      throw;
+    }
+  }
+
+  ~GiftedPrefetchingColumnReader() {
+#if defined(GIFTED_HAVE_IO_URING)
+    // The kernel may still be writing into the buffers.
+    try {
+      std::uint64_t block;
+      int result;
+      while (_inFlight > 0) {
+        if (_ring.PopCompletion(&block, &result)) {
+          _inFlight--;
+        } else {
+          _ring.Submit(1);
+        }
+      }
+    } catch (...) {
+    }
+#endif
+    if (_fd >= 0) close(_fd);
+  }
+
+  /**
+   * @brief Number of values in the column.
+   **/
+  std::size_t size() const {return _fileBytes / _elementLength;}
+
+  bool usesIoUring() const {return _useRing;}
+
+  /**
+   * @brief Get the next block of the column as a read-only view. The view
+   *        is valid until the next call to Next().
+   *
+   * @return false once the whole column has been read.
+   * @exception std::runtime_error if a read fails.
+   **/
+  bool Next(GiftedColumnVector *block) {
+    // The buffer handed out last time is free again.
+    IssueReads();
+    if (_nextToConsume == _numBlocks) return false;
+
+    Slot &slot = *_slots[_nextToConsume % _slots.size()];
+    if (_useRing) {
+      while (!slot.ready) WaitForCompletion();
+    } else {
+      ReadBlock(&slot);
+    }
+    *block = GiftedColumnVector::Wrap(_typeId, _elementLength, slot.expected / _elementLength,
+                                      slot.buffer.data(), nullptr, nullptr,
+                                      std::shared_ptr<const void>());
+    _nextToConsume++;
+    return true;
+  }
+
+private:
+  static const std::size_t kPageBytes = 4096;
+
+  struct Slot {
+    explicit Slot(const std::size_t bytes)
+        : buffer(bytes, kPageBytes), offset(0), expected(0), done(0), ready(false) {}
+
+    GiftedAlignedBuffer buffer;
+    std::uint64_t offset;  // In the file.
+    std::size_t expected;  // Bytes of the file in this block.
+    std::size_t done;      // Bytes read so far.
+    bool ready;
+    iovec iov;
+  };
+
+  void Open(const std::string &path, const bool directIO) {
+    int flags = O_RDONLY;
+#if defined(O_DIRECT)
+    if (directIO) flags |= O_DIRECT;
+#endif
+    _fd = open(path.c_str(), flags);
+#if defined(O_DIRECT)
+    if (_fd < 0 && errno == EINVAL && directIO) {
+      _fd = open(path.c_str(), O_RDONLY); // The file system has no direct I/O.
+    }
+#endif
+    if (_fd < 0) {
+      throw std::runtime_error("GiftedPrefetchingColumnReader: cannot open " + path);
+    }
+#if defined(F_NOCACHE)
+    if (directIO) fcntl(_fd, F_NOCACHE, 1);
+#endif
+    struct stat info;
+    if (fstat(_fd, &info) != 0) {
+      throw std::runtime_error("GiftedPrefetchingColumnReader: cannot stat " + path);
+    }
+    _fileBytes = static_cast<std::size_t>(info.st_size);
+    if (_fileBytes % _elementLength != 0) {
+      throw std::runtime_error("GiftedPrefetchingColumnReader: " + path + " is not a whole number of values");
+    }
+  }
+
+  // Start reads for as many upcoming blocks as there are free slots.
+  void IssueReads() {
+    while (_nextToIssue < _numBlocks && _nextToIssue - _nextToConsume < _slots.size()) {
+      Slot &slot = *_slots[_nextToIssue % _slots.size()];
+      slot.offset = static_cast<std::uint64_t>(_nextToIssue) * _blockBytes;
+      slot.expected = _fileBytes - slot.offset < _blockBytes ? _fileBytes - slot.offset : _blockBytes;
+      slot.done = 0;
+      slot.ready = false;
+      if (_useRing) {
+        QueueRead(&slot, _nextToIssue);
+      } else {
+#if defined(POSIX_FADV_WILLNEED)
+        posix_fadvise(_fd, slot.offset, slot.expected, POSIX_FADV_WILLNEED);
+#endif
+      }
+      _nextToIssue++;
+    }
+#if defined(GIFTED_HAVE_IO_URING)
+    if (_useRing) _ring.Submit(0);
+#endif
+  }
+
+  // Read the rest of a block; direct I/O wants whole pages even at the end.
+  std::size_t RemainingRequest(const Slot &slot) const {
+    const std::size_t remaining = (slot.expected - slot.done + kPageBytes - 1) / kPageBytes * kPageBytes;
+    return remaining < _blockBytes - slot.done ? remaining : _blockBytes - slot.done;
+  }
+
+  void QueueRead(Slot *slot, const std::size_t block) {
+#if defined(GIFTED_HAVE_IO_URING)
+    slot->iov.iov_base = slot->buffer.data() + slot->done;
+    slot->iov.iov_len = RemainingRequest(*slot);
+    if (!_ring.PrepareRead(_fd, &slot->iov, slot->offset + slot->done, block)) {
+      throw std::logic_error("GiftedPrefetchingColumnReader: submission queue overflow");
+    }
+    _inFlight++;
+#else
+    (void) slot;
+    (void) block;
+#endif
+  }
+
+  void WaitForCompletion() {
+#if defined(GIFTED_HAVE_IO_URING)
+    std::uint64_t block;
+    int result;
+    while (!_ring.PopCompletion(&block, &result)) {
+      _ring.Submit(1);
+    }
+    _inFlight--;
+    Slot &slot = *_slots[block % _slots.size()];
+    if (result < 0) {
+      throw std::runtime_error(std::string("GiftedPrefetchingColumnReader: read failed: ") + std::strerror(-result));
+    }
+    if (result == 0) {
+      throw std::runtime_error("GiftedPrefetchingColumnReader: file shrank during the scan");
+    }
+    slot.done += static_cast<std::size_t>(result);
+    if (slot.done >= slot.expected) {
+      slot.ready = true;
+    } else {
+      QueueRead(&slot, block); // Short read; go again for the rest.
+      _ring.Submit(0);
+    }
+#endif
+  }
+
+  void ReadBlock(Slot *slot) {
+    while (slot->done < slot->expected) {
+      const ssize_t result = pread(_fd, slot->buffer.data() + slot->done, RemainingRequest(*slot),
+                                   slot->offset + slot->done);
+      if (result < 0) {
+        if (errno == EINTR) continue;
+        throw std::runtime_error(std::string("GiftedPrefetchingColumnReader: read failed: ") + std::strerror(errno));
+      }
+      if (result == 0) {
+        throw std::runtime_error("GiftedPrefetchingColumnReader: file shrank during the scan");
+      }
+      slot->done += static_cast<std::size_t>(result);
+    }
+    slot->ready = true;
+  }
+
+  const GiftedBaseType::GiftedTypeId _typeId;
+  const std::size_t _elementLength;
+  int _fd;
+  std::size_t _fileBytes;
+  std::size_t _blockBytes;
+  std::size_t _numBlocks;
+  std::size_t _nextToIssue;   // Blocks [_nextToConsume, _nextToIssue) are in slots.
+  std::size_t _nextToConsume;
+  std::size_t _inFlight;      // Reads the kernel has not completed yet.
+  std::vector<std::unique_ptr<Slot> > _slots;
+  bool _useRing;
+#if defined(GIFTED_HAVE_IO_URING)
+  GiftedIoUring _ring;
+#endif
+
+  GiftedPrefetchingColumnReader(const GiftedPrefetchingColumnReader&) = delete;
+  GiftedPrefetchingColumnReader& operator=(const GiftedPrefetchingColumnReader&) = delete;
+};
+
+#endif  // GIFTED_STORAGE_PREFETCHING_COLUMN_READER_HPP_
@@ -0,0 +1,267 @@
+//
+//  RowBlock.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_STORAGE_ROW_BLOCK_HPP_
+#define GIFTED_STORAGE_ROW_BLOCK_HPP_
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "storage/ColumnVector.hpp"
+#include "types/BaseType.hpp"
+#include "types/TypeRegistry.hpp"
+
+namespace gifted_row_block_internal {
+
+template <std::size_t kLength>
+inline void GatherFieldFixed(const char *field, const std::size_t rowWidth, const std::size_t count, char *out) {
+  for (std::size_t i = 0; i < count; i++) std::memcpy(out + i * kLength, field + i * rowWidth, kLength);
+}
+
+template <std::size_t kLength>
+inline void ScatterFieldFixed(const char *values, const std::size_t count, const std::size_t rowWidth, char *field) {
+  for (std::size_t i = 0; i < count; i++) std::memcpy(field + i * rowWidth, values + i * kLength, kLength);
+}
+
+}  // namespace gifted_row_block_internal
+
+/**
+ * @brief Rows to a column: copy one field of "count" packed rows ("field"
+ *        points at it in the first row, rows are "rowWidth" bytes apart)
+ *        back to back into "out". 4 and 8 byte fields are fetched eight or
+ *        four rows at a time by the AVX2 gather; other common widths are
+ *        copied with a fixed size move each.
+ **/
+inline void GiftedGatherField(const char *field,
+                              const std::size_t rowWidth,
+                              const std::size_t fieldLength,
+                              const std::size_t count,
+                              char *out) {
+  using namespace gifted_row_block_internal;
+  std::size_t i = 0;
+#if defined(__AVX2__)
+  // Offsets are 32 bit, so go a bounded chunk of rows at a time.
+  if ((fieldLength == 4 || fieldLength == 8) && rowWidth <= (1u << 20)) {
+    const std::size_t chunk = (std::size_t(1) << 30) / rowWidth;
+    const __m256i step8 = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i width = _mm256_set1_epi32(static_cast<int>(rowWidth));
+    const __m256i offsets8 = _mm256_mullo_epi32(step8, width);
+    for (; i + 8 <= count;) {
+      const char *base = field + i * rowWidth;
+      const std::size_t end = count - i < chunk ? count - i : chunk;
+      std::size_t j = 0;
+      if (fieldLength == 4) {
+        for (; j + 8 <= end; j += 8) {
+          const __m256i offsets = _mm256_add_epi32(offsets8, _mm256_set1_epi32(static_cast<int>(j * rowWidth)));
+          _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + (i + j) * 4),
+                              _mm256_i32gather_epi32(reinterpret_cast<const int*>(base), offsets, 1));
+        }
+      } else {
+        const __m128i offsets4 = _mm256_castsi256_si128(offsets8);
+        for (; j + 4 <= end; j += 4) {
+          const __m128i offsets = _mm_add_epi32(offsets4, _mm_set1_epi32(static_cast<int>(j * rowWidth)));
+          _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + (i + j) * 8),
+                              _mm256_i32gather_epi64(reinterpret_cast<const long long*>(base), offsets, 1));
+        }
+      }
+      i += j;
+      if (j < end) break;
+    }
+  }
+#endif
+  const char *rest = field + i * rowWidth;
+  char *restOut = out + i * fieldLength;
+  const std::size_t left = count - i;
+  switch (fieldLength) {
+    case 1: GatherFieldFixed<1>(rest, rowWidth, left, restOut); break;
+    case 2: GatherFieldFixed<2>(rest, rowWidth, left, restOut); break;
+    case 4: GatherFieldFixed<4>(rest, rowWidth, left, restOut); break;
+    case 8: GatherFieldFixed<8>(rest, rowWidth, left, restOut); break;
+    case 16: GatherFieldFixed<16>(rest, rowWidth, left, restOut); break;
+    default:
+      for (std::size_t r = 0; r < left; r++) std::memcpy(restOut + r * fieldLength, rest + r * rowWidth, fieldLength);
+      break;
+  }
+}
+
+/**
+ * @brief A column to rows: the inverse of GiftedGatherField. x86 has no
+ *        scatter below AVX-512, so each value is one fixed size store.
+ **/
+inline void GiftedScatterField(const char *values,
+                               const std::size_t fieldLength,
+                               const std::size_t count,
+                               const std::size_t rowWidth,
+                               char *field) {
+  using namespace gifted_row_block_internal;
+  switch (fieldLength) {
+    case 1: ScatterFieldFixed<1>(values, count, rowWidth, field); break;
+    case 2: ScatterFieldFixed<2>(values, count, rowWidth, field); break;
+    case 4: ScatterFieldFixed<4>(values, count, rowWidth, field); break;
+    case 8: ScatterFieldFixed<8>(values, count, rowWidth, field); break;
+    case 16: ScatterFieldFixed<16>(values, count, rowWidth, field); break;
+    default:
+      for (std::size_t r = 0; r < count; r++) std::memcpy(field + r * rowWidth, values + r * fieldLength, fieldLength);
+      break;
+  }
+}
+
+/**
+ * @brief A block of packed rows of fixed length values (a "packed row
+ *        store"), for row oriented input and output.
+ *
+ *        A row is a null bitmap (one bit per column, set for null, so a
+ *        zeroed row has no nulls) followed by the columns' raw values, each
+ *        as long as its type's getLength(), back to back without padding.
+ *        Rows are read and written whole, e.g. copied from a network
+ *        buffer; AppendColumns() and ToColumns() transpose between rows
+ *        and GiftedColumnVectors one field at a time, with
+ *        GiftedScatterField and GiftedGatherField, never value by value
+ *        through the types.
+ **/
+class GiftedRowBlock {
+public:
+  GiftedRowBlock(const GiftedTypeRegistry &registry, const std::vector<GiftedBaseType::GiftedTypeId> &types)
+      : _types(types),
+        _nullBytes((types.size() + 7) / 8),
+        _rowWidth(_nullBytes),
+        _numRows(0) {
+    if (types.empty()) throw std::invalid_argument("GiftedRowBlock: no columns");
+    for (std::size_t c = 0; c < types.size(); c++) {
+      const GiftedTypeRegistry::Entry *entry = registry.getEntry(types[c]);
+      if (entry == nullptr) throw std::invalid_argument("GiftedRowBlock: unknown type");
+      if (entry->length == 0) throw std::invalid_argument("GiftedRowBlock: only fixed length types");
+      _offsets.push_back(_rowWidth);
+      _lengths.push_back(entry->length);
+      _rowWidth += entry->length;
+    }
+  }
+
+  std::size_t getNumColumns() const {return _types.size();}
+  GiftedBaseType::GiftedTypeId getTypeId(const std::size_t column) const {return _types[column];}
+  std::size_t getRowWidth() const {return _rowWidth;}
+  std::size_t getFieldOffset(const std::size_t column) const {return _offsets[column];}
+  std::size_t getFieldLength(const std::size_t column) const {return _lengths[column];}
+  std::size_t size() const {return _numRows;}
+
+  const char* getRow(const std::size_t row) const {return _rows.data() + row * _rowWidth;}
+  const char* getField(const std::size_t row, const std::size_t column) const {
+    return getRow(row) + _offsets[column];
+  }
+
+  bool isNull(const std::size_t row, const std::size_t column) const {
+    return (static_cast<unsigned char>(getRow(row)[column / 8]) >> (column % 8)) & 1;
+  }
+
+  /**
+   * @brief Append "count" zeroed rows and return where to write them.
+   **/
+  char* AppendRows(const std::size_t count) {
+    _rows.resize((_numRows + count) * _rowWidth, 0);
+    char *rows = _rows.data() + _numRows * _rowWidth;
+    _numRows += count;
+    return rows;
+  }
+
+  void AppendRow(const char *row) {
+    std::memcpy(AppendRows(1), row, _rowWidth);
+  }
+
+  /**
+   * @brief Columns to rows: append one row per value of "columns", one per
+   *        column of the block and of its types, all equally long.
+   **/
+  void AppendColumns(const std::vector<const GiftedColumnVector*> &columns) {
+    if (columns.size() != _types.size()) {
+      throw std::invalid_argument("GiftedRowBlock: need one column per block column");
+    }
+    const std::size_t count = columns.empty() ? 0 : columns[0]->size();
+    for (std::size_t c = 0; c < columns.size(); c++) {
+      if (columns[c]->getTypeId() != _types[c] || columns[c]->size() != count) {
+        throw std::invalid_argument("GiftedRowBlock: columns differ from the block's types or in length");
+      }
+    }
+    char *rows = AppendRows(count);
+    // A tile of rows at a time, all of its fields while it is in cache.
+    const std::size_t tile = TileRows();
+    for (std::size_t first = 0; first < count; first += tile) {
+      const std::size_t tileRows = count - first < tile ? count - first : tile;
+      char *tileStart = rows + first * _rowWidth;
+      for (std::size_t c = 0; c < columns.size(); c++) {
+        GiftedScatterField(columns[c]->getValues() + first * _lengths[c], _lengths[c], tileRows, _rowWidth,
+                           tileStart + _offsets[c]);
+        if (columns[c]->getValidityBitmap() == nullptr) continue;
+        for (std::size_t r = 0; r < tileRows; r++) {
+          if (columns[c]->isNull(first + r)) tileStart[r * _rowWidth + c / 8] |= static_cast<char>(1u << (c % 8));
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief Rows to columns: append rows [begin, begin + count) to
+   *        "columns", one column per block column, of its type.
+   **/
+  void ToColumns(const std::size_t begin, const std::size_t count, std::vector<GiftedColumnVector> *columns) const {
+    if (begin + count > _numRows) throw std::out_of_range("GiftedRowBlock: rows out of range");
+    while (columns->size() < _types.size()) {
+      columns->push_back(GiftedColumnVector(_types[columns->size()], _lengths[columns->size()], count));
+    }
+    std::vector<char*> values(_types.size());
+    std::vector<std::size_t> firsts(_types.size());
+    for (std::size_t c = 0; c < _types.size(); c++) {
+      firsts[c] = (*columns)[c].size();
+      values[c] = (*columns)[c].AppendFixedSlots(count);
+    }
+    std::vector<unsigned char> anyNull(_nullBytes);
+    const std::size_t tile = TileRows();
+    for (std::size_t first = 0; first < count; first += tile) {
+      const std::size_t tileRows = count - first < tile ? count - first : tile;
+      const char *tileStart = getRow(begin + first);
+      // The columns with a null in the tile; only their bits are read.
+      std::fill(anyNull.begin(), anyNull.end(), 0);
+      for (std::size_t r = 0; r < tileRows; r++) {
+        for (std::size_t byte = 0; byte < _nullBytes; byte++) anyNull[byte] |= tileStart[r * _rowWidth + byte];
+      }
+      for (std::size_t c = 0; c < _types.size(); c++) {
+        GiftedGatherField(tileStart + _offsets[c], _rowWidth, _lengths[c], tileRows,
+                          values[c] + first * _lengths[c]);
+        const std::size_t byte = c / 8;
+        const unsigned char bit = static_cast<unsigned char>(1u << (c % 8));
+        if ((anyNull[byte] & bit) == 0) continue;
+        for (std::size_t r = 0; r < tileRows; r++) {
+          if (tileStart[r * _rowWidth + byte] & bit) (*columns)[c].MarkNull(firsts[c] + first + r);
+        }
+      }
+    }
+  }
+
+private:
+  // Rows per transposition tile: about 16 KB, so a tile stays in cache
+  // while its fields are copied one after the other.
+  std::size_t TileRows() const {
+    const std::size_t rows = (16 * 1024) / _rowWidth;
+    return rows < 64 ? 64 : rows;
+  }
+
+  const std::vector<GiftedBaseType::GiftedTypeId> _types;
+  const std::size_t _nullBytes;
+  std::size_t _rowWidth;
+  std::vector<std::size_t> _offsets;  // Of each column's value in a row.
+  std::vector<std::size_t> _lengths;
+  std::vector<char> _rows;
+  std::size_t _numRows;
+};
+
+#endif  // GIFTED_STORAGE_ROW_BLOCK_HPP_
@@ -0,0 +1,182 @@
+//
+//  SortedIndex.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_STORAGE_SORTED_INDEX_HPP_
+#define GIFTED_STORAGE_SORTED_INDEX_HPP_
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "storage/ColumnVector.hpp"
+#include "types/BaseType.hpp"
+#include "types/TypeRegistry.hpp"
+
+/**
+ * @brief A sorted index over one fixed width column (of at most 8 bytes),
+ *        for point and range lookups without a scan.
+ *
+ *        The values are turned into normalized keys by the type's
+ *        NormalizeKeys kernel, read as unsigned 64 bit integers (so plain
+ *        integer order is the type's order), and sorted with their rows.
+ *        The sorted keys are searched through a CSS-tree: a static,
+ *        pointerless B+-tree whose nodes are 8 keys, one cache line. Level
+ *        l+1 holds the largest key of each node of level l, so a child is
+ *        found by arithmetic, not a pointer, and a search touches one line
+ *        per level. Within a node the number of keys below the probe is
+ *        the child, counted with two AVX2 compares (or a branch free loop).
+ *
+ *        Nulls are not indexed. The index copies what it needs; the column
+ *        may change afterwards, but the index then describes the old values.
+ **/
+class GiftedSortedIndex {
+public:
+  GiftedSortedIndex(const GiftedTypeRegistry &registry, const GiftedColumnVector &column)
+      : _kernels(registry.getEntry(column.getTypeId())->prototype.get()),
+        _elementLength(column.getElementLength()) {
+    if (column.isVariableLength() || _elementLength > sizeof(std::uint64_t)) {
+      throw std::invalid_argument("GiftedSortedIndex: only fixed width values of up to 8 bytes");
+    }
+    if (column.size() >= std::numeric_limits<std::uint32_t>::max()) {
+      throw std::overflow_error("GiftedSortedIndex: column is too large");
+    }
+
+    std::vector<std::uint64_t> keys(column.size());
+    std::string normalized(column.size() * _elementLength, '\0');
+    NormalizedKeys(column.getValues(), column.size(), &normalized[0], keys.data());
+    std::vector<std::pair<std::uint64_t, std::uint32_t> > entries;
+    entries.reserve(column.size());
+    for (std::size_t i = 0; i < column.size(); i++) {
+      if (!column.isNull(i)) entries.push_back(std::make_pair(keys[i], static_cast<std::uint32_t>(i)));
+    }
+    std::sort(entries.begin(), entries.end());
+
+    keys.resize(entries.size());
+    _rows.resize(entries.size());
+    for (std::size_t i = 0; i < entries.size(); i++) {
+      keys[i] = entries[i].first;
+      _rows[i] = entries[i].second;
+    }
+    BuildDirectory(&keys);
+  }
+
+  std::size_t size() const {return _rows.size();}
+
+  /**
+   * @brief Append the rows whose value is "value" (raw form) to "rows", in
+   *        ascending order.
+   **/
+  void Lookup(const char *value, std::vector<std::uint32_t> *rows) const {
+    LookupRange(value, value, rows);
+  }
+
+  /**
+   * @brief Append the rows whose value is in [low, high] (raw forms) to
+   *        "rows", in ascending order.
+   **/
+  void LookupRange(const char *low, const char *high, std::vector<std::uint32_t> *rows) const {
+    std::uint64_t lowKey, highKey;
+    char lowBytes[sizeof(std::uint64_t)], highBytes[sizeof(std::uint64_t)];
+    NormalizedKeys(low, 1, lowBytes, &lowKey);
+    NormalizedKeys(high, 1, highBytes, &highKey);
+    if (lowKey > highKey) return;
+    const std::size_t begin = LowerBound(lowKey);
+    const std::size_t end = highKey == std::numeric_limits<std::uint64_t>::max() ? _rows.size()
+                                                                                 : LowerBound(highKey + 1);
+    const std::size_t first = rows->size();
+    rows->insert(rows->end(), _rows.begin() + begin, _rows.begin() + end);
+    // A point lookup's rows are in order already (ties sort by row).
+    if (lowKey != highKey) std::sort(rows->begin() + first, rows->end());
+  }
+
+  /**
+   * @brief Position of the first sorted key not below "key".
+   **/
+  std::size_t LowerBound(const std::uint64_t key) const {
+    if (_rows.empty()) return 0;
+    std::size_t node = 0;
+    for (std::size_t level = _levels.size(); level-- > 0;) {
+      // Past the last node: every key is below the probe.
+      if (node * kNodeKeys >= _levels[level].size()) return _rows.size();
+      node = node * kNodeKeys + CountBelow(_levels[level].data() + node * kNodeKeys, key);
+    }
+    return node < _rows.size() ? node : _rows.size();
+  }
+
+  std::size_t getBytes() const {
+    std::size_t bytes = _rows.size() * sizeof(std::uint32_t);
+    for (std::size_t l = 0; l < _levels.size(); l++) bytes += _levels[l].size() * sizeof(std::uint64_t);
+    return bytes;
+  }
+
+private:
+  static const std::size_t kNodeKeys = 8;
+
+  // "scratch" holds count * _elementLength bytes.
+  void NormalizedKeys(const char *values, const std::size_t count, char *scratch, std::uint64_t *keys) const {
+    if (count > 0) _kernels->NormalizeKeys(_elementLength, values, count, scratch);
+    const unsigned char *bytes = reinterpret_cast<const unsigned char*>(scratch);
+    for (std::size_t i = 0; i < count; i++) {
+      std::uint64_t key = 0;
+      for (std::size_t b = 0; b < _elementLength; b++) key = (key << 8) | bytes[i * _elementLength + b];
+      keys[i] = key;
+    }
+  }
+
+  /**
+   * @brief Level 0 is the sorted keys, each level above the largest key of
+   *        every node below, until one node is left. Levels are padded to
+   *        whole nodes with the largest key, which no probe is below.
+   **/
+  void BuildDirectory(std::vector<std::uint64_t> *keys) {
+    _levels.clear();
+    if (keys->empty()) return;
+    std::vector<std::uint64_t> level;
+    level.swap(*keys);
+    while (true) {
+      level.resize((level.size() + kNodeKeys - 1) / kNodeKeys * kNodeKeys,
+                   std::numeric_limits<std::uint64_t>::max());
+      _levels.push_back(level);
+      if (level.size() == kNodeKeys) break;
+      std::vector<std::uint64_t> above(level.size() / kNodeKeys);
+      for (std::size_t n = 0; n < above.size(); n++) above[n] = level[n * kNodeKeys + kNodeKeys - 1];
+      level.swap(above);
+    }
+  }
+
+  static std::size_t CountBelow(const std::uint64_t *entries, const std::uint64_t key) {
+#if defined(__AVX2__)
+    // AVX2 compares signed; flipping the sign bits makes it unsigned.
+    const __m256i flip = _mm256_set1_epi64x(static_cast<long long>(0x8000000000000000ULL));
+    const __m256i probe = _mm256_xor_si256(_mm256_set1_epi64x(static_cast<long long>(key)), flip);
+    const __m256i first = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(entries)), flip);
+    const __m256i second = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(entries + 4)), flip);
+    const int mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(probe, first))) |
+                     (_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(probe, second))) << 4);
+    return static_cast<std::size_t>(__builtin_popcount(mask));
+#else
+    std::size_t below = 0;
+    for (std::size_t i = 0; i < kNodeKeys; i++) below += entries[i] < key;
+    return below;
+#endif
+  }
+
+  GiftedBaseType *_kernels;
+  const std::size_t _elementLength;
+  std::vector<std::uint32_t> _rows;  // The row of each sorted key.
+  std::vector<std::vector<std::uint64_t> > _levels;  // _levels[0]: the sorted keys.
+};
+
+#endif  // GIFTED_STORAGE_SORTED_INDEX_HPP_
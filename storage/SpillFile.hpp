@@ -0,0 +1,378 @@
+//
+//  SpillFile.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_STORAGE_SPILL_FILE_HPP_
+#define GIFTED_STORAGE_SPILL_FILE_HPP_
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "storage/ColumnVector.hpp"
+#include "types/BaseType.hpp"
+#include "types/TypeRegistry.hpp"
+#include "utility/AlignedBuffer.hpp"
+
+// Operators that spill split their input on kGiftedSpillBits hash bits per
+// level of recursion, from the top (the hash tables use the low bits).
+static const unsigned kGiftedSpillBits = 4;
+static const std::size_t kGiftedSpillFanout = std::size_t(1) << kGiftedSpillBits;
+static const unsigned kGiftedMaxSpillLevel = 64 / kGiftedSpillBits - 1;
+
+inline std::size_t GiftedSpillPartition(const std::uint64_t hash, const unsigned level) {
+  return static_cast<std::size_t>(hash >> (64 - kGiftedSpillBits * (level + 1))) & (kGiftedSpillFanout - 1);
+}
+
+/**
+ * @brief Where spill files go: $GIFTED_SPILL_DIR, else $TMPDIR, else /tmp.
+ **/
+inline std::string GiftedSpillDirectory() {
+  const char *directory = std::getenv("GIFTED_SPILL_DIR");
+  if (directory == nullptr || *directory == '\0') directory = std::getenv("TMPDIR");
+  if (directory == nullptr || *directory == '\0') directory = "/tmp";
+  return directory;
+}
+
+/**
+ * @brief Bytes of memory a column's values, offsets and validity take.
+ **/
+inline std::size_t GiftedColumnBytes(const GiftedColumnVector &column) {
+  return column.getValuesBytes() +
+         (column.isVariableLength() ? (column.size() + 1) * sizeof(GiftedColumnVector::OffsetType) : 0) +
+         (column.getValidityBitmap() != nullptr ? (column.size() + 7) / 8 : 0);
+}
+
+/**
+ * @brief Rows per batch cut out of spilled (or resident) columns: the batch
+ *        capacity rounded down to a multiple of 8, so that every view starts
+ *        on a whole byte of the validity bitmap.
+ *
+ * @exception std::invalid_argument if the batch holds fewer than 8 rows.
+ **/
+inline std::size_t GiftedSpillBatchRows(const std::size_t capacity) {
+  if (capacity < 8) {
+    throw std::invalid_argument("GiftedSpillBatchRows: batch capacity must be at least 8 rows");
+  }
+  return capacity & ~static_cast<std::size_t>(7);
+}
+
+/**
+ * @brief A temporary file of column chunks, for operators whose state does
+ *        not fit in memory. Values are written in their raw (marshalled)
+ *        form, as the columns hold them, so nothing is converted either
+ *        way: a chunk is a header (rows; type, element length, value bytes
+ *        and whether there is a validity bitmap per column) followed by each
+ *        column's offsets (from 0), values and validity bitmap.
+ *
+ *        Chunks are appended, then read back in order after Rewind(), as
+ *        views over one buffer per chunk. The file is unlinked as soon as it
+ *        is created, so it is gone with the object, or the process.
+ **/
+class GiftedSpillFile {
+public:
+  explicit GiftedSpillFile(const std::string &directory = GiftedSpillDirectory())
+      : _fd(-1), _numRows(0), _bytes(0), _readOffset(0), _reading(false) {
+    std::string path = directory + "/gifted-spill-XXXXXX";
+    std::vector<char> name(path.begin(), path.end());
+    name.push_back('\0');
+    _fd = mkstemp(name.data());
+    if (_fd < 0) {
+      throw std::runtime_error("GiftedSpillFile: cannot create a file in " + directory + ": " +
+                               std::strerror(errno));
+    }
+    unlink(name.data());
+  }
+
+  ~GiftedSpillFile() {
+    if (_fd >= 0) close(_fd);
+  }
+
+  std::size_t getNumRows() const {return _numRows;}
+  std::uint64_t getBytes() const {return _bytes + _writeBuffer.size();}
+
+  /**
+   * @brief Append equally long columns (without selection) as a chunk.
+   **/
+  void Append(const std::vector<const GiftedColumnVector*> &columns) {
+    if (_reading) throw std::logic_error("GiftedSpillFile: appending after Rewind()");
+    const std::size_t numRows = columns.empty() ? 0 : columns[0]->size();
+    if (numRows == 0) return;
+    std::vector<ColumnHeader> headers(columns.size());
+    for (std::size_t c = 0; c < columns.size(); c++) {
+      if (columns[c]->size() != numRows) throw std::invalid_argument("GiftedSpillFile: columns differ in length");
+      headers[c].typeId = columns[c]->getTypeId();
+      headers[c].hasValidity = columns[c]->getValidityBitmap() != nullptr;
+      headers[c].elementLength = columns[c]->getElementLength();
+      headers[c].valuesBytes = columns[c]->getValuesBytes();
+    }
+    const ChunkHeader chunk = {kMagic, static_cast<std::uint32_t>(columns.size()), numRows,
+                               PayloadBytes(headers, numRows)};
+    Write(&chunk, sizeof(chunk));
+    Write(headers.data(), headers.size() * sizeof(ColumnHeader));
+
+    const std::vector<char> padding(kAlignment, 0);
+    std::vector<GiftedColumnVector::OffsetType> offsets;
+    for (std::size_t c = 0; c < columns.size(); c++) {
+      const GiftedColumnVector &column = *columns[c];
+      const char *values = column.getValues();
+      if (column.isVariableLength()) {
+        const GiftedColumnVector::OffsetType *from = column.getOffsets();
+        offsets.resize(numRows + 1);
+        for (std::size_t i = 0; i <= numRows; i++) offsets[i] = from[i] - from[0];
+        Write(offsets.data(), offsets.size() * sizeof(offsets[0]));
+        Write(padding.data(), Padding(offsets.size() * sizeof(offsets[0])));
+        values += from[0];
+      }
+      Write(values, headers[c].valuesBytes);
+      Write(padding.data(), Padding(headers[c].valuesBytes));
+      if (headers[c].hasValidity) {
+        Write(column.getValidityBitmap(), (numRows + 7) / 8);
+        Write(padding.data(), Padding((numRows + 7) / 8));
+      }
+    }
+    _numRows += numRows;
+  }
+
+  /**
+   * @brief Finish writing, and read from the first chunk on.
+   **/
+  void Rewind() {
+    if (!_reading) Flush();
+    _reading = true;
+    _readOffset = 0;
+  }
+
+  /**
+   * @brief Read the next chunk into "columns", as read-only views that keep
+   *        the chunk's memory alive.
+   *
+   * @return false after the last chunk.
+   **/
+  bool Read(std::vector<GiftedColumnVector> *columns) {
+    if (!_reading) throw std::logic_error("GiftedSpillFile: reading before Rewind()");
+    columns->clear();
+    if (_readOffset >= _bytes) return false;
+    ChunkHeader chunk;
+    ReadAt(&chunk, sizeof(chunk));
+    if (chunk.magic != kMagic) throw std::runtime_error("GiftedSpillFile: corrupt chunk");
+    std::vector<ColumnHeader> headers(chunk.numColumns);
+    ReadAt(headers.data(), headers.size() * sizeof(ColumnHeader));
+    std::shared_ptr<GiftedAlignedBuffer> payload(new GiftedAlignedBuffer(chunk.payloadBytes + kAlignment));
+    ReadAt(payload->data(), chunk.payloadBytes);
+
+    const std::size_t numRows = chunk.numRows;
+    const char *at = payload->data();
+    for (std::size_t c = 0; c < headers.size(); c++) {
+      const GiftedColumnVector::OffsetType *offsets = nullptr;
+      if (headers[c].elementLength == 0) {
+        offsets = reinterpret_cast<const GiftedColumnVector::OffsetType*>(at);
+        at += Padded((numRows + 1) * sizeof(GiftedColumnVector::OffsetType));
+      }
+      const char *values = at;
+      at += Padded(headers[c].valuesBytes);
+      const std::uint8_t *validity = nullptr;
+      if (headers[c].hasValidity) {
+        validity = reinterpret_cast<const std::uint8_t*>(at);
+        at += Padded((numRows + 7) / 8);
+      }
+      columns->push_back(GiftedColumnVector::Wrap(static_cast<GiftedBaseType::GiftedTypeId>(headers[c].typeId),
+                                                  headers[c].elementLength, numRows, values, offsets, validity,
+                                                  payload));
+    }
+    return true;
+  }
+
+private:
+  static const std::uint32_t kMagic = 0x4c505347;  // "GSPL"
+  static const std::size_t kAlignment = 64;
+  static const std::size_t kWriteBufferBytes = 1 << 20;
+
+  struct ChunkHeader {
+    std::uint32_t magic;
+    std::uint32_t numColumns;
+    std::uint64_t numRows;
+    std::uint64_t payloadBytes;
+  };
+
+  struct ColumnHeader {
+    std::int32_t typeId;
+    std::uint32_t hasValidity;
+    std::uint64_t elementLength;
+    std::uint64_t valuesBytes;
+  };
+
+  static std::size_t Padded(const std::size_t bytes) {return (bytes + kAlignment - 1) / kAlignment * kAlignment;}
+  static std::size_t Padding(const std::size_t bytes) {return Padded(bytes) - bytes;}
+
+  static std::uint64_t PayloadBytes(const std::vector<ColumnHeader> &headers, const std::size_t numRows) {
+    std::uint64_t bytes = 0;
+    for (std::size_t c = 0; c < headers.size(); c++) {
+      if (headers[c].elementLength == 0) bytes += Padded((numRows + 1) * sizeof(GiftedColumnVector::OffsetType));
+      bytes += Padded(headers[c].valuesBytes);
+      if (headers[c].hasValidity) bytes += Padded((numRows + 7) / 8);
+    }
+    return bytes;
+  }
+
+  void Write(const void *data, const std::size_t bytes) {
+    const char *from = static_cast<const char*>(data);
+    _writeBuffer.insert(_writeBuffer.end(), from, from + bytes);
+    if (_writeBuffer.size() >= kWriteBufferBytes) Flush();
+  }
+
+  void Flush() {
+    for (std::size_t done = 0; done < _writeBuffer.size();) {
+      const ssize_t result = pwrite(_fd, _writeBuffer.data() + done, _writeBuffer.size() - done,
+                                    static_cast<off_t>(_bytes + done));
+      if (result < 0) {
+        if (errno == EINTR) continue;
+        throw std::runtime_error(std::string("GiftedSpillFile: write failed: ") + std::strerror(errno));
+      }
+      done += static_cast<std::size_t>(result);
+    }
+    _bytes += _writeBuffer.size();
+    _writeBuffer.clear();
+  }
+
+  void ReadAt(void *data, const std::size_t bytes) {
+    char *to = static_cast<char*>(data);
+    for (std::size_t done = 0; done < bytes;) {
+      const ssize_t result = pread(_fd, to + done, bytes - done, static_cast<off_t>(_readOffset + done));
+      if (result < 0) {
+        if (errno == EINTR) continue;
+        throw std::runtime_error(std::string("GiftedSpillFile: read failed: ") + std::strerror(errno));
+      }
+      if (result == 0) throw std::runtime_error("GiftedSpillFile: file is truncated");
+      done += static_cast<std::size_t>(result);
+    }
+    _readOffset += bytes;
+  }
+
+  int _fd;
+  std::size_t _numRows;
+  std::uint64_t _bytes;  // Written to the file so far.
+  std::vector<char> _writeBuffer;
+  std::uint64_t _readOffset;
+  bool _reading;
+
+  GiftedSpillFile(const GiftedSpillFile&) = delete;
+  GiftedSpillFile& operator=(const GiftedSpillFile&) = delete;
+};
+
+/**
+ * @brief Spill files for the partitions of an operator's state, each with
+ *        a buffer so that rows go to disk a chunk of "chunkRows" at a time.
+ **/
+class GiftedSpillPartitions {
+public:
+  GiftedSpillPartitions(const std::size_t numPartitions,
+                        const std::size_t chunkRows,
+                        const std::string &directory = GiftedSpillDirectory())
+      : _directory(directory),
+        _chunkRows(chunkRows > 0 ? chunkRows : 1),
+        _files(numPartitions),
+        _buffers(numPartitions) {}
+
+  /**
+   * @brief Append rows (equally long columns without selection) to
+   *        partition "partition". At least a chunk of rows goes straight to
+   *        the file.
+   **/
+  void Append(const std::size_t partition, const std::vector<const GiftedColumnVector*> &columns) {
+    if (columns.empty() || columns[0]->size() == 0) return;
+    if (columns[0]->size() >= _chunkRows) {
+      Flush(partition);
+      File(partition)->Append(columns);
+      return;
+    }
+    std::vector<GiftedColumnVector> &buffer = Buffer(partition, columns);
+    for (std::size_t c = 0; c < columns.size(); c++) buffer[c].AppendColumn(*columns[c]);
+    if (buffer[0].size() >= _chunkRows) Flush(partition);
+  }
+
+  /**
+   * @brief Append the rows at "positions" of equally long columns to
+   *        partition "partition".
+   **/
+  void AppendGathered(const std::size_t partition,
+                      const std::vector<const GiftedColumnVector*> &columns,
+                      const std::uint32_t *positions,
+                      const std::size_t count,
+                      const GiftedTypeRegistry &registry) {
+    if (columns.empty() || count == 0) return;
+    std::vector<GiftedColumnVector> &buffer = Buffer(partition, columns);
+    for (std::size_t c = 0; c < columns.size(); c++) {
+      buffer[c].AppendGathered(*columns[c], positions, count,
+                               registry.getEntry(columns[c]->getTypeId())->prototype.get());
+    }
+    if (buffer[0].size() >= _chunkRows) Flush(partition);
+  }
+
+  /**
+   * @brief Rows appended to partition "partition" so far.
+   **/
+  std::size_t getNumRows(const std::size_t partition) const {
+    return (_files[partition] ? _files[partition]->getNumRows() : 0) +
+           (_buffers[partition].empty() ? 0 : _buffers[partition][0].size());
+  }
+
+  /**
+   * @brief Write out the buffered rows and hand over the files, each
+   *        rewound, or null for partitions without rows.
+   **/
+  std::vector<std::shared_ptr<GiftedSpillFile> > Finish() {
+    for (std::size_t p = 0; p < _files.size(); p++) {
+      Flush(p);
+      std::vector<GiftedColumnVector>().swap(_buffers[p]);
+      if (_files[p]) _files[p]->Rewind();
+    }
+    std::vector<std::shared_ptr<GiftedSpillFile> > files(_files.size());
+    files.swap(_files);
+    return files;
+  }
+
+private:
+  std::vector<GiftedColumnVector>& Buffer(const std::size_t partition,
+                                          const std::vector<const GiftedColumnVector*> &columns) {
+    std::vector<GiftedColumnVector> &buffer = _buffers[partition];
+    if (buffer.empty()) {
+      for (std::size_t c = 0; c < columns.size(); c++) {
+        buffer.push_back(GiftedColumnVector(columns[c]->getTypeId(), columns[c]->getElementLength(), _chunkRows));
+      }
+    }
+    return buffer;
+  }
+
+  GiftedSpillFile* File(const std::size_t partition) {
+    if (!_files[partition]) _files[partition].reset(new GiftedSpillFile(_directory));
+    return _files[partition].get();
+  }
+
+  void Flush(const std::size_t partition) {
+    std::vector<GiftedColumnVector> &buffer = _buffers[partition];
+    if (buffer.empty() || buffer[0].size() == 0) return;
+    std::vector<const GiftedColumnVector*> columns;
+    for (std::size_t c = 0; c < buffer.size(); c++) columns.push_back(&buffer[c]);
+    File(partition)->Append(columns);
+    for (std::size_t c = 0; c < buffer.size(); c++) buffer[c].Clear();
+  }
+
+  const std::string _directory;
+  const std::size_t _chunkRows;
+  std::vector<std::shared_ptr<GiftedSpillFile> > _files;
+  std::vector<std::vector<GiftedColumnVector> > _buffers;
+};
+
+#endif  // GIFTED_STORAGE_SPILL_FILE_HPP_
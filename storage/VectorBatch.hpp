@@ -0,0 +1,177 @@
+//
+//  VectorBatch.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_STORAGE_VECTOR_BATCH_HPP_
+#define GIFTED_STORAGE_VECTOR_BATCH_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "storage/ColumnVector.hpp"
+#include "utility/CacheInfo.hpp"
+
+// Rows per batch when nothing better is known.
+static const std::size_t kGiftedDefaultBatchRows = 1024;
+
+/**
+ * @brief Pick a batch size (a power of two, multiple of 8) such that a batch
+ *        of rows of "bytesPerRow" bytes takes about half of the given cache,
+ *        leaving the rest for kernel outputs. With no cache size given, the
+ *        L2 size reported by the system is used.
+ **/
+inline std::size_t GiftedBatchRowsForCache(const std::size_t bytesPerRow,
+                                           std::size_t cacheBytes = 0) {
+  if (cacheBytes == 0) cacheBytes = GiftedL2CacheBytes();
+  std::size_t rows = 64;
+  while (rows < 65536 && 2 * rows * (bytesPerRow > 0 ? bytesPerRow : 1) <= cacheBytes / 2) {
+    rows *= 2;
+  }
+  return rows;
+}
+
+/**
+ * @brief A batch of rows travelling through a pipeline: one column vector
+ *        per attribute (each with its own validity), plus an optional
+ *        selection vector naming the rows that are still alive.
+ *
+ *        Filters only shrink the selection; they never move values. Columns
+ *        are usually views (over a table, a file mapping or a reader's
+ *        buffer) and stay valid until the producing operator is asked for
+ *        its next batch.
+ **/
+class GiftedVectorBatch {
+public:
+  explicit GiftedVectorBatch(const std::size_t capacity = kGiftedDefaultBatchRows)
+      : _capacity(capacity), _numRows(0), _firstRow(0), _hasSelection(false), _numSelected(0),
+        _selection(capacity * sizeof(std::uint32_t)) {}
+
+  GiftedVectorBatch(GiftedVectorBatch &&other) = default;
+  GiftedVectorBatch& operator=(GiftedVectorBatch &&other) = default;
+
+  /**
+   * @brief Most rows a batch carries.
+   **/
+  std::size_t getCapacity() const {return _capacity;}
+
+  /**
+   * @brief Rows in the columns, selected or not.
+   **/
+  std::size_t getNumRows() const {return _numRows;}
+
+  /**
+   * @brief Position in the scanned table of the batch's row 0, so that the
+   *        table's other columns can be fetched for the rows of a batch
+   *        later on (late materialization).
+   **/
+  std::size_t getFirstRow() const {return _firstRow;}
+  void SetFirstRow(const std::size_t firstRow) {_firstRow = firstRow;}
+
+  std::size_t getNumColumns() const {return _columns.size();}
+  const GiftedColumnVector& getColumn(const std::size_t i) const {return _columns[i];}
+  GiftedColumnVector& getColumnMutable(const std::size_t i) {return _columns[i];}
+
+  /**
+   * @brief Drop the columns and the selection, ready for the next batch.
+   **/
+  void Reset() {
+    _columns.clear();
+    _numRows = 0;
+    _firstRow = 0;
+    _hasSelection = false;
+    _numSelected = 0;
+  }
+
+  /**
+   * @brief Add a column; all columns of a batch have the same number of rows.
+   **/
+  void AddColumn(GiftedColumnVector &&column) {
+    if (_columns.empty()) {
+      _numRows = column.size();
+      if (_numRows > _capacity) {
+        throw std::invalid_argument("GiftedVectorBatch: column is larger than the batch");
+      }
+    } else if (column.size() != _numRows) {
+      throw std::invalid_argument("GiftedVectorBatch: columns differ in length");
+    }
+    _columns.push_back(std::move(column));
+  }
+
+  /**
+   * @brief Keep only the given columns, in the given order.
+   **/
+  void ProjectColumns(const std::vector<std::size_t> &keep) {
+    std::vector<GiftedColumnVector> kept;
+    kept.reserve(keep.size());
+    for (std::size_t i = 0; i < keep.size(); i++) {
+      kept.push_back(std::move(_columns.at(keep[i])));
+    }
+    _columns.swap(kept);
+  }
+
+  /**
+   * @brief True if only the rows in getSelection() are alive; otherwise
+   *        every row is.
+   **/
+  bool hasSelection() const {return _hasSelection;}
+
+  /**
+   * @brief Number of live rows.
+   **/
+  std::size_t getNumSelected() const {return _hasSelection ? _numSelected : _numRows;}
+
+  /**
+   * @brief Positions of the live rows, ascending. Only meaningful when
+   *        hasSelection().
+   **/
+  const std::uint32_t* getSelection() const {
+    return reinterpret_cast<const std::uint32_t*>(_selection.data());
+  }
+
+  /**
+   * @brief Room for a new selection of up to getNumRows() positions; fill it
+   *        and then call SetNumSelected(). It may alias getSelection(), so
+   *        narrowing a selection in place works.
+   **/
+  std::uint32_t* getSelectionMutable() {
+    return reinterpret_cast<std::uint32_t*>(_selection.data());
+  }
+
+  void SetNumSelected(const std::size_t numSelected) {
+    _hasSelection = true;
+    _numSelected = numSelected;
+  }
+
+  /**
+   * @brief Make every row live again, e.g. once the columns have been
+   *        compacted to the selected rows.
+   **/
+  void ClearSelection() {
+    _hasSelection = false;
+    _numSelected = 0;
+  }
+
+  /**
+   * @brief Replace all the columns, e.g. with compacted ones.
+   **/
+  void SetColumns(std::vector<GiftedColumnVector> *columns) {
+    _columns.swap(*columns);
+    _numRows = _columns.empty() ? 0 : _columns[0].size();
+  }
+
+private:
+  std::size_t _capacity;
+  std::size_t _numRows;
+  std::size_t _firstRow;
+  std::vector<GiftedColumnVector> _columns;
+  bool _hasSelection;
+  std::size_t _numSelected;
+  GiftedAlignedBuffer _selection;
+};
+
+#endif  // GIFTED_STORAGE_VECTOR_BATCH_HPP_
@@ -0,0 +1,79 @@
+//
+//  ZoneMap.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_STORAGE_ZONE_MAP_HPP_
+#define GIFTED_STORAGE_ZONE_MAP_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "storage/ColumnVector.hpp"
+#include "types/BaseType.hpp"
+
+/**
+ * @brief The minimum and maximum of a block of an int64, int32 or decimal
+ *        column (in the types' native order), and its null count, so that
+ *        scans can skip blocks a range predicate cannot match. Other types
+ *        get no range, and their blocks are never skipped.
+ **/
+struct GiftedZoneMap {
+  GiftedZoneMap() : hasRange(false), min(0), max(0), numNulls(0), numRows(0) {}
+
+  /**
+   * @brief The zone map of values [begin, begin + count) of "column".
+   **/
+  static GiftedZoneMap Build(const GiftedColumnVector &column, const std::size_t begin, const std::size_t count) {
+    GiftedZoneMap zone;
+    zone.numRows = count;
+    const GiftedBaseType::GiftedTypeId typeId = column.getTypeId();
+    const bool isInt32 = typeId == GiftedBaseType::_GiftedInt32TypeId;
+    const bool hasNulls = column.getValidityBitmap() != nullptr;
+    if (!isInt32 && typeId != GiftedBaseType::_GiftedIntTypeId && typeId != GiftedBaseType::_GiftedDecimalTypeId) {
+      for (std::size_t i = begin; hasNulls && i < begin + count; i++) zone.numNulls += column.isNull(i);
+      return zone;
+    }
+    for (std::size_t i = begin; i < begin + count; i++) {
+      if (hasNulls && column.isNull(i)) {
+        zone.numNulls++;
+        continue;
+      }
+      const std::int64_t value = IntegralValue(column, i, isInt32);
+      if (!zone.hasRange || value < zone.min) zone.min = value;
+      if (!zone.hasRange || value > zone.max) zone.max = value;
+      zone.hasRange = true;
+    }
+    return zone;
+  }
+
+  /**
+   * @brief False if no value of the block is in [low, high].
+   **/
+  bool MayContain(const std::int64_t low, const std::int64_t high) const {
+    // All null: no value can match.
+    if (numNulls == numRows) return false;
+    return !hasRange || (max >= low && min <= high);
+  }
+
+  static std::int64_t IntegralValue(const GiftedColumnVector &column, const std::size_t i, const bool isInt32) {
+    if (isInt32) {
+      std::int32_t value;
+      std::memcpy(&value, column.getValues() + i * sizeof(value), sizeof(value));
+      return value;
+    }
+    std::int64_t value;
+    std::memcpy(&value, column.getValues() + i * sizeof(value), sizeof(value));
+    return value;
+  }
+
+  bool hasRange;  // Whether min and max are known.
+  std::int64_t min;
+  std::int64_t max;
+  std::size_t numNulls;
+  std::size_t numRows;
+};
+
+#endif  // GIFTED_STORAGE_ZONE_MAP_HPP_
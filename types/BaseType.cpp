@@ -5,216 +5,74 @@
 //  Copyright © 2016 Gift-ed Research Group. All rights reserved.
 //
 
-#include <iostream>
-
-/**
- * @brief Gift-ed base types. All types are derived from this base class.
-**/
-class GiftedBaseType {
-
-public:
-
-  /**
-   * @brief List of all the types in the Quickstep system. Each type has a
-   *        unique id.
-   **/
-  enum GiftedTypeId {
-    _GiftedUnknownTypeId = -1,
-    _GiftedIntTypeId
-  };
-
-  GiftedBaseType() {}; // Constructor.
-  virtual ~GiftedBaseType() {}; // Pure virtual destructor.
-
-  /**
-   * @brief Clone the type (aka. a factory). Note this method create an empty
-   *        new instance of the specific (C++ subclass) type.
-   *
-   *        WARNING: Use with care! The caller is responsible for cleaning
-   *                 up the object that is allocated.
-   **/
-  virtual GiftedBaseType* Clone () const = 0;
-
-  /**
-   * @brief Interface to describe the type of the specific C++ class instance.
-   *
-   * @return Return the type. If not defined, then return an unknown type.
-   **/
-  virtual GiftedTypeId myType() const {return GiftedTypeId::_GiftedUnknownTypeId;}
-
-  /**
-   * @brief Interface to determine if the type's storage representation is 
-   *        fixed length or variable length. If the type is fixed length a
-   *        length. If it is length of the type for fixed length.
-   *
-   * @return Return a length greater than 0 if the type is fixed length, else 
-   *         for variable length return 0.
-   **/
-  virtual std::size_t getLength() = 0;
-
-  /**
-   * @brief Turn a disk representation to an in-memory represenation.
-   *
-   * @return none TODO: Worry about error handling.
-   *              TODO: Instead of pointing a char* and a size, we should have a
-   *                    protected structure to pass around (that can also deal
-   *                    array bounds).
-   **/
-  virtual void UnMarshall(const char* const payload, const std::size_t length) = 0;
-
-  // TODO: need the assocaited similar marshall call
-
-  // Comparison Operators ...
-  // Must define these. TODO: Worry about three-valued logic.
-  virtual void Equal(const GiftedBaseType* const right, bool &result) const = 0;
-  virtual void LessThan(const GiftedBaseType* const right, bool &result) const = 0;
-
-  // Can override if needed.
-  virtual void NotEqual(const GiftedBaseType* const right, bool &result) const {
-    Equal(right, result);
-    result =! result;  // flip the result from IsEqual
-  }
-  virtual void LessThanOrEqual(const GiftedBaseType* const right, bool &result) const {
-    LessThan(right, result);
-    if (!result) return Equal(right, result);
-  }
-  virtual void GreaterThan(const GiftedBaseType* const right, bool &result) const {
-    LessThanOrEqual(right, result); // Can make this all more efficient by using base operators.
-    result =! result;  // flip the result
-  }
-  virtual void GreaterThanOrEqual(const GiftedBaseType* const right, bool &result) const {
-    LessThan(right, result);
-    result =! result;  // flip the result
-  }
-
-  // Now the arithmetic operators add, subtract, divide, multiply, modulo, ....
-  /**
-    * @brief Add the argument to the current value pointed to by "this".
-    *        Note that this modifies the class instance that is called.
-    *
-    * @return None
-   **/
-  virtual void AddToLeft(const GiftedBaseType* const right) = 0;
-  // TODO: Add other operations like this for each operator.
-
-  // TODO: Add batch/bulk version of all of the comparison and arithmetic ops.
-  //       Only for fixed length types, otherwise return an error. Here is
-  //       what one would look like.
-  virtual void VectorizedEqual(const std::size_t elementLength,      // Size of each element.
-                               const char* const vectorDataElements, // Raw vector data.
-                               const std::size_t vectorLength,       // Size of the vector.
-                               const char* const rawLiteralData,     // Literal in the raw data form.
-                               bool *result) // somewhat crude would need a TupleIdSequence...
-  {
-    std::size_t i;
-    GiftedBaseType *_callerTypeInstance = Clone(); // Clone an instance of the caller type.
-    GiftedBaseType *_literalInstance = Clone();    // Clone an instance of the literal type.
-
-    // Initialize the literal.
-    _literalInstance->UnMarshall(rawLiteralData, elementLength);
-
-    for (i=0; i<vectorLength; i++) {
-      _callerTypeInstance->UnMarshall(vectorDataElements+(i*elementLength), elementLength);
-      _callerTypeInstance->Equal(_literalInstance, result[i]);
-    }
-
-    // TODO: Better to use auto pointer of some sort.
-    delete _callerTypeInstance;
-    delete _literalInstance;
-  };
-
-  // TODO: Define a VectorizedEqual in which the raw vector data is spread apart
-  //       by a stride between two vectors (for evaluating predicates on fixed
-  //       length attributes in a split row store.
-
-  // TODO: Define a fast projection from a columnar vector to another columnar
-  //       vector. This function would take as input a bitVector that indicates
-  //       which columns to project out.
-  //       Also create a "strided" version of this for packed row store.
-
-  // Printing Functions
-  friend std::ostream& operator<<(std::ostream& out, const GiftedBaseType& instance);
-  virtual void Print(std::ostream& os) const = 0;
-};
-
-/**
- * @brief A generic output operator that works with any Quickstep type. It 
- *        simply calls the virtual Print function.
- **/
-
-std::ostream& operator<<(std::ostream& out, const GiftedBaseType& instance)
-{
-  instance.Print(out);
-  return out;
-}
-
-
-/**
- * @brief The IntegerType.
- **/
-class GiftedIntegerType : public GiftedBaseType {
-public:
-
-  // Cover the basics ... constructor, desctuctor, and clone function.
-  GiftedIntegerType():_value(0) {};
-  ~GiftedIntegerType() {};
-  virtual GiftedBaseType* Clone () const override {return new GiftedIntegerType;};
-
-  GiftedTypeId myType() const override {return _GiftedIntTypeId;}
-
-  std::size_t getLength() override {
-    return sizeof(std::uint64_t);
-  }
-
-  void UnMarshall(const char* const payload, const std::size_t length) override {
-    _value = *reinterpret_cast<const std::uint64_t*>(payload);
-    return;
-  }
-
-  // Define the bare minimum functions.
-  // TODO: This is not very efficient and the type compatibility checks should
-  //       happen outside.
-  virtual void Equal(const GiftedBaseType* const right, bool &result) const override {
-    if (right->myType() == _GiftedIntTypeId)
-      result = (_value == dynamic_cast<const GiftedIntegerType*>(right)->_value);
-    else
-      return; // TODO: Throw an error
-  }
-
-  void LessThan(const GiftedBaseType* const right, bool &result) const override {
-    if (right->myType() == _GiftedIntTypeId) {
-      result = (_value < dynamic_cast<const GiftedIntegerType*>(right)->_value);
-    } else {
-      return; // TODO: Throw an error
-    }
-  }
-
-  void AddToLeft(const GiftedBaseType* const right) override {
-    if (right->myType() == _GiftedIntTypeId) {
-      _value += dynamic_cast<const GiftedIntegerType*>(right)->_value;
-    } else {
-      return; // TODO: Throw an error
-    }
-  }
-
-  virtual void Print(std::ostream& os) const override {
-    os << _value;
-  }
-
-  // Can also have special function only for this type ...
-  void Increment() {_value++;}
-
-    // Now here we can have a specialized highly-tuned version of VectorizedEqual
-
-protected:
-  std::uint64_t _value; // Value for the integer type
-};
+#include <unistd.h>
 
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "operators/AggregateOperator.hpp"
+#include "operators/BitmapIndexPredicate.hpp"
+#include "operators/BloomFilterPredicate.hpp"
+#include "operators/BufferPoolScanOperator.hpp"
+#include "operators/DeltaMainScanOperator.hpp"
+#include "operators/FilterOperator.hpp"
+#include "operators/HashAggregateOperator.hpp"
+#include "operators/HashJoinOperator.hpp"
+#include "operators/MergeJoinOperator.hpp"
+#include "operators/Operator.hpp"
+#include "operators/PaxScanOperator.hpp"
+#include "operators/ProjectOperator.hpp"
+#include "operators/SamplingScanOperator.hpp"
+#include "operators/ScanOperator.hpp"
+#include "operators/SpillingHashJoinOperator.hpp"
+#include "operators/WindowOperator.hpp"
+#include "storage/ArrowInterop.hpp"
+#include "storage/BitmapIndex.hpp"
+#include "storage/BloomFilter.hpp"
+#include "storage/BufferPool.hpp"
+#include "storage/ColumnVector.hpp"
+#include "storage/CsvExporter.hpp"
+#include "storage/CsvLoader.hpp"
+#include "storage/HashIndex.hpp"
+#include "storage/PaxBlock.hpp"
+#include "storage/PredicateResultCache.hpp"
+#include "storage/PrefetchingColumnReader.hpp"
+#include "storage/RowBlock.hpp"
+#include "storage/SortedIndex.hpp"
+#include "storage/VectorBatch.hpp"
+#include "types/BaseType.hpp"
+#include "types/BuiltinTypes.hpp"
+#include "types/DecimalType.hpp"
+#include "types/Expression.hpp"
+#include "types/ExpressionJit.hpp"
+#include "types/ExpressionPredicate.hpp"
+#include "types/FusedPredicate.hpp"
+#include "types/IntegerType.hpp"
+#include "types/TypeRegistry.hpp"
+#include "types/VectorizedComparison.hpp"
+#include "utility/AlignedBuffer.hpp"
+#include "utility/PerfCounter.hpp"
 
 int main(int argc, const char * argv[]) {
 
+  // Register the built-in types and any plugins named in GIFTED_PLUGINS.
+  GiftedTypeRegistry &registry = GiftedTypeRegistry::Instance();
+  GiftedRegisterBuiltinTypes(&registry);
+  registry.LoadPlugins(std::getenv("GIFTED_PLUGINS"));
+  registry.Freeze();
+  std::cout << "Registered " << registry.getNumTypes() << " types" << std::endl;
+
   // Create a pointer to a Quickstep integer type
-  std::unique_ptr<GiftedBaseType> anAttr (new GiftedIntegerType);
+  std::unique_ptr<GiftedBaseType> anAttr (registry.CreateInstance(registry.getTypeId("int64")));
 
   // Load data from "storage", here just a variable in memory.
   std::int64_t _onDisk = 13;
@@ -255,10 +113,12 @@ int main(int argc, const char * argv[]) {
   // Print out the variable.
   std::cout << "Sum of the two variables is: " << *anAttr << std::endl;
 
-  static const std::size_t _vectorCardinality = 1024;
-  std::int64_t _onDiskA[_vectorCardinality];
-  std::int64_t _onDiskB[_vectorCardinality];
-  bool _resultArray[_vectorCardinality];
+  const std::size_t _vectorCardinality = kGiftedDefaultBatchRows;
+  GiftedColumnVector _columnA(GiftedBaseType::_GiftedIntTypeId, sizeof(std::int64_t), _vectorCardinality);
+  GiftedColumnVector _columnB(GiftedBaseType::_GiftedIntTypeId, sizeof(std::int64_t), _vectorCardinality);
+  std::int64_t *_onDiskA = reinterpret_cast<std::int64_t*>(_columnA.AppendFixedSlots(_vectorCardinality));
+  std::int64_t *_onDiskB = reinterpret_cast<std::int64_t*>(_columnB.AppendFixedSlots(_vectorCardinality));
+  std::unique_ptr<bool[]> _resultArray(new bool[_vectorCardinality]);
   std::size_t i;
 
   // create the disk representations
@@ -273,13 +133,567 @@ int main(int argc, const char * argv[]) {
                               reinterpret_cast<char*>(_onDiskA),
                               _vectorCardinality,
                               _storagePtr,
-                              _resultArray);
+                              _resultArray.get());
 
   for (i = 0; i< _vectorCardinality; i++) {
     std::cout << _resultArray[i];
   }
   std::cout << std::endl;
 
+  // The same data through a pipeline: scan (A) -> filter (A < 512) ->
+  // project (B, fetched for the surviving rows only) -> aggregate, one cache
+  // sized batch at a time.
+  std::vector<const GiftedColumnVector*> _tableColumns(1, &_columnA);
+  std::vector<const GiftedColumnVector*> _lateColumns(1, &_columnB);
+  const std::size_t _batchRows = GiftedBatchRowsForCache(2 * sizeof(std::int64_t));
+  const std::int64_t _bound = 512;
+  std::unique_ptr<GiftedOperator> _scan(new GiftedScanOperator(_tableColumns, _batchRows));
+  std::unique_ptr<GiftedOperator> _filter(new GiftedFilterOperator(
+      std::move(_scan), 0,
+      std::unique_ptr<GiftedVectorizedComparison>(new GiftedVectorizedComparison(
+          registry, GiftedVectorizedComparison::kLessThan,
+          GiftedBaseType::_GiftedIntTypeId, GiftedBaseType::_GiftedIntTypeId,
+          reinterpret_cast<const char*>(&_bound), sizeof(_bound)))));
+  std::unique_ptr<GiftedOperator> _project(new GiftedProjectOperator(
+      std::move(_filter), registry, std::vector<std::size_t>(), _lateColumns));
+  std::vector<GiftedAggregateOperator::Aggregate> _aggregates;
+  _aggregates.push_back(GiftedAggregateOperator::Aggregate(GiftedAggregateOperator::kCount, 0));
+  _aggregates.push_back(GiftedAggregateOperator::Aggregate(GiftedAggregateOperator::kSum, 0));
+  _aggregates.push_back(GiftedAggregateOperator::Aggregate(GiftedAggregateOperator::kMax, 0));
+  GiftedAggregateOperator _aggregate(std::move(_project), _aggregates);
+  GiftedVectorBatch _batch(_batchRows);
+  if (_aggregate.Next(&_batch)) {
+    std::cout << "count, sum, max of B where A < 512:";
+    for (i = 0; i < _batch.getNumColumns(); i++) {
+      std::size_t _length;
+      const char *_raw = _batch.getColumn(i).getElement(0, &_length);
+      std::unique_ptr<GiftedBaseType> _value(registry.CreateInstance(_batch.getColumn(i).getTypeId()));
+      _value->UnMarshall(_raw, _length);
+      std::cout << " " << *_value;
+    }
+    std::cout << std::endl;
+  }
+
+  // A range predicate on A, both bounds tested in one fused kernel.
+  const std::int64_t _low = 100;
+  const std::int64_t _high = 200;
+  GiftedFilterOperator _rangeFilter(
+      std::unique_ptr<GiftedOperator>(new GiftedScanOperator(_tableColumns, _batchRows)),
+      std::unique_ptr<GiftedFusedPredicate>(new GiftedFusedPredicate(
+          0, GiftedBaseType::_GiftedIntTypeId, GiftedFusedPredicate::kGreaterThanOrEqual,
+          reinterpret_cast<const char*>(&_low), GiftedFusedPredicate::kAnd,
+          0, GiftedBaseType::_GiftedIntTypeId, GiftedFusedPredicate::kLessThan,
+          reinterpret_cast<const char*>(&_high))));
+  std::size_t _inRange = 0;
+  while (_rangeFilter.Next(&_batch)) {
+    _inRange += _batch.getNumSelected();
+  }
+  std::cout << "100 <= A < 200 : " << _inRange << " rows" << std::endl;
+
+  // The same filter on A twice; A does not change, so the second run
+  // takes the outcomes from the cache.
+  std::shared_ptr<GiftedPredicateResultCache> _resultCache(new GiftedPredicateResultCache(1 << 20));
+  for (int _run = 0; _run < 2; _run++) {
+    GiftedFilterOperator _cachedFilter(
+        std::unique_ptr<GiftedOperator>(new GiftedScanOperator(_tableColumns, _batchRows)), 0,
+        std::unique_ptr<GiftedColumnPredicate>(new GiftedVectorizedComparison(
+            registry, GiftedVectorizedComparison::kEqual,
+            GiftedBaseType::_GiftedIntTypeId, GiftedBaseType::_GiftedIntTypeId,
+            _storagePtr, sizeof(std::int64_t))));
+    _cachedFilter.SetResultCache(_resultCache, 1);
+    while (_cachedFilter.Next(&_batch)) {}
+  }
+  const GiftedPredicateResultCache::Stats _cacheStats = _resultCache->getStats();
+  std::cout << "A = 26 twice: " << _cacheStats.hits << " cache hits, " << _cacheStats.misses << " misses"
+            << std::endl;
+
+  // An ad hoc expression over A and B, compiled to native code if a JIT
+  // compiler is configured (GIFTED_JIT_CXX), interpreted otherwise.
+  std::unique_ptr<GiftedExpression> _expression = GiftedExpression::Binary(
+      GiftedExpression::kLessThan,
+      GiftedExpression::Binary(GiftedExpression::kAdd,
+                               GiftedExpression::Column(0, GiftedBaseType::_GiftedIntTypeId),
+                               GiftedExpression::Column(1, GiftedBaseType::_GiftedIntTypeId)),
+      GiftedExpression::Literal(GiftedBaseType::_GiftedIntTypeId, 600));
+  std::unique_ptr<GiftedExpressionJit> _jit;
+  if (std::getenv("GIFTED_JIT_CXX") != nullptr) _jit.reset(new GiftedExpressionJit);
+  std::unique_ptr<GiftedExpressionPredicate> _expressionPredicate(
+      new GiftedExpressionPredicate(std::move(_expression), _jit.get()));
+  const bool _compiled = _expressionPredicate->isCompiled();
+  std::vector<const GiftedColumnVector*> _bothColumns(_tableColumns);
+  _bothColumns.push_back(&_columnB);
+  GiftedFilterOperator _expressionFilter(
+      std::unique_ptr<GiftedOperator>(new GiftedScanOperator(_bothColumns, _batchRows)),
+      std::move(_expressionPredicate));
+  std::size_t _passed = 0;
+  while (_expressionFilter.Next(&_batch)) {
+    _passed += _batch.getNumSelected();
+  }
+  std::cout << "A + B < 600 (" << (_compiled ? "compiled" : "interpreted") << ") : " << _passed << " rows"
+            << std::endl;
+
+  // Compare an int32 column against a decimal literal; the column is cast
+  // to decimal once per batch.
+  GiftedColumnVector _int32Column(GiftedBaseType::_GiftedInt32TypeId, sizeof(std::int32_t));
+  for (i = 0; i < 8; i++) {
+    const std::int32_t _value = static_cast<std::int32_t>(i);
+    _int32Column.AppendFixed(reinterpret_cast<const char*>(&_value));
+  }
+  const std::int64_t _decimalLiteral = 3 * GiftedDecimalType::kScale; // 3.0000
+  GiftedVectorizedComparison _lessThanThree(registry,
+                                            GiftedVectorizedComparison::kLessThan,
+                                            GiftedBaseType::_GiftedInt32TypeId,
+                                            GiftedBaseType::_GiftedDecimalTypeId,
+                                            reinterpret_cast<const char*>(&_decimalLiteral),
+                                            sizeof(_decimalLiteral));
+  _lessThanThree.Evaluate(_int32Column, _resultArray.get());
+  std::cout << "int32 < 3.0000 : ";
+  for (i = 0; i < _int32Column.size(); i++) {
+    std::cout << _resultArray[i];
+  }
+  std::cout << std::endl;
+
+  // The same against an int64 column, whose extremes do not fit a decimal
+  // and are settled by their sign.
+  GiftedColumnVector _int64Column(GiftedBaseType::_GiftedIntTypeId, sizeof(std::int64_t));
+  const std::int64_t _int64Values[] = {std::numeric_limits<std::int64_t>::min(), -1, 2, 3,
+                                       std::numeric_limits<std::int64_t>::max()};
+  for (i = 0; i < sizeof(_int64Values) / sizeof(_int64Values[0]); i++) {
+    _int64Column.AppendFixed(reinterpret_cast<const char*>(&_int64Values[i]));
+  }
+  GiftedVectorizedComparison _int64LessThanThree(registry,
+                                                 GiftedVectorizedComparison::kLessThan,
+                                                 GiftedBaseType::_GiftedIntTypeId,
+                                                 GiftedBaseType::_GiftedDecimalTypeId,
+                                                 reinterpret_cast<const char*>(&_decimalLiteral),
+                                                 sizeof(_decimalLiteral));
+  _int64LessThanThree.Evaluate(_int64Column, _resultArray.get());
+  std::cout << "int64 < 3.0000 : ";
+  for (i = 0; i < _int64Column.size(); i++) {
+    std::cout << _resultArray[i];
+  }
+  std::cout << std::endl;
+
+  // Bulk load a small CSV straight into column vectors; empty fields are
+  // NULL, "" is an empty string.
+  static const char _csvText[] = "1,2.5,\n2,,\"be,ta\"\n3,10,\"\"\n";
+  std::vector<GiftedBaseType::GiftedTypeId> _csvSchema;
+  _csvSchema.push_back(GiftedBaseType::_GiftedIntTypeId);
+  _csvSchema.push_back(GiftedBaseType::_GiftedDecimalTypeId);
+  _csvSchema.push_back(GiftedBaseType::_GiftedVarCharTypeId);
+  GiftedCsvLoader _loader(registry, _csvSchema);
+  std::vector<GiftedColumnVector> _csvColumns = _loader.LoadBuffer(_csvText, sizeof(_csvText) - 1);
+  std::cout << "Loaded " << _csvColumns[0].size() << " rows from CSV" << std::endl;
+
+  // And write them back out as TSV.
+  std::vector<const GiftedColumnVector*> _exportColumns;
+  for (i = 0; i < _csvColumns.size(); i++) {
+    _exportColumns.push_back(&_csvColumns[i]);
+  }
+  {
+    GiftedCsvExporter _exporter(registry, STDOUT_FILENO, '\t');
+    _exporter.WriteColumns(_exportColumns);
+  }
+
+  // Through a CSV file and back, NULLs and empty strings included.
+  char _csvPath[] = "/tmp/giftedCsvXXXXXX";
+  const int _csvFd = mkstemp(_csvPath);
+  if (_csvFd >= 0) {
+    {
+      GiftedCsvExporter _exporter(registry, _csvFd);
+      _exporter.WriteColumns(_exportColumns);
+    }
+    close(_csvFd);
+    const std::vector<GiftedColumnVector> _reloaded = _loader.LoadFile(_csvPath);
+    std::size_t _sameRows = 0;
+    for (std::size_t _row = 0; _row < _csvColumns[0].size(); _row++) {
+      bool _same = true;
+      for (std::size_t _column = 0; _column < _csvColumns.size(); _column++) {
+        std::size_t _length;
+        std::size_t _reloadedLength;
+        const char *_value = _csvColumns[_column].getElement(_row, &_length);
+        const char *_reloadedValue = _reloaded[_column].getElement(_row, &_reloadedLength);
+        _same = _same && _csvColumns[_column].isNull(_row) == _reloaded[_column].isNull(_row) &&
+                _length == _reloadedLength && std::memcmp(_value, _reloadedValue, _length) == 0;
+      }
+      _sameRows += _same;
+    }
+    std::cout << "CSV round trip: " << _sameRows << " of " << _csvColumns[0].size() << " rows the same"
+              << std::endl;
+    unlink(_csvPath);
+  }
+
+  // Hand the int64 column to Arrow and take it back, both without a copy.
+  ArrowSchema _arrowSchema;
+  ArrowArray _arrowArray;
+  GiftedExportArrowArray(std::move(_csvColumns[0]), &_arrowSchema, &_arrowArray);
+  GiftedColumnVector _imported = GiftedImportArrowArray(registry, _arrowSchema, &_arrowArray);
+  _arrowSchema.release(&_arrowSchema);
+  std::cout << "Round trip through Arrow: " << _imported.size() << " rows" << std::endl;
+
+  // Join A with the loaded keys; the join's Bloom filter drops most rows of
+  // A in the scan, before they reach the join.
+  std::shared_ptr<GiftedBlockedBloomFilter> _bloomFilter(new GiftedBlockedBloomFilter);
+  std::unique_ptr<GiftedOperator> _buildSide(
+      new GiftedScanOperator(std::vector<const GiftedColumnVector*>(1, &_imported), _batchRows));
+  std::unique_ptr<GiftedOperator> _probeSide(new GiftedFilterOperator(
+      std::unique_ptr<GiftedOperator>(new GiftedScanOperator(_tableColumns, _batchRows)), 0,
+      std::unique_ptr<GiftedColumnPredicate>(new GiftedBloomFilterPredicate(registry, _bloomFilter))));
+  GiftedHashJoinOperator _join(registry, std::move(_buildSide), 0, std::move(_probeSide), 0, _bloomFilter);
+  std::size_t _joined = 0;
+  while (_join.Next(&_batch)) {
+    _joined += _batch.getNumRows();
+  }
+  std::cout << "Joined " << _joined << " rows of A with " << _join.getBuildRows() << " keys" << std::endl;
+
+  // The same join of A with itself, radix partitioned as if A were too
+  // large for the cache.
+  GiftedHashJoinOperator _selfJoin(
+      registry,
+      std::unique_ptr<GiftedOperator>(new GiftedScanOperator(_tableColumns, _batchRows)), 0,
+      std::unique_ptr<GiftedOperator>(new GiftedScanOperator(_tableColumns, _batchRows)), 0,
+      std::shared_ptr<GiftedBlockedBloomFilter>(), GiftedHashJoinOperator::kRadixPartitioning);
+  _joined = 0;
+  while (_selfJoin.Next(&_batch)) {
+    _joined += _batch.getNumRows();
+  }
+  std::cout << "Self join of A on " << _selfJoin.getRadixBits() << " radix bits: " << _joined << " rows"
+            << std::endl;
+
+  // A is sorted, so the self join can merge instead of hashing.
+  GiftedMergeJoinOperator _mergeJoin(
+      registry,
+      std::unique_ptr<GiftedOperator>(new GiftedScanOperator(_tableColumns, _batchRows)),
+      std::vector<std::size_t>(1, 0),
+      std::unique_ptr<GiftedOperator>(new GiftedScanOperator(_tableColumns, _batchRows)),
+      std::vector<std::size_t>(1, 0));
+  _joined = 0;
+  while (_mergeJoin.Next(&_batch)) {
+    _joined += _batch.getNumRows();
+  }
+  std::cout << "Merge self join of A: " << _joined << " rows" << std::endl;
+
+  // Point and range lookups on A through its indexes instead of a scan.
+  GiftedHashIndex _hashIndex(registry, _columnA);
+  GiftedSortedIndex _sortedIndex(registry, _columnA);
+  const std::int64_t _lookupLow = 100, _lookupHigh = 199;
+  std::vector<std::uint32_t> _hashRows, _sortedRows, _rangeRows;
+  _hashIndex.Lookup(reinterpret_cast<const char*>(&_lookupLow), sizeof(_lookupLow), &_hashRows);
+  _sortedIndex.Lookup(reinterpret_cast<const char*>(&_lookupLow), &_sortedRows);
+  _sortedIndex.LookupRange(reinterpret_cast<const char*>(&_lookupLow), reinterpret_cast<const char*>(&_lookupHigh), &_rangeRows);
+  std::cout << "A = 100 by hash and sorted index: " << _hashRows.size() << " " << _sortedRows.size()
+            << ", 100 <= A <= 199: " << _rangeRows.size() << " rows" << std::endl;
+
+  // A % 8 as a low cardinality column; IN (1, 6) answered by its bitmap index.
+  GiftedColumnVector _category(GiftedBaseType::_GiftedIntTypeId, sizeof(std::int64_t), _vectorCardinality);
+  for (std::size_t _row = 0; _row < _columnA.size(); _row++) {
+    const std::int64_t _value = _onDiskA[_row] % 8;
+    _category.AppendFixed(reinterpret_cast<const char*>(&_value));
+  }
+  GiftedBitmapIndex _categoryIndex(_category);
+  const std::int64_t _one = 1, _six = 6;
+  std::vector<std::string> _inList;
+  _inList.push_back(std::string(reinterpret_cast<const char*>(&_one), sizeof(_one)));
+  _inList.push_back(std::string(reinterpret_cast<const char*>(&_six), sizeof(_six)));
+  GiftedFilterOperator _indexFilter(
+      std::unique_ptr<GiftedOperator>(new GiftedScanOperator(std::vector<const GiftedColumnVector*>(1, &_category),
+                                                             _batchRows)),
+      std::unique_ptr<GiftedBatchPredicate>(new GiftedBitmapIndexPredicate(_categoryIndex.In(_inList))));
+  std::size_t _inRows = 0;
+  while (_indexFilter.Next(&_batch)) {
+    _inRows += _batch.getNumSelected();
+  }
+  std::cout << "A % 8 IN (1, 6) by bitmap index: " << _inRows << " rows" << std::endl;
+
+  // Sketches: the distinct values of A % 8 and A's median, approximately.
+  std::vector<const GiftedColumnVector*> _sketchColumns(1, &_columnA);
+  _sketchColumns.push_back(&_category);
+  std::vector<GiftedAggregateOperator::Aggregate> _sketches;
+  _sketches.push_back(GiftedAggregateOperator::Aggregate(GiftedAggregateOperator::kApproxCountDistinct, 1));
+  _sketches.push_back(GiftedAggregateOperator::Aggregate(GiftedAggregateOperator::kApproxQuantile, 0, 0.5));
+  GiftedAggregateOperator _sketchAggregate(
+      registry, std::unique_ptr<GiftedOperator>(new GiftedScanOperator(_sketchColumns, _batchRows)), _sketches);
+  if (_sketchAggregate.Next(&_batch)) {
+    std::cout << "approx. distinct A % 8, median A: "
+              << *reinterpret_cast<const std::int64_t*>(_batch.getColumn(0).getValues()) << " "
+              << *reinterpret_cast<const std::int64_t*>(_batch.getColumn(1).getValues()) << std::endl;
+  }
+
+  // COUNT(*) of A estimated from a 10% row sample.
+  GiftedSamplingScanOperator _sample(_tableColumns, 1.0, 0.1, false, 0x5eed, _batchRows);
+  std::size_t _sampled = 0;
+  while (_sample.Next(&_batch)) {
+    _sampled += _batch.getNumSelected();
+  }
+  std::cout << "rows of A estimated from a 10% sample: " << _sampled * _sample.getScaleFactor() << std::endl;
+
+  // Running SUM(A) and the AVG of A over the row and its two neighbours.
+  std::vector<GiftedWindowOperator::Window> _windows;
+  _windows.push_back(GiftedWindowOperator::Window(GiftedWindowOperator::kSum, 0));
+  _windows.push_back(GiftedWindowOperator::Window(GiftedWindowOperator::kAverage, 0, 1, 1));
+  GiftedWindowOperator _window(registry,
+                               std::unique_ptr<GiftedOperator>(new GiftedScanOperator(_tableColumns, _batchRows)),
+                               std::vector<std::size_t>(), _windows);
+  std::int64_t _runningSum = 0;
+  std::unique_ptr<GiftedBaseType> _movingAverage(registry.CreateInstance(GiftedBaseType::_GiftedDecimalTypeId));
+  while (_window.Next(&_batch)) {
+    const std::size_t _last = _batch.getNumRows() - 1;
+    std::size_t _length;
+    _runningSum = *reinterpret_cast<const std::int64_t*>(_batch.getColumn(1).getElement(_last, &_length));
+    const char *_average = _batch.getColumn(2).getElement(_last, &_length);
+    _movingAverage->UnMarshall(_average, _length);
+  }
+  std::cout << "running SUM(A), moving AVG(A) at the last row: " << _runningSum << " " << *_movingAverage
+            << std::endl;
+
+  // A and B as packed rows, and back to columns.
+  std::vector<GiftedBaseType::GiftedTypeId> _rowTypes(1, GiftedBaseType::_GiftedIntTypeId);
+  _rowTypes.push_back(GiftedBaseType::_GiftedIntTypeId);
+  GiftedRowBlock _rowBlock(registry, _rowTypes);
+  _rowBlock.AppendColumns(_bothColumns);
+  std::vector<GiftedColumnVector> _transposed;
+  _rowBlock.ToColumns(0, _rowBlock.size(), &_transposed);
+  const bool _sameB = std::memcmp(_transposed[1].getValues(), _columnB.getValues(),
+                                  _columnB.size() * sizeof(std::int64_t)) == 0;
+  std::cout << _rowBlock.size() << " rows of " << _rowBlock.getRowWidth() << " bytes, B round trips: "
+            << (_sameB ? "yes" : "no") << std::endl;
+
+  // A and B in PAX blocks: SUM(B) reads only B's minipages, a row's A and B
+  // are in the same block.
+  std::vector<GiftedPaxBlock> _paxBlocks;
+  for (std::size_t _row = 0; _row < _columnA.size();) {
+    _paxBlocks.push_back(GiftedPaxBlock(registry, _rowTypes, 256));
+    _row += _paxBlocks.back().AppendColumns(_bothColumns, _row);
+  }
+  std::vector<const GiftedPaxBlock*> _paxBlockPointers;
+  for (i = 0; i < _paxBlocks.size(); i++) _paxBlockPointers.push_back(&_paxBlocks[i]);
+  std::vector<GiftedAggregateOperator::Aggregate> _paxAggregates;
+  _paxAggregates.push_back(GiftedAggregateOperator::Aggregate(GiftedAggregateOperator::kSum, 0));
+  GiftedAggregateOperator _paxSum(
+      std::unique_ptr<GiftedOperator>(new GiftedPaxScanOperator(_paxBlockPointers, std::vector<std::size_t>(1, 1))),
+      _paxAggregates);
+  if (_paxSum.Next(&_batch)) {
+    std::size_t _length;
+    std::cout << "SUM(B) over " << _paxBlocks.size() << " PAX blocks: "
+              << *reinterpret_cast<const std::int64_t*>(_batch.getColumn(0).getElement(0, &_length)) << std::endl;
+  }
+
+  // A and B inserted a quarter at a time into a delta/main table, merged
+  // into compressed main blocks in the background; a range scan on A skips
+  // the blocks whose zone maps rule it out.
+  GiftedDeltaMainTable _deltaMain(registry, _rowTypes, 128, 256);
+  _deltaMain.StartMerger(std::chrono::milliseconds(10));
+  for (std::size_t _row = 0; _row < _columnA.size(); _row += 256) {
+    GiftedColumnVector _sliceA = _columnA.Slice(_row, 256);
+    GiftedColumnVector _sliceB = _columnB.Slice(_row, 256);
+    std::vector<const GiftedColumnVector*> _slices(1, &_sliceA);
+    _slices.push_back(&_sliceB);
+    _deltaMain.Insert(_slices);
+  }
+  _deltaMain.StopMerger();
+  _deltaMain.Merge();
+  GiftedDeltaMainScanOperator _deltaMainScan(_deltaMain, _deltaMain.getSnapshot(), std::vector<std::size_t>(1, 0));
+  _deltaMainScan.SetRangeFilter(0, 100, 199);
+  std::size_t _deltaMainRows = 0;
+  while (_deltaMainScan.Next(&_batch)) _deltaMainRows += _batch.getNumRows();
+  std::cout << "100 <= A <= 199 in " << _deltaMain.getNumMainBlocks() << " main blocks: " << _deltaMainRows
+            << " rows read, " << _deltaMainScan.getSkippedBlocks() << " blocks skipped" << std::endl;
+
+  // A in a scratch file of 4 KB blocks, summed through a buffer pool of
+  // only two frames.
+  char _poolPath[] = "/tmp/gifted-pool-XXXXXX";
+  const int _poolFd = mkstemp(_poolPath);
+  if (_poolFd >= 0) {
+    close(_poolFd);
+    GiftedBufferPoolOptions _poolOptions;
+    _poolOptions.frameBytes = 4096;
+    _poolOptions.numFrames = 2;
+    GiftedBufferPool _pool(_poolPath, _poolOptions);
+    std::vector<GiftedPooledColumn> _pooledColumns(1, GiftedStorePooledColumn(&_pool, _columnA));
+    std::vector<GiftedAggregateOperator::Aggregate> _poolAggregates;
+    _poolAggregates.push_back(GiftedAggregateOperator::Aggregate(GiftedAggregateOperator::kSum, 0));
+    GiftedAggregateOperator _poolSum(
+        std::unique_ptr<GiftedOperator>(new GiftedBufferPoolScanOperator(&_pool, _pooledColumns, _batchRows)),
+        _poolAggregates);
+    if (_poolSum.Next(&_batch)) {
+      std::size_t _length;
+      const GiftedBufferPool::Stats _poolStats = _pool.getStats();
+      std::cout << "SUM(A) through a 2 frame buffer pool: "
+                << *reinterpret_cast<const std::int64_t*>(_batch.getColumn(0).getElement(0, &_length)) << ", "
+                << _poolStats.hits << " hits, " << _poolStats.misses << " misses" << std::endl;
+    }
+
+    // A block looked up twice stays in the pool while a scan streams past it.
+    for (i = 0; i < 8; i++) {
+      char *_newData;
+      _pool.Unpin(_pool.NewBlock(&_newData), true);
+    }
+    for (i = 0; i < 2; i++) {
+      _pool.Pin(0);
+      _pool.Unpin(0, false);
+    }
+    for (std::uint64_t _block = 1; _block < _pool.getNumBlocks(); _block++) {
+      _pool.Pin(_block, GiftedBufferPool::kScan);
+      _pool.Unpin(_block, false);
+    }
+    const std::size_t _hitsBefore = _pool.getStats().hits;
+    _pool.Pin(0);
+    _pool.Unpin(0, false);
+    std::cout << "Block 0 after a scan of " << _pool.getNumBlocks() - 1 << " blocks: "
+              << (_pool.getStats().hits > _hitsBefore ? "hit" : "miss") << std::endl;
+    unlink(_poolPath);
+  }
+
+  // GROUP BY A / 4 and the self join of A once more, each given only 4 KB of
+  // memory, so that both spill partitions to temporary files.
+  GiftedColumnVector _quarterA(GiftedBaseType::_GiftedIntTypeId, sizeof(std::int64_t), _vectorCardinality);
+  std::int64_t *_quarters = reinterpret_cast<std::int64_t*>(_quarterA.AppendFixedSlots(_vectorCardinality));
+  for (i = 0; i < _vectorCardinality; i++) {
+    _quarters[i] = _onDiskA[i] / 4;
+  }
+  std::vector<const GiftedColumnVector*> _groupedColumns(_tableColumns);
+  _groupedColumns.push_back(&_quarterA);
+  std::vector<GiftedAggregateOperator::Aggregate> _groupAggregates;
+  _groupAggregates.push_back(GiftedAggregateOperator::Aggregate(GiftedAggregateOperator::kSum, 0));
+  GiftedHashAggregateOperator _groupBy(
+      registry, std::unique_ptr<GiftedOperator>(new GiftedScanOperator(_groupedColumns, _batchRows)),
+      std::vector<std::size_t>(1, 1), _groupAggregates, 4096);
+  std::size_t _groups = 0;
+  while (_groupBy.Next(&_batch)) {
+    _groups += _batch.getNumRows();
+  }
+  std::cout << "GROUP BY A / 4 in 4 KB: " << _groups << " groups, " << _groupBy.getSpilledPartitions()
+            << " partitions spilled" << std::endl;
+  GiftedSpillingHashJoinOperator _spillingJoin(
+      registry,
+      std::unique_ptr<GiftedOperator>(new GiftedScanOperator(_tableColumns, _batchRows)), 0,
+      std::unique_ptr<GiftedOperator>(new GiftedScanOperator(_tableColumns, _batchRows)), 0, 4096);
+  _joined = 0;
+  while (_spillingJoin.Next(&_batch)) {
+    _joined += _batch.getNumRows();
+  }
+  std::cout << "Self join of A in 4 KB: " << _joined << " rows, " << _spillingJoin.getSpilledBuildRows()
+            << " build rows spilled" << std::endl;
+
+  // With GIFTED_TLB_SCAN_MB set, SUM over an int64 column of that many MB,
+  // on ordinary and on huge pages, with the data TLB misses of each scan.
+  if (std::getenv("GIFTED_TLB_SCAN_MB") != nullptr) {
+    const std::size_t _scanRows = std::strtoull(std::getenv("GIFTED_TLB_SCAN_MB"), nullptr, 10) * (1 << 17);
+    const GiftedHugePages _pageModes[] = {kGiftedNoHugePages, kGiftedHugePages2MB};
+    const char *_pageNames[] = {"4 KB pages", "huge pages"};
+    for (int _mode = 0; _mode < 2; _mode++) {
+      GiftedSetHugePages(_pageModes[_mode]);
+      GiftedColumnVector _big(GiftedBaseType::_GiftedIntTypeId, sizeof(std::int64_t), _scanRows);
+      std::int64_t *_bigValues = reinterpret_cast<std::int64_t*>(_big.AppendFixedSlots(_scanRows));
+      for (std::size_t _row = 0; _row < _scanRows; _row++) _bigValues[_row] = static_cast<std::int64_t>(_row % 1000);
+      std::vector<GiftedAggregateOperator::Aggregate> _bigAggregates;
+      _bigAggregates.push_back(GiftedAggregateOperator::Aggregate(GiftedAggregateOperator::kSum, 0));
+      GiftedAggregateOperator _bigSum(
+          std::unique_ptr<GiftedOperator>(new GiftedScanOperator(std::vector<const GiftedColumnVector*>(1, &_big),
+                                                                 _batchRows)),
+          _bigAggregates);
+      GiftedPerfCounter _tlbMisses = GiftedPerfCounter::DataTlbMisses();
+      const std::chrono::steady_clock::time_point _start = std::chrono::steady_clock::now();
+      _tlbMisses.Start();
+      _bigSum.Next(&_batch);
+      const std::uint64_t _misses = _tlbMisses.Stop();
+      const double _milliseconds =
+          std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _start).count();
+      std::cout << "SUM over " << _scanRows / (1 << 17) << " MB on " << _pageNames[_mode] << ": " << _milliseconds
+                << " ms, ";
+      if (_tlbMisses.isAvailable()) {
+        std::cout << _misses << " dTLB misses" << std::endl;
+      } else {
+        std::cout << "no dTLB counter" << std::endl;
+      }
+    }
+    GiftedSetHugePages(kGiftedNoHugePages);
+  }
+
+  // Scan the int64 columns of an Arrow IPC file in place for the value 13.
+  if (argc > 1) {
+    const std::int64_t _literal = 13;
+    GiftedArrowFileReader _arrowFile(registry, argv[1]);
+    for (std::size_t _column = 0; _column < _arrowFile.getNumColumns(); _column++) {
+      if (_arrowFile.getColumnType(_column) != GiftedBaseType::_GiftedIntTypeId) continue;
+      std::size_t _matches = 0;
+      for (std::size_t _batch = 0; _batch < _arrowFile.getNumRecordBatches(); _batch++) {
+        GiftedColumnVector _mapped = _arrowFile.ReadColumn(_batch, _column);
+        std::unique_ptr<bool[]> _matchArray(new bool[_mapped.size()]);
+        _anInstance.VectorizedEqual(_anInstance.getLength(), _mapped.getValues(), _mapped.size(),
+                                    reinterpret_cast<const char*>(&_literal), _matchArray.get());
+        for (i = 0; i < _mapped.size(); i++) {
+          _matches += _matchArray[i] && !_mapped.isNull(i);
+        }
+      }
+      std::cout << _arrowFile.getColumnName(_column) << " = 13 : " << _matches << " rows" << std::endl;
+    }
+
+    // A copy whose first record batch claims an empty body must be rejected, not read past.
+    std::ifstream _arrowIn(argv[1], std::ios::binary);
+    std::string _arrowBytes((std::istreambuf_iterator<char>(_arrowIn)), std::istreambuf_iterator<char>());
+    char _corruptPath[] = "/tmp/giftedArrowXXXXXX";
+    const int _corruptFd = mkstemp(_corruptPath);
+    if (_corruptFd >= 0 && _arrowFile.getNumRecordBatches() > 0 && _arrowFile.getNumColumns() > 0) {
+      // Trailer: int32 footer length, then "ARROW1"; Footer.recordBatches is field 3.
+      std::int32_t _footerLength;
+      std::memcpy(&_footerLength, &_arrowBytes[_arrowBytes.size() - 10], sizeof(_footerLength));
+      const std::size_t _footerStart = _arrowBytes.size() - 10 - _footerLength;
+      const gifted_arrow_internal::FlatTable _footer = gifted_arrow_internal::FlatTable::Root(
+          reinterpret_cast<const std::uint8_t*>(&_arrowBytes[_footerStart]), _footerLength);
+      const std::int64_t _emptyBody = 0;
+      std::memcpy(&_arrowBytes[_footerStart + _footer.getStructAt(3, 0, 24) + 16], &_emptyBody, sizeof(_emptyBody));
+      const bool _written = write(_corruptFd, _arrowBytes.data(), _arrowBytes.size()) ==
+          static_cast<ssize_t>(_arrowBytes.size());
+      close(_corruptFd);
+      if (_written) {
+        GiftedArrowFileReader _corruptFile(registry, _corruptPath);
+        std::size_t _rejected = 0;
+        for (std::size_t _column = 0; _column < _corruptFile.getNumColumns(); _column++) {
+          try {
+            _corruptFile.ReadColumn(0, _column);
+          } catch (const std::exception &) {
+            _rejected++;
+          }
+        }
+        std::cout << "Corrupt Arrow file: " << _rejected << " of " << _corruptFile.getNumColumns()
+                  << " columns rejected" << std::endl;
+      }
+      unlink(_corruptPath);
+    } else if (_corruptFd >= 0) {
+      close(_corruptFd);
+      unlink(_corruptPath);
+    }
+  }
+
+  // Stream a column file through the prefetching reader, block by block.
+  char _columnPath[] = "/tmp/giftedColumnXXXXXX";
+  const int _columnFd = mkstemp(_columnPath);
+  if (_columnFd >= 0) {
+    const bool _written = write(_columnFd, _onDiskA, _columnA.getValuesBytes()) ==
+        static_cast<ssize_t>(_columnA.getValuesBytes());
+    close(_columnFd);
+    if (_written) {
+      GiftedPrefetchOptions _prefetchOptions;
+      _prefetchOptions.blockBytes = _vectorCardinality * _anInstance.getLength();
+      GiftedPrefetchingColumnReader _columnReader(GiftedBaseType::_GiftedIntTypeId,
+                                                  _anInstance.getLength(), _columnPath,
+                                                  _prefetchOptions);
+      GiftedColumnVector _block(GiftedBaseType::_GiftedIntTypeId, _anInstance.getLength(), 0);
+      std::size_t _matches = 0;
+      while (_columnReader.Next(&_block)) {
+        _anInstance.VectorizedEqual(_anInstance.getLength(), _block.getValues(), _block.size(),
+                                    _storagePtr, _resultArray.get());
+        for (i = 0; i < _block.size(); i++) {
+          _matches += _resultArray[i];
+        }
+      }
+      std::cout << "Prefetched scan (" << (_columnReader.usesIoUring() ? "io_uring" : "pread")
+                << "): " << _matches << " rows = " << *anotherAttr << std::endl;
+    }
+    unlink(_columnPath);
+  }
+
   delete anotherAttr;
 
   return 0;
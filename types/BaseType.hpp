@@ -0,0 +1,308 @@
+//
+//  BaseType.hpp
+//
+//  Created by Jignesh Patel on 7/4/16.
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_TYPES_BASE_TYPE_HPP_
+#define GIFTED_TYPES_BASE_TYPE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "types/HashFunctions.hpp"
+#include "types/TextConversions.hpp"
+
+/**
+ * @brief Gift-ed base types. All types are derived from this base class.
+**/
+class GiftedBaseType {
+
+public:
+
+  /**
+   * @brief List of the built-in types in the Quickstep system. Each type has a
+   *        unique id. Ids at or above _GiftedNumBuiltinTypeIds are handed out
+   *        at runtime by the GiftedTypeRegistry (e.g. to types loaded from a
+   *        plugin), so adding a type does not require editing this enum.
+   **/
+  enum GiftedTypeId : int {
+    _GiftedUnknownTypeId = -1,
+    _GiftedIntTypeId,
+    _GiftedInt32TypeId,
+    _GiftedDecimalTypeId,
+    _GiftedVarCharTypeId,
+    _GiftedNumBuiltinTypeIds
+  };
+
+  GiftedBaseType() {}; // Constructor.
+  virtual ~GiftedBaseType() {}; // Pure virtual destructor.
+
+  /**
+   * @brief Clone the type (aka. a factory). Note this method create an empty
+   *        new instance of the specific (C++ subclass) type.
+   *
+   *        WARNING: Use with care! The caller is responsible for cleaning
+   *                 up the object that is allocated.
+   **/
+  virtual GiftedBaseType* Clone () const = 0;
+
+  /**
+   * @brief Interface to describe the type of the specific C++ class instance.
+   *
+   * @return Return the type. If not defined, then return an unknown type.
+   **/
+  virtual GiftedTypeId myType() const {return GiftedTypeId::_GiftedUnknownTypeId;}
+
+  /**
+   * @brief Interface to determine if the type's storage representation is
+   *        fixed length or variable length. If the type is fixed length a
+   *        length. If it is length of the type for fixed length.
+   *
+   * @return Return a length greater than 0 if the type is fixed length, else
+   *         for variable length return 0.
+   **/
+  virtual std::size_t getLength() = 0;
+
+  /**
+   * @brief Turn a disk representation to an in-memory represenation.
+   *
+   * @return none TODO: Worry about error handling.
+   *              TODO: Instead of pointing a char* and a size, we should have a
+   *                    protected structure to pass around (that can also deal
+   *                    array bounds).
+   **/
+  virtual void UnMarshall(const char* const payload, const std::size_t length) = 0;
+
+  // TODO: need the assocaited similar marshall call
+
+  // Comparison Operators ...
+  // Must define these. TODO: Worry about three-valued logic.
+  virtual void Equal(const GiftedBaseType* const right, bool &result) const = 0;
+  virtual void LessThan(const GiftedBaseType* const right, bool &result) const = 0;
+
+  // Can override if needed.
+  virtual void NotEqual(const GiftedBaseType* const right, bool &result) const {
+    Equal(right, result);
+    result =! result;  // flip the result from IsEqual
+  }
+  virtual void LessThanOrEqual(const GiftedBaseType* const right, bool &result) const {
+    LessThan(right, result);
+    if (!result) return Equal(right, result);
+  }
+  virtual void GreaterThan(const GiftedBaseType* const right, bool &result) const {
+    LessThanOrEqual(right, result); // Can make this all more efficient by using base operators.
+    result =! result;  // flip the result
+  }
+  virtual void GreaterThanOrEqual(const GiftedBaseType* const right, bool &result) const {
+    LessThan(right, result);
+    result =! result;  // flip the result
+  }
+
+  // Now the arithmetic operators add, subtract, divide, multiply, modulo, ....
+  /**
+    * @brief Add the argument to the current value pointed to by "this".
+    *        Note that this modifies the class instance that is called.
+    *
+    * @return None
+   **/
+  virtual void AddToLeft(const GiftedBaseType* const right) = 0;
+  // TODO: Add other operations like this for each operator.
+
+  // TODO: Add batch/bulk version of all of the comparison and arithmetic ops.
+  //       Only for fixed length types, otherwise return an error. Here is
+  //       what one would look like.
+  virtual void VectorizedEqual(const std::size_t elementLength,      // Size of each element.
+                               const char* const vectorDataElements, // Raw vector data.
+                               const std::size_t vectorLength,       // Size of the vector.
+                               const char* const rawLiteralData,     // Literal in the raw data form.
+                               bool *result) // somewhat crude would need a TupleIdSequence...
+  {
+    std::size_t i;
+    GiftedBaseType *_callerTypeInstance = Clone(); // Clone an instance of the caller type.
+    GiftedBaseType *_literalInstance = Clone();    // Clone an instance of the literal type.
+
+    // Initialize the literal.
+    _literalInstance->UnMarshall(rawLiteralData, elementLength);
+
+    for (i=0; i<vectorLength; i++) {
+      _callerTypeInstance->UnMarshall(vectorDataElements+(i*elementLength), elementLength);
+      _callerTypeInstance->Equal(_literalInstance, result[i]);
+    }
+
+    // TODO: Better to use auto pointer of some sort.
+    delete _callerTypeInstance;
+    delete _literalInstance;
+  };
+
+  virtual void VectorizedLessThan(const std::size_t elementLength,      // Size of each element.
+                                  const char* const vectorDataElements, // Raw vector data.
+                                  const std::size_t vectorLength,       // Size of the vector.
+                                  const char* const rawLiteralData,     // Literal in the raw data form.
+                                  bool *result)
+  {
+    std::size_t i;
+    GiftedBaseType *_callerTypeInstance = Clone();
+    GiftedBaseType *_literalInstance = Clone();
+
+    _literalInstance->UnMarshall(rawLiteralData, elementLength);
+
+    for (i=0; i<vectorLength; i++) {
+      _callerTypeInstance->UnMarshall(vectorDataElements+(i*elementLength), elementLength);
+      _callerTypeInstance->LessThan(_literalInstance, result[i]);
+    }
+
+    delete _callerTypeInstance;
+    delete _literalInstance;
+  };
+
+  /**
+   * @brief Parse a batch of text fields straight into the raw (marshalled)
+   *        form, e.g. when bulk loading a CSV file, without going through a
+   *        type instance and UnMarshall per value. Field i is the
+   *        fieldLengths[i] characters at text+fieldBegins[i]. The values are
+   *        written back to back to "out" (vectorLength*getLength() bytes),
+   *        and failed[i] is set if field i is not a valid value.
+   *
+   *        Only for fixed length types, variable length text is stored as
+   *        is. A type without a text form keeps this default, which throws.
+   **/
+  virtual void ParseVector(const char* const text,
+                           const std::uint32_t* const fieldBegins,
+                           const std::uint32_t* const fieldLengths,
+                           const std::size_t vectorLength,
+                           char *out,
+                           bool *failed)
+  {
+    throw std::invalid_argument("GiftedBaseType: type has no ParseVector");
+  };
+
+  /**
+   * @brief Batch counterpart of Print: write the text form of a vector of raw
+   *        values back to back into "out", which must have room for
+   *        vectorLength*kGiftedMaxFormattedLength characters, and set
+   *        textEnds[i] to the offset in "out" just past value i.
+   *
+   *        Only for fixed length types, the raw form of variable length text
+   *        already is its text. This default goes through Print per value;
+   *        types override it with a direct conversion.
+   *
+   * @return The number of characters written.
+   **/
+  virtual std::size_t FormatVector(const std::size_t elementLength,
+                                   const char* const vectorDataElements,
+                                   const std::size_t vectorLength,
+                                   char *out,
+                                   std::uint32_t *textEnds)
+  {
+    std::size_t i;
+    std::size_t written = 0;
+    GiftedBaseType *_callerTypeInstance = Clone();
+    std::ostringstream _text;
+
+    for (i=0; i<vectorLength; i++) {
+      _callerTypeInstance->UnMarshall(vectorDataElements+(i*elementLength), elementLength);
+      _text.str(std::string());
+      _callerTypeInstance->Print(_text);
+      const std::string value = _text.str();
+      const std::size_t length =
+          value.size() < kGiftedMaxFormattedLength ? value.size() : kGiftedMaxFormattedLength;
+      value.copy(out + written, length);
+      written += length;
+      textEnds[i] = static_cast<std::uint32_t>(written);
+    }
+
+    delete _callerTypeInstance;
+    return written;
+  };
+
+  /**
+   * @brief Gather: copy the values at the given positions of a vector of raw
+   *        values back to back into "out" (numPositions*elementLength bytes).
+   *        Used to materialize the rows that survive a filter.
+   *
+   *        Only for fixed length types, variable length columns are gathered
+   *        by rebuilding their offsets (see GiftedColumnVector::AppendGathered).
+   *        This default copies one value at a time.
+   **/
+  virtual void VectorizedGather(const std::size_t elementLength,
+                                const char* const vectorDataElements,
+                                const std::uint32_t* const positions,
+                                const std::size_t numPositions,
+                                char *out)
+  {
+    std::size_t i;
+    for (i=0; i<numPositions; i++) {
+      std::memcpy(out+(i*elementLength), vectorDataElements+(positions[i]*elementLength), elementLength);
+    }
+  };
+
+  /**
+   * @brief Hash every value of a vector of raw values, e.g. to build or probe
+   *        a hash table or a Bloom filter. Equal values must hash equally.
+   *
+   *        Only for fixed length types, variable length values are hashed as
+   *        bytes (see GiftedColumnVector::Hash). This default hashes the raw
+   *        bytes of each value.
+   **/
+  virtual void VectorizedHash(const std::size_t elementLength,
+                              const char* const vectorDataElements,
+                              const std::size_t vectorLength,
+                              std::uint64_t *hashes)
+  {
+    std::size_t i;
+    for (i=0; i<vectorLength; i++) {
+      hashes[i] = GiftedHashBytes(vectorDataElements+(i*elementLength), elementLength);
+    }
+  };
+
+  /**
+   * @brief Normalized keys: rewrite a vector of raw values into byte strings
+   *        (elementLength bytes each, back to back in "out") that memcmp
+   *        orders as LessThan orders the values. Keys of several columns
+   *        can then be compared as one string, e.g. by a merge join.
+   *
+   *        Only for fixed length types, variable length values are escaped
+   *        instead (see GiftedNormalizeKeys). A type without an order
+   *        preserving byte form keeps this default, which throws.
+   **/
+  virtual void NormalizeKeys(const std::size_t elementLength,
+                             const char* const vectorDataElements,
+                             const std::size_t vectorLength,
+                             char *out)
+  {
+    throw std::invalid_argument("GiftedBaseType: type has no NormalizeKeys");
+  };
+
+  // TODO: Define a VectorizedEqual in which the raw vector data is spread apart
+  //       by a stride between two vectors (for evaluating predicates on fixed
+  //       length attributes in a split row store.
+
+  // TODO: Define a fast projection from a columnar vector to another columnar
+  //       vector. This function would take as input a bitVector that indicates
+  //       which columns to project out.
+  //       Also create a "strided" version of this for packed row store.
+
+  // Printing Functions
+  friend std::ostream& operator<<(std::ostream& out, const GiftedBaseType& instance);
+  virtual void Print(std::ostream& os) const = 0;
+};
+
+/**
+ * @brief A generic output operator that works with any Quickstep type. It
+ *        simply calls the virtual Print function.
+ **/
+
+inline std::ostream& operator<<(std::ostream& out, const GiftedBaseType& instance)
+{
+  instance.Print(out);
+  return out;
+}
+
+#endif  // GIFTED_TYPES_BASE_TYPE_HPP_
@@ -0,0 +1,36 @@
+//
+//  BatchPredicate.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_TYPES_BATCH_PREDICATE_HPP_
+#define GIFTED_TYPES_BATCH_PREDICATE_HPP_
+
+#include <string>
+
+#include "storage/VectorBatch.hpp"
+
+/**
+ * @brief A test over several columns of a batch at once, e.g. a fused pair
+ *        of comparisons or a whole expression. Unlike a column predicate it
+ *        handles nulls itself.
+ **/
+class GiftedBatchPredicate {
+public:
+  virtual ~GiftedBatchPredicate() {}
+
+  /**
+   * @brief Set result[i] to the outcome for every row i of "batch" (selected
+   *        or not). Rows with a null in a column the test reads fail.
+   **/
+  virtual void Evaluate(const GiftedVectorBatch &batch, bool *result) = 0;
+
+  /**
+   * @brief As GiftedColumnPredicate::getCacheKey(); the key includes the
+   *        batch columns the test reads.
+   **/
+  virtual std::string getCacheKey() const {return std::string();}
+};
+
+#endif  // GIFTED_TYPES_BATCH_PREDICATE_HPP_
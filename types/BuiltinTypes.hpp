@@ -0,0 +1,33 @@
+//
+//  BuiltinTypes.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_TYPES_BUILTIN_TYPES_HPP_
+#define GIFTED_TYPES_BUILTIN_TYPES_HPP_
+
+#include "types/DecimalType.hpp"
+#include "types/Int32Type.hpp"
+#include "types/IntegerType.hpp"
+#include "types/TypeRegistry.hpp"
+#include "types/VarCharType.hpp"
+
+/**
+ * @brief Register the types that are compiled into the system. Types that
+ *        live outside the tree come in through GiftedTypeRegistry::LoadPlugin
+ *        instead.
+ **/
+inline void GiftedRegisterBuiltinTypes(GiftedTypeRegistry *registry) {
+  registry->RegisterType("int64", new GiftedIntegerType);
+  registry->RegisterType("int32", new GiftedInt32Type);
+  registry->RegisterType("decimal", new GiftedDecimalType);
+  registry->RegisterType("varchar", new GiftedVarCharType);
+
+  GiftedIntegerType::RegisterCasts(registry);
+  GiftedInt32Type::RegisterCasts(registry);
+  GiftedDecimalType::RegisterCasts(registry);
+  GiftedVarCharType::RegisterCasts(registry);
+}
+
+#endif  // GIFTED_TYPES_BUILTIN_TYPES_HPP_
@@ -0,0 +1,135 @@
+//
+//  CastKernels.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_TYPES_CAST_KERNELS_HPP_
+#define GIFTED_TYPES_CAST_KERNELS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "storage/ColumnVector.hpp"
+#include "types/TextConversions.hpp"
+
+/**
+ * @brief A batch cast: converts every value of "input" and appends the result
+ *        to "output" (a column of the target type). If "failed" is not null,
+ *        failed[i] is set to true for each value that does not fit in the
+ *        target type (overflow, unparsable text, ...); the output then holds
+ *        a zero/empty value in that slot so positions stay aligned.
+ **/
+typedef void (*GiftedCastKernel)(const GiftedColumnVector &input,
+                                 GiftedColumnVector *output,
+                                 bool *failed);
+
+// Value converters used to instantiate GiftedFixedCastKernel. Each returns
+// false if the value cannot be represented in the target type.
+
+template <typename From, typename To>
+struct GiftedWideningConvert {
+  static bool Apply(const From value, To *out) {
+    *out = static_cast<To>(value);
+    return true;
+  }
+};
+
+template <typename From, typename To>
+struct GiftedNarrowingConvert {
+  static bool Apply(const From value, To *out) {
+    const bool fits = value >= static_cast<From>(std::numeric_limits<To>::min()) &&
+                      value <= static_cast<From>(std::numeric_limits<To>::max());
+    *out = fits ? static_cast<To>(value) : To();
+    return fits;
+  }
+};
+
+// Integer -> fixed point with "Scale" units per whole number. A value out of
+// range saturates, so that it keeps its sign.
+template <typename From, std::int64_t Scale>
+struct GiftedScaleUpConvert {
+  static bool Apply(const From value, std::int64_t *out) {
+    if (value > std::numeric_limits<std::int64_t>::max() / Scale) {
+      *out = std::numeric_limits<std::int64_t>::max();
+      return false;
+    }
+    if (value < std::numeric_limits<std::int64_t>::min() / Scale) {
+      *out = std::numeric_limits<std::int64_t>::min();
+      return false;
+    }
+    *out = static_cast<std::int64_t>(value) * Scale;
+    return true;
+  }
+};
+
+// Fixed point with "Scale" units per whole number -> integer (truncates).
+template <typename To, std::int64_t Scale>
+struct GiftedScaleDownConvert {
+  static bool Apply(const std::int64_t value, To *out) {
+    return GiftedNarrowingConvert<std::int64_t, To>::Apply(value / Scale, out);
+  }
+};
+
+/**
+ * @brief Cast between two fixed length types whose raw forms are the native
+ *        types From and To. One pass, no per value virtual calls.
+ **/
+template <typename From, typename To, class Convert>
+void GiftedFixedCastKernel(const GiftedColumnVector &input,
+                           GiftedColumnVector *output,
+                           bool *failed) {
+  const std::size_t count = input.size();
+  const From *in = reinterpret_cast<const From*>(input.getValues());
+  To *out = reinterpret_cast<To*>(output->AppendFixedSlots(count));
+  if (failed == nullptr) {
+    for (std::size_t i = 0; i < count; i++) {
+      Convert::Apply(in[i], &out[i]);
+    }
+  } else {
+    for (std::size_t i = 0; i < count; i++) {
+      failed[i] = !Convert::Apply(in[i], &out[i]);
+    }
+  }
+}
+
+/**
+ * @brief Cast from a fixed length type to text using its format function.
+ **/
+template <typename From, std::size_t (*Format)(From, char*)>
+void GiftedFormatCastKernel(const GiftedColumnVector &input,
+                            GiftedColumnVector *output,
+                            bool *failed) {
+  const std::size_t count = input.size();
+  const From *in = reinterpret_cast<const From*>(input.getValues());
+  output->Reserve(output->size() + count,
+                  output->getValuesBytes() + count * kGiftedMaxFormattedLength);
+  char text[kGiftedMaxFormattedLength];
+  for (std::size_t i = 0; i < count; i++) {
+    output->AppendVariable(text, Format(in[i], text));
+  }
+  if (failed != nullptr) {
+    for (std::size_t i = 0; i < count; i++) failed[i] = false;
+  }
+}
+
+/**
+ * @brief Cast from text to a fixed length type using its parse function.
+ **/
+template <typename To, bool (*Parse)(const char*, std::size_t, To*)>
+void GiftedParseCastKernel(const GiftedColumnVector &input,
+                           GiftedColumnVector *output,
+                           bool *failed) {
+  const std::size_t count = input.size();
+  const char *text = input.getValues();
+  const GiftedColumnVector::OffsetType *offsets = input.getOffsets();
+  To *out = reinterpret_cast<To*>(output->AppendFixedSlots(count));
+  for (std::size_t i = 0; i < count; i++) {
+    const bool ok = Parse(text + offsets[i], offsets[i + 1] - offsets[i], &out[i]);
+    if (!ok) out[i] = To();
+    if (failed != nullptr) failed[i] = !ok;
+  }
+}
+
+#endif  // GIFTED_TYPES_CAST_KERNELS_HPP_
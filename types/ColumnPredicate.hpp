@@ -0,0 +1,37 @@
+//
+//  ColumnPredicate.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_TYPES_COLUMN_PREDICATE_HPP_
+#define GIFTED_TYPES_COLUMN_PREDICATE_HPP_
+
+#include <string>
+
+#include "storage/ColumnVector.hpp"
+
+/**
+ * @brief A test applied to every value of a column at once, e.g. a
+ *        comparison with a literal. Filters hold their test through this
+ *        interface.
+ **/
+class GiftedColumnPredicate {
+public:
+  virtual ~GiftedColumnPredicate() {}
+
+  /**
+   * @brief Set result[i] to the outcome for value i of "batch". The outcome
+   *        for null values does not matter; callers drop them.
+   **/
+  virtual void Evaluate(const GiftedColumnVector &batch, bool *result) = 0;
+
+  /**
+   * @brief A string that is the same for predicates with the same outcome on
+   *        the same values, e.g. to key cached results; empty if results
+   *        must not be cached (the test changes over time).
+   **/
+  virtual std::string getCacheKey() const {return std::string();}
+};
+
+#endif  // GIFTED_TYPES_COLUMN_PREDICATE_HPP_
@@ -0,0 +1,215 @@
+//
+//  DecimalType.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_TYPES_DECIMAL_TYPE_HPP_
+#define GIFTED_TYPES_DECIMAL_TYPE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+
+#include "types/BaseType.hpp"
+#include "types/CastKernels.hpp"
+#include "types/FixedWidthKernels.hpp"
+#include "types/TextConversions.hpp"
+#include "types/TypeRegistry.hpp"
+
+/**
+ * @brief The DecimalType. A fixed point number with kScaleDigits digits after
+ *        the decimal point, stored as a 64-bit count of 1/kScale units.
+ **/
+class GiftedDecimalType : public GiftedBaseType {
+public:
+  static const int kScaleDigits = 4;
+  static const std::int64_t kScale = 10000;
+
+  GiftedDecimalType():_value(0) {};
+  ~GiftedDecimalType() {};
+  virtual GiftedBaseType* Clone () const override {return new GiftedDecimalType;};
+
+  GiftedTypeId myType() const override {return _GiftedDecimalTypeId;}
+
+  std::size_t getLength() override {
+    return sizeof(std::int64_t);
+  }
+
+  void UnMarshall(const char* const payload, const std::size_t length) override {
+    _value = *reinterpret_cast<const std::int64_t*>(payload);
+  }
+
+  void Equal(const GiftedBaseType* const right, bool &result) const override {
+    result = (_value == checkedCast(right)->_value);
+  }
+
+  void LessThan(const GiftedBaseType* const right, bool &result) const override {
+    result = (_value < checkedCast(right)->_value);
+  }
+
+  void AddToLeft(const GiftedBaseType* const right) override {
+    _value += checkedCast(right)->_value;
+  }
+
+  void Print(std::ostream& os) const override {
+    char text[kGiftedMaxFormattedLength];
+    os.write(text, FormatValue(_value, text));
+  }
+
+  void VectorizedEqual(const std::size_t elementLength,
+                       const char* const vectorDataElements,
+                       const std::size_t vectorLength,
+                       const char* const rawLiteralData,
+                       bool *result) override {
+    GiftedFixedWidthCompare<std::int64_t, std::equal_to<std::int64_t> >(
+        vectorDataElements, vectorLength, rawLiteralData, result);
+  }
+
+  void VectorizedLessThan(const std::size_t elementLength,
+                          const char* const vectorDataElements,
+                          const std::size_t vectorLength,
+                          const char* const rawLiteralData,
+                          bool *result) override {
+    GiftedFixedWidthCompare<std::int64_t, std::less<std::int64_t> >(
+        vectorDataElements, vectorLength, rawLiteralData, result);
+  }
+
+  /**
+   * @brief Parse text such as "-12.5" into the scaled representation. At most
+   *        kScaleDigits digits may follow the decimal point.
+   **/
+  static bool ParseValue(const char *text, const std::size_t length, std::int64_t *value) {
+    std::size_t point = 0;
+    while (point < length && text[point] != '.') point++;
+
+    std::int64_t whole = 0;
+    const bool negative = length > 0 && text[0] == '-';
+    const bool noWholeDigits = point == 0 || (point == 1 && (text[0] == '-' || text[0] == '+'));
+    if (!noWholeDigits && !GiftedParseInt64(text, point, &whole)) {
+      return false;
+    }
+
+    std::int64_t fraction = 0;
+    const std::size_t fractionDigits = point < length ? length - point - 1 : 0;
+    if (fractionDigits > static_cast<std::size_t>(kScaleDigits)) return false;
+    if (noWholeDigits && fractionDigits == 0) return false;
+    for (std::size_t i = 0; i < fractionDigits; i++) {
+      const unsigned digit = static_cast<unsigned char>(text[point + 1 + i]) - '0';
+      if (digit > 9) return false;
+      fraction = fraction * 10 + digit;
+    }
+    for (std::size_t i = fractionDigits; i < static_cast<std::size_t>(kScaleDigits); i++) {
+      fraction *= 10;
+    }
+
+    std::int64_t scaled;
+    if (!GiftedScaleUpConvert<std::int64_t, kScale>::Apply(whole, &scaled)) return false;
+    if (negative) {
+      if (scaled < std::numeric_limits<std::int64_t>::min() + fraction) return false;
+      *value = scaled - fraction;
+    } else {
+      if (scaled > std::numeric_limits<std::int64_t>::max() - fraction) return false;
+      *value = scaled + fraction;
+    }
+    return true;
+  }
+
+  /**
+   * @brief Write "value" as text with all kScaleDigits fraction digits.
+   **/
+  static std::size_t FormatValue(const std::int64_t value, char *buffer) {
+    std::int64_t whole = value / kScale;
+    std::int64_t fraction = value % kScale;
+    std::size_t length = 0;
+    if (value < 0) {
+      buffer[length++] = '-';
+      whole = -whole;
+      fraction = -fraction;
+    }
+    length += GiftedFormatInt64(whole, buffer + length);
+    buffer[length++] = '.';
+    for (int i = kScaleDigits - 1; i >= 0; i--) {
+      buffer[length + i] = static_cast<char>('0' + fraction % 10);
+      fraction /= 10;
+    }
+    return length + kScaleDigits;
+  }
+
+  void ParseVector(const char* const text,
+                   const std::uint32_t* const fieldBegins,
+                   const std::uint32_t* const fieldLengths,
+                   const std::size_t vectorLength,
+                   char *out,
+                   bool *failed) override {
+    GiftedFixedWidthParse<std::int64_t, &GiftedDecimalType::ParseValue>(
+        text, fieldBegins, fieldLengths, vectorLength, out, failed);
+  }
+
+  std::size_t FormatVector(const std::size_t elementLength,
+                           const char* const vectorDataElements,
+                           const std::size_t vectorLength,
+                           char *out,
+                           std::uint32_t *textEnds) override {
+    return GiftedFixedWidthFormat<std::int64_t, &GiftedDecimalType::FormatValue>(
+        vectorDataElements, vectorLength, out, textEnds);
+  }
+
+  void VectorizedGather(const std::size_t elementLength,
+                        const char* const vectorDataElements,
+                        const std::uint32_t* const positions,
+                        const std::size_t numPositions,
+                        char *out) override {
+    GiftedFixedWidthGather<std::int64_t>(vectorDataElements, positions, numPositions, out);
+  }
+
+  void VectorizedHash(const std::size_t elementLength,
+                      const char* const vectorDataElements,
+                      const std::size_t vectorLength,
+                      std::uint64_t *hashes) override {
+    GiftedFixedWidthHash<std::int64_t>(vectorDataElements, vectorLength, hashes);
+  }
+
+  void NormalizeKeys(const std::size_t elementLength,
+                     const char* const vectorDataElements,
+                     const std::size_t vectorLength,
+                     char *out) override {
+    GiftedFixedWidthNormalize<std::int64_t, std::uint64_t>(vectorDataElements, vectorLength, out);
+  }
+
+  /**
+   * @brief Register the casts out of this type.
+   **/
+  static void RegisterCasts(GiftedTypeRegistry *registry) {
+    registry->RegisterCast(
+        _GiftedDecimalTypeId, _GiftedIntTypeId,
+        &GiftedFixedCastKernel<std::int64_t, std::int64_t,
+                               GiftedScaleDownConvert<std::int64_t, kScale> >,
+        false);
+    registry->RegisterCast(
+        _GiftedDecimalTypeId, _GiftedInt32TypeId,
+        &GiftedFixedCastKernel<std::int64_t, std::int32_t,
+                               GiftedScaleDownConvert<std::int32_t, kScale> >,
+        false);
+    registry->RegisterCast(
+        _GiftedDecimalTypeId, _GiftedVarCharTypeId,
+        &GiftedFormatCastKernel<std::int64_t, &GiftedDecimalType::FormatValue>,
+        false);
+  }
+
+protected:
+  std::int64_t _value; // Value in units of 1/kScale.
+
+private:
+  static const GiftedDecimalType* checkedCast(const GiftedBaseType* const right) {
+    if (right->myType() != _GiftedDecimalTypeId) {
+      throw std::invalid_argument("GiftedDecimalType: operand type mismatch, cast first");
+    }
+    return static_cast<const GiftedDecimalType*>(right);
+  }
+};
+
+#endif  // GIFTED_TYPES_DECIMAL_TYPE_HPP_
@@ -0,0 +1,238 @@
+//
+//  Expression.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_TYPES_EXPRESSION_HPP_
+#define GIFTED_TYPES_EXPRESSION_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "storage/ColumnVector.hpp"
+#include "storage/VectorBatch.hpp"
+#include "types/BaseType.hpp"
+
+/**
+ * @brief An expression over the fixed width integer columns of a batch
+ *        (int64, int32 and decimal) and literals: arithmetic, comparisons
+ *        and AND/OR/NOT, e.g. "a + b < 10 OR NOT c = 3".
+ *
+ *        Every value is carried as an int64 (int32 values are widened,
+ *        decimals stay in 1/kScale units, and truth values are 0 or 1), so
+ *        integers of either width mix freely, while a decimal only meets
+ *        another decimal (cast first) and is never multiplied. Arithmetic
+ *        wraps around on overflow.
+ *
+ *        Evaluate() interprets the tree a node at a time, each node writing
+ *        a whole vector; see GiftedExpressionJit for the same expression as
+ *        a single compiled loop.
+ **/
+class GiftedExpression {
+public:
+  enum OperatorId {
+    kColumn = 0,
+    kLiteral,
+    kAdd,
+    kSubtract,
+    kMultiply,
+    kEqual,
+    kNotEqual,
+    kLessThan,
+    kLessThanOrEqual,
+    kGreaterThan,
+    kGreaterThanOrEqual,
+    kAnd,
+    kOr,
+    kNot
+  };
+
+  // What a node's int64 values stand for.
+  enum DomainId {
+    kInteger = 0,
+    kDecimal,
+    kBoolean
+  };
+
+  /**
+   * @brief Batch column "column", of type "type".
+   **/
+  static std::unique_ptr<GiftedExpression> Column(const std::size_t column,
+                                                  const GiftedBaseType::GiftedTypeId type) {
+    std::unique_ptr<GiftedExpression> node(new GiftedExpression(kColumn, DomainOf(type)));
+    node->_column = column;
+    node->_type = type;
+    return node;
+  }
+
+  /**
+   * @brief A literal of type "type", given as its value as an int64 (for a
+   *        decimal, in 1/kScale units).
+   **/
+  static std::unique_ptr<GiftedExpression> Literal(const GiftedBaseType::GiftedTypeId type,
+                                                   const std::int64_t value) {
+    std::unique_ptr<GiftedExpression> node(new GiftedExpression(kLiteral, DomainOf(type)));
+    node->_type = type;
+    node->_literal = value;
+    return node;
+  }
+
+  /**
+   * @brief A binary node: arithmetic, comparison, or kAnd/kOr.
+   *
+   * @exception std::invalid_argument if the operands do not fit the
+   *            operator.
+   **/
+  static std::unique_ptr<GiftedExpression> Binary(const OperatorId op,
+                                                  std::unique_ptr<GiftedExpression> left,
+                                                  std::unique_ptr<GiftedExpression> right) {
+    const DomainId leftDomain = left->getDomain();
+    const DomainId rightDomain = right->getDomain();
+    DomainId domain = kBoolean;
+    if (op == kAnd || op == kOr) {
+      if (leftDomain != kBoolean || rightDomain != kBoolean) {
+        throw std::invalid_argument("GiftedExpression: AND and OR take truth values");
+      }
+    } else if (op >= kAdd && op <= kGreaterThanOrEqual) {
+      if (leftDomain == kBoolean || rightDomain == kBoolean || leftDomain != rightDomain) {
+        throw std::invalid_argument("GiftedExpression: operands differ in type, cast first");
+      }
+      if (op == kMultiply && leftDomain == kDecimal) {
+        throw std::invalid_argument("GiftedExpression: decimals cannot be multiplied");
+      }
+      if (op <= kMultiply) domain = leftDomain;
+    } else {
+      throw std::invalid_argument("GiftedExpression: not a binary operator");
+    }
+    std::unique_ptr<GiftedExpression> node(new GiftedExpression(op, domain));
+    node->_left = std::move(left);
+    node->_right = std::move(right);
+    return node;
+  }
+
+  static std::unique_ptr<GiftedExpression> Not(std::unique_ptr<GiftedExpression> operand) {
+    if (operand->getDomain() != kBoolean) {
+      throw std::invalid_argument("GiftedExpression: NOT takes a truth value");
+    }
+    std::unique_ptr<GiftedExpression> node(new GiftedExpression(kNot, kBoolean));
+    node->_left = std::move(operand);
+    return node;
+  }
+
+  OperatorId getOperator() const {return _op;}
+  DomainId getDomain() const {return _domain;}
+  std::size_t getColumn() const {return _column;}
+  GiftedBaseType::GiftedTypeId getType() const {return _type;}
+  std::int64_t getLiteral() const {return _literal;}
+  const GiftedExpression* getLeft() const {return _left.get();}
+  const GiftedExpression* getRight() const {return _right.get();}
+
+  /**
+   * @brief The batch columns the expression reads, each once, in the order
+   *        they first appear.
+   **/
+  void CollectColumns(std::vector<std::size_t> *columns) const {
+    if (_op == kColumn) {
+      for (std::size_t i = 0; i < columns->size(); i++) {
+        if ((*columns)[i] == _column) return;
+      }
+      columns->push_back(_column);
+      return;
+    }
+    if (_left) _left->CollectColumns(columns);
+    if (_right) _right->CollectColumns(columns);
+  }
+
+  /**
+   * @brief Interpret the expression for every row of "batch" (selected or
+   *        not) into out[0 .. getNumRows()). Nulls are not looked at.
+   **/
+  void Evaluate(const GiftedVectorBatch &batch, std::int64_t *out) const {
+    const std::size_t numRows = batch.getNumRows();
+    if (_op == kColumn) {
+      const GiftedColumnVector &column = batch.getColumn(_column);
+      if (column.getTypeId() != _type) {
+        throw std::invalid_argument("GiftedExpression: column type differs from the expression's");
+      }
+      if (_type == GiftedBaseType::_GiftedInt32TypeId) {
+        const std::int32_t *values = reinterpret_cast<const std::int32_t*>(column.getValues());
+        for (std::size_t i = 0; i < numRows; i++) out[i] = values[i];
+      } else {
+        const std::int64_t *values = reinterpret_cast<const std::int64_t*>(column.getValues());
+        for (std::size_t i = 0; i < numRows; i++) out[i] = values[i];
+      }
+      return;
+    }
+    if (_op == kLiteral) {
+      for (std::size_t i = 0; i < numRows; i++) out[i] = _literal;
+      return;
+    }
+
+    _left->Evaluate(batch, out);
+    if (_op == kNot) {
+      for (std::size_t i = 0; i < numRows; i++) out[i] = !out[i];
+      return;
+    }
+    std::vector<std::int64_t> right(numRows);
+    _right->Evaluate(batch, right.data());
+    for (std::size_t i = 0; i < numRows; i++) {
+      out[i] = Apply(_op, out[i], right[i]);
+    }
+  }
+
+  /**
+   * @brief One binary operator on two values, wrapping around on overflow.
+   **/
+  static std::int64_t Apply(const OperatorId op, const std::int64_t left, const std::int64_t right) {
+    const std::uint64_t leftBits = static_cast<std::uint64_t>(left);
+    const std::uint64_t rightBits = static_cast<std::uint64_t>(right);
+    switch (op) {
+      case kAdd: return static_cast<std::int64_t>(leftBits + rightBits);
+      case kSubtract: return static_cast<std::int64_t>(leftBits - rightBits);
+      case kMultiply: return static_cast<std::int64_t>(leftBits * rightBits);
+      case kEqual: return left == right;
+      case kNotEqual: return left != right;
+      case kLessThan: return left < right;
+      case kLessThanOrEqual: return left <= right;
+      case kGreaterThan: return left > right;
+      case kGreaterThanOrEqual: return left >= right;
+      case kAnd: return (left != 0) & (right != 0);
+      case kOr: return (left != 0) | (right != 0);
+      default: throw std::invalid_argument("GiftedExpression: not a binary operator");
+    }
+  }
+
+private:
+  GiftedExpression(const OperatorId op, const DomainId domain)
+      : _op(op),
+        _domain(domain),
+        _column(0),
+        _type(GiftedBaseType::_GiftedUnknownTypeId),
+        _literal(0) {}
+
+  static DomainId DomainOf(const GiftedBaseType::GiftedTypeId type) {
+    switch (type) {
+      case GiftedBaseType::_GiftedIntTypeId:
+      case GiftedBaseType::_GiftedInt32TypeId:
+        return kInteger;
+      case GiftedBaseType::_GiftedDecimalTypeId:
+        return kDecimal;
+      default:
+        throw std::invalid_argument("GiftedExpression: only int64, int32 and decimal values");
+    }
+  }
+
+  const OperatorId _op;
+  const DomainId _domain;
+  std::size_t _column;
+  GiftedBaseType::GiftedTypeId _type;
+  std::int64_t _literal;
+  std::unique_ptr<GiftedExpression> _left;
+  std::unique_ptr<GiftedExpression> _right;
+};
+
+#endif  // GIFTED_TYPES_EXPRESSION_HPP_
@@ -0,0 +1,352 @@
+//
+//  ExpressionJit.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_TYPES_EXPRESSION_JIT_HPP_
+#define GIFTED_TYPES_EXPRESSION_JIT_HPP_
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "types/BaseType.hpp"
+#include "types/Expression.hpp"
+#include "types/HashFunctions.hpp"
+
+/**
+ * @brief A compiled expression: result[i] = expression for row i, given the
+ *        values of the expression's columns (in CollectColumns() order) and
+ *        its literals (in GenerateSource() order).
+ **/
+typedef void (*GiftedJitKernel)(const char* const* columns,
+                                const std::int64_t* literals,
+                                std::size_t vectorLength,
+                                bool *result);
+
+/**
+ * @brief Compiles expressions into native loops with the system's C++
+ *        compiler: the expression is printed as a C++ function with one loop
+ *        and no calls, compiled into a shared library and loaded with
+ *        dlopen.
+ *
+ *        Literals are parameters of the generated code, so the source only
+ *        depends on the expression's shape (operators, column types and
+ *        slots). Kernels are cached by their source, in memory and as
+ *        libraries in a cache directory, so a shape is only compiled once,
+ *        even across processes. Compiling takes a fraction of a second;
+ *        worth it for a long scan or a repeated query, not for a small one.
+ *
+ *        The compiler is $GIFTED_JIT_CXX (default "c++") and the cache
+ *        directory $GIFTED_JIT_CACHE (default gifted-jit-<uid> in $TMPDIR or
+ *        /tmp), unless given. Libraries in the cache are loaded into the
+ *        process, so the directory must belong to the user and be closed to
+ *        everyone else; the default one is made so, and if someone else got
+ *        there first the JIT falls back to a fresh private directory. The
+ *        kernels are built for the host's CPU, which is part of their key, so
+ *        hosts sharing a cache never load each other's libraries.
+ **/
+class GiftedExpressionJit {
+public:
+  explicit GiftedExpressionJit(const std::string &cacheDirectory = std::string(),
+                               const std::string &compiler = std::string())
+      : _cacheDirectory(cacheDirectory.empty() ? DefaultCacheDirectory() : cacheDirectory),
+        _compiler(compiler.empty() ? DefaultCompiler() : compiler),
+        _target(_compiler + " -march=native for " + HostCpu()),
+        _numCompiled(0) {
+    std::string problem;
+    if (!isPrivateDirectory(_cacheDirectory, &problem)) {
+      throw std::runtime_error("GiftedExpressionJit: cache directory " + _cacheDirectory + " " + problem);
+    }
+  }
+
+  ~GiftedExpressionJit() {
+    for (std::size_t i = 0; i < _handles.size(); i++) dlclose(_handles[i]);
+  }
+
+  GiftedExpressionJit(const GiftedExpressionJit&) = delete;
+  GiftedExpressionJit& operator=(const GiftedExpressionJit&) = delete;
+
+  /**
+   * @brief The C++ source of a truth valued expression's kernel.
+   *
+   * @param literals Receives the literals to pass to the kernel.
+   **/
+  static std::string GenerateSource(const GiftedExpression &expression, std::vector<std::int64_t> *literals) {
+    if (expression.getDomain() != GiftedExpression::kBoolean) {
+      throw std::invalid_argument("GiftedExpressionJit: the expression is not a predicate");
+    }
+    std::vector<std::size_t> columns;
+    expression.CollectColumns(&columns);
+    std::vector<GiftedBaseType::GiftedTypeId> types(columns.size(), GiftedBaseType::_GiftedUnknownTypeId);
+    literals->clear();
+    const std::string body = EmitNode(expression, columns, &types, literals);
+
+    std::ostringstream source;
+    source << "#include <cstddef>\n#include <cstdint>\n\n"
+           << "extern \"C\" void gifted_jit_kernel(const char* const* columns, const std::int64_t* literals,\n"
+           << "                                  std::size_t vectorLength, bool *result) {\n";
+    for (std::size_t c = 0; c < columns.size(); c++) {
+      const char *native = types[c] == GiftedBaseType::_GiftedInt32TypeId ? "std::int32_t" : "std::int64_t";
+      source << "  const " << native << " *c" << c << " = reinterpret_cast<const " << native
+             << "*>(columns[" << c << "]);\n";
+    }
+    for (std::size_t l = 0; l < literals->size(); l++) {
+      source << "  const std::int64_t l" << l << " = literals[" << l << "];\n";
+    }
+    source << "  for (std::size_t i = 0; i < vectorLength; i++) {\n"
+           << "    result[i] = " << body << " != 0;\n"
+           << "  }\n}\n";
+    return source.str();
+  }
+
+  /**
+   * @brief The kernel for "source" (from GenerateSource()), compiled now
+   *        unless it is cached.
+   *
+   * @exception std::runtime_error if it cannot be compiled or loaded.
+   **/
+  GiftedJitKernel Compile(const std::string &source) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::unordered_map<std::string, GiftedJitKernel>::const_iterator cached = _kernels.find(source);
+    if (cached != _kernels.end()) return cached->second;
+
+    // The stored source names the compiler and CPU it was built for.
+    const std::string stamped = "// " + _target + "\n" + source;
+    char name[32];
+    std::snprintf(name, sizeof(name), "/gifted_jit_%016llx",
+                  static_cast<unsigned long long>(GiftedHashBytes(stamped.data(), stamped.size())));
+    const std::string base = _cacheDirectory + name;
+    // A library on disk is only trusted next to the exact source it is for.
+    if (ReadFile(base + ".cpp") != stamped || access((base + ".so").c_str(), R_OK) != 0) {
+      Build(stamped, base);
+      _numCompiled++;
+    }
+
+    void *handle = dlopen((base + ".so").c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (handle == nullptr) {
+      throw std::runtime_error("GiftedExpressionJit: cannot load " + base + ".so: " + dlerror());
+    }
+    GiftedJitKernel kernel = reinterpret_cast<GiftedJitKernel>(dlsym(handle, "gifted_jit_kernel"));
+    if (kernel == nullptr) {
+      dlclose(handle);
+      throw std::runtime_error("GiftedExpressionJit: " + base + ".so has no kernel");
+    }
+    _handles.push_back(handle);
+    _kernels[source] = kernel;
+    return kernel;
+  }
+
+  /**
+   * @brief How many kernels this JIT had to compile (the rest were cached).
+   **/
+  std::size_t getNumCompiled() const {return _numCompiled;}
+
+private:
+  /**
+   * @brief $GIFTED_JIT_CACHE, else the user's gifted-jit-<uid> in $TMPDIR or
+   *        /tmp, made with mode 0700. If that name is taken by a directory
+   *        that is not private to the user, a new one from mkdtemp.
+   **/
+  static std::string DefaultCacheDirectory() {
+    const char *directory = std::getenv("GIFTED_JIT_CACHE");
+    if (directory != nullptr && *directory != '\0') return directory;
+    directory = std::getenv("TMPDIR");
+    const std::string parent = directory == nullptr || *directory == '\0' ? "/tmp" : directory;
+
+    std::ostringstream path;
+    path << parent << "/gifted-jit-" << geteuid();
+    std::string problem;
+    if ((mkdir(path.str().c_str(), 0700) == 0 || errno == EEXIST) && isPrivateDirectory(path.str(), &problem)) {
+      return path.str();
+    }
+    std::string pattern = path.str() + "-XXXXXX";
+    std::vector<char> name(pattern.begin(), pattern.end());
+    name.push_back('\0');
+    if (mkdtemp(name.data()) == nullptr) {
+      throw std::runtime_error("GiftedExpressionJit: cannot create a cache directory in " + parent + ": " +
+                               std::strerror(errno));
+    }
+    return name.data();
+  }
+
+  /**
+   * @brief True if "path" is a directory (not a link to one) that belongs to
+   *        the effective user and only the user can write to; otherwise
+   *        false, with what is wrong in "problem".
+   **/
+  static bool isPrivateDirectory(const std::string &path, std::string *problem) {
+    const int fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0) {
+      *problem = std::string("cannot be opened: ") + std::strerror(errno);
+      return false;
+    }
+    struct stat status;
+    const bool statted = fstat(fd, &status) == 0;
+    close(fd);
+    if (!statted || !S_ISDIR(status.st_mode)) {
+      *problem = "is not a directory";
+      return false;
+    }
+    if (status.st_uid != geteuid()) {
+      *problem = "belongs to another user";
+      return false;
+    }
+    if ((status.st_mode & (S_IWGRP | S_IWOTH)) != 0) {
+      *problem = "is writable by others";
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * @brief What identifies the host's CPU for -march=native: its model name
+   *        and feature flags from /proc/cpuinfo, else the host name.
+   **/
+  static std::string HostCpu() {
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line, model, flags;
+    while (std::getline(cpuinfo, line) && (model.empty() || flags.empty())) {
+      if (model.empty() && line.compare(0, 10, "model name") == 0) model = line;
+      if (flags.empty() && (line.compare(0, 5, "flags") == 0 || line.compare(0, 8, "Features") == 0)) {
+        flags = line;
+      }
+    }
+    if (!model.empty() || !flags.empty()) {
+      std::ostringstream identity;
+      identity << model << " (flags " << std::hex << GiftedHashBytes(flags.data(), flags.size()) << ")";
+      return identity.str();
+    }
+    char host[256] = {0};
+    gethostname(host, sizeof(host) - 1);
+    return std::string("host ") + host;
+  }
+
+  static std::string DefaultCompiler() {
+    const char *compiler = std::getenv("GIFTED_JIT_CXX");
+    return compiler == nullptr || *compiler == '\0' ? "c++" : compiler;
+  }
+
+  static std::string EmitNode(const GiftedExpression &node,
+                              const std::vector<std::size_t> &columns,
+                              std::vector<GiftedBaseType::GiftedTypeId> *types,
+                              std::vector<std::int64_t> *literals) {
+    std::ostringstream code;
+    switch (node.getOperator()) {
+      case GiftedExpression::kColumn: {
+        std::size_t slot = 0;
+        while (columns[slot] != node.getColumn()) slot++;
+        if ((*types)[slot] != GiftedBaseType::_GiftedUnknownTypeId && (*types)[slot] != node.getType()) {
+          throw std::invalid_argument("GiftedExpressionJit: a column is used with two types");
+        }
+        (*types)[slot] = node.getType();
+        code << "static_cast<std::int64_t>(c" << slot << "[i])";
+        return code.str();
+      }
+      case GiftedExpression::kLiteral:
+        code << "l" << literals->size();
+        literals->push_back(node.getLiteral());
+        return code.str();
+      case GiftedExpression::kNot:
+        code << "static_cast<std::int64_t>(" << EmitNode(*node.getLeft(), columns, types, literals) << " == 0)";
+        return code.str();
+      default:
+        break;
+    }
+
+    const std::string left = EmitNode(*node.getLeft(), columns, types, literals);
+    const std::string right = EmitNode(*node.getRight(), columns, types, literals);
+    switch (node.getOperator()) {
+      case GiftedExpression::kAdd:
+      case GiftedExpression::kSubtract:
+      case GiftedExpression::kMultiply: {
+        // In unsigned arithmetic, so overflow wraps around as in Apply().
+        const char *op = node.getOperator() == GiftedExpression::kAdd ? " + "
+            : (node.getOperator() == GiftedExpression::kSubtract ? " - " : " * ");
+        code << "static_cast<std::int64_t>(static_cast<std::uint64_t>(" << left << ")" << op
+             << "static_cast<std::uint64_t>(" << right << "))";
+        return code.str();
+      }
+      case GiftedExpression::kAnd:
+        code << "((" << left << " != 0) & (" << right << " != 0))";
+        break;
+      case GiftedExpression::kOr:
+        code << "((" << left << " != 0) | (" << right << " != 0))";
+        break;
+      case GiftedExpression::kEqual: code << "(" << left << " == " << right << ")"; break;
+      case GiftedExpression::kNotEqual: code << "(" << left << " != " << right << ")"; break;
+      case GiftedExpression::kLessThan: code << "(" << left << " < " << right << ")"; break;
+      case GiftedExpression::kLessThanOrEqual: code << "(" << left << " <= " << right << ")"; break;
+      case GiftedExpression::kGreaterThan: code << "(" << left << " > " << right << ")"; break;
+      case GiftedExpression::kGreaterThanOrEqual: code << "(" << left << " >= " << right << ")"; break;
+      default:
+        throw std::invalid_argument("GiftedExpressionJit: unknown operator");
+    }
+    return "static_cast<std::int64_t>" + code.str();
+  }
+
+  static std::string ReadFile(const std::string &path) {
+    std::ifstream file(path.c_str(), std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  }
+
+  /**
+   * @brief Compile "source" into base.so (and keep it as base.cpp). Both are
+   *        written under temporary names and renamed into place, library
+   *        first, so other processes never see a partial library.
+   **/
+  void Build(const std::string &source, const std::string &base) {
+    if (base.find('\'') != std::string::npos || _compiler.find('\'') != std::string::npos) {
+      throw std::runtime_error("GiftedExpressionJit: quote in the compiler or cache path");
+    }
+    std::ostringstream suffix;
+    suffix << "." << getpid();
+    const std::string sourcePath = base + suffix.str() + ".cpp";
+    const std::string libraryPath = base + suffix.str() + ".so";
+    {
+      std::ofstream file(sourcePath.c_str(), std::ios::binary);
+      file << source;
+      if (!file) throw std::runtime_error("GiftedExpressionJit: cannot write " + sourcePath);
+    }
+    const std::string command = "'" + _compiler + "' -std=c++11 -O3 -march=native -fPIC -shared -o '" +
+                                libraryPath + "' '" + sourcePath + "' > /dev/null 2>&1";
+    if (std::system(command.c_str()) != 0) {
+      std::remove(sourcePath.c_str());
+      std::remove(libraryPath.c_str());
+      throw std::runtime_error("GiftedExpressionJit: compiling failed: " + command);
+    }
+    if (std::rename(libraryPath.c_str(), (base + ".so").c_str()) != 0 ||
+        std::rename(sourcePath.c_str(), (base + ".cpp").c_str()) != 0) {
+      std::remove(sourcePath.c_str());
+      std::remove(libraryPath.c_str());
+      throw std::runtime_error("GiftedExpressionJit: cannot store " + base + ".so");
+    }
+  }
+
+  const std::string _cacheDirectory;
+  const std::string _compiler;
+  const std::string _target;  // Compiler and CPU the kernels are built for.
+  std::mutex _mutex;
+  std::unordered_map<std::string, GiftedJitKernel> _kernels;
+  std::vector<void*> _handles;
+  std::size_t _numCompiled;
+};
+
+#endif  // GIFTED_TYPES_EXPRESSION_JIT_HPP_
@@ -0,0 +1,107 @@
+//
+//  ExpressionPredicate.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_TYPES_EXPRESSION_PREDICATE_HPP_
+#define GIFTED_TYPES_EXPRESSION_PREDICATE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "storage/ColumnVector.hpp"
+#include "storage/VectorBatch.hpp"
+#include "types/BatchPredicate.hpp"
+#include "types/Expression.hpp"
+#include "types/ExpressionJit.hpp"
+
+/**
+ * @brief A truth valued GiftedExpression as a filter's test. With a JIT, the
+ *        expression runs as its compiled kernel; without one, or if it does
+ *        not compile (no compiler, say), it is interpreted.
+ **/
+class GiftedExpressionPredicate : public GiftedBatchPredicate {
+public:
+  GiftedExpressionPredicate(std::unique_ptr<GiftedExpression> expression,
+                            GiftedExpressionJit *jit = nullptr)
+      : _expression(std::move(expression)),
+        _kernel(nullptr) {
+    if (_expression->getDomain() != GiftedExpression::kBoolean) {
+      throw std::invalid_argument("GiftedExpressionPredicate: the expression is not a predicate");
+    }
+    _expression->CollectColumns(&_columns);
+    _source = GiftedExpressionJit::GenerateSource(*_expression, &_literals);
+    if (jit != nullptr) {
+      try {
+        _kernel = jit->Compile(_source);
+      } catch (const std::runtime_error&) {
+        _kernel = nullptr;
+      }
+    }
+  }
+
+  /**
+   * @brief True if the expression runs compiled.
+   **/
+  bool isCompiled() const {return _kernel != nullptr;}
+
+  // The expression's shape (its kernel source), columns and literals.
+  std::string getCacheKey() const override {
+    std::string key = "expr:" + _source;
+    for (std::size_t c = 0; c < _columns.size(); c++) key += ":" + std::to_string(_columns[c]);
+    for (std::size_t l = 0; l < _literals.size(); l++) key += ":" + std::to_string(_literals[l]);
+    return key;
+  }
+
+  void Evaluate(const GiftedVectorBatch &batch, bool *result) override {
+    const std::size_t numRows = batch.getNumRows();
+    if (_kernel != nullptr) {
+      _columnValues.resize(_columns.size());
+      for (std::size_t c = 0; c < _columns.size(); c++) {
+        _columnValues[c] = batch.getColumn(_columns[c]).getValues();
+      }
+      CheckTypes(batch, *_expression);
+      _kernel(_columnValues.data(), _literals.data(), numRows, result);
+    } else {
+      _values.resize(numRows);
+      _expression->Evaluate(batch, _values.data());
+      for (std::size_t i = 0; i < numRows; i++) result[i] = _values[i] != 0;
+    }
+
+    for (std::size_t c = 0; c < _columns.size(); c++) {
+      const GiftedColumnVector &column = batch.getColumn(_columns[c]);
+      if (column.getValidityBitmap() == nullptr) continue;
+      for (std::size_t i = 0; i < numRows; i++) {
+        result[i] = result[i] && !column.isNull(i);
+      }
+    }
+  }
+
+private:
+  // The compiled kernel reads the columns as the types it was made for.
+  static void CheckTypes(const GiftedVectorBatch &batch, const GiftedExpression &node) {
+    if (node.getOperator() == GiftedExpression::kColumn) {
+      if (batch.getColumn(node.getColumn()).getTypeId() != node.getType()) {
+        throw std::invalid_argument("GiftedExpressionPredicate: column type differs from the expression's");
+      }
+      return;
+    }
+    if (node.getLeft() != nullptr) CheckTypes(batch, *node.getLeft());
+    if (node.getRight() != nullptr) CheckTypes(batch, *node.getRight());
+  }
+
+  std::unique_ptr<GiftedExpression> _expression;
+  std::vector<std::size_t> _columns;
+  std::vector<std::int64_t> _literals;
+  std::string _source;
+  GiftedJitKernel _kernel;
+  std::vector<const char*> _columnValues;
+  std::vector<std::int64_t> _values;
+};
+
+#endif  // GIFTED_TYPES_EXPRESSION_PREDICATE_HPP_
@@ -0,0 +1,194 @@
+//
+//  FixedWidthKernels.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_TYPES_FIXED_WIDTH_KERNELS_HPP_
+#define GIFTED_TYPES_FIXED_WIDTH_KERNELS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "types/HashFunctions.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief Tight loop that compares a packed vector of native values of type T
+ *        against a literal. Types whose raw form is just a native value use
+ *        this to override the generic (clone and UnMarshall per value)
+ *        VectorizedEqual/VectorizedLessThan; the loop has no calls or
+ *        branches, so the compiler vectorizes it.
+ **/
+template <typename T, class Compare>
+inline void GiftedFixedWidthCompare(const char* const vectorDataElements,
+                                    const std::size_t vectorLength,
+                                    const char* const rawLiteralData,
+                                    bool *result) {
+  T literal;
+  std::memcpy(&literal, rawLiteralData, sizeof(T));
+  const T *values = reinterpret_cast<const T*>(vectorDataElements);
+  Compare compare;
+  for (std::size_t i = 0; i < vectorLength; i++) {
+    result[i] = compare(values[i], literal);
+  }
+}
+
+/**
+ * @brief Parse a batch of text fields into packed native values of type T
+ *        (see GiftedBaseType::ParseVector).
+ **/
+template <typename T, bool (*Parse)(const char*, std::size_t, T*)>
+inline void GiftedFixedWidthParse(const char* const text,
+                                  const std::uint32_t* const fieldBegins,
+                                  const std::uint32_t* const fieldLengths,
+                                  const std::size_t vectorLength,
+                                  char *out,
+                                  bool *failed) {
+  T *values = reinterpret_cast<T*>(out);
+  for (std::size_t i = 0; i < vectorLength; i++) {
+    T value;
+    const bool ok = Parse(text + fieldBegins[i], fieldLengths[i], &value);
+    values[i] = ok ? value : T();
+    failed[i] = !ok;
+  }
+}
+
+/**
+ * @brief Format packed native values of type T as text (see
+ *        GiftedBaseType::FormatVector).
+ **/
+template <typename T, std::size_t (*Format)(T, char*)>
+inline std::size_t GiftedFixedWidthFormat(const char* const vectorDataElements,
+                                          const std::size_t vectorLength,
+                                          char *out,
+                                          std::uint32_t *textEnds) {
+  const T *values = reinterpret_cast<const T*>(vectorDataElements);
+  std::size_t written = 0;
+  for (std::size_t i = 0; i < vectorLength; i++) {
+    written += Format(values[i], out + written);
+    textEnds[i] = static_cast<std::uint32_t>(written);
+  }
+  return written;
+}
+
+/**
+ * @brief Hash packed native values of type T (see
+ *        GiftedBaseType::VectorizedHash). The values are widened to 64 bits,
+ *        so the loop has no calls and the compiler can vectorize it.
+ **/
+template <typename T>
+inline void GiftedFixedWidthHash(const char* const vectorDataElements,
+                                 const std::size_t vectorLength,
+                                 std::uint64_t *hashes) {
+  const T *values = reinterpret_cast<const T*>(vectorDataElements);
+  for (std::size_t i = 0; i < vectorLength; i++) {
+    hashes[i] = GiftedHashInt64(static_cast<std::uint64_t>(static_cast<std::int64_t>(values[i])));
+  }
+}
+
+inline std::uint32_t GiftedBigEndian(const std::uint32_t value) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  return value;
+#else
+  return __builtin_bswap32(value);
+#endif
+}
+
+inline std::uint64_t GiftedBigEndian(const std::uint64_t value) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  return value;
+#else
+  return __builtin_bswap64(value);
+#endif
+}
+
+/**
+ * @brief Normalized keys of packed signed integers of type T (see
+ *        GiftedBaseType::NormalizeKeys): flipping the sign bit makes the
+ *        order unsigned, and storing big endian makes it the byte order.
+ *        U is the unsigned type of the same width.
+ **/
+template <typename T, typename U>
+inline void GiftedFixedWidthNormalize(const char* const vectorDataElements,
+                                      const std::size_t vectorLength,
+                                      char *out) {
+  const T *values = reinterpret_cast<const T*>(vectorDataElements);
+  const U signBit = static_cast<U>(1) << (8 * sizeof(U) - 1);
+  for (std::size_t i = 0; i < vectorLength; i++) {
+    const U key = GiftedBigEndian(static_cast<U>(static_cast<U>(values[i]) ^ signBit));
+    std::memcpy(out + i * sizeof(U), &key, sizeof(U));
+  }
+}
+
+/**
+ * @brief Gather packed native values of type T at the given positions (see
+ *        GiftedBaseType::VectorizedGather). Unrolled by four so the loads
+ *        are independent and can be in flight together.
+ **/
+template <typename T>
+inline void GiftedFixedWidthGather(const char* const vectorDataElements,
+                                   const std::uint32_t* const positions,
+                                   const std::size_t numPositions,
+                                   char *out) {
+  const T *values = reinterpret_cast<const T*>(vectorDataElements);
+  T *gathered = reinterpret_cast<T*>(out);
+  std::size_t i = 0;
+  for (; i + 4 <= numPositions; i += 4) {
+    const T v0 = values[positions[i]];
+    const T v1 = values[positions[i + 1]];
+    const T v2 = values[positions[i + 2]];
+    const T v3 = values[positions[i + 3]];
+    gathered[i] = v0;
+    gathered[i + 1] = v1;
+    gathered[i + 2] = v2;
+    gathered[i + 3] = v3;
+  }
+  for (; i < numPositions; i++) {
+    gathered[i] = values[positions[i]];
+  }
+}
+
+#if defined(__AVX2__)
+// With AVX2, 32 and 64 bit values are fetched by the hardware gather.
+template <>
+inline void GiftedFixedWidthGather<std::int32_t>(const char* const vectorDataElements,
+                                                 const std::uint32_t* const positions,
+                                                 const std::size_t numPositions,
+                                                 char *out) {
+  const int *values = reinterpret_cast<const int*>(vectorDataElements);
+  std::int32_t *gathered = reinterpret_cast<std::int32_t*>(out);
+  std::size_t i = 0;
+  for (; i + 8 <= numPositions; i += 8) {
+    const __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(positions + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(gathered + i), _mm256_i32gather_epi32(values, index, 4));
+  }
+  for (; i < numPositions; i++) {
+    gathered[i] = values[positions[i]];
+  }
+}
+
+template <>
+inline void GiftedFixedWidthGather<std::int64_t>(const char* const vectorDataElements,
+                                                 const std::uint32_t* const positions,
+                                                 const std::size_t numPositions,
+                                                 char *out) {
+  const long long *values = reinterpret_cast<const long long*>(vectorDataElements);
+  std::int64_t *gathered = reinterpret_cast<std::int64_t*>(out);
+  std::size_t i = 0;
+  for (; i + 4 <= numPositions; i += 4) {
+    // Positions are unsigned; they are below 2^31 for any batch.
+    const __m128i index = _mm_loadu_si128(reinterpret_cast<const __m128i*>(positions + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(gathered + i), _mm256_i32gather_epi64(values, index, 8));
+  }
+  for (; i < numPositions; i++) {
+    gathered[i] = values[positions[i]];
+  }
+}
+#endif  // __AVX2__
+
+#endif  // GIFTED_TYPES_FIXED_WIDTH_KERNELS_HPP_
@@ -0,0 +1,228 @@
+//
+//  FusedPredicate.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_TYPES_FUSED_PREDICATE_HPP_
+#define GIFTED_TYPES_FUSED_PREDICATE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+#include "storage/ColumnVector.hpp"
+#include "storage/VectorBatch.hpp"
+#include "types/BaseType.hpp"
+#include "types/BatchPredicate.hpp"
+
+/**
+ * @brief Fused kernel: result[i] = left[i] LeftCompare leftLiteral, combined
+ *        (AND if kAnd, else OR) with right[i] RightCompare rightLiteral.
+ *        Both tests and the connective are in one loop with no calls or
+ *        branches, so the compiler vectorizes it and no intermediate result
+ *        is written out.
+ **/
+template <typename L, class LeftCompare, typename R, class RightCompare, bool kAnd>
+inline void GiftedFusedCompareKernel(const char* const leftValues,
+                                     const char* const rightValues,
+                                     const char* const leftLiteral,
+                                     const char* const rightLiteral,
+                                     const std::size_t vectorLength,
+                                     bool *result) {
+  L leftBound;
+  R rightBound;
+  std::memcpy(&leftBound, leftLiteral, sizeof(L));
+  std::memcpy(&rightBound, rightLiteral, sizeof(R));
+  const L *left = reinterpret_cast<const L*>(leftValues);
+  const R *right = reinterpret_cast<const R*>(rightValues);
+  LeftCompare leftCompare;
+  RightCompare rightCompare;
+  for (std::size_t i = 0; i < vectorLength; i++) {
+    const bool leftPasses = leftCompare(left[i], leftBound);
+    const bool rightPasses = rightCompare(right[i], rightBound);
+    result[i] = kAnd ? (leftPasses & rightPasses) : (leftPasses | rightPasses);
+  }
+}
+
+typedef void (*GiftedFusedKernel)(const char*, const char*, const char*, const char*, std::size_t, bool*);
+
+/**
+ * @brief Two comparisons with literals, on one or two columns, joined by
+ *        AND or OR, e.g. "a >= 10 AND a < 20" or "a = 3 OR b > 7", run as
+ *        one fused kernel.
+ *
+ *        The kernels are template instances for every pair of fixed width
+ *        integer representations (int64, int32 and decimal) and of
+ *        comparisons, with either connective, all compiled in; the
+ *        constructor picks the instance, so Evaluate() is one call per
+ *        batch with no interpretation. Each literal is in its column's raw
+ *        form (cast it first). Predicates this library has no kernel for
+ *        (see Supports()) go through two filters instead.
+ **/
+class GiftedFusedPredicate : public GiftedBatchPredicate {
+public:
+  enum ComparisonId {
+    kEqual = 0,
+    kNotEqual,
+    kLessThan,
+    kLessThanOrEqual,
+    kGreaterThan,
+    kGreaterThanOrEqual
+  };
+
+  enum ConnectiveId {
+    kAnd = 0,
+    kOr
+  };
+
+  /**
+   * @brief True if there is a fused kernel for columns of these types.
+   **/
+  static bool Supports(const GiftedBaseType::GiftedTypeId leftType,
+                       const GiftedBaseType::GiftedTypeId rightType) {
+    return Width(leftType) != 0 && Width(rightType) != 0;
+  }
+
+  /**
+   * @exception std::invalid_argument if Supports() is false for the types.
+   **/
+  GiftedFusedPredicate(const std::size_t leftColumn,
+                       const GiftedBaseType::GiftedTypeId leftType,
+                       const ComparisonId leftComparison,
+                       const char* const leftLiteral,
+                       const ConnectiveId connective,
+                       const std::size_t rightColumn,
+                       const GiftedBaseType::GiftedTypeId rightType,
+                       const ComparisonId rightComparison,
+                       const char* const rightLiteral)
+      : _leftColumn(leftColumn),
+        _rightColumn(rightColumn),
+        _leftType(leftType),
+        _rightType(rightType),
+        _leftComparison(leftComparison),
+        _rightComparison(rightComparison),
+        _connective(connective),
+        _kernel(nullptr) {
+    if (!Supports(leftType, rightType)) {
+      throw std::invalid_argument("GiftedFusedPredicate: no fused kernel for these types");
+    }
+    std::memcpy(_leftLiteral, leftLiteral, Width(leftType));
+    std::memcpy(_rightLiteral, rightLiteral, Width(rightType));
+    const bool isAnd = connective == kAnd;
+    if (Width(leftType) == sizeof(std::int64_t)) {
+      _kernel = PickLeftComparison<std::int64_t>(leftComparison, rightType, rightComparison, isAnd);
+    } else {
+      _kernel = PickLeftComparison<std::int32_t>(leftComparison, rightType, rightComparison, isAnd);
+    }
+  }
+
+  std::size_t getLeftColumn() const {return _leftColumn;}
+  std::size_t getRightColumn() const {return _rightColumn;}
+
+  std::string getCacheKey() const override {
+    std::string key = "fused:" + std::to_string(_leftColumn) + ":" + std::to_string(static_cast<int>(_leftType)) +
+                      ":" + std::to_string(static_cast<int>(_leftComparison)) + ":" +
+                      std::to_string(static_cast<int>(_connective)) + ":" + std::to_string(_rightColumn) + ":" +
+                      std::to_string(static_cast<int>(_rightType)) + ":" +
+                      std::to_string(static_cast<int>(_rightComparison)) + ":";
+    key.append(_leftLiteral, Width(_leftType));
+    return key.append(_rightLiteral, Width(_rightType));
+  }
+
+  void Evaluate(const GiftedVectorBatch &batch, bool *result) override {
+    const GiftedColumnVector &left = batch.getColumn(_leftColumn);
+    const GiftedColumnVector &right = batch.getColumn(_rightColumn);
+    if (left.getTypeId() != _leftType || right.getTypeId() != _rightType) {
+      throw std::invalid_argument("GiftedFusedPredicate: column types differ from the predicate's");
+    }
+    const std::size_t numRows = batch.getNumRows();
+    _kernel(left.getValues(), right.getValues(), _leftLiteral, _rightLiteral, numRows, result);
+    ClearNulls(left, numRows, result);
+    if (_rightColumn != _leftColumn) ClearNulls(right, numRows, result);
+  }
+
+private:
+  // Bytes in the raw form of the types with fused kernels, 0 for the rest.
+  static std::size_t Width(const GiftedBaseType::GiftedTypeId type) {
+    switch (type) {
+      case GiftedBaseType::_GiftedIntTypeId:
+      case GiftedBaseType::_GiftedDecimalTypeId:
+        return sizeof(std::int64_t);
+      case GiftedBaseType::_GiftedInt32TypeId:
+        return sizeof(std::int32_t);
+      default:
+        return 0;
+    }
+  }
+
+  static void ClearNulls(const GiftedColumnVector &column, const std::size_t numRows, bool *result) {
+    if (column.getValidityBitmap() == nullptr) return;
+    for (std::size_t i = 0; i < numRows; i++) {
+      result[i] = result[i] && !column.isNull(i);
+    }
+  }
+
+  // The kernel is picked one template argument at a time, so every
+  // combination is instantiated here at compile time.
+  template <typename L>
+  static GiftedFusedKernel PickLeftComparison(const ComparisonId leftComparison,
+                                              const GiftedBaseType::GiftedTypeId rightType,
+                                              const ComparisonId rightComparison,
+                                              const bool isAnd) {
+    switch (leftComparison) {
+      case kEqual: return PickRightType<L, std::equal_to<L> >(rightType, rightComparison, isAnd);
+      case kNotEqual: return PickRightType<L, std::not_equal_to<L> >(rightType, rightComparison, isAnd);
+      case kLessThan: return PickRightType<L, std::less<L> >(rightType, rightComparison, isAnd);
+      case kLessThanOrEqual: return PickRightType<L, std::less_equal<L> >(rightType, rightComparison, isAnd);
+      case kGreaterThan: return PickRightType<L, std::greater<L> >(rightType, rightComparison, isAnd);
+      case kGreaterThanOrEqual: return PickRightType<L, std::greater_equal<L> >(rightType, rightComparison, isAnd);
+    }
+    throw std::invalid_argument("GiftedFusedPredicate: unknown comparison");
+  }
+
+  template <typename L, class LeftCompare>
+  static GiftedFusedKernel PickRightType(const GiftedBaseType::GiftedTypeId rightType,
+                                         const ComparisonId rightComparison,
+                                         const bool isAnd) {
+    if (Width(rightType) == sizeof(std::int64_t)) {
+      return PickRightComparison<L, LeftCompare, std::int64_t>(rightComparison, isAnd);
+    }
+    return PickRightComparison<L, LeftCompare, std::int32_t>(rightComparison, isAnd);
+  }
+
+  template <typename L, class LeftCompare, typename R>
+  static GiftedFusedKernel PickRightComparison(const ComparisonId rightComparison, const bool isAnd) {
+    switch (rightComparison) {
+      case kEqual: return PickConnective<L, LeftCompare, R, std::equal_to<R> >(isAnd);
+      case kNotEqual: return PickConnective<L, LeftCompare, R, std::not_equal_to<R> >(isAnd);
+      case kLessThan: return PickConnective<L, LeftCompare, R, std::less<R> >(isAnd);
+      case kLessThanOrEqual: return PickConnective<L, LeftCompare, R, std::less_equal<R> >(isAnd);
+      case kGreaterThan: return PickConnective<L, LeftCompare, R, std::greater<R> >(isAnd);
+      case kGreaterThanOrEqual: return PickConnective<L, LeftCompare, R, std::greater_equal<R> >(isAnd);
+    }
+    throw std::invalid_argument("GiftedFusedPredicate: unknown comparison");
+  }
+
+  template <typename L, class LeftCompare, typename R, class RightCompare>
+  static GiftedFusedKernel PickConnective(const bool isAnd) {
+    return isAnd ? &GiftedFusedCompareKernel<L, LeftCompare, R, RightCompare, true>
+                 : &GiftedFusedCompareKernel<L, LeftCompare, R, RightCompare, false>;
+  }
+
+  const std::size_t _leftColumn;
+  const std::size_t _rightColumn;
+  const GiftedBaseType::GiftedTypeId _leftType;
+  const GiftedBaseType::GiftedTypeId _rightType;
+  const ComparisonId _leftComparison;
+  const ComparisonId _rightComparison;
+  const ConnectiveId _connective;
+  GiftedFusedKernel _kernel;
+  char _leftLiteral[sizeof(std::int64_t)];
+  char _rightLiteral[sizeof(std::int64_t)];
+};
+
+#endif  // GIFTED_TYPES_FUSED_PREDICATE_HPP_
@@ -0,0 +1,48 @@
+//
+//  HashFunctions.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_TYPES_HASH_FUNCTIONS_HPP_
+#define GIFTED_TYPES_HASH_FUNCTIONS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @brief Hash a 64 bit value (the MurmurHash3 finalizer). Every input bit
+ *        affects every output bit, so both the low bits (hash table
+ *        buckets, radix partitions) and the high bits (Bloom filter blocks)
+ *        can be used.
+ **/
+inline std::uint64_t GiftedHashInt64(std::uint64_t value) {
+  value ^= value >> 33;
+  value *= 0xff51afd7ed558ccdULL;
+  value ^= value >> 33;
+  value *= 0xc4ceb9fe1a85ec53ULL;
+  value ^= value >> 33;
+  return value;
+}
+
+/**
+ * @brief Hash a string of bytes, eight at a time.
+ **/
+inline std::uint64_t GiftedHashBytes(const char *data, const std::size_t length) {
+  std::uint64_t hash = 0x9e3779b97f4a7c15ULL ^ length;
+  std::size_t i = 0;
+  for (; i + 8 <= length; i += 8) {
+    std::uint64_t word;
+    std::memcpy(&word, data + i, 8);
+    hash = (hash ^ GiftedHashInt64(word)) * 0x9e3779b97f4a7c15ULL;
+  }
+  if (i < length) {
+    std::uint64_t word = 0;
+    std::memcpy(&word, data + i, length - i);
+    hash = (hash ^ GiftedHashInt64(word)) * 0x9e3779b97f4a7c15ULL;
+  }
+  return GiftedHashInt64(hash);
+}
+
+#endif  // GIFTED_TYPES_HASH_FUNCTIONS_HPP_
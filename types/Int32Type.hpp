@@ -0,0 +1,150 @@
+//
+//  Int32Type.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_TYPES_INT32_TYPE_HPP_
+#define GIFTED_TYPES_INT32_TYPE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <stdexcept>
+
+#include "types/BaseType.hpp"
+#include "types/CastKernels.hpp"
+#include "types/DecimalType.hpp"
+#include "types/FixedWidthKernels.hpp"
+#include "types/TextConversions.hpp"
+#include "types/TypeRegistry.hpp"
+
+/**
+ * @brief The 32-bit IntegerType.
+ **/
+class GiftedInt32Type : public GiftedBaseType {
+public:
+
+  GiftedInt32Type():_value(0) {};
+  ~GiftedInt32Type() {};
+  virtual GiftedBaseType* Clone () const override {return new GiftedInt32Type;};
+
+  GiftedTypeId myType() const override {return _GiftedInt32TypeId;}
+
+  std::size_t getLength() override {
+    return sizeof(std::int32_t);
+  }
+
+  void UnMarshall(const char* const payload, const std::size_t length) override {
+    _value = *reinterpret_cast<const std::int32_t*>(payload);
+  }
+
+  void Equal(const GiftedBaseType* const right, bool &result) const override {
+    result = (_value == checkedCast(right)->_value);
+  }
+
+  void LessThan(const GiftedBaseType* const right, bool &result) const override {
+    result = (_value < checkedCast(right)->_value);
+  }
+
+  void AddToLeft(const GiftedBaseType* const right) override {
+    _value += checkedCast(right)->_value;
+  }
+
+  void Print(std::ostream& os) const override {
+    os << _value;
+  }
+
+  void VectorizedEqual(const std::size_t elementLength,
+                       const char* const vectorDataElements,
+                       const std::size_t vectorLength,
+                       const char* const rawLiteralData,
+                       bool *result) override {
+    GiftedFixedWidthCompare<std::int32_t, std::equal_to<std::int32_t> >(
+        vectorDataElements, vectorLength, rawLiteralData, result);
+  }
+
+  void VectorizedLessThan(const std::size_t elementLength,
+                          const char* const vectorDataElements,
+                          const std::size_t vectorLength,
+                          const char* const rawLiteralData,
+                          bool *result) override {
+    GiftedFixedWidthCompare<std::int32_t, std::less<std::int32_t> >(
+        vectorDataElements, vectorLength, rawLiteralData, result);
+  }
+
+  void ParseVector(const char* const text,
+                   const std::uint32_t* const fieldBegins,
+                   const std::uint32_t* const fieldLengths,
+                   const std::size_t vectorLength,
+                   char *out,
+                   bool *failed) override {
+    GiftedFixedWidthParse<std::int32_t, &GiftedParseInt32>(
+        text, fieldBegins, fieldLengths, vectorLength, out, failed);
+  }
+
+  std::size_t FormatVector(const std::size_t elementLength,
+                           const char* const vectorDataElements,
+                           const std::size_t vectorLength,
+                           char *out,
+                           std::uint32_t *textEnds) override {
+    return GiftedFixedWidthFormat<std::int32_t, &GiftedFormatInt32>(
+        vectorDataElements, vectorLength, out, textEnds);
+  }
+
+  void VectorizedGather(const std::size_t elementLength,
+                        const char* const vectorDataElements,
+                        const std::uint32_t* const positions,
+                        const std::size_t numPositions,
+                        char *out) override {
+    GiftedFixedWidthGather<std::int32_t>(vectorDataElements, positions, numPositions, out);
+  }
+
+  void VectorizedHash(const std::size_t elementLength,
+                      const char* const vectorDataElements,
+                      const std::size_t vectorLength,
+                      std::uint64_t *hashes) override {
+    GiftedFixedWidthHash<std::int32_t>(vectorDataElements, vectorLength, hashes);
+  }
+
+  void NormalizeKeys(const std::size_t elementLength,
+                     const char* const vectorDataElements,
+                     const std::size_t vectorLength,
+                     char *out) override {
+    GiftedFixedWidthNormalize<std::int32_t, std::uint32_t>(vectorDataElements, vectorLength, out);
+  }
+
+  /**
+   * @brief Register the casts out of this type.
+   **/
+  static void RegisterCasts(GiftedTypeRegistry *registry) {
+    registry->RegisterCast(
+        _GiftedInt32TypeId, _GiftedIntTypeId,
+        &GiftedFixedCastKernel<std::int32_t, std::int64_t,
+                               GiftedWideningConvert<std::int32_t, std::int64_t> >,
+        true);
+    registry->RegisterCast(
+        _GiftedInt32TypeId, _GiftedDecimalTypeId,
+        &GiftedFixedCastKernel<std::int32_t, std::int64_t,
+                               GiftedScaleUpConvert<std::int32_t, GiftedDecimalType::kScale> >,
+        true);
+    registry->RegisterCast(
+        _GiftedInt32TypeId, _GiftedVarCharTypeId,
+        &GiftedFormatCastKernel<std::int32_t, &GiftedFormatInt32>,
+        false);
+  }
+
+protected:
+  std::int32_t _value;
+
+private:
+  static const GiftedInt32Type* checkedCast(const GiftedBaseType* const right) {
+    if (right->myType() != _GiftedInt32TypeId) {
+      throw std::invalid_argument("GiftedInt32Type: operand type mismatch, cast first");
+    }
+    return static_cast<const GiftedInt32Type*>(right);
+  }
+};
+
+#endif  // GIFTED_TYPES_INT32_TYPE_HPP_
@@ -0,0 +1,166 @@
+//
+//  IntegerType.hpp
+//
+//  Created by Jignesh Patel on 7/4/16.
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_TYPES_INTEGER_TYPE_HPP_
+#define GIFTED_TYPES_INTEGER_TYPE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <stdexcept>
+
+#include "types/BaseType.hpp"
+#include "types/CastKernels.hpp"
+#include "types/DecimalType.hpp"
+#include "types/FixedWidthKernels.hpp"
+#include "types/TextConversions.hpp"
+#include "types/TypeRegistry.hpp"
+
+/**
+ * @brief The IntegerType.
+ **/
+class GiftedIntegerType : public GiftedBaseType {
+public:
+
+  // Cover the basics ... constructor, desctuctor, and clone function.
+  GiftedIntegerType():_value(0) {};
+  ~GiftedIntegerType() {};
+  virtual GiftedBaseType* Clone () const override {return new GiftedIntegerType;};
+
+  GiftedTypeId myType() const override {return _GiftedIntTypeId;}
+
+  std::size_t getLength() override {
+    return sizeof(std::int64_t);
+  }
+
+  void UnMarshall(const char* const payload, const std::size_t length) override {
+    _value = *reinterpret_cast<const std::int64_t*>(payload);
+    return;
+  }
+
+  // Define the bare minimum functions.
+  // Mixed type operands have to be cast to a common type first, which the
+  // operator dispatch does once per batch (see GiftedVectorizedComparison).
+  virtual void Equal(const GiftedBaseType* const right, bool &result) const override {
+    if (right->myType() == _GiftedIntTypeId)
+      result = (_value == dynamic_cast<const GiftedIntegerType*>(right)->_value);
+    else
+      throw std::invalid_argument("GiftedIntegerType: operand type mismatch, cast first");
+  }
+
+  void LessThan(const GiftedBaseType* const right, bool &result) const override {
+    if (right->myType() == _GiftedIntTypeId) {
+      result = (_value < dynamic_cast<const GiftedIntegerType*>(right)->_value);
+    } else {
+      throw std::invalid_argument("GiftedIntegerType: operand type mismatch, cast first");
+    }
+  }
+
+  void AddToLeft(const GiftedBaseType* const right) override {
+    if (right->myType() == _GiftedIntTypeId) {
+      _value += dynamic_cast<const GiftedIntegerType*>(right)->_value;
+    } else {
+      throw std::invalid_argument("GiftedIntegerType: operand type mismatch, cast first");
+    }
+  }
+
+  virtual void Print(std::ostream& os) const override {
+    os << _value;
+  }
+
+  // Can also have special function only for this type ...
+  void Increment() {_value++;}
+
+  // Now here we can have a specialized highly-tuned version of VectorizedEqual
+  void VectorizedEqual(const std::size_t elementLength,
+                       const char* const vectorDataElements,
+                       const std::size_t vectorLength,
+                       const char* const rawLiteralData,
+                       bool *result) override {
+    GiftedFixedWidthCompare<std::int64_t, std::equal_to<std::int64_t> >(
+        vectorDataElements, vectorLength, rawLiteralData, result);
+  }
+
+  void VectorizedLessThan(const std::size_t elementLength,
+                          const char* const vectorDataElements,
+                          const std::size_t vectorLength,
+                          const char* const rawLiteralData,
+                          bool *result) override {
+    GiftedFixedWidthCompare<std::int64_t, std::less<std::int64_t> >(
+        vectorDataElements, vectorLength, rawLiteralData, result);
+  }
+
+  // Uses the SWAR parser, eight digits at a time.
+  void ParseVector(const char* const text,
+                   const std::uint32_t* const fieldBegins,
+                   const std::uint32_t* const fieldLengths,
+                   const std::size_t vectorLength,
+                   char *out,
+                   bool *failed) override {
+    GiftedFixedWidthParse<std::int64_t, &GiftedParseInt64>(
+        text, fieldBegins, fieldLengths, vectorLength, out, failed);
+  }
+
+  std::size_t FormatVector(const std::size_t elementLength,
+                           const char* const vectorDataElements,
+                           const std::size_t vectorLength,
+                           char *out,
+                           std::uint32_t *textEnds) override {
+    return GiftedFixedWidthFormat<std::int64_t, &GiftedFormatInt64>(
+        vectorDataElements, vectorLength, out, textEnds);
+  }
+
+  void VectorizedGather(const std::size_t elementLength,
+                        const char* const vectorDataElements,
+                        const std::uint32_t* const positions,
+                        const std::size_t numPositions,
+                        char *out) override {
+    GiftedFixedWidthGather<std::int64_t>(vectorDataElements, positions, numPositions, out);
+  }
+
+  void VectorizedHash(const std::size_t elementLength,
+                      const char* const vectorDataElements,
+                      const std::size_t vectorLength,
+                      std::uint64_t *hashes) override {
+    GiftedFixedWidthHash<std::int64_t>(vectorDataElements, vectorLength, hashes);
+  }
+
+  void NormalizeKeys(const std::size_t elementLength,
+                     const char* const vectorDataElements,
+                     const std::size_t vectorLength,
+                     char *out) override {
+    GiftedFixedWidthNormalize<std::int64_t, std::uint64_t>(vectorDataElements, vectorLength, out);
+  }
+
+  /**
+   * @brief Register the casts out of this type.
+   **/
+  static void RegisterCasts(GiftedTypeRegistry *registry) {
+    registry->RegisterCast(
+        _GiftedIntTypeId, _GiftedInt32TypeId,
+        &GiftedFixedCastKernel<std::int64_t, std::int32_t,
+                               GiftedNarrowingConvert<std::int64_t, std::int32_t> >,
+        false);
+    // Implicit, though scaling up fails for |value| > INT64_MAX / kScale: such
+    // a value is beyond every decimal, and comparisons settle it by its sign.
+    registry->RegisterCast(
+        _GiftedIntTypeId, _GiftedDecimalTypeId,
+        &GiftedFixedCastKernel<std::int64_t, std::int64_t,
+                               GiftedScaleUpConvert<std::int64_t, GiftedDecimalType::kScale> >,
+        true);
+    registry->RegisterCast(
+        _GiftedIntTypeId, _GiftedVarCharTypeId,
+        &GiftedFormatCastKernel<std::int64_t, &GiftedFormatInt64>,
+        false);
+  }
+
+protected:
+  std::int64_t _value; // Value for the integer type
+};
+
+#endif  // GIFTED_TYPES_INTEGER_TYPE_HPP_
@@ -0,0 +1,156 @@
+//
+//  TextConversions.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_TYPES_TEXT_CONVERSIONS_HPP_
+#define GIFTED_TYPES_TEXT_CONVERSIONS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+/**
+ * @brief Longest text produced by any of the Gifted*Format functions.
+ **/
+static const std::size_t kGiftedMaxFormattedLength = 32;
+
+/**
+ * @brief Convert exactly eight ASCII digits (the first one most significant)
+ *        to their value with a handful of 64-bit operations (SWAR) instead of
+ *        a multiply per digit.
+ *
+ * @return false if any of the eight characters is not a digit.
+ **/
+inline bool GiftedParseEightDigits(const char *text, std::uint64_t *value) {
+  std::uint64_t chunk;
+  std::memcpy(&chunk, text, sizeof(chunk));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  chunk = __builtin_bswap64(chunk);
+#endif
+  // Every byte must be in ['0', '9'].
+  if ((((chunk & 0xF0F0F0F0F0F0F0F0ULL) |
+        (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) !=
+       0x3333333333333333ULL)) {
+    return false;
+  }
+  // Combine neighbouring digits, then pairs, then quads.
+  chunk = ((chunk & 0x0F0F0F0F0F0F0F0FULL) * 2561) >> 8;
+  chunk = ((chunk & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+  *value = ((chunk & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32;
+  return true;
+}
+
+/**
+ * @brief Parse an optionally signed decimal integer that spans all of
+ *        [text, text+length). Digits are consumed eight at a time with
+ *        GiftedParseEightDigits.
+ *
+ * @return false if the text is not an integer or does not fit in 64 bits.
+ **/
+inline bool GiftedParseInt64(const char *text, std::size_t length, std::int64_t *value) {
+  bool negative = false;
+  if (length > 0 && (*text == '-' || *text == '+')) {
+    negative = (*text == '-');
+    ++text;
+    --length;
+  }
+  // Up to 19 digits always fit in 64 unsigned bits; skip leading zeros so
+  // that only longer numbers are rejected.
+  while (length > 19 && *text == '0') {
+    ++text;
+    --length;
+  }
+  if (length == 0 || length > 19) return false;
+
+  std::uint64_t magnitude = 0;
+  std::uint64_t eight;
+  while (length >= 8) {
+    if (!GiftedParseEightDigits(text, &eight)) return false;
+    magnitude = magnitude * 100000000ULL + eight;
+    text += 8;
+    length -= 8;
+  }
+  if (length > 0) {
+    // Left pad the tail with '0's to a full eight digits.
+    char padded[8] = {'0', '0', '0', '0', '0', '0', '0', '0'};
+    std::memcpy(padded + 8 - length, text, length);
+    if (!GiftedParseEightDigits(padded, &eight)) return false;
+    static const std::uint64_t kPowersOfTen[8] =
+        {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000};
+    magnitude = magnitude * kPowersOfTen[length] + eight;
+  }
+
+  const std::uint64_t limit =
+      static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max()) + (negative ? 1 : 0);
+  if (magnitude > limit) return false;
+  *value = negative ? static_cast<std::int64_t>(0 - magnitude) : static_cast<std::int64_t>(magnitude);
+  return true;
+}
+
+inline bool GiftedParseInt32(const char *text, const std::size_t length, std::int32_t *value) {
+  std::int64_t wide;
+  if (!GiftedParseInt64(text, length, &wide)) return false;
+  if (wide < std::numeric_limits<std::int32_t>::min() ||
+      wide > std::numeric_limits<std::int32_t>::max()) return false;
+  *value = static_cast<std::int32_t>(wide);
+  return true;
+}
+
+/**
+ * @brief Number of decimal digits in "value".
+ **/
+inline std::size_t GiftedCountDigits(const std::uint64_t value) {
+  std::size_t digits = 1;
+  std::uint64_t bound = 10;
+  while (digits < 20 && value >= bound) {
+    ++digits;
+    bound *= 10;
+  }
+  return digits;
+}
+
+/**
+ * @brief Write the decimal form of "value" to "buffer", which must have room
+ *        for kGiftedMaxFormattedLength characters. No terminator is written.
+ *        The length is worked out first, so digits are written in place two
+ *        at a time from a pair table, halving the number of divisions.
+ *
+ * @return The number of characters written.
+ **/
+inline std::size_t GiftedFormatInt64(const std::int64_t value, char *buffer) {
+  static const char kDigitPairs[] =
+      "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+      "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+      "8081828384858687888990919293949596979899";
+
+  std::uint64_t magnitude = value < 0 ? 0 - static_cast<std::uint64_t>(value)
+                                      : static_cast<std::uint64_t>(value);
+  std::size_t length = 0;
+  if (value < 0) buffer[length++] = '-';
+  length += GiftedCountDigits(magnitude);
+
+  char *out = buffer + length;
+  while (magnitude >= 100) {
+    const std::size_t pair = static_cast<std::size_t>(magnitude % 100) * 2;
+    magnitude /= 100;
+    *--out = kDigitPairs[pair + 1];
+    *--out = kDigitPairs[pair];
+  }
+  if (magnitude >= 10) {
+    const std::size_t pair = static_cast<std::size_t>(magnitude) * 2;
+    *--out = kDigitPairs[pair + 1];
+    *--out = kDigitPairs[pair];
+  } else {
+    *--out = static_cast<char>('0' + magnitude);
+  }
+  return length;
+}
+
+inline std::size_t GiftedFormatInt32(const std::int32_t value, char *buffer) {
+  return GiftedFormatInt64(value, buffer);
+}
+
+#endif  // GIFTED_TYPES_TEXT_CONVERSIONS_HPP_
@@ -0,0 +1,372 @@
+//
+//  TypeRegistry.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_TYPES_TYPE_REGISTRY_HPP_
+#define GIFTED_TYPES_TYPE_REGISTRY_HPP_
+
+#include <dlfcn.h>
+
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "types/BaseType.hpp"
+#include "types/CastKernels.hpp"
+
+class GiftedTypeRegistry;
+
+/**
+ * @brief A type plugin is a shared object that exports the two C symbols
+ *        below. The loader checks the ABI version first and then calls the
+ *        entry point, which registers the plugin's types with the registry
+ *        that is passed in (plugins must not use their own copy of
+ *        GiftedTypeRegistry::Instance()).
+ **/
+#define GIFTED_PLUGIN_ABI_VERSION 1
+#define GIFTED_PLUGIN_ABI_SYMBOL "GiftedPluginAbiVersion"
+#define GIFTED_PLUGIN_ENTRY_SYMBOL "GiftedRegisterTypes"
+
+extern "C" {
+typedef int (*GiftedPluginAbiVersionFn)();
+typedef void (*GiftedPluginEntryFn)(GiftedTypeRegistry *registry);
+}
+
+/**
+ * @brief Convenience base for types that are not in the built-in enum. The
+ *        registry hands out the id when the type is registered, and every
+ *        instance reports it through myType().
+ **/
+template <class Derived>
+class GiftedDynamicType : public GiftedBaseType {
+public:
+  GiftedTypeId myType() const override {return typeId;}
+
+  static GiftedTypeId typeId; // Set by GiftedTypeRegistry::RegisterDynamicType.
+};
+
+template <class Derived>
+GiftedBaseType::GiftedTypeId GiftedDynamicType<Derived>::typeId =
+    GiftedBaseType::_GiftedUnknownTypeId;
+
+/**
+ * @brief Registry of all the types known to the system, keyed by both name
+ *        and type id.
+ *
+ *        Types are registered (and plugins loaded) at startup, after which
+ *        Freeze() is called. From then on the registry is read-only: lookups
+ *        by id are a single array index and are safe from any thread, so an
+ *        operator can resolve the type (and hence its batch kernels) once
+ *        when it is set up and not pay anything per batch.
+ **/
+class GiftedTypeRegistry {
+public:
+
+  /**
+   * @brief Everything the registry knows about one type.
+   **/
+  struct Entry {
+    GiftedBaseType::GiftedTypeId id;
+    std::string name;
+    std::size_t length; // 0 for variable length types.
+    std::unique_ptr<GiftedBaseType> prototype; // Factory and batch kernels.
+  };
+
+  GiftedTypeRegistry()
+      : _nextDynamicId(GiftedBaseType::_GiftedNumBuiltinTypeIds),
+        _frozen(false) {}
+
+  // The shared objects are never closed as the prototypes live in them.
+  ~GiftedTypeRegistry() {}
+
+  /**
+   * @brief The process wide registry.
+   **/
+  static GiftedTypeRegistry& Instance() {
+    static GiftedTypeRegistry instance;
+    return instance;
+  }
+
+  /**
+   * @brief Register a type. The registry takes ownership of the prototype,
+   *        which is used to Clone() new instances and run batch kernels.
+   *        The type id is the one reported by prototype->myType().
+   *
+   * @return The id of the registered type.
+   **/
+  GiftedBaseType::GiftedTypeId RegisterType(const std::string &name,
+                                            GiftedBaseType *prototype) {
+    std::unique_ptr<GiftedBaseType> owned(prototype);
+    if (_frozen) {
+      throw std::logic_error("GiftedTypeRegistry: registry is frozen, cannot add " + name);
+    }
+    const GiftedBaseType::GiftedTypeId id = owned->myType();
+    if (id == GiftedBaseType::_GiftedUnknownTypeId) {
+      throw std::invalid_argument("GiftedTypeRegistry: type " + name + " has no type id");
+    }
+    if (_nameToId.count(name) != 0 || getEntry(id) != nullptr) {
+      throw std::invalid_argument("GiftedTypeRegistry: type " + name + " registered twice");
+    }
+
+    std::unique_ptr<Entry> entry(new Entry);
+    entry->id = id;
+    entry->name = name;
+    entry->length = owned->getLength();
+    entry->prototype = std::move(owned);
+
+    if (static_cast<std::size_t>(id) >= _entries.size()) {
+      _entries.resize(id + 1);
+    }
+    _entries[id] = std::move(entry);
+    _nameToId[name] = id;
+    return id;
+  }
+
+  /**
+   * @brief Register a GiftedDynamicType, allocating a fresh type id for it.
+   *        The id is only taken if the registration succeeds.
+   **/
+  template <class T>
+  GiftedBaseType::GiftedTypeId RegisterDynamicType(const std::string &name) {
+    if (T::typeId != GiftedBaseType::_GiftedUnknownTypeId) {
+      return RegisterType(name, new T);
+    }
+    T::typeId = static_cast<GiftedBaseType::GiftedTypeId>(_nextDynamicId);
+    try {
+      RegisterType(name, new T);
+    } catch (...) {
+      T::typeId = GiftedBaseType::_GiftedUnknownTypeId;
+      throw;
+    }
+    return static_cast<GiftedBaseType::GiftedTypeId>(_nextDynamicId++);
+  }
+
+  /**
+   * @brief Register a batch cast kernel between two types. Types register the
+   *        casts out of themselves next to the type itself (see e.g.
+   *        GiftedInt32Type::RegisterCasts); both ends must be registered by
+   *        the time Freeze() is called.
+   *
+   * @param implicit True if the cast is lossless and may be inserted by the
+   *        operator dispatch on its own (e.g. int32 -> int64), false if it
+   *        has to be asked for (e.g. int64 -> int32, which may overflow).
+   **/
+  void RegisterCast(const GiftedBaseType::GiftedTypeId from,
+                    const GiftedBaseType::GiftedTypeId to,
+                    const GiftedCastKernel kernel,
+                    const bool implicit) {
+    if (_frozen) {
+      throw std::logic_error("GiftedTypeRegistry: registry is frozen, cannot add a cast");
+    }
+    CastEntry cast;
+    cast.from = from;
+    cast.to = to;
+    cast.kernel = kernel;
+    cast.implicit = implicit;
+    _pendingCasts.push_back(cast);
+  }
+
+  /**
+   * @brief Load one type plugin (a shared object) and let it register its
+   *        types. If the entry point throws, the types and casts it
+   *        registered are dropped, their dynamic type ids are handed out
+   *        again, and the shared object is closed.
+   **/
+  void LoadPlugin(const std::string &path) {
+    std::unique_ptr<void, PluginCloser> handle(dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL));
+    if (handle == nullptr) {
+      throw std::runtime_error("GiftedTypeRegistry: cannot load " + path + ": " + dlerror());
+    }
+
+    GiftedPluginAbiVersionFn abiVersion =
+        reinterpret_cast<GiftedPluginAbiVersionFn>(dlsym(handle.get(), GIFTED_PLUGIN_ABI_SYMBOL));
+    GiftedPluginEntryFn entryPoint =
+        reinterpret_cast<GiftedPluginEntryFn>(dlsym(handle.get(), GIFTED_PLUGIN_ENTRY_SYMBOL));
+    if (abiVersion == nullptr || entryPoint == nullptr) {
+      throw std::runtime_error("GiftedTypeRegistry: " + path + " is not a Gifted type plugin");
+    }
+    if (abiVersion() != GIFTED_PLUGIN_ABI_VERSION) {
+      throw std::runtime_error("GiftedTypeRegistry: " + path + " was built for another ABI version");
+    }
+
+    // The prototypes live in the shared object: they must be gone before
+    // it is closed.
+    std::vector<bool> known(_entries.size());
+    for (std::size_t id = 0; id < _entries.size(); id++) known[id] = _entries[id] != nullptr;
+    const std::size_t numCasts = _pendingCasts.size();
+    const int nextDynamicId = _nextDynamicId;
+    _pluginHandles.reserve(_pluginHandles.size() + 1);
+    try {
+      entryPoint(this);
+    } catch (...) {
+      for (std::size_t id = 0; id < _entries.size(); id++) {
+        if (_entries[id] == nullptr || (id < known.size() && known[id])) continue;
+        _nameToId.erase(_entries[id]->name);
+        _entries[id].reset();
+      }
+      _entries.resize(known.size());
+      _pendingCasts.resize(numCasts);
+      _nextDynamicId = nextDynamicId;
+      throw;
+    }
+    _pluginHandles.push_back(handle.release());
+  }
+
+  /**
+   * @brief Load every plugin in a ':' separated list of paths (e.g. the value
+   *        of an environment variable). A null or empty list is a no-op.
+   **/
+  void LoadPlugins(const char *pathList) {
+    if (pathList == nullptr) return;
+    const std::string paths(pathList);
+    std::size_t begin = 0;
+    while (begin <= paths.size()) {
+      std::size_t end = paths.find(':', begin);
+      if (end == std::string::npos) end = paths.size();
+      if (end > begin) LoadPlugin(paths.substr(begin, end - begin));
+      begin = end + 1;
+    }
+  }
+
+  /**
+   * @brief Stop accepting new types and build the dispatch tables. Must be
+   *        called once all the types and plugins are registered, and before
+   *        any lookups from worker threads.
+   **/
+  void Freeze() {
+    if (_frozen) return;
+
+    // Build the dense from x to cast table.
+    const std::size_t numIds = _entries.size();
+    _castTable.assign(numIds * numIds, CastEntry());
+    for (std::size_t i = 0; i < _pendingCasts.size(); i++) {
+      const CastEntry &cast = _pendingCasts[i];
+      if (getEntry(cast.from) == nullptr || getEntry(cast.to) == nullptr) {
+        throw std::invalid_argument("GiftedTypeRegistry: cast between unregistered types");
+      }
+      _castTable[cast.from * numIds + cast.to] = cast;
+    }
+    _pendingCasts.clear();
+    _frozen = true;
+  }
+
+  bool isFrozen() const {return _frozen;}
+
+  /**
+   * @brief Look up a type by id. Returns nullptr for an unknown id.
+   **/
+  const Entry* getEntry(const GiftedBaseType::GiftedTypeId id) const {
+    if (id < 0 || static_cast<std::size_t>(id) >= _entries.size()) return nullptr;
+    return _entries[id].get();
+  }
+
+  /**
+   * @brief Look up a type by name. Returns nullptr for an unknown name.
+   **/
+  const Entry* getEntry(const std::string &name) const {
+    std::unordered_map<std::string, GiftedBaseType::GiftedTypeId>::const_iterator it =
+        _nameToId.find(name);
+    return it == _nameToId.end() ? nullptr : getEntry(it->second);
+  }
+
+  GiftedBaseType::GiftedTypeId getTypeId(const std::string &name) const {
+    const Entry *entry = getEntry(name);
+    return entry == nullptr ? GiftedBaseType::_GiftedUnknownTypeId : entry->id;
+  }
+
+  /**
+   * @brief Create a new empty instance of a type.
+   *
+   *        WARNING: The caller is responsible for cleaning up the object.
+   **/
+  GiftedBaseType* CreateInstance(const GiftedBaseType::GiftedTypeId id) const {
+    const Entry *entry = getEntry(id);
+    if (entry == nullptr) {
+      throw std::invalid_argument("GiftedTypeRegistry: unknown type id");
+    }
+    return entry->prototype->Clone();
+  }
+
+  /**
+   * @brief The batch cast kernel between two types, or nullptr if there is
+   *        none. Only valid after Freeze().
+   **/
+  GiftedCastKernel getCast(const GiftedBaseType::GiftedTypeId from,
+                           const GiftedBaseType::GiftedTypeId to) const {
+    const CastEntry *cast = findCast(from, to);
+    return cast == nullptr ? nullptr : cast->kernel;
+  }
+
+  bool hasImplicitCast(const GiftedBaseType::GiftedTypeId from,
+                       const GiftedBaseType::GiftedTypeId to) const {
+    const CastEntry *cast = findCast(from, to);
+    return cast != nullptr && cast->kernel != nullptr && cast->implicit;
+  }
+
+  /**
+   * @brief The type both "left" and "right" can be implicitly cast to, to
+   *        compare or combine them. Returns _GiftedUnknownTypeId if there is
+   *        none.
+   **/
+  GiftedBaseType::GiftedTypeId getCommonType(const GiftedBaseType::GiftedTypeId left,
+                                             const GiftedBaseType::GiftedTypeId right) const {
+    if (left == right) return left;
+    if (hasImplicitCast(left, right)) return right;
+    if (hasImplicitCast(right, left)) return left;
+    return GiftedBaseType::_GiftedUnknownTypeId;
+  }
+
+  /**
+   * @brief One past the largest type id in use; handy to size per-type tables.
+   **/
+  std::size_t getMaxTypeId() const {return _entries.size();}
+
+  std::size_t getNumTypes() const {return _nameToId.size();}
+
+private:
+  struct PluginCloser {
+    void operator()(void *handle) const {dlclose(handle);}
+  };
+
+  struct CastEntry {
+    CastEntry() : from(GiftedBaseType::_GiftedUnknownTypeId),
+                  to(GiftedBaseType::_GiftedUnknownTypeId),
+                  kernel(nullptr),
+                  implicit(false) {}
+
+    GiftedBaseType::GiftedTypeId from;
+    GiftedBaseType::GiftedTypeId to;
+    GiftedCastKernel kernel;
+    bool implicit;
+  };
+
+  const CastEntry* findCast(const GiftedBaseType::GiftedTypeId from,
+                            const GiftedBaseType::GiftedTypeId to) const {
+    const std::size_t numIds = _entries.size();
+    if (from < 0 || to < 0 ||
+        static_cast<std::size_t>(from) >= numIds ||
+        static_cast<std::size_t>(to) >= numIds ||
+        _castTable.empty()) {
+      return nullptr;
+    }
+    return &_castTable[from * numIds + to];
+  }
+
+  std::vector<std::unique_ptr<Entry>> _entries; // Indexed by type id.
+  std::vector<CastEntry> _pendingCasts;         // Until Freeze().
+  std::vector<CastEntry> _castTable;            // [from * getMaxTypeId() + to]
+  std::unordered_map<std::string, GiftedBaseType::GiftedTypeId> _nameToId;
+  std::vector<void*> _pluginHandles;
+  int _nextDynamicId;
+  bool _frozen;
+
+  GiftedTypeRegistry(const GiftedTypeRegistry&) = delete;
+  GiftedTypeRegistry& operator=(const GiftedTypeRegistry&) = delete;
+};
+
+#endif  // GIFTED_TYPES_TYPE_REGISTRY_HPP_
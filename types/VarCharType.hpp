@@ -0,0 +1,107 @@
+//
+//  VarCharType.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_TYPES_VAR_CHAR_TYPE_HPP_
+#define GIFTED_TYPES_VAR_CHAR_TYPE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+#include "types/BaseType.hpp"
+#include "types/CastKernels.hpp"
+#include "types/DecimalType.hpp"
+#include "types/TextConversions.hpp"
+#include "types/TypeRegistry.hpp"
+
+/**
+ * @brief The VarCharType, a variable length string. The raw form is just the
+ *        characters, the length comes from the column's offsets.
+ **/
+class GiftedVarCharType : public GiftedBaseType {
+public:
+
+  GiftedVarCharType() {};
+  ~GiftedVarCharType() {};
+  virtual GiftedBaseType* Clone () const override {return new GiftedVarCharType;};
+
+  GiftedTypeId myType() const override {return _GiftedVarCharTypeId;}
+
+  std::size_t getLength() override {
+    return 0; // Variable length.
+  }
+
+  void UnMarshall(const char* const payload, const std::size_t length) override {
+    _value.assign(payload, length);
+  }
+
+  void Equal(const GiftedBaseType* const right, bool &result) const override {
+    result = (_value == checkedCast(right)->_value);
+  }
+
+  void LessThan(const GiftedBaseType* const right, bool &result) const override {
+    result = (_value < checkedCast(right)->_value);
+  }
+
+  // Adding strings concatenates them.
+  void AddToLeft(const GiftedBaseType* const right) override {
+    _value += checkedCast(right)->_value;
+  }
+
+  void Print(std::ostream& os) const override {
+    os << _value;
+  }
+
+  // The batch kernels with a fixed element stride do not apply.
+  void VectorizedEqual(const std::size_t elementLength,
+                       const char* const vectorDataElements,
+                       const std::size_t vectorLength,
+                       const char* const rawLiteralData,
+                       bool *result) override {
+    throw std::invalid_argument("GiftedVarCharType: no fixed length VectorizedEqual");
+  }
+
+  void VectorizedLessThan(const std::size_t elementLength,
+                          const char* const vectorDataElements,
+                          const std::size_t vectorLength,
+                          const char* const rawLiteralData,
+                          bool *result) override {
+    throw std::invalid_argument("GiftedVarCharType: no fixed length VectorizedLessThan");
+  }
+
+  /**
+   * @brief Register the casts out of this type, i.e. the parse casts.
+   **/
+  static void RegisterCasts(GiftedTypeRegistry *registry) {
+    registry->RegisterCast(
+        _GiftedVarCharTypeId, _GiftedIntTypeId,
+        &GiftedParseCastKernel<std::int64_t, &GiftedParseInt64>,
+        false);
+    registry->RegisterCast(
+        _GiftedVarCharTypeId, _GiftedInt32TypeId,
+        &GiftedParseCastKernel<std::int32_t, &GiftedParseInt32>,
+        false);
+    registry->RegisterCast(
+        _GiftedVarCharTypeId, _GiftedDecimalTypeId,
+        &GiftedParseCastKernel<std::int64_t, &GiftedDecimalType::ParseValue>,
+        false);
+  }
+
+protected:
+  std::string _value;
+
+private:
+  static const GiftedVarCharType* checkedCast(const GiftedBaseType* const right) {
+    if (right->myType() != _GiftedVarCharTypeId) {
+      throw std::invalid_argument("GiftedVarCharType: operand type mismatch, cast first");
+    }
+    return static_cast<const GiftedVarCharType*>(right);
+  }
+};
+
+#endif  // GIFTED_TYPES_VAR_CHAR_TYPE_HPP_
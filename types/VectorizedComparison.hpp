@@ -0,0 +1,181 @@
+//
+//  VectorizedComparison.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_TYPES_VECTORIZED_COMPARISON_HPP_
+#define GIFTED_TYPES_VECTORIZED_COMPARISON_HPP_
+
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "storage/ColumnVector.hpp"
+#include "types/BaseType.hpp"
+#include "types/ColumnPredicate.hpp"
+#include "types/TypeRegistry.hpp"
+
+/**
+ * @brief Compare a column against a literal whose type may differ from the
+ *        column's, e.g. an int32 column against a decimal literal.
+ *
+ *        The common type and the cast kernels are resolved once, when the
+ *        comparison is set up. The literal is cast once, and each batch is
+ *        cast with one call to the batch cast kernel (when its type is not
+ *        already the common type) before the common type's vectorized
+ *        kernel runs over it. There is no per row cast or type check.
+ *
+ *        A value the batch cast cannot represent (e.g. a huge int64 scaled
+ *        up to a decimal) lies beyond every value of the common type: it is
+ *        never equal to the literal, and less than it if it is negative.
+ *        Cast kernels leave such values saturated, so their sign is kept.
+ **/
+class GiftedVectorizedComparison : public GiftedColumnPredicate {
+public:
+  enum ComparisonId {
+    kEqual,
+    kLessThan
+  };
+
+  /**
+   * @brief Resolve the comparison.
+   *
+   * @exception std::invalid_argument if the two types have no common type
+   *            (an explicit cast is needed), std::overflow_error if the
+   *            literal does not fit in the common type.
+   **/
+  GiftedVectorizedComparison(const GiftedTypeRegistry &registry,
+                             const ComparisonId comparison,
+                             const GiftedBaseType::GiftedTypeId columnType,
+                             const GiftedBaseType::GiftedTypeId literalType,
+                             const char* const rawLiteralData,
+                             const std::size_t literalLength)
+      : _comparison(comparison),
+        _columnType(columnType),
+        _commonEntry(registry.getEntry(registry.getCommonType(columnType, literalType))),
+        _columnCast(nullptr),
+        _literal(_commonEntry == nullptr ? GiftedBaseType::_GiftedUnknownTypeId : _commonEntry->id,
+                 _commonEntry == nullptr ? 0 : _commonEntry->length, 1),
+        _scratch(_literal.getTypeId(), _literal.getElementLength()),
+        _failedCapacity(0) {
+    if (_commonEntry == nullptr) {
+      throw std::invalid_argument("GiftedVectorizedComparison: types are not comparable without a cast");
+    }
+    if (columnType != _commonEntry->id) {
+      _columnCast = registry.getCast(columnType, _commonEntry->id);
+    }
+
+    // Bring the literal to the common type, once.
+    const GiftedTypeRegistry::Entry *literalEntry = registry.getEntry(literalType);
+    GiftedColumnVector literal(literalType, literalEntry->length, 1);
+    if (literal.isVariableLength()) {
+      literal.AppendVariable(rawLiteralData, literalLength);
+    } else {
+      literal.AppendFixed(rawLiteralData);
+    }
+    if (literalType == _commonEntry->id) {
+      _literal = std::move(literal);
+    } else {
+      bool failed = false;
+      registry.getCast(literalType, _commonEntry->id)(literal, &_literal, &failed);
+      if (failed) {
+        throw std::overflow_error("GiftedVectorizedComparison: literal does not fit the common type");
+      }
+    }
+
+    if (_literal.isVariableLength()) {
+      std::size_t length;
+      const char *raw = _literal.getElement(0, &length);
+      _literalInstance.reset(_commonEntry->prototype->Clone());
+      _literalInstance->UnMarshall(raw, length);
+      _valueInstance.reset(_commonEntry->prototype->Clone());
+    }
+  }
+
+  GiftedBaseType::GiftedTypeId getCommonType() const {return _commonEntry->id;}
+
+  // The comparison, the column type, the common type and the literal's bytes
+  // in it (the same bytes mean different values in different types).
+  std::string getCacheKey() const override {
+    std::size_t length;
+    const char *literal = _literal.getElement(0, &length);
+    std::string key = "cmp:" + std::to_string(static_cast<int>(_comparison)) + ":" +
+                      std::to_string(static_cast<int>(_columnType)) + ":" +
+                      std::to_string(static_cast<int>(_commonEntry->id)) + ":";
+    return key.append(literal, length);
+  }
+
+  /**
+   * @brief Evaluate the comparison for every value in "batch", which must be
+   *        of the column type given at construction.
+   *
+   * @exception std::overflow_error if a value does not fit a variable
+   *            length common type.
+   **/
+  void Evaluate(const GiftedColumnVector &batch, bool *result) override {
+    const GiftedColumnVector *input = &batch;
+    bool anyFailed = false;
+    if (_columnCast != nullptr) {
+      if (batch.size() > _failedCapacity) {
+        _failed.reset(new bool[batch.size()]);
+        _failedCapacity = batch.size();
+      }
+      _scratch.Clear();
+      _columnCast(batch, &_scratch, _failed.get());
+      for (std::size_t i = 0; i < batch.size(); i++) anyFailed = anyFailed || _failed[i];
+      input = &_scratch;
+    }
+
+    if (!input->isVariableLength()) {
+      GiftedBaseType *kernels = _commonEntry->prototype.get();
+      const std::size_t length = input->getElementLength();
+      if (_comparison == kEqual) {
+        kernels->VectorizedEqual(length, input->getValues(), input->size(), _literal.getValues(), result);
+      } else {
+        kernels->VectorizedLessThan(length, input->getValues(), input->size(), _literal.getValues(), result);
+      }
+      if (!anyFailed) return;
+
+      // Settle the values beyond the common type by their (saturated) sign.
+      const std::string zero(length, '\0');
+      for (std::size_t i = 0; i < input->size(); i++) {
+        if (!_failed[i]) continue;
+        bool negative = false;
+        kernels->VectorizedLessThan(length, input->getValues() + i * length, 1, zero.data(), &negative);
+        result[i] = _comparison == kLessThan && negative;
+      }
+      return;
+    }
+    if (anyFailed) {
+      throw std::overflow_error("GiftedVectorizedComparison: value does not fit the common type");
+    }
+
+    // Variable length values have no packed kernel; go value by value.
+    for (std::size_t i = 0; i < input->size(); i++) {
+      std::size_t length;
+      const char *raw = input->getElement(i, &length);
+      _valueInstance->UnMarshall(raw, length);
+      if (_comparison == kEqual) {
+        _valueInstance->Equal(_literalInstance.get(), result[i]);
+      } else {
+        _valueInstance->LessThan(_literalInstance.get(), result[i]);
+      }
+    }
+  }
+
+private:
+  const ComparisonId _comparison;
+  const GiftedBaseType::GiftedTypeId _columnType;
+  const GiftedTypeRegistry::Entry *_commonEntry;
+  GiftedCastKernel _columnCast; // Null if the column is of the common type.
+  GiftedColumnVector _literal;  // The literal, as the common type.
+  GiftedColumnVector _scratch;  // The current batch, cast to the common type.
+  std::unique_ptr<bool[]> _failed;
+  std::size_t _failedCapacity;
+  std::unique_ptr<GiftedBaseType> _literalInstance;
+  std::unique_ptr<GiftedBaseType> _valueInstance;
+};
+
+#endif  // GIFTED_TYPES_VECTORIZED_COMPARISON_HPP_
@@ -0,0 +1,198 @@
+//
+//  AlignedBuffer.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_UTILITY_ALIGNED_BUFFER_HPP_
+#define GIFTED_UTILITY_ALIGNED_BUFFER_HPP_
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+/**
+ * @brief Whether large buffers are backed by huge pages, which cut the TLB
+ *        misses of scans over big columns (a 4 KB page TLB covers a few MB,
+ *        a 2 MB page one a few GB):
+ *        - kGiftedNoHugePages: ordinary pages.
+ *        - kGiftedTransparentHugePages: 2 MB aligned, and the kernel is
+ *          asked (madvise) to back them with transparent huge pages.
+ *        - kGiftedHugePages2MB, kGiftedHugePages1GB: mapped from the
+ *          reserved huge page pool (MAP_HUGETLB), the 1 GB size only for
+ *          buffers of at least 1 GB. Without reserved pages, falls back to
+ *          transparent huge pages.
+ *        Buffers smaller than 2 MB always use ordinary pages.
+ **/
+enum GiftedHugePages {
+  kGiftedNoHugePages,
+  kGiftedTransparentHugePages,
+  kGiftedHugePages2MB,
+  kGiftedHugePages1GB
+};
+
+inline std::atomic<int>& GiftedHugePageSetting() {
+  static std::atomic<int> setting(kGiftedNoHugePages);
+  return setting;
+}
+
+/**
+ * @brief Set how buffers allocated from now on are backed, process wide.
+ **/
+inline void GiftedSetHugePages(const GiftedHugePages hugePages) {
+  GiftedHugePageSetting().store(hugePages);
+}
+
+/**
+ * @brief A growable, cache line aligned chunk of raw memory. Used as the
+ *        backing store for column data so that vectorized kernels can use
+ *        aligned loads. A larger alignment (e.g. the page size, for direct
+ *        I/O) can be asked for at construction.
+ **/
+class GiftedAlignedBuffer {
+public:
+  static const std::size_t kAlignment = 64; // One cache line.
+
+  // The page sizes a buffer can be backed by.
+  static const std::size_t kHugePageBytes = std::size_t(1) << 21;
+  static const std::size_t kGiantPageBytes = std::size_t(1) << 30;
+
+  GiftedAlignedBuffer() : _data(nullptr), _capacity(0), _alignment(kAlignment), _mappedPageBytes(0) {}
+
+  /**
+   * @param alignment A power of two that is at least kAlignment.
+   **/
+  explicit GiftedAlignedBuffer(const std::size_t capacity,
+                               const std::size_t alignment = kAlignment)
+      : _data(nullptr), _capacity(0), _alignment(alignment), _mappedPageBytes(0) {
+    Grow(capacity, 0);
+  }
+
+  ~GiftedAlignedBuffer() {Release(_data, _capacity, _mappedPageBytes);}
+
+  GiftedAlignedBuffer(GiftedAlignedBuffer &&other)
+      : _data(other._data), _capacity(other._capacity), _alignment(other._alignment),
+        _mappedPageBytes(other._mappedPageBytes) {
+    other._data = nullptr;
+    other._capacity = 0;
+    other._mappedPageBytes = 0;
+  }
+
+  GiftedAlignedBuffer& operator=(GiftedAlignedBuffer &&other) {
+    if (this != &other) {
+      Release(_data, _capacity, _mappedPageBytes);
+      _data = other._data;
+      _capacity = other._capacity;
+      _alignment = other._alignment;
+      _mappedPageBytes = other._mappedPageBytes;
+      other._data = nullptr;
+      other._capacity = 0;
+      other._mappedPageBytes = 0;
+    }
+    return *this;
+  }
+
+  char* data() {return _data;}
+  const char* data() const {return _data;}
+  std::size_t capacity() const {return _capacity;}
+
+  /**
+   * @brief The size of the reserved huge pages the buffer is mapped from,
+   *        or 0 if it is on the heap (with or without transparent huge
+   *        pages).
+   **/
+  std::size_t getMappedPageBytes() const {return _mappedPageBytes;}
+
+  /**
+   * @brief Make sure the buffer holds at least "capacity" bytes, keeping the
+   *        first "bytesToKeep" bytes of the current contents.
+   **/
+  void Grow(const std::size_t capacity, const std::size_t bytesToKeep) {
+    if (capacity <= _capacity) return;
+    // Round up to whole alignment units so kernels may safely over-read the tail.
+    std::size_t rounded = (capacity + _alignment - 1) & ~(_alignment - 1);
+    const int hugePages = rounded >= kHugePageBytes ? GiftedHugePageSetting().load() : kGiftedNoHugePages;
+    std::size_t mappedPageBytes = 0;
+    void *fresh = nullptr;
+    if (hugePages == kGiftedHugePages1GB && rounded >= kGiantPageBytes) {
+      fresh = MapHugePages(&rounded, kGiantPageBytes);
+      if (fresh != nullptr) mappedPageBytes = kGiantPageBytes;
+    }
+    if (fresh == nullptr && hugePages >= kGiftedHugePages2MB) {
+      fresh = MapHugePages(&rounded, kHugePageBytes);
+      if (fresh != nullptr) mappedPageBytes = kHugePageBytes;
+    }
+    if (fresh == nullptr) {
+      // Transparent huge pages need 2 MB aligned memory.
+      std::size_t alignment = _alignment;
+      if (hugePages != kGiftedNoHugePages && alignment < kHugePageBytes) {
+        alignment = kHugePageBytes;
+        rounded = (rounded + alignment - 1) & ~(alignment - 1);
+      }
+      if (posix_memalign(&fresh, alignment, rounded) != 0) {
+        throw std::bad_alloc();
+      }
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+      if (hugePages != kGiftedNoHugePages) madvise(fresh, rounded, MADV_HUGEPAGE);
+#endif
+    }
+    const std::size_t keep = bytesToKeep < _capacity ? bytesToKeep : _capacity;
+    if (keep > 0) {
+      std::memcpy(fresh, _data, keep);
+    }
+    Release(_data, _capacity, _mappedPageBytes);
+    _data = static_cast<char*>(fresh);
+    _capacity = rounded;
+    _mappedPageBytes = mappedPageBytes;
+  }
+
+private:
+  // Map "*bytes", rounded up to whole pages, from the reserved pages of
+  // "pageBytes"; null if there are none (or no such page size).
+  static void* MapHugePages(std::size_t *bytes, const std::size_t pageBytes) {
+#if defined(__linux__) && defined(MAP_HUGETLB)
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#if defined(MAP_HUGE_SHIFT)
+    flags |= (pageBytes == kGiantPageBytes ? 30 : 21) << MAP_HUGE_SHIFT;
+#endif
+    const std::size_t rounded = (*bytes + pageBytes - 1) & ~(pageBytes - 1);
+    void *mapped = mmap(nullptr, rounded, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (mapped == MAP_FAILED) return nullptr;
+    *bytes = rounded;
+    return mapped;
+#else
+    (void) bytes;
+    (void) pageBytes;
+    return nullptr;
+#endif
+  }
+
+  static void Release(char *data, const std::size_t capacity, const std::size_t mappedPageBytes) {
+#if defined(__linux__)
+    if (mappedPageBytes > 0) {
+      munmap(data, capacity);
+      return;
+    }
+#else
+    (void) capacity;
+    (void) mappedPageBytes;
+#endif
+    std::free(data);
+  }
+
+  char *_data;
+  std::size_t _capacity;
+  std::size_t _alignment;
+  std::size_t _mappedPageBytes;  // 0 if _data is from the heap.
+
+  GiftedAlignedBuffer(const GiftedAlignedBuffer&) = delete;
+  GiftedAlignedBuffer& operator=(const GiftedAlignedBuffer&) = delete;
+};
+
+#endif  // GIFTED_UTILITY_ALIGNED_BUFFER_HPP_
@@ -0,0 +1,77 @@
+//
+//  Bitmap.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_UTILITY_BITMAP_HPP_
+#define GIFTED_UTILITY_BITMAP_HPP_
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @brief Pack a vector of bools (e.g. a VectorizedEqual result) into a
+ *        bitmap, least significant bit first as in Arrow, 16 values per step
+ *        with SSE2.
+ **/
+inline void GiftedPackBools(const bool *values, const std::size_t count, std::uint8_t *bitmap) {
+  std::size_t i = 0;
+#if defined(__SSE2__)
+  for (; i + 16 <= count; i += 16) {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+    // bools are 0 or 1; move bit 0 of every byte up to bit 7 for movemask.
+    const int mask = _mm_movemask_epi8(_mm_slli_epi64(bytes, 7));
+    bitmap[i / 8] = static_cast<std::uint8_t>(mask & 0xFF);
+    bitmap[i / 8 + 1] = static_cast<std::uint8_t>(mask >> 8);
+  }
+#endif
+  for (; i < count; i += 8) {
+    std::uint8_t byte = 0;
+    for (std::size_t bit = 0; bit < 8 && i + bit < count; bit++) {
+      byte |= static_cast<std::uint8_t>(values[i + bit] ? 1u << bit : 0u);
+    }
+    bitmap[i / 8] = byte;
+  }
+}
+
+/**
+ * @brief The eight bools of every byte value, as the eight bytes of a word
+ *        (in memory order), for GiftedUnpackBools.
+ **/
+inline const std::uint64_t* GiftedBoolSpreadTable() {
+  struct Table {
+    Table() {
+      for (unsigned byte = 0; byte < 256; byte++) {
+        unsigned char values[8];
+        for (unsigned bit = 0; bit < 8; bit++) values[bit] = (byte >> bit) & 1;
+        std::memcpy(&spread[byte], values, 8);
+      }
+    }
+    std::uint64_t spread[256];
+  };
+  static const Table table;
+  return table.spread;
+}
+
+/**
+ * @brief The inverse of GiftedPackBools: one table lookup and one 8 byte
+ *        store per bitmap byte.
+ **/
+inline void GiftedUnpackBools(const std::uint8_t *bitmap, const std::size_t count, bool *values) {
+  const std::uint64_t *spread = GiftedBoolSpreadTable();
+  std::size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    std::memcpy(values + i, &spread[bitmap[i / 8]], 8);
+  }
+  for (; i < count; i++) {
+    values[i] = (bitmap[i / 8] >> (i & 7)) & 1;
+  }
+}
+
+#endif  // GIFTED_UTILITY_BITMAP_HPP_
@@ -0,0 +1,26 @@
+//
+//  CacheInfo.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_UTILITY_CACHE_INFO_HPP_
+#define GIFTED_UTILITY_CACHE_INFO_HPP_
+
+#include <unistd.h>
+
+#include <cstddef>
+
+/**
+ * @brief Size in bytes of the per core L2 cache, as reported by the system,
+ *        or a conservative 256KB if the system does not say.
+ **/
+inline std::size_t GiftedL2CacheBytes() {
+#if defined(_SC_LEVEL2_CACHE_SIZE)
+  const long reported = sysconf(_SC_LEVEL2_CACHE_SIZE);
+  if (reported > 0) return static_cast<std::size_t>(reported);
+#endif
+  return 256 * 1024;
+}
+
+#endif  // GIFTED_UTILITY_CACHE_INFO_HPP_
@@ -0,0 +1,182 @@
+//
+//  IoUring.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_UTILITY_IO_URING_HPP_
+#define GIFTED_UTILITY_IO_URING_HPP_
+
+#if defined(__linux__)
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#define GIFTED_HAVE_IO_URING 1
+
+/**
+ * @brief A bare io_uring submission/completion queue pair, driven through
+ *        the raw system calls so there is no dependency on liburing. Only
+ *        what the readers need is here: queue a read, submit, reap.
+ *
+ *        Not thread safe; one ring belongs to one reader.
+ **/
+class GiftedIoUring {
+public:
+  GiftedIoUring()
+      : _ringFd(-1), _sqRing(nullptr), _sqRingBytes(0), _cqRing(nullptr), _cqRingBytes(0),
+        _sqes(nullptr), _sqesBytes(0), _toSubmit(0) {}
+
+  ~GiftedIoUring() {
+    Teardown();
+  }
+
+  /**
+   * @brief Create the rings. Returns false when the kernel has no io_uring,
+   *        it is not allowed (e.g. by a seccomp filter), or the rings cannot
+   *        be mapped, so the caller can fall back to plain reads.
+   **/
+  bool Setup(const unsigned entries) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    _ringFd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (_ringFd < 0) return false;
+
+    _sqRingBytes = params.sq_off.array + params.sq_entries * sizeof(std::uint32_t);
+    _cqRingBytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMap && _cqRingBytes > _sqRingBytes) _sqRingBytes = _cqRingBytes;
+
+    _sqRing = Map(_sqRingBytes, IORING_OFF_SQ_RING);
+    _cqRing = singleMap ? _sqRing : Map(_cqRingBytes, IORING_OFF_CQ_RING);
+    _sqesBytes = params.sq_entries * sizeof(io_uring_sqe);
+    _sqes = static_cast<io_uring_sqe*>(Map(_sqesBytes, IORING_OFF_SQES));
+    if (_sqRing == nullptr || _cqRing == nullptr || _sqes == nullptr) {
+      Teardown();
+      return false;
+    }
+
+    char *sq = static_cast<char*>(_sqRing);
+    _sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    _sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    _sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    _sqEntries = params.sq_entries;
+    _sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+    char *cq = static_cast<char*>(_cqRing);
+    _cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    _cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    _cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    _cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    return true;
+  }
+
+  /**
+   * @brief Queue a vectored read (IORING_OP_READV, so any io_uring kernel
+   *        will do). "iov" must stay valid until the read completes.
+   *        Returns false if the submission queue is full.
+   **/
+  bool PrepareRead(const int fd, const iovec *iov, const std::uint64_t offset, const std::uint64_t userData) {
+    const unsigned tail = *_sqTail;
+    if (tail - __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE) >= _sqEntries) return false;
+    const unsigned index = tail & _sqMask;
+    io_uring_sqe *sqe = &_sqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<std::uint64_t>(iov);
+    sqe->len = 1;
+    sqe->off = offset;
+    sqe->user_data = userData;
+    _sqArray[index] = index;
+    __atomic_store_n(_sqTail, tail + 1, __ATOMIC_RELEASE);
+    _toSubmit++;
+    return true;
+  }
+
+  /**
+   * @brief Hand the queued reads to the kernel, and wait until at least
+   *        "waitFor" completions are available.
+   **/
+  void Submit(const unsigned waitFor) {
+    if (_toSubmit == 0 && waitFor == 0) return;
+    for (;;) {
+      const long submitted = syscall(__NR_io_uring_enter, _ringFd, _toSubmit, waitFor,
+                                     waitFor > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+      if (submitted < 0) {
+        if (errno == EINTR) continue;
+        throw std::runtime_error(std::string("GiftedIoUring: io_uring_enter failed: ") + std::strerror(errno));
+      }
+      _toSubmit -= static_cast<unsigned>(submitted);
+      return;
+    }
+  }
+
+  /**
+   * @brief Take one completion off the queue, if there is one. "result" is
+   *        the byte count, or -errno.
+   **/
+  bool PopCompletion(std::uint64_t *userData, int *result) {
+    const unsigned head = *_cqHead;
+    if (head == __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE)) return false;
+    const io_uring_cqe &cqe = _cqes[head & _cqMask];
+    *userData = cqe.user_data;
+    *result = cqe.res;
+    __atomic_store_n(_cqHead, head + 1, __ATOMIC_RELEASE);
+    return true;
+  }
+
+private:
+  // Null if the mapping fails.
+  void* Map(const std::size_t bytes, const off_t offset) {
+    void *mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, offset);
+    return mapped == MAP_FAILED ? nullptr : mapped;
+  }
+
+  void Teardown() {
+    if (_sqes != nullptr) munmap(_sqes, _sqesBytes);
+    if (_cqRing != nullptr && _cqRing != _sqRing) munmap(_cqRing, _cqRingBytes);
+    if (_sqRing != nullptr) munmap(_sqRing, _sqRingBytes);
+    if (_ringFd >= 0) close(_ringFd);
+    _ringFd = -1;
+    _sqRing = nullptr;
+    _cqRing = nullptr;
+    _sqes = nullptr;
+  }
+
+  int _ringFd;
+  void *_sqRing;
+  std::size_t _sqRingBytes;
+  void *_cqRing;
+  std::size_t _cqRingBytes;
+  io_uring_sqe *_sqes;
+  std::size_t _sqesBytes;
+  unsigned _toSubmit;
+
+  unsigned *_sqHead;
+  unsigned *_sqTail;
+  unsigned _sqMask;
+  unsigned _sqEntries;
+  unsigned *_sqArray;
+  unsigned *_cqHead;
+  unsigned *_cqTail;
+  unsigned _cqMask;
+  io_uring_cqe *_cqes;
+
+  GiftedIoUring(const GiftedIoUring&) = delete;
+  GiftedIoUring& operator=(const GiftedIoUring&) = delete;
+};
+
+#endif  // __linux__
+
+#endif  // GIFTED_UTILITY_IO_URING_HPP_
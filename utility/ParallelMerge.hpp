@@ -0,0 +1,58 @@
+//
+//  ParallelMerge.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_UTILITY_PARALLEL_MERGE_HPP_
+#define GIFTED_UTILITY_PARALLEL_MERGE_HPP_
+
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Merge "parts" (e.g. per thread sketches) into parts->front() as a
+ *        tree: each round merges pairs on their own threads, so n parts take
+ *        log2(n) rounds instead of n - 1 merges in a row. T needs
+ *        Merge(const T&). Returns parts->front(); "parts" must not be empty.
+ *
+ *        An exception from a Merge is rethrown once its round's threads are
+ *        joined (the first pair's, if several throw); "parts" is then only
+ *        partly merged.
+ **/
+template <typename T>
+T& GiftedParallelMerge(std::vector<T> *parts) {
+  for (std::size_t stride = 1; stride < parts->size(); stride *= 2) {
+    const std::size_t pairs = (parts->size() + stride - 1) / (2 * stride);
+    std::vector<std::exception_ptr> errors(pairs);
+    std::vector<std::thread> workers;
+    workers.reserve(pairs);
+    try {
+      for (std::size_t p = 0; p < pairs; p++) {
+        T *into = &(*parts)[2 * stride * p];
+        const T *from = into + stride;
+        std::exception_ptr *error = &errors[p];
+        workers.push_back(std::thread([into, from, error]() {
+          try {
+            into->Merge(*from);
+          } catch (...) {
+            *error = std::current_exception();
+          }
+        }));
+      }
+    } catch (...) {
+      // No thread to spare: let the started ones finish first.
+      for (std::size_t w = 0; w < workers.size(); w++) workers[w].join();
+      throw;
+    }
+    for (std::size_t w = 0; w < workers.size(); w++) workers[w].join();
+    for (std::size_t p = 0; p < pairs; p++) {
+      if (errors[p]) std::rethrow_exception(errors[p]);
+    }
+  }
+  return parts->front();
+}
+
+#endif  // GIFTED_UTILITY_PARALLEL_MERGE_HPP_
@@ -0,0 +1,98 @@
+//
+//  PerfCounter.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_UTILITY_PERF_COUNTER_HPP_
+#define GIFTED_UTILITY_PERF_COUNTER_HPP_
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @brief A hardware event counter of the calling thread, e.g. the data TLB
+ *        misses of a scan: Start(), run the code, then Stop() returns the
+ *        count in between.
+ *
+ *        Counts through perf_event_open on Linux. Where that is not there
+ *        or not allowed (no PMU in a VM, perf_event_paranoid, a seccomp
+ *        filter) isAvailable() is false and Stop() returns 0.
+ **/
+class GiftedPerfCounter {
+public:
+  /**
+   * @brief Data TLB misses of loads (page walks).
+   **/
+  static GiftedPerfCounter DataTlbMisses() {
+#if defined(__linux__)
+    return GiftedPerfCounter(PERF_TYPE_HW_CACHE,
+                             PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                             (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+#else
+    return GiftedPerfCounter(0, 0);
+#endif
+  }
+
+  GiftedPerfCounter(const std::uint32_t type, const std::uint64_t config) : _fd(-1) {
+#if defined(__linux__)
+    perf_event_attr attributes;
+    std::memset(&attributes, 0, sizeof(attributes));
+    attributes.size = sizeof(attributes);
+    attributes.type = type;
+    attributes.config = config;
+    attributes.disabled = 1;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    _fd = static_cast<int>(syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0));
+#else
+    (void) type;
+    (void) config;
+#endif
+  }
+
+  GiftedPerfCounter(GiftedPerfCounter &&other) : _fd(other._fd) {other._fd = -1;}
+
+  ~GiftedPerfCounter() {
+#if defined(__linux__)
+    if (_fd >= 0) close(_fd);
+#endif
+  }
+
+  bool isAvailable() const {return _fd >= 0;}
+
+  void Start() {
+#if defined(__linux__)
+    if (_fd < 0) return;
+    ioctl(_fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(_fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+  }
+
+  std::uint64_t Stop() {
+#if defined(__linux__)
+    if (_fd < 0) return 0;
+    ioctl(_fd, PERF_EVENT_IOC_DISABLE, 0);
+    std::uint64_t count = 0;
+    if (read(_fd, &count, sizeof(count)) != static_cast<ssize_t>(sizeof(count))) return 0;
+    return count;
+#else
+    return 0;
+#endif
+  }
+
+private:
+  int _fd;
+
+  GiftedPerfCounter(const GiftedPerfCounter&) = delete;
+  GiftedPerfCounter& operator=(const GiftedPerfCounter&) = delete;
+};
+
+#endif  // GIFTED_UTILITY_PERF_COUNTER_HPP_
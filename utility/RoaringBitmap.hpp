@@ -0,0 +1,282 @@
+//
+//  RoaringBitmap.hpp
+//
+//  Copyright © 2016 Gift-ed Research Group. All rights reserved.
+//
+
+#ifndef GIFTED_UTILITY_ROARING_BITMAP_HPP_
+#define GIFTED_UTILITY_ROARING_BITMAP_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <vector>
+
+#include "utility/Bitmap.hpp"
+
+/**
+ * @brief A compressed set of 32 bit row ids, as in Roaring: the ids are
+ *        split by their upper 16 bits into chunks of 65536, and each chunk
+ *        is stored as whichever is smaller, a sorted array of its lower 16
+ *        bits (up to 4096 of them, 8 KB) or a plain 65536 bit bitmap (8 KB).
+ *        Sparse sets cost 2 bytes per id, dense ones 1 bit, and And, Or and
+ *        AndNot work chunk by chunk with merges or word loops.
+ **/
+class GiftedRoaringBitmap {
+public:
+  GiftedRoaringBitmap() {}
+
+  /**
+   * @brief Add "value"; cheapest in ascending order.
+   **/
+  void Add(const std::uint32_t value) {
+    const std::uint16_t key = static_cast<std::uint16_t>(value >> 16);
+    const std::uint16_t low = static_cast<std::uint16_t>(value & 0xFFFF);
+    std::vector<Container>::iterator container = _containers.end();
+    if (_containers.empty() || _containers.back().key < key) {
+      _containers.push_back(Container(key));
+      container = _containers.end() - 1;
+    } else if (_containers.back().key == key) {
+      container = _containers.end() - 1;
+    } else {
+      container = std::lower_bound(_containers.begin(), _containers.end(), key, KeyBelow);
+      if (container->key != key) container = _containers.insert(container, Container(key));
+    }
+    container->Add(low);
+  }
+
+  bool Contains(const std::uint32_t value) const {
+    const Container *container = Find(static_cast<std::uint16_t>(value >> 16));
+    return container != nullptr && container->Contains(static_cast<std::uint16_t>(value & 0xFFFF));
+  }
+
+  bool empty() const {return _containers.empty();}
+
+  std::size_t Cardinality() const {
+    std::size_t cardinality = 0;
+    for (std::size_t c = 0; c < _containers.size(); c++) cardinality += _containers[c].cardinality;
+    return cardinality;
+  }
+
+  std::size_t getBytes() const {
+    std::size_t bytes = _containers.size() * sizeof(Container);
+    for (std::size_t c = 0; c < _containers.size(); c++) {
+      bytes += _containers[c].array.size() * sizeof(std::uint16_t) +
+               _containers[c].words.size() * sizeof(std::uint64_t);
+    }
+    return bytes;
+  }
+
+  static GiftedRoaringBitmap And(const GiftedRoaringBitmap &left, const GiftedRoaringBitmap &right) {
+    return Combine(left, right, kAnd);
+  }
+
+  static GiftedRoaringBitmap Or(const GiftedRoaringBitmap &left, const GiftedRoaringBitmap &right) {
+    return Combine(left, right, kOr);
+  }
+
+  static GiftedRoaringBitmap AndNot(const GiftedRoaringBitmap &left, const GiftedRoaringBitmap &right) {
+    return Combine(left, right, kAndNot);
+  }
+
+  /**
+   * @brief Append the ids to "rows", in ascending order.
+   **/
+  void ToRows(std::vector<std::uint32_t> *rows) const {
+    rows->reserve(rows->size() + Cardinality());
+    for (std::size_t c = 0; c < _containers.size(); c++) {
+      const Container &container = _containers[c];
+      const std::uint32_t high = static_cast<std::uint32_t>(container.key) << 16;
+      if (container.isBitmap()) {
+        for (std::size_t w = 0; w < kBitmapWords; w++) {
+          for (std::uint64_t word = container.words[w]; word != 0; word &= word - 1) {
+            rows->push_back(high | static_cast<std::uint32_t>(w * 64 + __builtin_ctzll(word)));
+          }
+        }
+      } else {
+        for (std::size_t i = 0; i < container.array.size(); i++) rows->push_back(high | container.array[i]);
+      }
+    }
+  }
+
+  /**
+   * @brief Set result[i] to whether first + i is in the set, for i in
+   *        [0, count): a filter's outcome for a batch of rows.
+   **/
+  void FillBools(const std::uint32_t first, const std::size_t count, bool *result) const {
+    if (count == 0) return;
+    std::memset(result, 0, count);
+    const std::uint64_t end = static_cast<std::uint64_t>(first) + count;
+    std::vector<Container>::const_iterator container =
+        std::lower_bound(_containers.begin(), _containers.end(), static_cast<std::uint16_t>(first >> 16), KeyBelow);
+    for (; container != _containers.end(); ++container) {
+      const std::uint64_t base = static_cast<std::uint64_t>(container->key) << 16;
+      if (base >= end) break;
+      // The part of the batch in this chunk, in chunk coordinates.
+      const std::size_t low = base < first ? static_cast<std::size_t>(first - base) : 0;
+      const std::size_t high = static_cast<std::size_t>(std::min<std::uint64_t>(end - base, 65536));
+      bool *out = result + (base + low - first);
+      if (container->isBitmap()) {
+        const std::uint8_t *bytes = reinterpret_cast<const std::uint8_t*>(container->words.data());
+        std::size_t i = low;
+        for (; i < high && i % 8 != 0; i++) out[i - low] = (bytes[i / 8] >> (i % 8)) & 1;
+        // Whole bytes at once (the words are little endian, as on x86).
+        if (i < high) GiftedUnpackBools(bytes + i / 8, high - i, out + (i - low));
+      } else {
+        std::vector<std::uint16_t>::const_iterator value =
+            std::lower_bound(container->array.begin(), container->array.end(), static_cast<std::uint16_t>(low));
+        for (; value != container->array.end() && *value < high; ++value) out[*value - low] = true;
+      }
+    }
+  }
+
+private:
+  static const std::size_t kMaxArray = 4096;
+  static const std::size_t kBitmapWords = 65536 / 64;
+
+  enum Operation {kAnd, kOr, kAndNot};
+
+  struct Container {
+    explicit Container(const std::uint16_t key) : key(key), cardinality(0) {}
+
+    bool isBitmap() const {return !words.empty();}
+
+    bool Contains(const std::uint16_t low) const {
+      if (isBitmap()) return (words[low / 64] >> (low % 64)) & 1;
+      return std::binary_search(array.begin(), array.end(), low);
+    }
+
+    void Add(const std::uint16_t low) {
+      if (isBitmap()) {
+        const std::uint64_t bit = std::uint64_t(1) << (low % 64);
+        cardinality += (words[low / 64] & bit) == 0;
+        words[low / 64] |= bit;
+        return;
+      }
+      if (array.empty() || array.back() < low) {
+        array.push_back(low);
+      } else {
+        std::vector<std::uint16_t>::iterator at = std::lower_bound(array.begin(), array.end(), low);
+        if (*at == low) return;
+        array.insert(at, low);
+      }
+      cardinality++;
+      if (array.size() > kMaxArray) ToBitmap();
+    }
+
+    void ToBitmap() {
+      words.assign(kBitmapWords, 0);
+      for (std::size_t i = 0; i < array.size(); i++) words[array[i] / 64] |= std::uint64_t(1) << (array[i] % 64);
+      std::vector<std::uint16_t>().swap(array);
+    }
+
+    // Bitmaps that became sparse (after And or AndNot) go back to arrays.
+    void Shrink() {
+      if (!isBitmap() || cardinality > kMaxArray) return;
+      array.reserve(cardinality);
+      for (std::size_t w = 0; w < kBitmapWords; w++) {
+        for (std::uint64_t word = words[w]; word != 0; word &= word - 1) {
+          array.push_back(static_cast<std::uint16_t>(w * 64 + __builtin_ctzll(word)));
+        }
+      }
+      std::vector<std::uint64_t>().swap(words);
+    }
+
+    std::uint16_t key;
+    std::uint32_t cardinality;
+    std::vector<std::uint16_t> array;  // Sorted; unused once a bitmap.
+    std::vector<std::uint64_t> words;  // kBitmapWords words, or none.
+  };
+
+  static bool KeyBelow(const Container &container, const std::uint16_t key) {return container.key < key;}
+
+  const Container* Find(const std::uint16_t key) const {
+    std::vector<Container>::const_iterator container =
+        std::lower_bound(_containers.begin(), _containers.end(), key, KeyBelow);
+    return container != _containers.end() && container->key == key ? &*container : nullptr;
+  }
+
+  static GiftedRoaringBitmap Combine(const GiftedRoaringBitmap &left,
+                                     const GiftedRoaringBitmap &right,
+                                     const Operation operation) {
+    GiftedRoaringBitmap result;
+    std::size_t l = 0, r = 0;
+    while (l < left._containers.size() || r < right._containers.size()) {
+      const Container *a = l < left._containers.size() ? &left._containers[l] : nullptr;
+      const Container *b = r < right._containers.size() ? &right._containers[r] : nullptr;
+      if (b == nullptr || (a != nullptr && a->key < b->key)) {
+        if (operation != kAnd) result._containers.push_back(*a);
+        l++;
+      } else if (a == nullptr || b->key < a->key) {
+        if (operation == kOr) result._containers.push_back(*b);
+        r++;
+      } else {
+        Container combined = CombineContainers(*a, *b, operation);
+        if (combined.cardinality > 0) result._containers.push_back(std::move(combined));
+        l++;
+        r++;
+      }
+    }
+    return result;
+  }
+
+  static Container CombineContainers(const Container &a, const Container &b, const Operation operation) {
+    Container result(a.key);
+    if (a.isBitmap() || b.isBitmap()) {
+      if (operation == kAnd && !a.isBitmap()) return FilterArray(a, b, true);
+      if (operation == kAnd && !b.isBitmap()) return FilterArray(b, a, true);
+      if (operation == kAndNot && !a.isBitmap()) return FilterArray(a, b, false);
+      // The result is a bitmap: word by word.
+      Container left = a, right = b;
+      if (!left.isBitmap()) left.ToBitmap();
+      if (!right.isBitmap()) right.ToBitmap();
+      result.words.resize(kBitmapWords);
+      std::uint32_t cardinality = 0;
+      for (std::size_t w = 0; w < kBitmapWords; w++) {
+        const std::uint64_t word = operation == kAnd ? left.words[w] & right.words[w]
+            : (operation == kOr ? left.words[w] | right.words[w] : left.words[w] & ~right.words[w]);
+        result.words[w] = word;
+        cardinality += static_cast<std::uint32_t>(__builtin_popcountll(word));
+      }
+      result.cardinality = cardinality;
+      result.Shrink();
+      return result;
+    }
+
+    // Both arrays: a merge.
+    switch (operation) {
+      case kAnd:
+        std::set_intersection(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                              std::back_inserter(result.array));
+        break;
+      case kOr:
+        std::set_union(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                       std::back_inserter(result.array));
+        break;
+      case kAndNot:
+        std::set_difference(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                            std::back_inserter(result.array));
+        break;
+    }
+    result.cardinality = static_cast<std::uint32_t>(result.array.size());
+    if (result.array.size() > kMaxArray) result.ToBitmap();
+    return result;
+  }
+
+  // The values of "array" that are ("keep") or are not in "bitmap".
+  static Container FilterArray(const Container &array, const Container &bitmap, const bool keep) {
+    Container result(array.key);
+    result.array.reserve(array.array.size());
+    for (std::size_t i = 0; i < array.array.size(); i++) {
+      if (bitmap.Contains(array.array[i]) == keep) result.array.push_back(array.array[i]);
+    }
+    result.cardinality = static_cast<std::uint32_t>(result.array.size());
+    return result;
+  }
+
+  std::vector<Container> _containers;  // By key.
+};
+
+#endif  // GIFTED_UTILITY_ROARING_BITMAP_HPP_